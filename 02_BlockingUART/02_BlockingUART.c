@@ -4,103 +4,43 @@
 */
 
 #include <stdint.h>
-
-/* Define register access function
-   To make the code more readable, we make use of these macros */
-#define PUT32(address, value) (*((volatile unsigned int *)(address))) = value
-#define GET32(address) (*(volatile unsigned int *)(address))
-
-/* Define Atomic Register Access
-   See section 2.1.3 "Atomic Register Access" on RP2350 datasheet */
-#define WRITE_NORMAL (0x0000)   // normal read write access
-#define WRITE_XOR    (0x1000)   // atomic XOR on write
-#define WRITE_SET    (0x2000)   // atomic bitmask set on write
-#define WRITE_CLR    (0x3000)   // atomic bitmask clear on write
-
-/* Function declaration */
-int main( void );
-void Default_Handler(void);
-void Reset_Handler(void);
-
-/* Type definitions */
-typedef void(*vectors_t)(void);
-typedef struct {
-    uint32_t word0;
-    uint32_t word1;
-    uint32_t word2;
-    uint32_t word3;
-    uint32_t word4;
-} PicobinBlockItem;
-
-/* Extern Variables */
-extern unsigned int __stack_end__;
-
-/* Vector Table */
-__attribute__( ( used, section( ".vector_table" ) ) ) vectors_t vectorTable[] =
-{
-  (vectors_t)(&__stack_end__), // Initial SP
-  Reset_Handler,               // Reset
-  Default_Handler,             // NMI
-  Default_Handler,             // HardFault
-  Default_Handler,             // MemManage
-  Default_Handler,             // BusFaults
-  Default_Handler,             // UsageFault
-  0,                           // Reserved
-  0,                           // Reserved
-  0,                           // Reserved
-  0,                           // Reserved.
-  Default_Handler,             // SVCall
-  Default_Handler,             // DebugMonitor
-  0,                           // Reserved
-  Default_Handler,             // PendSV
-  Default_Handler,             // SysTick
-  Default_Handler,             // IRQ0
-  Default_Handler,             // IRQ1 ...
-};
-
-/* RP2350 Spec - 5.9.5. Minimum Viable Image Metadata
-   As we want to work with ARM Arch, then we use the Minimum Arm IMAGE_DEF
-*/
-PicobinBlockItem picoBinBlockItem __attribute__((section(".picobin_block_item"))) = {
-    .word0 = 0xffffded3,    // PICOBIN_BLOCK_MARKER_START (4 byte magic header)
-    .word1 = 0x10210142,    // 0x42 PICOBIN_BLOCK_ITEM_1BS_IMAGE_TYPE, 0x01 word in size, 0x1021 image type exe secure, ARM, RP2350
-    .word2 = 0x000001ff,    // 0x00 pad, 0x0001 size, 0xff(size_type == 1, item_type_ == PICOBIN_BLOCK_ITEM_2BS_LAST)
-    .word3 = 0x00000000,    // loop containing just this block
-    .word4 = 0xab123579,    // PICOBIN_BLOCK_MARKER_END (4 byte magic footer)
-};
-
-void Default_Handler(void)
-{
-  while (1)
-  {
-    asm("nop");
-  }
-}
-
-void Reset_Handler(void)
-{
-  uint32_t cpuId = GET32(0xd0000000);
-  if (cpuId == 1)
-  {
-    // Hold Core1 on infinite loop
-    while(1)
-    {
-        asm("nop");
-    }
-  }
-  main();
-}
+#include "rp2350.h"
+#include "clocks.h"
+#include "crt0.h"
+#include "prof.h"
+
+/* Register access (PUT32/GET32) and the atomic register aliases (WRITE_SET,
+   WRITE_CLR, ...) come from ../bsp/rp2350.h, shared with the drivers.
+   On a host build (make host) the accesses go to the RP2350 simulator */
+
+/* The startup code (vector table, image definition and Reset_Handler, which
+   initializes .data/.bss and calls main) is in ../bsp/crt0.c */
+
+/* Profiling (make PROF=1, see ../bsp/prof.h)
+   The probes count the cycles of the functions below with the DWT cycle
+   counter, e.g. to check the estimate of delay(). The report is sent after
+   every round of lines (decode it with tools/profdecode.py). Without PROF=1
+   the probes are not compiled. */
+PROF_PROBE(delay);
+PROF_PROBE(configDevice);
+PROF_PROBE(uartTxChar);
+PROF_PROBE(uartTxString);
 
 /* Delay Function
-   5 instructions are needed to do a loop. Therefore:
-   5 loops @ 12MHz = 2398 clock cycles per ms.
+   5 instructions are needed to do a loop. Therefore the loops per ms are
+   derived from clk_sys: clk_sys / 5000 (2400 @ 12MHz, 30000 @ 150MHz).
+   The loop runs from SRAM (TIME_CRITICAL, see ../bsp/crt0.h): from flash an
+   XIP cache miss would make some loops slower than the estimate.
 */
-void delay(uint32_t millisec)
+void TIME_CRITICAL(delay)(uint32_t millisec)
 {
-    for(uint32_t i = 0; i < millisec * 2398; i++)
+    PROF_BEGIN(delay);
+    uint32_t loops = millisec * (clocksGetSysHz() / 5000);
+    for(uint32_t i = 0; i < loops; i++)
     {
         asm("nop");
     }
+    PROF_END(delay);
 }
 
 /* ConfigDevice Function
@@ -108,15 +48,11 @@ void delay(uint32_t millisec)
 */
 void configDevice(void)
 {
-    // Setup XOC clock to drive the GPIO (Pico2 board as a ABM8-272-T3 crystal that oscillates at 12MHz)
-    PUT32((0x40048000 + 0),      0x00000aa0);               //  XOC range 1-15MHz (Crystal Oschillator)
-    PUT32((0x40048000 + 0x0c),   0x000000c4);               //  Startup Delay (default = 50,000 cycles aprox.)
-    PUT32((0x40048000 + 0x2000), 0x00FAB000);               //  Enable XOC
-    while (!(GET32(0x40048000 + 4) & ( 1 << 31 )));         //  Wait for XOC stable
+    PROF_BEGIN(configDevice);
 
-    // Configure source clock for components (see datasheer RP2350 Chapter 8. "Clocks")
-    PUT32((0x40010000 + 0x3C), 0 );                         //  CLK SYS CTRL = XOC (for processor, bus frabric & memories)
-    PUT32((0x40010000 + 0x48), ((1 << 11) | ( 4 << 5)));    //  CLK_PERI_CTRL = XOC (for perifery UART and SPI) + Enable
+    // Configure the clock tree (see datasheer RP2350 Chapter 8. "Clocks"):
+    // XOSC 12MHz -> PLL_SYS -> clk_sys = clk_peri = CLK_SYS_HZ (for processor, bus fabric, memories, UART and SPI)
+    clocksInit(CLK_SYS_HZ);
 
     // De-asserts the reset of UART0
     PUT32((0x40020000 + WRITE_SET + 0x0), (1 << 26));       // Set UART0 to reset
@@ -131,7 +67,7 @@ void configDevice(void)
     PUT32((0x40028000 + 0x0c), 2);                          // IO GPIO1 uses UART RX
 
     // Enable GPIO out in SIO register
-    PUT32((0xd0000000 + WRITE_SET + 0x038), (1 << 25));     // SIO OE (output enable) for Pin25
+    PUT32((0xd0000000 + 0x038), (1 << 25));                 // SIO OE (output enable) for Pin25
 
     // Configure the pad control (new on RP2350)
     PUT32((0x40038000 + WRITE_CLR + 0x68), (1 << 8));       // Remove GPIO25 pad isolation
@@ -140,12 +76,15 @@ void configDevice(void)
     PUT32((0x40038000 + WRITE_SET + 0x08), (1 << 6));       // Enable UART0RX pad for input
 
     // Configure UART0
-    //   Baud: For a baud rate of 115200 with UARTCLK = 12MHz then:
-    //   Baud Rate Divisor = 12000000/(16 * 115200) ~= 6.5104
-    PUT32((0x40070000 + 0x24), 6);                                         // UARTIBRD_H: Integer part of the baudrate divisor
-    PUT32((0x40070000 + 0x28), 5104);                                      // UARTFBRD_L: Decimal part of the baudrate divisor
+    //   Baud: The divisor is computed from UARTCLK = clk_peri in units of 1/64:
+    //   Baud Rate Divisor = clk_peri/(16 * 115200), e.g. 150000000/(16 * 115200) ~= 81.38 -> IBRD = 81, FBRD = 24
+    //   (rounded to the nearest 1/64, see uartBaudCompute() in ../bsp/uart.c for the error of a rate)
+    uint32_t baudDiv = ((8 * clocksGetPeriHz()) / 115200 + 1) / 2;        // 64 * clk_peri / (16 * baud), rounded
+    PUT32((0x40070000 + 0x24), (baudDiv >> 6));                            // UARTIBRD_H: Integer part of the baudrate divisor
+    PUT32((0x40070000 + 0x28), (baudDiv & 0x3f));                          // UARTFBRD_L: Decimal part of the baudrate divisor
     PUT32((0x40070000 + 0x2c), (( 0x3 << 5 ) | ( 1 << 4 )));               // UARTLCR_H: Word lenght = 8, FIFO RX/TX enabled
     PUT32((0x40070000 + 0x30), ((   1 << 9 ) | ( 1 << 8 ) | ( 1 << 0 )));  // UARTCR: UART Enabled, Tx enabled, Rx enabled
+    PROF_END(configDevice);
 }
 
 
@@ -154,9 +93,11 @@ void configDevice(void)
 */
 void uartTxChar(int8_t txData)
 {
+    PROF_BEGIN(uartTxChar);
     volatile int8_t myData = txData;
     while(GET32(0x40070000 + 0x018) & (1 << 5));        // Wait until UART0 FIFO is empty
     PUT32((0x40070000 + 0x0), myData);                  // UARTDR: Write data to Tx.
+    PROF_END(uartTxChar);
 }
 
 /* Transmits string over UART
@@ -164,12 +105,14 @@ void uartTxChar(int8_t txData)
 */
 void uartTxString(int8_t* txData)
 {
+    PROF_BEGIN(uartTxString);
     while(*txData != '\0')
     {
         uartTxChar(*txData++);
     }
     uartTxChar('\r');
     uartTxChar('\n');
+    PROF_END(uartTxString);
 }
 
 /* Indicates when data is avaiable on UART Rx FIFO 
@@ -187,13 +130,26 @@ uint8_t uartRxChar(void)
     return((unsigned char)GET32(0x40070000 + 0x0));         // UARTDR: Write data to Tx.
 }
 
+#if PROF_ENABLE
+/* Sends the binary report of the probes, waiting on the TX FIFO like
+   uartTxChar (without its probe, so the report does not measure itself) */
+void profUartWrite(const uint8_t *data, uint32_t len)
+{
+    while(len--)
+    {
+        while(GET32(0x40070000 + 0x018) & (1 << 5));    // Wait until UART0 FIFO is not full
+        PUT32((0x40070000 + 0x0), *data++);             // UARTDR: Write data to Tx.
+    }
+}
+#endif
+
 /* -------------
    Main Function
    -------------
 */
 int main( void ){
+    profInit();                 // Starts the cycle counter, only with PROF=1
     configDevice();
-    delay(1000);
     uartTxString((int8_t*)"-= UART Blocking Example for RP2350 =-\n\n");
     while(1)
     {
@@ -203,13 +159,16 @@ int main( void ){
         {
             textString[1] = i++;
             uartTxString(textString);
-            PUT32((0xd0000000 + WRITE_SET + 0x028), (1 << 25));    // xor GPIO (toggle pin)
+            PUT32((0xd0000000 + 0x028), (1 << 25));               // xor GPIO (toggle pin)
             delay(100);
             if (uartRxDataAvail() != 0)
             {
               uartTxChar(uartRxChar());    // Transmit each received character
             }
         }
+#if PROF_ENABLE
+        profDump(profUartWrite);
+#endif
     }
     return 0;
 }
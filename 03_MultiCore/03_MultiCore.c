@@ -4,244 +4,189 @@
 */
 
 #include <stdint.h>
-
-/* Define register access function
-   To make the code more readable, we make use of these macros */
-#define PUT32(address, value) (*((volatile unsigned int *)(address))) = value
-#define GET32(address) (*(volatile unsigned int *)(address))
-
-/* Define Atomic Register Access
-   See section 2.1.3 "Atomic Register Access" on RP2350 datasheet */
-#define WRITE_NORMAL (0x0000)   // normal read write access
-#define WRITE_XOR    (0x1000)   // atomic XOR on write
-#define WRITE_SET    (0x2000)   // atomic bitmask set on write
-#define WRITE_CLR    (0x3000)   // atomic bitmask clear on write
-
-/* Function declaration */
-int main( void );
-void Default_Handler(void);
-void Reset_Handler(void);
-
-/* Type definitions */
-typedef void(*vectors_t)(void);
-typedef struct {
-    uint32_t word0;
-    uint32_t word1;
-    uint32_t word2;
-    uint32_t word3;
-    uint32_t word4;
-} PicobinBlockItem;
-
-/* Extern Variables */
-extern unsigned int __stack_end__;
-
-/* Vector Table */
-__attribute__( ( used, section( ".vector_table" ) ) ) vectors_t vectorTable[] =
-{
-  (vectors_t)(&__stack_end__), // Initial SP
-  Reset_Handler,               // Reset
-  Default_Handler,             // NMI
-  Default_Handler,             // HardFault
-  Default_Handler,             // MemManage
-  Default_Handler,             // BusFaults
-  Default_Handler,             // UsageFault
-  0,                           // Reserved
-  0,                           // Reserved
-  0,                           // Reserved
-  0,                           // Reserved.
-  Default_Handler,             // SVCall
-  Default_Handler,             // DebugMonitor
-  0,                           // Reserved
-  Default_Handler,             // PendSV
-  Default_Handler,             // SysTick
-  Default_Handler,             // IRQ0
-  Default_Handler,             // IRQ1 ...
-};
-
-/* RP2350 Spec - 5.9.5. Minimum Viable Image Metadata
-   As we want to work with ARM Arch, then we use the Minimum Arm IMAGE_DEF
+#include "rp2350.h"
+#include "clocks.h"
+#include "crt0.h"
+#include "uart.h"
+#include "timer.h"
+#include "pio.h"
+#include "pio_programs.h"
+#include "sched.h"
+#include "prof.h"
+#include "boot.h"
+#include "stack.h"
+
+/* Register access (PUT32/GET32) and the atomic register aliases (WRITE_SET,
+   WRITE_CLR, ...) come from ../bsp/rp2350.h, shared with the drivers.
+   On a host build (make host) the accesses go to the RP2350 simulator */
+
+/* The startup code (vector table, image definition and Reset_Handler, which
+   initializes .data/.bss and calls main) is in ../bsp/crt0.c */
+
+/* Tasks and timing
+   Both cores run the task scheduler of ../bsp/sched.c and sleep (wfe) when
+   there is nothing to do. The work is a task that runs to completion and is
+   submitted again by a timer (see ../bsp/timer.c):
+   - lineTask: prints a line and echoes the received characters. It is pinned
+     to core 0, where the UART0 interrupt is enabled
+   The timer keeps an absolute deadline and adds the period to it, so the time
+   spent in the task does not add up as drift.
+   - stackTask: prints the stack high-water marks of both cores every 10s
+     (see ../bsp/stack.h)
+   The LED pattern needs no core at all: a PIO state machine plays it and a
+   DMA channel feeds it the steps in a ring (see ledStart()).
 */
-PicobinBlockItem picoBinBlockItem __attribute__((section(".picobin_block_item"))) = {
-    .word0 = 0xffffded3,    // PICOBIN_BLOCK_MARKER_START (4 byte magic header)
-    .word1 = 0x10210142,    // 0x42 PICOBIN_BLOCK_ITEM_1BS_IMAGE_TYPE, 0x01 word in size, 0x1021 image type exe secure, ARM, RP2350
-    .word2 = 0x000001ff,    // 0x00 pad, 0x0001 size, 0xff(size_type == 1, item_type_ == PICOBIN_BLOCK_ITEM_2BS_LAST)
-    .word3 = 0x00000000,    // loop containing just this block
-    .word4 = 0xab123579,    // PICOBIN_BLOCK_MARKER_END (4 byte magic footer)
-};
-
-void Default_Handler(void)
+static Task lineTask;
+static Timer lineTimer;
+static Task stackTask;
+static Timer stackTimer;
+
+void lineStep(void *context);
+void stackStep(void *context);
+
+#define LED_SM          (0)    // PIO0 state machine of the LED
+#define LED_DMA_CH      (0)    // DMA channel feeding it
+
+/* Profiling (make PROF=1, see ../bsp/prof.h)
+   The probes measure the cycles of the functions below on the core that runs
+   them. Core 1 starts its cycle counter in a task pinned to it, and core 0
+   sends the binary report every second (decode it with tools/profdecode.py).
+   Without PROF=1 the probes are not compiled. */
+PROF_PROBE(configDevice);
+PROF_PROBE(uartTxString);
+PROF_PROBE(lineStep);
+
+#if PROF_ENABLE
+static Task profInitTask;
+static Task profDumpTask;
+static Timer profTimer;
+
+void profInitCore(void *context)
 {
-  while (1)
-  {
-    asm("nop");
-  }
+    (void)context;
+    profInit();
 }
 
-void Reset_Handler(void)
+void profWrite(const uint8_t *data, uint32_t len)
 {
-  uint32_t cpuId = GET32(0xd0000000);
-  if (cpuId == 1)
-  {
-    // Hold Core1 on infinite loop
-    while(1)
-    {
-        asm("nop");
-    }
-  }
-  main();
+    uartWriteAll(0, data, len);
 }
 
-/* Delay Function
-   5 instructions are needed to do a loop. Therefore:
-   5 loops @ 12MHz = 2398 clock cycles per ms.
-*/
-void delay(uint32_t millisec)
+void profDumpStep(void *context)
 {
-    for(uint32_t i = 0; i < millisec * 2398; i++)
-    {
-        asm("nop");
-    }
+    (void)context;
+    profDump(profWrite);
 }
 
-void delay_core1(uint32_t millisec)
+void profSubmit(void *context)
 {
-    for(uint32_t i = 0; i < millisec * 2398; i++)
-    {
-        asm("nop");
-    }
+    schedSubmit(&profDumpTask, profDumpStep, context, 0);
 }
+#endif
 
 /* ConfigDevice Function
    Configures the clock and GPIO
 */
 void configDevice(void)
 {
-    // Setup XOC clock to drive the GPIO (Pico2 board as a ABM8-272-T3 crystal that oscillates at 12MHz)
-    PUT32((0x40048000 + 0),      0x00000aa0);               //  XOC range 1-15MHz (Crystal Oschillator)
-    PUT32((0x40048000 + 0x0c),   0x000000c4);               //  Startup Delay (default = 50,000 cycles aprox.)
-    PUT32((0x40048000 + 0x2000), 0x00FAB000);               //  Enable XOC
-    while (!(GET32(0x40048000 + 4) & ( 1 << 31 )));         //  Wait for XOC stable
-
-    // Configure source clock for components (see datasheer RP2350 Chapter 8. "Clocks")
-    PUT32((0x40010000 + 0x3C), 0 );                         //  CLK SYS CTRL = XOC (for processor, bus frabric & memories)
-    PUT32((0x40010000 + 0x48), ((1 << 11) | ( 4 << 5)));    //  CLK_PERI_CTRL = XOC (for perifery UART and SPI) + Enable
-
-    // De-asserts the reset of UART0
-    PUT32((0x40020000 + WRITE_SET + 0x0), (1 << 26));       // Set UART0 to reset
-    asm("nop");
-    asm("nop");
-    PUT32((0x40020000 + WRITE_CLR + 0x0), (1 << 26));       // De-assert the reset from UART0 
-    while (!(GET32(0x40020000 + 0x08) & (1 << 26)));        // Wait for UART0 to be ready
+    PROF_BEGIN(configDevice);
 
-    // Configure GPIO25 to use function 5 (SIO) to controll the GPIO by software
-    PUT32((0x40028000 + 0xcc), 5);                          // IO GPIO25 uses SIO
-    PUT32((0x40028000 + 0x04), 2);                          // IO GPIO0 uses UART TX
-    PUT32((0x40028000 + 0x0c), 2);                          // IO GPIO1 uses UART RX
+    // Configure the clock tree (see datasheer RP2350 Chapter 8. "Clocks"):
+    // XOSC 12MHz -> PLL_SYS -> clk_sys = clk_peri = CLK_SYS_HZ (for processor, bus fabric, memories, UART and SPI)
+    clocksInit(CLK_SYS_HZ);
+    bootStamp(BOOT_CLOCKS);
 
-    // Enable GPIO out in SIO register
-    PUT32((0xd0000000 + WRITE_SET + 0x038), (1 << 25));     // SIO OE (output enable) for Pin25
+    // Start the 1us time base of both cores (TIMER0 ticking from clk_ref)
+    timerInit();
 
-    // Configure the pad control (new on RP2350)
-    PUT32((0x40038000 + WRITE_CLR + 0x68), (1 << 8));       // Remove GPIO25 pad isolation
-    PUT32((0x40038000 + WRITE_CLR + 0x04), (1 << 8));       // Remove UART0TX pad isolation
-    PUT32((0x40038000 + WRITE_CLR + 0x08), (1 << 8));       // Remove UART0RX pad isolation
-    PUT32((0x40038000 + WRITE_SET + 0x08), (1 << 6));       // Enable UART0RX pad for input
+    // GPIO25 (LED) is driven by the state machine 0 of PIO0 (function 6), which
+    // waits for the first step of the pattern (see ledStart())
+    pioInit(0);
+    pioLedInit(0, LED_SM, 25);
 
-    // Configure UART0
-    //   Baud: For a baud rate of 115200 with UARTCLK = 12MHz then:
-    //   Baud Rate Divisor = 12000000/(16 * 115200) ~= 6.5104
-    PUT32((0x40070000 + 0x24), 6);                                         // UARTIBRD_H: Integer part of the baudrate divisor
-    PUT32((0x40070000 + 0x28), 5104);                                      // UARTFBRD_L: Decimal part of the baudrate divisor
-    PUT32((0x40070000 + 0x2c), (( 0x3 << 5 ) | ( 1 << 4 )));               // UARTLCR_H: Word lenght = 8, FIFO RX/TX enabled
-    PUT32((0x40070000 + 0x30), ((   1 << 9 ) | ( 1 << 8 ) | ( 1 << 0 )));  // UARTCR: UART Enabled, Tx enabled, Rx enabled
-
-    PUT32((0x40018000 + WRITE_SET + 0), (1 << 24));                        // Take PROC1 out of reset
-    while (!(GET32(0x40018000 + 0x0C) & ( 1 << 24 )));                     // Wait until PROC1 is out of reset
+    // UART0 (GPIO0/GPIO1, 115200 8N1) is driven by the interrupt driven driver (see ../bsp/uart.c)
+    uartInit(0, 115200, 0);
+    bootStamp(BOOT_PERIPHERALS);
+    PROF_END(configDevice);
 }
 
 
-/* Transmits Character over UART
-   Writes a character on the UART TX FIFO
-*/
-void uartTxChar(int8_t txData)
-{
-    volatile int8_t myData = txData;
-    while(GET32(0x40070000 + 0x018) & (1 << 5));        // Wait until UART0 FIFO is empty
-    PUT32((0x40070000 + 0x0), myData);                  // UARTDR: Write data to Tx.
-}
-
 /* Transmits string over UART
-   Writes a character on the UART TX FIFO
+   Queues the string on the UART TX buffer, the UART0 interrupt sends it
 */
 void uartTxString(int8_t* txData)
 {
-    while(*txData != '\0')
+    PROF_BEGIN(uartTxString);
+    uint32_t len = 0;
+    while(txData[len] != '\0')
     {
-        uartTxChar(*txData++);
+        len++;
     }
-    uartTxChar('\r');
-    uartTxChar('\n');
+    uartWriteAll(0, (const uint8_t *)txData, len);
+    uartWriteAll(0, (const uint8_t *)"\r\n", 2);
+    PROF_END(uartTxString);
 }
 
-/* Indicates when data is avaiable on UART Rx FIFO 
-*/
-int uartRxDataAvail(void)
+/* Writes the reports of the BSP (boot times, stack watermarks) on UART0 */
+void consoleWrite(const uint8_t *data, uint32_t len)
 {
-    return ((GET32(0x40070000 + 0x018) & (1 << 4)) == 0);   // Wait until UART0 FIFO is no empty
+    uartWriteAll(0, data, len);
 }
 
-/* Receives character over UART
+/* Echoes the characters received by the UART0 interrupt since the last call
 */
-uint8_t uartRxChar(void)
+void uartEcho(void)
 {
-    while(uartRxDataAvail() == 0);                          // Wait until UART0 Rx data is available
-    return((unsigned char)GET32(0x40070000 + 0x0));         // UARTDR: Write data to Tx.
+    uint8_t rxData[32];
+    uint32_t count;
+    while((count = uartRead(0, rxData, sizeof(rxData))) > 0)
+    {
+        uartWriteAll(0, rxData, count);                     // Transmit each received character
+    }
 }
 
-void main_core_1(void)
+/* Starts the LED pattern: on 5ms, off 1ms, on 5ms, off 100ms, forever.
+   Each step is a level and its duration in 100us PIO cycles (pio_programs.h).
+   The DMA channel reads the 4 steps in a 16 byte ring (hence the alignment)
+   whenever the TX FIFO of the state machine has room, and never ends: the
+   LED keeps its timing without interrupts, whatever the cores do. */
+void ledStart(void)
 {
-    while(1)
-    {
-        delay_core1(100);
-        PUT32((0xd0000000 + WRITE_SET + 0x028), (1 << 25));    // xor GPIO (toggle pin)
-        delay_core1(5);
-        PUT32((0xd0000000 + WRITE_SET + 0x028), (1 << 25));    // xor GPIO (toggle pin)
-        delay_core1(1);
-        PUT32((0xd0000000 + WRITE_SET + 0x028), (1 << 25));    // xor GPIO (toggle pin)
-        delay_core1(5);
-        PUT32((0xd0000000 + WRITE_SET + 0x028), (1 << 25));    // xor GPIO (toggle pin)
-    }
+    static const uint32_t pattern[4] __attribute__((aligned(16))) = {
+        PIO_LED_STEP(1, 5000), PIO_LED_STEP(0, 1000), PIO_LED_STEP(1, 5000), PIO_LED_STEP(0, 100000)
+    };
+    pioSmDmaTx(0, LED_SM, LED_DMA_CH, pattern, 4, 4, PIO_DMA_RING(4));
 }
 
-void wait_rx_fifo_data(void)
+/* Prints the next line every 200ms, echoing what was received in between.
+   Nothing is lost while the core sleeps: the UART0 interrupt buffers RX */
+void lineSubmit(void *context)
 {
-        while ( !( GET32(0xd0000050) & 0x00000001 ) )
-        {
-            // wait to get data in Rx-FIFO
-            asm("wfe");
-        }
+    schedSubmit(&lineTask, lineStep, context, 0);
 }
 
-void init_core_1(void)
+void lineStep(void *context)
 {
-    const uint32_t cmdList[6] = { 0, 0, 1, (int)&vectorTable, ((uint32_t)(&__stack_end__) - 0x100), (int)main_core_1 };
- 
-    for(int loop = 0; loop < 2; loop++ )
-    {
-        while( ( GET32( 0xd0000050 ) & 0x01 ) == 1 )  // Loop until Rx FIFO is empty
-        {
-            GET32( ( 0xd0000000 + 0x58 ) );
-        }
-        asm( "sev" );
-    }
+    static unsigned char i = '0';
+    int8_t textString[] = "[ ] Hola Mundo!";
+    PROF_BEGIN(lineStep);
+    uartEcho();
+    textString[1] = i;
+    i = (i < 'Z') ? (i + 1) : '0';
+    uartTxString(textString);
+    PROF_END(lineStep);
+}
 
-    for (uint8_t i = 0; i < 6; i++)
-    {
-        PUT32( ( 0xd0000000 + 0x54 ), cmdList[i] );
-        asm( "sev" );
-        wait_rx_fifo_data();
-        uint32_t response = GET32(0xd0000058);
-    }
+/* The stack high-water marks every 10s, for tools/stackreport.py */
+void stackSubmit(void *context)
+{
+    schedSubmit(&stackTask, stackStep, context, 0);
+}
+
+void stackStep(void *context)
+{
+    (void)context;
+    stackPrint(consoleWrite);
 }
 
 /* -------------
@@ -250,25 +195,31 @@ void init_core_1(void)
 */
 int main( void )
 {
+    // Fast boot: the crystal starts up (about 1ms) while the work that does
+    // not need clk_sys at full speed is done, and nothing waits for a
+    // terminal before the banner. boot.h stamps each phase.
+    clocksStartXosc();
+    crt0RelocateVectors();             // Vector table in SRAM, core 1 gets it in the launch sequence
+    profInit();                        // Cycle counter of core 0, only with PROF=1
+    schedInit();
+    schedLaunchCore1();                // Core 1 runs the scheduler (see ../bsp/multicore.c for the launch sequence)
+    bootStamp(BOOT_CORE1);
     configDevice();
-    init_core_1();
-    delay(1000);
+#if PROF_ENABLE
+    schedSubmit(&profInitTask, profInitCore, 0, 1);
+#endif
     uartTxString((int8_t*)"-= RP2350 MultiCore =-\n\n");
-
-    while(1)
-    {
-        unsigned char i = '0';
-        int8_t textString[] = "[ ] Hola Mundo!";
-        while(i <= 'Z')
-        {
-            textString[1] = i++;
-            uartTxString(textString);
-            delay(200);
-            if (uartRxDataAvail() != 0)
-            {
-              uartTxChar(uartRxChar());    // Transmit each received character
-            }
-        }
-    }
+    bootStamp(BOOT_FIRST_BYTE);
+    bootPrint(consoleWrite);
+    stackPrint(consoleWrite);          // A stack overflow of the previous boot, if any
+
+    uint64_t now = timerGetUs();
+    timerStart(&lineTimer, now, 200000, lineSubmit, 0);         // Periodic timer: every 200ms, no drift
+    timerStart(&stackTimer, now + 10000000, 10000000, stackSubmit, 0);
+    ledStart();
+#if PROF_ENABLE
+    timerStart(&profTimer, now + 1000000, 1000000, profSubmit, 0);
+#endif
+    schedRun();                        // Core 0 runs the tasks too, it never returns
     return 0;
 }
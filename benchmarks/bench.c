@@ -0,0 +1,90 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "clocks.h"
+#include "uart.h"
+#include "crt0.h"
+#include "text.h"
+#include "bench.h"
+
+volatile uint32_t benchIrqCycles;
+
+/* Every IRQ goes through benchIrq() (in SRAM, as the drivers' handlers):
+   calls the handler of the linked vector table and accounts its cycles */
+static void TIME_CRITICAL(benchIrq)(void)
+{
+    uint32_t start = benchCycles();
+    vectorTable[cpuGetIpsr()]();
+    benchIrqCycles += benchCycles() - start;
+}
+
+void benchPrint(const char *text)
+{
+    uint32_t len = 0;
+    while (text[len] != '\0')
+    {
+        len++;
+    }
+    uartWriteAll(0, (const uint8_t *)text, len);
+}
+
+void benchInit(const char *name)
+{
+    clocksInit(CLK_SYS_HZ);
+    uartInit(0, 115200, 0);
+
+    cpuCycleCounterStart();
+    benchIrqCycles = 0;
+
+    vectors_t *vectors = crt0RelocateVectors();
+    for (uint32_t i = 16; i < CRT0_VECTORS; i++)
+    {
+        vectors[i] = benchIrq;                                             // Take the interrupts through benchIrq
+    }
+
+    Crt0BootStats boot;
+    crt0GetBootStats(&boot);
+    benchPrint("-= ");
+    benchPrint(name);
+    benchPrint(" =-\r\n");
+    benchResult("boot .time_critical copy", boot.timeCriticalBytes, "bytes");
+    benchResult("boot .time_critical copy", boot.timeCriticalCycles, "cycles");
+    benchResult("boot .data copy", boot.dataBytes, "bytes");
+    benchResult("boot .data copy", boot.dataCycles, "cycles");
+    benchResult("boot .bss zero", boot.bssBytes, "bytes");
+    benchResult("boot .bss zero", boot.bssCycles, "cycles");
+}
+
+void benchPrintValue(uint32_t value, uint32_t width)
+{
+    char digits[TEXT_VALUE_MAX];
+    uint32_t len = textFormatValue(digits, value, 10, width);
+    uartWriteAll(0, (const uint8_t *)digits, len);
+}
+
+void benchResult(const char *name, uint32_t value, const char *unit)
+{
+    benchPrint(name);
+    benchPrint(": ");
+    benchPrintValue(value, 0);
+    benchPrint(" ");
+    benchPrint(unit);
+    benchPrint("\r\n");
+}
+
+void benchDone(void)
+{
+    benchPrint("done\r\n");
+    while (uartTxFree(0) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();
+    }
+    while (1)
+    {
+        cpuWfi();
+    }
+}
@@ -0,0 +1,49 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Benchmark support
+   bench.c provides the cycle counter (cpuCycles, see cpu.h) and the printing
+   of the results over UART0 (115200 8N1, interrupt driven driver). The
+   startup code is the one of the examples (../bsp/crt0.c).
+   benchInit() points the cores to the copy of the vector table in RAM
+   (crt0RelocateVectors) and routes every interrupt through a wrapper that
+   adds the cycles of the handler to benchIrqCycles, so a benchmark can
+   account the CPU time spent in interrupts.
+   Every benchmark provides main().
+*/
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "rp2350.h"
+#include "cpu.h"
+
+/* Cycles spent in the interrupt handlers (exception entry/exit excluded) */
+extern volatile uint32_t benchIrqCycles;
+
+/* Configures the clocks (CLK_SYS_HZ), UART0 and the interrupt accounting,
+   starts the cycle counter and prints the boot cost measured by crt0 */
+void benchInit(const char *name);
+
+static inline uint32_t benchCycles(void)
+{
+    return cpuCycles();
+}
+
+/* Prints text as is */
+void benchPrint(const char *text);
+
+/* Prints value in decimal, right aligned on width characters (at most
+   TEXT_VALUE_MAX, see text.h) */
+void benchPrintValue(uint32_t value, uint32_t width);
+
+/* Prints "name: value unit" on its own line */
+void benchResult(const char *name, uint32_t value, const char *unit);
+
+/* Waits until the results are sent and sleeps forever */
+void benchDone(void);
+
+int main(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,202 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Framing benchmark: the COBS + CRC-16 frames of ../bsp/frame.c
+   - self-test: the CRC check value, frames of 0 to FRAME_MAX_PAYLOAD bytes
+     (zeros, 0xff, counting bytes) encoded and decoded back, a run of frames
+     with some of them dropped (lost count), a damaged frame (CRC error) and
+     a frame longer than the buffer (overflow). Each line prints its number
+     of failures.
+   - overhead: bytes on the wire for a 16 byte and a FRAME_MAX_PAYLOAD
+     payload.
+   - throughput: 256 frames of 64 bytes sent on UART1 (GPIO4, RTS/CTS on
+     GPIO6/GPIO7) at 3 Mbaud: payload KB/s and frames/s measured with
+     TIMER0, the CPU cycles per frame spent encoding (frameBegin/Append/End)
+     and in the UART1 interrupt. The encoding is code only: 0 cycles on the
+     simulator.
+   On the simulator the frames go to SIM_UART1_OUT (stdout by default), so
+   tools/framelink.py can decode them and count the lost ones:
+       SIM_UART1_OUT=frames.bin make BENCH=frame hostrun
+       ../tools/framelink.py decode frames.bin --stats
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "timer.h"
+#include "uart.h"
+#include "frame.h"
+#include "bench.h"
+
+#define BENCH_UART      (1)
+#define BENCH_BAUD      (3000000)
+#define BENCH_FRAMES    (256)
+#define BENCH_PAYLOAD   (64)
+#define BENCH_TYPE      (0x10)
+
+static FrameTx benchTx;
+static FrameRx benchRx;
+static uint8_t benchData[FRAME_MAX_PAYLOAD];
+
+/* Gives an encoded frame to the decoder. Returns 1 when it comes back with
+   the same type and payload */
+static int benchDecode(const uint8_t *encoded, uint32_t len, uint8_t type, const uint8_t *payload, uint32_t size)
+{
+    Frame frame;
+    int valid = 0;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        valid = frameRxByte(&benchRx, encoded[i], &frame);
+    }
+    if (!valid || (frame.type != type) || (frame.len != size))
+    {
+        return 0;
+    }
+    for (uint32_t i = 0; i < size; i++)
+    {
+        if (frame.payload[i] != payload[i])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static uint32_t benchEncode(uint8_t type, const uint8_t *payload, uint32_t size)
+{
+    frameBegin(&benchTx, type);
+    frameAppend(&benchTx, payload, size);
+    return frameEnd(&benchTx);
+}
+
+static uint32_t benchSelfTestRoundTrip(void)
+{
+    uint32_t failures = 0;
+    frameTxInit(&benchTx);
+    frameRxInit(&benchRx);
+    for (uint32_t pattern = 0; pattern < 3; pattern++)
+    {
+        for (uint32_t i = 0; i < FRAME_MAX_PAYLOAD; i++)
+        {
+            benchData[i] = (pattern == 0) ? 0 : (pattern == 1) ? 0xff : (uint8_t)i;
+        }
+        for (uint32_t size = 0; size <= FRAME_MAX_PAYLOAD; size++)
+        {
+            uint32_t len = benchEncode((uint8_t)size, benchData, size);
+            for (uint32_t i = 0; i < len - 1; i++)
+            {
+                failures += (benchTx.buf[i] == 0);                         // Only the delimiter is a zero
+            }
+            failures += !benchDecode(benchTx.buf, len, (uint8_t)size, benchData, size);
+        }
+    }
+    failures += (benchRx.stats.lost != 0) || (benchRx.stats.crcErrors != 0);
+    failures += (frameAppend(&benchTx, benchData, FRAME_MAX_PAYLOAD + 1) == 0);
+    return failures;
+}
+
+static uint32_t benchSelfTestErrors(void)
+{
+    uint32_t failures = 0;
+    uint32_t dropped = 0;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        benchData[i] = (uint8_t)(i + 1);
+    }
+    frameTxInit(&benchTx);
+    frameRxInit(&benchRx);
+    for (uint32_t n = 0; n < 300; n++)                                     // Sequence numbers wrap at 256
+    {
+        benchData[0] = (uint8_t)n;
+        uint32_t len = benchEncode(BENCH_TYPE, benchData, 8);
+        if ((n % 7) == 3)
+        {
+            dropped++;
+            continue;
+        }
+        failures += !benchDecode(benchTx.buf, len, BENCH_TYPE, benchData, 8);
+    }
+    failures += (benchRx.stats.lost != dropped);
+
+    // A damaged frame is dropped, the next one counts it as lost
+    uint32_t len = benchEncode(BENCH_TYPE, benchData, 8);
+    benchTx.buf[4] ^= 0x80;                                                // A payload byte, never 0
+    failures += benchDecode(benchTx.buf, len, BENCH_TYPE, benchData, 8);
+    len = benchEncode(BENCH_TYPE, benchData, 8);
+    failures += !benchDecode(benchTx.buf, len, BENCH_TYPE, benchData, 8);
+    failures += (benchRx.stats.crcErrors != 1) || (benchRx.stats.lost != dropped + 1);
+
+    // Garbage longer than a frame, then a valid frame
+    for (uint32_t i = 0; i < FRAME_BUF_SIZE + 10; i++)
+    {
+        Frame frame;
+        failures += frameRxByte(&benchRx, (uint8_t)(i | 1), &frame);
+    }
+    len = benchEncode(BENCH_TYPE, benchData, 8);
+    failures += benchDecode(benchTx.buf, len, BENCH_TYPE, benchData, 8);   // The delimiter only ends the garbage
+    len = benchEncode(BENCH_TYPE, benchData, 8);
+    failures += !benchDecode(benchTx.buf, len, BENCH_TYPE, benchData, 8);
+    failures += (benchRx.stats.overflows != 1);
+    return failures;
+}
+
+int main(void)
+{
+    benchInit("Framing benchmark (COBS + CRC-16)");
+    timerInit();
+
+    benchResult("self-test CRC-16 check", (frameCrc16(0xffff, (const uint8_t *)"123456789", 9) != 0x29b1), "failures");
+    benchResult("self-test round trip", benchSelfTestRoundTrip(), "failures");
+    benchResult("self-test loss and errors", benchSelfTestErrors(), "failures");
+
+    frameTxInit(&benchTx);
+    benchResult("16 byte payload", benchEncode(BENCH_TYPE, benchData, 16), "bytes framed");
+    benchResult("max payload", FRAME_MAX_PAYLOAD, "bytes");
+    benchResult("  framed", benchEncode(BENCH_TYPE, benchData, FRAME_MAX_PAYLOAD), "bytes");
+
+    // Telemetry: frame number, time stamp and a pattern with zeros
+    for (uint32_t i = 0; i < BENCH_PAYLOAD; i++)
+    {
+        benchData[i] = (uint8_t)(i * 37);
+    }
+    uartInit(BENCH_UART, BENCH_BAUD, UART_FLOW_RTS_CTS);
+    frameTxInit(&benchTx);
+    while (uartTxFree(0) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();                                                          // No UART0 interrupt during the measure
+    }
+    uint32_t irqCycles = benchIrqCycles;
+    uint32_t encodeCycles = 0;
+    uint64_t start = timerGetUs();
+    for (uint32_t n = 0; n < BENCH_FRAMES; n++)
+    {
+        uint64_t now = timerGetUs();
+        benchData[0] = (uint8_t)n;
+        benchData[1] = (uint8_t)(n >> 8);
+        benchData[4] = (uint8_t)now;
+        benchData[5] = (uint8_t)(now >> 8);
+        benchData[6] = (uint8_t)(now >> 16);
+        benchData[7] = (uint8_t)(now >> 24);
+        uint32_t cycles = benchCycles();
+        uint32_t len = benchEncode(BENCH_TYPE, benchData, BENCH_PAYLOAD);
+        encodeCycles += benchCycles() - cycles;
+        uartWriteAll(BENCH_UART, benchTx.buf, len);
+    }
+    while (uartTxFree(BENCH_UART) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();                                                          // Sleep until the TX interrupt empties the buffer
+    }
+    while (GET32(UART_FR(BENCH_UART)) & UART_FR_BUSY);                     // Last characters of the FIFO
+    uint32_t us = (uint32_t)(timerGetUs() - start);
+    irqCycles = benchIrqCycles - irqCycles;
+    us = us ? us : 1;
+
+    benchResult("UART1", BENCH_BAUD, "baud");
+    benchResult("  payload", (uint32_t)(((uint64_t)BENCH_FRAMES * BENCH_PAYLOAD * 1000000) / us / 1024), "KB/s");
+    benchResult("  frames", (uint32_t)(((uint64_t)BENCH_FRAMES * 1000000) / us), "frames/s");
+    benchResult("  encode", encodeCycles / BENCH_FRAMES, "cycles/frame");
+    benchResult("  interrupt", irqCycles / BENCH_FRAMES, "cycles/frame");
+
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,173 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Inter-core benchmark: moving data from core 0 to core 1
+   - FIFO:    raw 32-bit words pushed through the SIO FIFO (FIFO_WR 0xd0000054,
+     FIFO_RD 0xd0000058), as init_core_1 of 03_MultiCore does
+   - channel: messages through the SPSC ring of ../bsp/channel.c, with the
+     SIO FIFO used as a doorbell only
+   For each one: the time and the core 0 cycles to move 1 KB (acknowledged by
+   core 1 with the sum of the data), and the round trip of a single word or
+   a 4 byte message (ping-pong between the cores).
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "timer.h"
+#include "multicore.h"
+#include "channel.h"
+#include "bench.h"
+
+#define BENCH_WORDS     (256)           // 1 KB
+#define BENCH_MSG_LEN   (64)            // bytes per message
+#define BENCH_BATCH     (4)             // messages per channelSendBatch
+#define BENCH_ROUNDS    (1000)          // ping-pong round trips
+
+static uint32_t benchData[BENCH_WORDS];
+static uint32_t ring01[512];            // core 0 -> core 1, holds the whole KB
+static uint32_t ring10[64];             // core 1 -> core 0
+static Channel toCore1;
+static Channel toCore0;
+
+static void benchSum(void *context, const void *data, uint32_t len)
+{
+    const uint32_t *words = data;
+    for (uint32_t i = 0; i < len / 4; i++)
+    {
+        *(uint32_t *)context += words[i];
+    }
+}
+
+/* Core 1 follows the same sequence as core 0 */
+static void benchCore1(void)
+{
+    // FIFO: 1 KB then ping-pong
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < BENCH_WORDS; i++)
+    {
+        sum += multicoreFifoPop();
+    }
+    multicoreFifoPush(sum);
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++)
+    {
+        multicoreFifoPush(multicoreFifoPop());
+    }
+
+    // Channel: 1 KB then ping-pong
+    sum = 0;
+    uint32_t messages = 0;
+    while (messages < (BENCH_WORDS * 4) / BENCH_MSG_LEN)
+    {
+        channelWait(&toCore1);
+        messages += channelReceiveBatch(&toCore1, benchSum, &sum, BENCH_BATCH);
+    }
+    channelSend(&toCore0, &sum, sizeof(sum));
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++)
+    {
+        uint32_t ping;
+        channelWait(&toCore1);
+        channelReceive(&toCore1, &ping, sizeof(ping));
+        channelSend(&toCore0, &ping, sizeof(ping));
+    }
+    while (1)
+    {
+        cpuWfe();
+    }
+}
+
+/* Prints the result of a test: elapsed time and core 0 cycles */
+static void benchReport(const char *name, uint32_t us, uint32_t cycles, uint32_t rounds)
+{
+    benchPrint(name);
+    benchPrint("\r\n");
+    if (rounds)
+    {
+        benchResult("  round trip", (us * 1000) / rounds, "ns");
+        benchResult("  core 0 cycles", cycles / rounds, "cycles/round trip");
+    }
+    else
+    {
+        benchResult("  1 KB", us, "us");
+        benchResult("  core 0 cycles", cycles, "cycles/KB");
+    }
+}
+
+int main(void)
+{
+    benchInit("Inter-core benchmark");
+    timerInit();
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < BENCH_WORDS; i++)
+    {
+        benchData[i] = i * 0x01010101u;
+        expected += benchData[i];
+    }
+    channelInit(&toCore1, ring01, sizeof(ring01) / 4);
+    channelInit(&toCore0, ring10, sizeof(ring10) / 4);
+    multicoreLaunchCore1(benchCore1);
+
+    // FIFO: every word waits for room in the 8 words FIFO
+    uint32_t start = benchCycles();
+    uint64_t t0 = timerGetUs();
+    for (uint32_t i = 0; i < BENCH_WORDS; i++)
+    {
+        multicoreFifoPush(benchData[i]);
+    }
+    uint32_t fifoSum = multicoreFifoPop();
+    uint32_t fifoUs = (uint32_t)(timerGetUs() - t0);
+    uint32_t fifoCycles = benchCycles() - start;
+
+    start = benchCycles();
+    t0 = timerGetUs();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++)
+    {
+        multicoreFifoPush(r);
+        multicoreFifoPop();
+    }
+    uint32_t fifoPingUs = (uint32_t)(timerGetUs() - t0);
+    uint32_t fifoPingCycles = benchCycles() - start;
+
+    // Channel: batches of messages, one head update and doorbell per batch
+    ChannelMsg batch[BENCH_BATCH];
+    uint32_t chanSum = 0;
+    start = benchCycles();
+    t0 = timerGetUs();
+    for (uint32_t msg = 0; msg < (BENCH_WORDS * 4) / BENCH_MSG_LEN; msg += BENCH_BATCH)
+    {
+        for (uint32_t i = 0; i < BENCH_BATCH; i++)
+        {
+            batch[i].data = (const uint8_t *)benchData + (msg + i) * BENCH_MSG_LEN;
+            batch[i].len = BENCH_MSG_LEN;
+        }
+        channelSendBatch(&toCore1, batch, BENCH_BATCH);
+    }
+    channelWait(&toCore0);
+    channelReceive(&toCore0, &chanSum, sizeof(chanSum));
+    uint32_t chanUs = (uint32_t)(timerGetUs() - t0);
+    uint32_t chanCycles = benchCycles() - start;
+
+    start = benchCycles();
+    t0 = timerGetUs();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++)
+    {
+        uint32_t pong;
+        channelSend(&toCore1, &r, sizeof(r));
+        channelWait(&toCore0);
+        channelReceive(&toCore0, &pong, sizeof(pong));
+    }
+    uint32_t chanPingUs = (uint32_t)(timerGetUs() - t0);
+    uint32_t chanPingCycles = benchCycles() - start;
+
+    ChannelStats stats;
+    channelGetStats(&toCore1, &stats);
+    benchReport("FIFO words", fifoUs, fifoCycles, 0);
+    benchReport("FIFO ping-pong", fifoPingUs, fifoPingCycles, BENCH_ROUNDS);
+    benchReport("channel 64 byte messages", chanUs, chanCycles, 0);
+    benchReport("channel ping-pong", chanPingUs, chanPingCycles, BENCH_ROUNDS);
+    benchResult("checksum", (fifoSum != expected) + (chanSum != expected), "errors");
+    benchResult("channel messages", stats.sent, "sent");
+    benchResult("channel doorbells", stats.doorbells, "sent");
+    benchDone();
+    return 0;
+}
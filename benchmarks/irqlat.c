@@ -0,0 +1,256 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Interrupt latency benchmark: the cycles of the exception entry and return
+   of the Cortex-M33, measured with the cycle counter from inside the
+   handlers. Two spare IRQs raised by software (SPARE_IRQ_0 and 1, NVIC_ISPR)
+   and the TIMER0 ALARM2 interrupt (TIMER0_IRQ_2, not used by timer.c):
+   - entry:   from the pending write to the first instruction of the handler
+   - exit:    from the last instruction of the handler back to the thread
+   - tail:    two IRQs pending at once, from the end of the first handler to
+              the start of the second one (tail-chaining)
+   - preempt: a handler raises a more urgent IRQ: from the pending write to
+              the nested handler
+   - resume:  from the end of the nested handler back to the preempted one
+   - alarm:   from the last cycle counter read of a polling loop to the
+              alarm handler
+   Every figure is the best of BENCH_RUNS, minus the cost of a cycle counter
+   read. The handlers are linked twice, in flash and in SRAM (TIME_CRITICAL),
+   and put in the SRAM vector table without the accounting wrapper of
+   bench.c. The table has a line per handler copy and per clk_sys: the
+   flash copy depends on the XIP cache and the QSPI clock, the SRAM copy
+   should not.
+   Then BASEPRI and the priority grouping: an IRQ at the BASEPRI level must
+   wait, a more urgent one must not, and with PRIGROUP 7 the more urgent IRQ
+   no longer preempts.
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "nvic.h"
+#include "clocks.h"
+#include "timer.h"
+#include "uart.h"
+#include "bench.h"
+
+#ifdef __riscv
+#error "irqlat measures the NVIC of the Cortex-M33 (BASEPRI, PRIGROUP): Arm only"
+#endif
+
+#define BENCH_RUNS      (16)
+#define BENCH_IRQ_A     (SPARE_IRQ_0)
+#define BENCH_IRQ_B     (SPARE_IRQ_0 + 1)
+#define BENCH_IRQ_ALARM (TIMER0_IRQ_2)
+#define BENCH_ALARM     (2)
+#define BENCH_PRIO_LOW  (0x80)
+#define BENCH_PRIO_HIGH (0x40)
+
+#define TIMER_ALARM2    (TIMER0_BASE + 0x18)
+#define TIMER_TIMERAWL  (TIMER0_BASE + 0x28)
+#define TIMER_INTR      (TIMER0_BASE + 0x3c)
+#define TIMER_INTE      (TIMER0_BASE + 0x40)
+
+typedef struct {
+    uint32_t entry;
+    uint32_t exit;
+    uint32_t tail;
+    uint32_t preempt;
+    uint32_t resume;
+    uint32_t alarm;
+} BenchLatency;
+
+static volatile uint32_t benchPreempt;  // handler A raises IRQ B
+static volatile uint32_t benchEntryA;
+static volatile uint32_t benchExitA;
+static volatile uint32_t benchPendB;
+static volatile uint32_t benchResumeA;
+static volatile uint32_t benchEntryB;
+static volatile uint32_t benchExitB;
+static uint32_t benchOverhead;          // cycles of a cycle counter read
+
+/* Bodies of the handlers, so that both copies only differ by their address */
+#define BENCH_HANDLER_A                                                     \
+    benchEntryA = cpuCycles();                                              \
+    if (benchPreempt)                                                       \
+    {                                                                       \
+        benchPendB = cpuCycles();                                           \
+        nvicSetPending(BENCH_IRQ_B);                                        \
+        benchResumeA = cpuCycles();                                         \
+    }                                                                       \
+    benchExitA = cpuCycles()
+
+#define BENCH_HANDLER_B                                                     \
+    benchEntryB = cpuCycles();                                              \
+    benchExitB = cpuCycles()
+
+#define BENCH_HANDLER_ALARM                                                 \
+    benchEntryA = cpuCycles();                                              \
+    PUT32(TIMER_INTR, (1u << BENCH_ALARM));                                 \
+    benchExitA = cpuCycles()
+
+/* noipa: -O2 must not merge them with the SRAM copies */
+static __attribute__((noipa)) void benchFlashA(void) { BENCH_HANDLER_A; }
+static __attribute__((noipa)) void benchFlashB(void) { BENCH_HANDLER_B; }
+static __attribute__((noipa)) void benchFlashAlarm(void) { BENCH_HANDLER_ALARM; }
+static void TIME_CRITICAL(benchSramA)(void) { BENCH_HANDLER_A; }
+static void TIME_CRITICAL(benchSramB)(void) { BENCH_HANDLER_B; }
+static void TIME_CRITICAL(benchSramAlarm)(void) { BENCH_HANDLER_ALARM; }
+
+static uint32_t benchMin(uint32_t min, uint32_t cycles)
+{
+    cycles -= benchOverhead;
+    return (cycles < min) ? cycles : min;
+}
+
+/* Sets the handlers in the SRAM vector table and measures them */
+static void benchMeasure(vectors_t a, vectors_t b, vectors_t alarm, BenchLatency *latency)
+{
+    vectors_t *vectors = crt0RelocateVectors();
+    vectors[16 + BENCH_IRQ_A] = a;
+    vectors[16 + BENCH_IRQ_B] = b;
+    vectors[16 + BENCH_IRQ_ALARM] = alarm;
+    cpuDsb();
+
+    latency->entry = latency->exit = latency->tail = 0xffffffff;
+    latency->preempt = latency->resume = latency->alarm = 0xffffffff;
+    for (uint32_t run = 0; run < BENCH_RUNS; run++)
+    {
+        // Entry and exit
+        benchPreempt = 0;
+        uint32_t start = cpuCycles();
+        nvicSetPending(BENCH_IRQ_A);
+        cpuIsb();
+        uint32_t back = cpuCycles();
+        latency->entry = benchMin(latency->entry, benchEntryA - start);
+        latency->exit = benchMin(latency->exit, back - benchExitA);
+
+        // Tail-chaining: both pending when the interrupts are unmasked
+        uint32_t primask = cpuIrqSave();
+        nvicSetPending(BENCH_IRQ_A);
+        nvicSetPending(BENCH_IRQ_B);
+        cpuIrqRestore(primask);
+        cpuIsb();
+        latency->tail = benchMin(latency->tail, benchEntryB - benchExitA);
+
+        // Preemption of A by the more urgent B
+        nvicSetPriority(BENCH_IRQ_B, BENCH_PRIO_HIGH);
+        benchPreempt = 1;
+        nvicSetPending(BENCH_IRQ_A);
+        cpuIsb();
+        benchPreempt = 0;
+        nvicSetPriority(BENCH_IRQ_B, BENCH_PRIO_LOW);
+        latency->preempt = benchMin(latency->preempt, benchEntryB - benchPendB);
+        latency->resume = benchMin(latency->resume, benchResumeA - benchExitB);
+
+        // Alarm, a few microseconds ahead, while polling the cycle counter
+        uint32_t last;
+        benchEntryA = 0;
+        PUT32(TIMER_ALARM2, (GET32(TIMER_TIMERAWL) + 5));                  // Writing the alarm arms it
+        do
+        {
+            last = cpuCycles();
+        } while (benchEntryA == 0);
+        latency->alarm = benchMin(latency->alarm, benchEntryA - last);
+    }
+}
+
+static void benchRow(uint32_t mhz, const char *copy, const BenchLatency *latency)
+{
+    benchPrintValue(mhz, 7);
+    benchPrint(copy);
+    benchPrintValue(latency->entry, 8);
+    benchPrintValue(latency->exit, 8);
+    benchPrintValue(latency->tail, 8);
+    benchPrintValue(latency->preempt, 8);
+    benchPrintValue(latency->resume, 8);
+    benchPrintValue(latency->alarm, 8);
+    benchPrint("\r\n");
+}
+
+/* Waits for UART0 to send everything before clk_peri changes */
+static void benchUartFlush(void)
+{
+    while (uartTxFree(0) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();
+    }
+    while (GET32(UART_FR(0)) & UART_FR_BUSY);                              // The FIFO and the last character
+}
+
+/* Raises A with the BASEPRI and PRIGROUP given, then B from A: returns a bit
+   per handler that ran before the thread went on (1: A, 2: B), 4 when B
+   preempted A */
+static uint32_t benchMasking(uint32_t basepri, uint32_t prigroup, uint32_t irq)
+{
+    nvicSetPriorityGrouping(prigroup);
+    nvicSetPriority(BENCH_IRQ_A, BENCH_PRIO_LOW);
+    nvicSetPriority(BENCH_IRQ_B, BENCH_PRIO_HIGH);
+    benchEntryA = benchEntryB = benchResumeA = 0;
+    benchPreempt = (irq == BENCH_IRQ_A);
+    cpuSetBasepri(basepri);
+    nvicSetPending(irq);
+    cpuIsb();
+    uint32_t ran = (benchEntryA != 0) | ((benchEntryB != 0) << 1);
+    ran |= ((benchEntryB != 0) && (benchResumeA != 0) && ((int32_t)(benchResumeA - benchEntryB) > 0)) << 2;
+    cpuSetBasepri(0);                                                      // Lets the held one run
+    cpuIsb();
+    benchPreempt = 0;
+    nvicSetPriorityGrouping(0);
+    nvicSetPriority(BENCH_IRQ_B, BENCH_PRIO_LOW);
+    return ran;
+}
+
+int main(void)
+{
+    static const uint32_t clocks[] = { CLK_SYS_HZ, 100000000, 48000000 };
+
+    benchInit("Interrupt latency benchmark");
+    timerInit();
+
+    uint32_t start = cpuCycles();
+    benchOverhead = cpuCycles() - start;
+    benchResult("cycle counter read", benchOverhead, "cycles");
+
+    nvicSetPriority(BENCH_IRQ_A, BENCH_PRIO_LOW);
+    nvicSetPriority(BENCH_IRQ_B, BENCH_PRIO_LOW);
+    nvicSetPriority(BENCH_IRQ_ALARM, BENCH_PRIO_LOW);
+    nvicEnableIrq(BENCH_IRQ_A);
+    nvicEnableIrq(BENCH_IRQ_B);
+    PUT32((TIMER_INTE + WRITE_SET), (1u << BENCH_ALARM));
+    nvicEnableIrq(BENCH_IRQ_ALARM);
+
+    benchPrint("clk_sys handler    entry    exit    tail preempt  resume   alarm (cycles)\r\n");
+    for (uint32_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++)
+    {
+        benchUartFlush();
+        if (clocksInit(clocks[c]) != 0)
+        {
+            continue;
+        }
+        uartInit(0, 115200, 0);
+
+        BenchLatency flash;
+        BenchLatency sram;
+        benchMeasure(benchFlashA, benchFlashB, benchFlashAlarm, &flash);
+        benchMeasure(benchSramA, benchSramB, benchSramAlarm, &sram);
+        benchRow(clocks[c] / 1000000, "   flash ", &flash);
+        benchRow(clocks[c] / 1000000, "   SRAM  ", &sram);
+    }
+    benchUartFlush();
+    clocksInit(CLK_SYS_HZ);
+    uartInit(0, 115200, 0);
+
+    // Masking, with the SRAM handlers still in place
+    benchResult("basepri 0x80, IRQ at 0x80 ran", benchMasking(BENCH_PRIO_LOW, 0, BENCH_IRQ_A) & 1, "(0: held)");
+    benchResult("basepri 0x80, IRQ at 0x40 ran", (benchMasking(BENCH_PRIO_LOW, 0, BENCH_IRQ_B) >> 1) & 1, "(1: taken)");
+    benchResult("prigroup 0, 0x40 preempts 0x80", (benchMasking(0, 0, BENCH_IRQ_A) >> 2) & 1, "(1: preempted)");
+    benchResult("prigroup 7, 0x40 preempts 0x80", (benchMasking(0, 7, BENCH_IRQ_A) >> 2) & 1, "(0: one group)");
+
+    nvicDisableIrq(BENCH_IRQ_A);
+    nvicDisableIrq(BENCH_IRQ_B);
+    nvicDisableIrq(BENCH_IRQ_ALARM);
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,216 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Kernel benchmark: the same portable kernels built for both cores of the
+   RP2350, to compare Cortex-M33 (make BENCH=kernels) and Hazard3
+   (make BENCH=kernels ISA=riscv) on the kind of code a workload runs:
+   - crc32: bitwise CRC-32 of 1 KB (shifts, xor, a branch per bit)
+   - fir: 16 taps Q15 FIR filter over 256 samples (multiply-accumulate)
+   - bits: popcount, count leading zeros and rotate of 256 words (a single
+     instruction each with Zbb, a libgcc call for the popcount on Arm)
+   - sort: insertion sort of 128 words (loads, compares, branches)
+   - matmul: 8x8 matrix product of 32-bit integers (indexed loads)
+   - divide: 256 32-bit divisions and remainders (hardware divider of both)
+   Each kernel is TIME_CRITICAL (SRAM, no XIP cache effect) and runs once to
+   warm up, then once measured with the interrupts disabled. It prints its
+   cycles and a check value, which must be the same on both ISAs (and on
+   the simulator, where the code costs no cycles). The code size of every
+   kernel is in the size report of each build, tools/benchcompare.py puts
+   the cycles of the two side by side (see README.md).
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "bench.h"
+
+#define KERNEL_BYTES    (1024)
+#define KERNEL_SAMPLES  (256)
+#define KERNEL_TAPS     (16)
+#define KERNEL_SORT     (128)
+#define KERNEL_MATRIX   (8)
+
+static uint8_t kernelData[KERNEL_BYTES] __attribute__((aligned(4)));
+static int16_t kernelSamples[KERNEL_SAMPLES + KERNEL_TAPS];
+static int16_t kernelFiltered[KERNEL_SAMPLES];
+static uint32_t kernelWords[KERNEL_SORT];
+static int32_t kernelA[KERNEL_MATRIX][KERNEL_MATRIX];
+static int32_t kernelB[KERNEL_MATRIX][KERNEL_MATRIX];
+static int32_t kernelC[KERNEL_MATRIX][KERNEL_MATRIX];
+
+/* Low pass, Q15, sum 32768 */
+static const int16_t kernelTaps[KERNEL_TAPS] = {
+    -211, -398, -292, 474, 1946, 3781, 5336, 5748,
+    5748, 5336, 3781, 1946, 474, -292, -398, -211,
+};
+
+static uint32_t kernelRandom(uint32_t *state)
+{
+    // xorshift32
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint32_t TIME_CRITICAL(kernelCrc32)(const uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xffffffff;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xedb88320) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t TIME_CRITICAL(kernelFir)(const int16_t *in, int16_t *out, uint32_t count)
+{
+    uint32_t check = 0;
+    for (uint32_t n = 0; n < count; n++)
+    {
+        int32_t acc = 0;
+        for (uint32_t k = 0; k < KERNEL_TAPS; k++)
+        {
+            acc += (int32_t)in[n + k] * kernelTaps[k];
+        }
+        out[n] = (int16_t)(acc >> 15);
+        check += (uint16_t)out[n];
+    }
+    return check;
+}
+
+static uint32_t TIME_CRITICAL(kernelBits)(const uint32_t *words, uint32_t count)
+{
+    uint32_t check = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t x = words[i];
+        check += (uint32_t)__builtin_popcount(x);
+        check += (uint32_t)__builtin_clz(x | 1);
+        check ^= (x << 7) | (x >> 25);
+    }
+    return check;
+}
+
+static uint32_t TIME_CRITICAL(kernelSort)(uint32_t *words, uint32_t count)
+{
+    for (uint32_t i = 1; i < count; i++)
+    {
+        uint32_t value = words[i];
+        uint32_t j = i;
+        while ((j > 0) && (words[j - 1] > value))
+        {
+            words[j] = words[j - 1];
+            j--;
+        }
+        words[j] = value;
+    }
+    return words[0] ^ words[count / 2] ^ words[count - 1];
+}
+
+static uint32_t TIME_CRITICAL(kernelMatmul)(void)
+{
+    uint32_t check = 0;
+    for (uint32_t i = 0; i < KERNEL_MATRIX; i++)
+    {
+        for (uint32_t j = 0; j < KERNEL_MATRIX; j++)
+        {
+            int32_t sum = 0;
+            for (uint32_t k = 0; k < KERNEL_MATRIX; k++)
+            {
+                sum += kernelA[i][k] * kernelB[k][j];
+            }
+            kernelC[i][j] = sum;
+            check += (uint32_t)sum;
+        }
+    }
+    return check;
+}
+
+static uint32_t TIME_CRITICAL(kernelDivide)(const uint32_t *words, uint32_t count)
+{
+    uint32_t check = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t divisor = (words[(i + 1) % count] >> 20) | 1;
+        check += (words[i] / divisor) ^ (words[i] % divisor);
+    }
+    return check;
+}
+
+/* Fills the inputs again (the sort works in place) */
+static void kernelFill(void)
+{
+    uint32_t state = 0x12345678;
+    for (uint32_t i = 0; i < KERNEL_BYTES; i++)
+    {
+        kernelData[i] = (uint8_t)kernelRandom(&state);
+    }
+    for (uint32_t i = 0; i < (KERNEL_SAMPLES + KERNEL_TAPS); i++)
+    {
+        kernelSamples[i] = (int16_t)kernelRandom(&state);
+    }
+    for (uint32_t i = 0; i < KERNEL_SORT; i++)
+    {
+        kernelWords[i] = kernelRandom(&state);
+    }
+    for (uint32_t i = 0; i < KERNEL_MATRIX; i++)
+    {
+        for (uint32_t j = 0; j < KERNEL_MATRIX; j++)
+        {
+            kernelA[i][j] = (int32_t)(kernelRandom(&state) % 2001) - 1000;
+            kernelB[i][j] = (int32_t)(kernelRandom(&state) % 2001) - 1000;
+        }
+    }
+}
+
+static uint32_t kernelRun(uint32_t kernel)
+{
+    switch (kernel)
+    {
+        case 0: return kernelCrc32(kernelData, KERNEL_BYTES);
+        case 1: return kernelFir(kernelSamples, kernelFiltered, KERNEL_SAMPLES);
+        case 2: return kernelBits(kernelWords, KERNEL_SORT);
+        case 3: return kernelSort(kernelWords, KERNEL_SORT);
+        case 4: return kernelMatmul();
+        default: return kernelDivide(kernelWords, KERNEL_SORT);
+    }
+}
+
+static const char *const kernelNames[] = { "crc32", "fir", "bits", "sort", "matmul", "divide" };
+
+int main(void)
+{
+    benchInit("Kernel benchmark");
+#ifdef __riscv
+    benchPrint("ISA: RISC-V (Hazard3)\r\n");
+#else
+    benchPrint("ISA: Arm (Cortex-M33)\r\n");
+#endif
+
+    for (uint32_t kernel = 0; kernel < (sizeof(kernelNames) / sizeof(kernelNames[0])); kernel++)
+    {
+        kernelFill();
+        kernelRun(kernel);                                                 // Warm up
+        kernelFill();
+        uint32_t primask = cpuIrqSave();
+        uint32_t start = benchCycles();
+        uint32_t check = kernelRun(kernel);
+        uint32_t cycles = benchCycles() - start;
+        cpuIrqRestore(primask);
+        benchPrint(kernelNames[kernel]);
+        benchResult("", cycles, "cycles");
+        benchPrint(kernelNames[kernel]);
+        benchResult(" check", check, "");
+    }
+
+    benchDone();
+    return 0;
+}
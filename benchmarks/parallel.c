@@ -0,0 +1,162 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Parallel loop benchmark: the reference kernels of ../bsp/parallel_kernels.c
+   on one core (the kernel called over the whole range) and on both cores
+   (parallelReduce/parallelFor of ../bsp/parallel.c):
+   - sum of 4096 words, CRC-32 of 16 KB, table transform of 16 KB
+   - busy: a nop per element, the only kernel that takes time on the
+     simulator (where code costs no cycles)
+   For each one: core 0 cycles on one and two cores, the speedup in percent
+   and the mismatches between the two results.
+   Then the fork/join overhead (an empty kernel over 2 elements, the best of
+   16 runs) and the break-even of sum and busy: the smallest range (powers
+   of two) that is faster on two cores, 0 when none is.
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "parallel.h"
+#include "parallel_kernels.h"
+#include "bench.h"
+
+#define BENCH_BYTES     (16384)
+#define BENCH_WORDS     (BENCH_BYTES / 4)
+
+static uint32_t benchWords[BENCH_WORDS];
+static uint8_t benchBytes[BENCH_BYTES];
+static uint8_t benchCopy[BENCH_BYTES];
+static uint8_t benchTable[256];
+
+static uint32_t TIME_CRITICAL(benchBusyKernel)(void *context, uint32_t begin, uint32_t end)
+{
+    (void)context;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        cpuNop();
+    }
+    return end - begin;
+}
+
+static uint32_t TIME_CRITICAL(benchEmptyKernel)(void *context, uint32_t begin, uint32_t end)
+{
+    (void)context;
+    (void)begin;
+    (void)end;
+    return 0;
+}
+
+static void benchReport(const char *name, uint32_t single, uint32_t dual, uint32_t mismatches)
+{
+    benchPrint(name);
+    benchResult(" one core", single, "cycles");
+    benchPrint(name);
+    benchResult(" two cores", dual, "cycles");
+    benchPrint(name);
+    benchResult(" speedup", dual ? (uint32_t)(((uint64_t)single * 100) / dual) : 0, "%");
+    benchPrint(name);
+    benchResult(" mismatches", mismatches, "");
+}
+
+/* Smallest power of two range faster on two cores, 0 if none up to max */
+static uint32_t benchBreakEven(ParallelKernel kernel, ParallelCombine combine, void *context, uint32_t max)
+{
+    for (uint32_t count = 2; count <= max; count *= 2)
+    {
+        uint32_t start = benchCycles();
+        kernel(context, 0, count);
+        uint32_t single = benchCycles() - start;
+        start = benchCycles();
+        parallelReduce(count, kernel, combine, context);
+        uint32_t dual = benchCycles() - start;
+        if (dual < single)
+        {
+            return count;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    benchInit("Parallel loop benchmark");
+    parallelInit();
+
+    uint32_t state = 1;
+    for (uint32_t i = 0; i < BENCH_WORDS; i++)
+    {
+        state = state * 1664525 + 1013904223;
+        benchWords[i] = state;
+    }
+    for (uint32_t i = 0; i < BENCH_BYTES; i++)
+    {
+        benchBytes[i] = (uint8_t)(benchWords[i / 4] >> (8 * (i % 4)));
+        benchCopy[i] = benchBytes[i];
+    }
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        benchTable[i] = (uint8_t)((i * 167) + 13);                         // a permutation (167 is odd)
+    }
+
+    // sum
+    uint32_t start = benchCycles();
+    uint32_t single = parallelSumKernel(benchWords, 0, BENCH_WORDS);
+    uint32_t singleCycles = benchCycles() - start;
+    start = benchCycles();
+    uint32_t dual = parallelSum(benchWords, BENCH_WORDS);
+    benchReport("sum", singleCycles, benchCycles() - start, single != dual);
+
+    // CRC-32
+    start = benchCycles();
+    single = parallelCrc32Kernel(benchBytes, 0, BENCH_BYTES);
+    singleCycles = benchCycles() - start;
+    start = benchCycles();
+    dual = parallelCrc32(benchBytes, BENCH_BYTES);
+    benchReport("crc32", singleCycles, benchCycles() - start, single != dual);
+
+    // transform: once on each copy, the copies must match
+    ParallelTransform transform = { benchCopy, benchTable };
+    start = benchCycles();
+    parallelTransformKernel(&transform, 0, BENCH_BYTES);
+    singleCycles = benchCycles() - start;
+    start = benchCycles();
+    parallelTransform(benchBytes, BENCH_BYTES, benchTable);
+    uint32_t dualCycles = benchCycles() - start;
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < BENCH_BYTES; i++)
+    {
+        mismatches += (benchBytes[i] != benchCopy[i]);
+    }
+    benchReport("transform", singleCycles, dualCycles, mismatches);
+
+    // busy
+    start = benchCycles();
+    single = benchBusyKernel(0, 0, BENCH_WORDS);
+    singleCycles = benchCycles() - start;
+    start = benchCycles();
+    dual = parallelReduce(BENCH_WORDS, benchBusyKernel, parallelSumCombine, 0);
+    benchReport("busy", singleCycles, benchCycles() - start, single != dual);
+
+    // Fork/join overhead and break-even
+    uint32_t overhead = 0xffffffff;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        start = benchCycles();
+        parallelFor(2, benchEmptyKernel, 0);
+        uint32_t cycles = benchCycles() - start;
+        overhead = (cycles < overhead) ? cycles : overhead;
+    }
+    benchResult("fork/join overhead", overhead, "cycles");
+    benchResult("sum break-even", benchBreakEven(parallelSumKernel, parallelSumCombine, benchWords, BENCH_WORDS), "words");
+    benchResult("busy break-even", benchBreakEven(benchBusyKernel, parallelSumCombine, 0, BENCH_WORDS), "elements");
+
+    ParallelStats stats;
+    parallelGetStats(&stats);
+    benchResult("jobs", stats.jobs, "");
+    benchResult("join waits", stats.joinWaits, "");
+
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,113 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* PIO benchmark: CPU cycles needed to send and receive 1 KB through the PIO
+   UART of ../bsp/pio_programs.c at 115200, in loopback: PIO0 SM0 (TX) drives
+   GPIO22 and PIO0 SM1 (RX) reads it back through the pad, no wire needed.
+   - polled: the CPU puts every character in the TX FIFO and gets every
+     character from the RX FIFO (pioSmPut/pioUartRxRead)
+   - DMA:    two DMA channels paced by the FIFO DREQs move the data, the CPU
+     only starts them (pioSmDmaRx/pioSmDmaTx). Waiting for the end is not
+     counted.
+   Both runs compare the received data with the sent data and check the
+   framing error flag of the RX program. A character dropped by the RX
+   program ends the run after BENCH_TIMEOUT and counts as an error.
+   GPIO22 is free on the Pico 2 header, it is left driven high (idle line).
+*/
+#include "rp2350.h"
+#include "dma.h"
+#include "pio.h"
+#include "pio_programs.h"
+#include "bench.h"
+
+#define BENCH_PIN       (22)
+#define BENCH_BAUD      (115200)
+#define BENCH_SIZE      (1024)
+#define BENCH_TX_SM     (0)
+#define BENCH_RX_SM     (1)
+#define BENCH_TX_CH     (0)
+#define BENCH_RX_CH     (1)
+#define BENCH_TIMEOUT   (CLK_SYS_HZ / 100)     // 10ms (~115 characters) without receiving: lost characters
+
+static uint8_t benchData[BENCH_SIZE];
+static uint8_t benchRx[BENCH_SIZE];
+
+/* Differences between the sent and the received data, framing errors
+   included (relative IRQ flag 4 of the RX state machine) */
+static uint32_t pioCheck(uint32_t received)
+{
+    uint32_t errors = BENCH_SIZE - received;
+    for (uint32_t i = 0; i < received; i++)
+    {
+        errors += (benchRx[i] != benchData[i]) ? 1 : 0;
+        benchRx[i] = 0;
+    }
+    if (GET32(PIO_IRQ(0)) & (1u << (4 + BENCH_RX_SM)))
+    {
+        errors++;
+        PUT32(PIO_IRQ(0), (1u << (4 + BENCH_RX_SM)));          // Clear the flag
+    }
+    return errors;
+}
+
+int main(void)
+{
+    benchInit("PIO benchmark");
+    for (uint32_t i = 0; i < BENCH_SIZE; i++)
+    {
+        benchData[i] = (uint8_t)((i * 7) + (i >> 8));                      // Every byte value, in no order
+    }
+
+    pioInit(0);
+    pioUartTxInit(0, BENCH_TX_SM, BENCH_PIN, BENCH_BAUD);
+    pioUartRxInit(0, BENCH_RX_SM, BENCH_PIN, BENCH_BAUD);
+
+    // Polled: the CPU feeds the TX FIFO and drains the RX FIFO
+    uint32_t sent = 0;
+    uint32_t received = 0;
+    uint32_t start = benchCycles();
+    uint32_t last = start;
+    while ((received < BENCH_SIZE) && ((benchCycles() - last) < BENCH_TIMEOUT))
+    {
+        if ((sent < BENCH_SIZE) && (pioSmPut(0, BENCH_TX_SM, benchData[sent]) == 0))
+        {
+            sent++;
+        }
+        uint32_t count = pioUartRxRead(0, BENCH_RX_SM, &benchRx[received], BENCH_SIZE - received);
+        if (count > 0)
+        {
+            received += count;
+            last = benchCycles();
+        }
+    }
+    uint32_t polledCycles = last - start;
+    uint32_t errors = pioCheck(received);
+
+    // DMA: the RX channel first, so that it is ready for the first character
+    start = benchCycles();
+    pioSmDmaRx(0, BENCH_RX_SM, BENCH_RX_CH, benchRx, BENCH_SIZE, 1);
+    pioSmDmaTx(0, BENCH_TX_SM, BENCH_TX_CH, benchData, BENCH_SIZE, 1, 0);
+    uint32_t dmaCycles = benchCycles() - start;
+    uint32_t left = BENCH_SIZE;
+    last = benchCycles();
+    while (pioSmDmaBusy(BENCH_RX_CH) && ((benchCycles() - last) < BENCH_TIMEOUT))   // ~89ms at 115200
+    {
+        if (GET32(DMA_CH_TRANS_COUNT(BENCH_RX_CH)) != left)
+        {
+            left = GET32(DMA_CH_TRANS_COUNT(BENCH_RX_CH));
+            last = benchCycles();
+        }
+    }
+    pioSmDmaStop(BENCH_TX_CH);
+    pioSmDmaStop(BENCH_RX_CH);
+    errors += pioCheck(BENCH_SIZE - GET32(DMA_CH_TRANS_COUNT(BENCH_RX_CH)));
+
+    benchResult("polled pioSmPut/pioUartRxRead", polledCycles, "cycles/KB");
+    benchResult("DMA pioSmDmaTx/pioSmDmaRx", dmaCycles, "cycles/KB");
+    benchResult("loopback errors", errors, "");
+
+    benchDone();
+    return 0;
+}
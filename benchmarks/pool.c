@@ -0,0 +1,167 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Pool allocator benchmark: ../bsp/pool.c over the heap of the linker
+   script, with 3 classes (16, 64 and 256 bytes). Each round allocates 12
+   blocks (16, 64 and 256 bytes in turn) and frees them:
+   - one core:  core 0 alone
+   - two cores: both cores at the same time, each on its own blocks
+   - handoff:   core 0 allocates, core 1 frees (blocks sent through the
+                FIFO), the blocks come back through the shared lists
+   For each one: the core 0 cycles per allocation and free. Then the
+   exhaustion of the 256 bytes class, the statistics of every class (in
+   use, high water, failures, refills and flushes of the core caches) and
+   the contention on the spinlock of the shared lists.
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "multicore.h"
+#include "sync.h"
+#include "pool.h"
+#include "bench.h"
+
+#define BENCH_ROUNDS    (200)
+#define BENCH_BURST     (12)            // blocks allocated by a round
+#define BENCH_CLASSES   (3)
+
+static const PoolClassConfig benchClasses[BENCH_CLASSES] = { { 16, 128 }, { 64, 64 }, { 256, 32 } };
+static const uint32_t benchSizes[3] = { 16, 48, 200 };
+static volatile uint32_t benchFailures;
+
+static void benchRun(void)
+{
+    void *blocks[BENCH_BURST];
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t i = 0; i < BENCH_BURST; i++)
+        {
+            blocks[i] = poolAlloc(benchSizes[i % 3]);
+            benchFailures += (blocks[i] == 0);
+        }
+        for (uint32_t i = 0; i < BENCH_BURST; i++)
+        {
+            poolFree(blocks[i]);
+        }
+    }
+}
+
+/* Core 1: runs the test sent by core 0, then sends it back.
+   1: the rounds, 2: frees the blocks sent by core 0 until a 0 */
+static void benchCore1(void)
+{
+    cpuCycleCounterStart();                                                // Cycles of the lock statistics
+    while (1)
+    {
+        uint32_t test = multicoreFifoPop();
+        if (test == 1)
+        {
+            benchRun();
+        }
+        else
+        {
+            uint32_t block;
+            while ((block = multicoreFifoPop()) != 0)
+            {
+                poolFree((void *)(uintptr_t)block);
+            }
+        }
+        multicoreFifoPush(test);
+    }
+}
+
+static void benchTime(const char *name, uint32_t cycles)
+{
+    benchPrint(name);
+    benchResult("", cycles / (BENCH_ROUNDS * BENCH_BURST), "cycles/block");
+}
+
+int main(void)
+{
+    benchInit("Pool allocator benchmark");
+    benchResult("heap", (uint32_t)((uintptr_t)&__heap_end__ - (uintptr_t)&__heap_start__), "bytes");
+    if (poolInit(benchClasses, BENCH_CLASSES, &__heap_start__, &__heap_end__) != 0)
+    {
+        benchPrint("poolInit failed\r\n");
+        benchDone();
+        return 0;
+    }
+    multicoreLaunchCore1(benchCore1);
+
+    // One core
+    uint32_t start = benchCycles();
+    benchRun();
+    benchTime("one core", benchCycles() - start);
+
+    // Two cores
+    multicoreFifoPush(1);
+    start = benchCycles();
+    benchRun();
+    uint32_t cycles = benchCycles() - start;
+    multicoreFifoPop();                                                    // Core 1 is done
+    benchTime("two cores", cycles);
+
+    // Handoff: allocated by core 0, freed by core 1
+    multicoreFifoPush(2);
+    start = benchCycles();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (uint32_t i = 0; i < BENCH_BURST; i++)
+        {
+            void *block = poolAlloc(benchSizes[i % 3]);
+            if (block == 0)
+            {
+                benchFailures++;
+                continue;
+            }
+            multicoreFifoPush((uint32_t)(uintptr_t)block);
+        }
+    }
+    multicoreFifoPush(0);
+    cycles = benchCycles() - start;
+    multicoreFifoPop();
+    benchTime("handoff", cycles);
+    benchResult("failures", benchFailures, "");
+
+    // Exhaustion of the largest class, a request larger than every class
+    void *blocks[64];
+    uint32_t count = 0;
+    while ((count < 64) && ((blocks[count] = poolAlloc(256)) != 0))
+    {
+        count++;
+    }
+    benchResult("256 bytes blocks until empty", count, "");
+    benchResult("300 bytes request", poolAlloc(300) != 0, "(0: refused)");
+    for (uint32_t i = 0; i < count; i++)
+    {
+        poolFree(blocks[i]);
+    }
+
+    for (uint32_t c = 0; c < BENCH_CLASSES; c++)
+    {
+        static const char *const names[BENCH_CLASSES] = { "class 16", "class 64", "class 256" };
+        PoolStats stats;
+        poolGetStats(c, &stats);
+        benchPrint(names[c]);
+        benchResult(" in use", stats.inUse, "blocks");
+        benchPrint(names[c]);
+        benchResult(" high water", stats.highWater, "blocks");
+        benchPrint(names[c]);
+        benchResult(" failures", stats.failures, "");
+        benchPrint(names[c]);
+        benchResult(" refills", stats.refills, "");
+        benchPrint(names[c]);
+        benchResult(" flushes", stats.flushes, "");
+    }
+
+    SyncStats lock;
+    poolGetLockStats(&lock);
+    benchResult("lock acquires", lock.acquires, "");
+    benchResult("lock contended", lock.contended, "");
+    benchResult("lock max wait", lock.maxWaitCycles, "cycles");
+
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,143 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Power management benchmark: ../bsp/power.c
+   - clock gating: the clocks running (CLOCKS ENABLED0/1) before and after
+     powerSetClocks() keeps only UART0 and TIMER0 (TIMER0 alone in deep
+     sleep)
+   - idle: a 1 kHz timer of TIMER0 posts a message, the thread handles it
+     and waits for the next one, BENCH_MESSAGES times for each way of
+     waiting:
+       busy:       polls (nop) until the next message
+       sleep:      powerIdle() in POWER_SLEEP, with the message counter as
+                   its work flag
+       deep sleep: powerIdle() in POWER_DEEP_SLEEP
+     For each: the time awake and asleep and the wake-ups (powerGetStats),
+     the cycles of the core per message (its clock, and the cycle counter,
+     stop while it sleeps) and the worst latency, from the deadline of a
+     message to the thread handling it. The cycles awake are what costs
+     energy, the latency is what deep sleep gives in exchange.
+   - dormant: waits for a character on UART0 RX (that character is lost),
+     then the cycles of the restart of the clocks. On the simulator,
+     make run sends it at 1 s (SIM_UART0_RX).
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "clocks.h"
+#include "timer.h"
+#include "uart.h"
+#include "power.h"
+#include "bench.h"
+
+#define BENCH_MESSAGES  (50)
+#define BENCH_PERIOD_US (1000)
+#define BENCH_BUSY      (0)             // idle mode: polling
+
+static volatile uint32_t benchPosted;
+
+static void benchPost(void *context)
+{
+    (void)context;
+    benchPosted++;
+}
+
+/* Waits for UART0 to send everything: no UART interrupt during a measure,
+   and no character lost when the clocks stop */
+static void benchUartFlush(void)
+{
+    while (uartTxFree(0) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();
+    }
+    while (GET32(UART_FR(0)) & UART_FR_BUSY);                              // The FIFO and the last character
+}
+
+static uint32_t benchClockCount(uint64_t clocks)
+{
+    uint32_t count = 0;
+    for (; clocks != 0; clocks &= clocks - 1)
+    {
+        count++;
+    }
+    return count;
+}
+
+static void benchIdle(const char *name, uint32_t mode)
+{
+    Timer timer;
+    uint32_t handled = 0;
+    uint32_t worst = 0;
+
+    benchUartFlush();
+    benchPosted = 0;
+    powerInit();
+    if (mode != BENCH_BUSY)
+    {
+        powerSetIdleMode(mode);
+    }
+    uint64_t first = timerGetUs() + BENCH_PERIOD_US;
+    uint32_t start = benchCycles();
+    timerStart(&timer, first, BENCH_PERIOD_US, benchPost, 0);
+    while (handled < BENCH_MESSAGES)
+    {
+        while (benchPosted == handled)
+        {
+            if (mode == BENCH_BUSY)
+            {
+                cpuNop();
+            }
+            else
+            {
+                powerIdle(&benchPosted, handled);
+            }
+        }
+        uint32_t latency = (uint32_t)(timerGetUs() - (first + (uint64_t)handled * BENCH_PERIOD_US));
+        worst = (latency > worst) ? latency : worst;
+        handled++;
+    }
+    uint32_t cycles = benchCycles() - start;
+    timerStop(&timer);
+
+    PowerStats stats;
+    powerGetStats(0, &stats);
+    benchPrint(name);
+    benchPrintValue((uint32_t)stats.runUs, 9);
+    benchPrintValue((uint32_t)(stats.sleepUs + stats.deepSleepUs), 10);
+    benchPrintValue((stats.sleeps + stats.deepSleeps), 9);
+    benchPrintValue((cycles / BENCH_MESSAGES), 11);
+    benchPrintValue(worst, 10);
+    benchPrint("\r\n");
+}
+
+int main(void)
+{
+    benchInit("Power management benchmark");
+    timerInit();
+
+    // Clock gating
+    benchResult("clocks running", benchClockCount(powerGetEnabledClocks()), "");
+    powerSetClocks((POWER_CLK_UART0 | POWER_CLK_TIMER0), POWER_CLK_TIMER0);
+    benchResult("clocks running, gated", benchClockCount(powerGetEnabledClocks()), "");
+
+    // Idle
+    benchPrint("idle        run(us) sleep(us)  wakeups cycles/msg worst(us)\r\n");
+    benchIdle("busy      ", BENCH_BUSY);
+    benchIdle("sleep     ", POWER_SLEEP);
+    benchIdle("deep sleep", POWER_DEEP_SLEEP);
+    powerSetClocks(POWER_CLK_PERIPHERALS, POWER_CLK_PERIPHERALS);
+
+    // Dormant, until a character on UART0
+    benchPrint("dormant: waiting for a character on UART0\r\n");
+    benchUartFlush();
+    int result = powerDormantUart(0);
+    uartInit(0, 115200, 0);                                                // clk_peri was reconfigured
+    PowerStats stats;
+    powerGetStats(0, &stats);
+    benchResult("dormant wake-ups", stats.dormants, (result == 0) ? "" : "(failed)");
+    benchResult("dormant restart", stats.wakeCycles, "cycles");
+
+    benchDone();
+    return 0;
+}
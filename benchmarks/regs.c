@@ -0,0 +1,135 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Register layer benchmark: the same sequences written with PUT32/GET32
+   and with the macros of ../bsp/regs.h
+   - gpio:   GPIO26 to SIO, output enabled, pad isolation removed
+   - pad:    GPIO26 pad to 12mA, fast slew, no schmitt, in one store
+   - update: GPIO26 pad drive changed with the other bits left alone
+             (read-modify-write vs REG_UPDATE, one store to the XOR alias)
+   - toggle: GPIO26 output toggled (SIO GPIO_OUT_XOR)
+   Both versions of a pair must leave the same register values, and take
+   the same cycles. Their code size is in the size report of the build
+   (functions regs*Raw and regs*Typed).
+   GPIO26 is not connected on the Pico 2, its output is left disabled.
+*/
+#include "rp2350.h"
+#include "regs.h"
+#include "bench.h"
+
+#define BENCH_PIN       (26)
+#define BENCH_RUNS      (16)
+
+typedef void (*BenchSequence)(void);
+
+/* noipa: -O2 must not inline them, so that each has its own size */
+static __attribute__((noipa)) void regsGpioRaw(void)
+{
+    PUT32((IO_BANK0_BASE + 0x0d4), 5);                                     // IO GPIO26 uses SIO
+    PUT32((SIO_BASE + 0x038), (1 << BENCH_PIN));                           // SIO OE for GPIO26
+    PUT32((PADS_BANK0_BASE + WRITE_CLR + 0x6c), (1 << 8));                 // Remove GPIO26 pad isolation
+}
+
+static __attribute__((noipa)) void regsGpioTyped(void)
+{
+    REG_WRITE(IO_BANK0_GPIO(BENCH_PIN), GPIO_CTRL_FUNCSEL, GPIO_FUNC_SIO);
+    REG_STROBE(SIO_BASE, SIO_GPIO_OE_SET(1 << BENCH_PIN));
+    REG_CLR(PADS_BANK0_GPIO(BENCH_PIN), PADS_GPIO_ISO);
+}
+
+static __attribute__((noipa)) void regsPadRaw(void)
+{
+    PUT32((PADS_BANK0_BASE + 0x6c), ((1 << 6) | (3 << 4) | (1 << 0)));   // IE, 12mA, fast slew
+}
+
+static __attribute__((noipa)) void regsPadTyped(void)
+{
+    REG_WRITE(PADS_BANK0_GPIO(BENCH_PIN), PADS_GPIO_IE | PADS_GPIO_DRIVE | PADS_GPIO_SLEWFAST,
+              REG_VALUE(PADS_GPIO_IE, 1) | REG_VALUE(PADS_GPIO_DRIVE, 3) | REG_VALUE(PADS_GPIO_SLEWFAST, 1));
+}
+
+static __attribute__((noipa)) void regsUpdateRaw(void)
+{
+    PUT32((PADS_BANK0_BASE + 0x6c), ((GET32(PADS_BANK0_BASE + 0x6c) & ~(3 << 4)) | (1 << 4)));  // 4mA
+}
+
+static __attribute__((noipa)) void regsUpdateTyped(void)
+{
+    REG_UPDATE(PADS_BANK0_GPIO(BENCH_PIN), PADS_GPIO_DRIVE, REG_VALUE(PADS_GPIO_DRIVE, 1));
+}
+
+static __attribute__((noipa)) void regsToggleRaw(void)
+{
+    PUT32((SIO_BASE + 0x028), (1 << BENCH_PIN));                           // xor GPIO26
+}
+
+static __attribute__((noipa)) void regsToggleTyped(void)
+{
+    REG_STROBE(SIO_BASE, SIO_GPIO_OUT_XOR(1 << BENCH_PIN));
+}
+
+/* Registers written by the sequences */
+static void regsSnapshot(uint32_t *regs)
+{
+    regs[0] = REG_READ(IO_BANK0_GPIO(BENCH_PIN), GPIO_CTRL_FUNCSEL);
+    regs[1] = GET32(PADS_BANK0_GPIO(BENCH_PIN));
+    regs[2] = REG_READ(SIO_BASE, SIO_GPIO_OE(1 << BENCH_PIN));
+    regs[3] = REG_READ(SIO_BASE, SIO_GPIO_OUT(1 << BENCH_PIN));
+}
+
+/* Least cycles of a sequence over BENCH_RUNS runs, with the registers it leaves */
+static uint32_t regsRun(BenchSequence sequence, uint32_t *regs)
+{
+    uint32_t min = 0xffffffffu;
+    for (uint32_t run = 0; run < BENCH_RUNS; run++)
+    {
+        uint32_t start = benchCycles();
+        sequence();
+        uint32_t cycles = benchCycles() - start;
+        min = (cycles < min) ? cycles : min;
+    }
+    regsSnapshot(regs);
+    return min;
+}
+
+/* Runs a pair from the same register values, returns 1 when they differ */
+static uint32_t regsCompare(const char *name, BenchSequence raw, BenchSequence typed)
+{
+    uint32_t before[4];
+    uint32_t afterRaw[4];
+    uint32_t afterTyped[4];
+    uint32_t errors = 0;
+    regsSnapshot(before);
+    uint32_t rawCycles = regsRun(raw, afterRaw);
+    PUT32(IO_BANK0_GPIO(BENCH_PIN), before[0]);                            // Back to the starting point
+    PUT32(PADS_BANK0_GPIO(BENCH_PIN), before[1]);
+    PUT32((SIO_BASE + (before[2] ? 0x038 : 0x040)), (1 << BENCH_PIN));
+    PUT32((SIO_BASE + (before[3] ? 0x018 : 0x020)), (1 << BENCH_PIN));
+    uint32_t typedCycles = regsRun(typed, afterTyped);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        errors |= (afterRaw[i] != afterTyped[i]) ? 1 : 0;
+    }
+    benchPrint(name);
+    benchPrint("\r\n");
+    benchResult("  PUT32/GET32", rawCycles, "cycles");
+    benchResult("  regs.h", typedCycles, "cycles");
+    return errors;
+}
+
+int main(void)
+{
+    benchInit("Register layer benchmark");
+
+    uint32_t errors = regsCompare("gpio", regsGpioRaw, regsGpioTyped);
+    errors += regsCompare("pad", regsPadRaw, regsPadTyped);
+    errors += regsCompare("update", regsUpdateRaw, regsUpdateTyped);
+    errors += regsCompare("toggle", regsToggleRaw, regsToggleTyped);
+    REG_STROBE(SIO_BASE, SIO_GPIO_OE_CLR(1 << BENCH_PIN));                 // GPIO26 back to input
+    benchResult("register mismatches", errors, "");
+
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,223 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Scheduler benchmark: cost of a task and two-core speedup (../bsp/sched.c)
+   - local dispatch: core 0 submits a task pinned to itself and runs it
+     (schedSubmit + schedRunOne), core 0 cycles per task
+   - cross-core: core 0 submits a task pinned to core 1, which is sleeping in
+     wfe, and waits for it to run: round trip of a task between the cores
+   - speedup: a CPU-bound kernel (bitwise CRC-32 of 8 KB, in 64 tasks of
+     128 bytes) pinned to core 0, then submitted with SCHED_ANY_CORE so that
+     core 1 steals the tasks that core 0 has not started yet
+   - race: both cores submit the same SCHED_ANY_CORE task in a loop, each
+     to its own queue, and run what they find. Every successful submission
+     must run exactly once and the task must end up free. For the board
+     only: the simulator runs the C code of a core between two register
+     accesses in one step, so it never interleaves the two submissions
+   The kernel has a nop per bit, so that it also costs time on the simulator
+   (where only the register accesses and the asm statements do).
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "timer.h"
+#include "multicore.h"
+#include "sched.h"
+#include "bench.h"
+
+#define BENCH_ROUNDS    (1000)          // tasks for the latency tests
+#define BENCH_CHUNKS    (64)            // kernel tasks
+#define BENCH_CHUNK     (128)           // bytes per kernel task
+#define BENCH_RACE_ROUNDS (2000)        // submissions tried by each core
+
+static uint8_t benchData[BENCH_CHUNKS * BENCH_CHUNK];
+static uint32_t benchCrc[BENCH_CHUNKS];
+static Task benchTasks[BENCH_CHUNKS];
+static volatile uint32_t benchDoneCount[2];
+static Task benchRacer;
+static Task benchRaceTask;
+static volatile uint32_t benchRaceSubmits[2];
+static volatile uint32_t benchRaceRuns[2];
+static volatile uint32_t benchRaceDone;
+
+static void benchNothing(void *arg)
+{
+    (void)arg;
+}
+
+static void benchPing(void *arg)
+{
+    (void)arg;
+    benchDoneCount[multicoreCoreId()]++;
+    cpuSev();                                                              // core 0 waits in wfe
+}
+
+/* Bitwise CRC-32 (polynomial 0xedb88320) of one chunk */
+static void benchKernel(void *arg)
+{
+    uint32_t chunk = (uint32_t)(uintptr_t)arg;
+    const uint8_t *data = &benchData[chunk * BENCH_CHUNK];
+    uint32_t crc = 0xffffffffu;
+    for (uint32_t i = 0; i < BENCH_CHUNK; i++)
+    {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+            cpuNop();
+        }
+    }
+    benchCrc[chunk] = ~crc;
+    benchDoneCount[multicoreCoreId()]++;
+    cpuSev();
+}
+
+static void benchRaceRun(void *arg)
+{
+    (void)arg;
+    benchRaceRuns[multicoreCoreId()]++;
+}
+
+/* Submits the shared task as often as it is free, and runs the tasks found
+   meanwhile (the racer of either queue) */
+static void benchRace(void)
+{
+    uint32_t self = multicoreCoreId();
+    for (uint32_t r = 0; r < BENCH_RACE_ROUNDS; r++)
+    {
+        if (schedSubmit(&benchRacer, benchRaceRun, 0, SCHED_ANY_CORE) == 0)
+        {
+            benchRaceSubmits[self]++;
+        }
+        schedRunOne();
+    }
+}
+
+static void benchRaceCore1(void *arg)
+{
+    (void)arg;
+    benchRace();
+    benchRaceDone = 1;
+    cpuSev();
+}
+
+/* Core 0 runs tasks (its own or stolen) until count tasks are done */
+static void benchWaitDone(uint32_t count)
+{
+    while ((benchDoneCount[0] + benchDoneCount[1]) < count)
+    {
+        if (!schedRunOne())
+        {
+            cpuWfe();
+        }
+    }
+}
+
+/* Runs the kernel over the whole buffer, returns the elapsed time in us */
+static uint32_t benchRunKernel(uint32_t affinity)
+{
+    benchDoneCount[0] = benchDoneCount[1] = 0;
+    uint64_t t0 = timerGetUs();
+    for (uint32_t chunk = 0; chunk < BENCH_CHUNKS; chunk++)
+    {
+        schedSubmit(&benchTasks[chunk], benchKernel, (void *)(uintptr_t)chunk, affinity);
+    }
+    benchWaitDone(BENCH_CHUNKS);
+    return (uint32_t)(timerGetUs() - t0);
+}
+
+int main(void)
+{
+    benchInit("Scheduler benchmark");
+    timerInit();
+    for (uint32_t i = 0; i < sizeof(benchData); i++)
+    {
+        benchData[i] = (uint8_t)(i * 7 + (i >> 8));
+    }
+    schedInit();
+    schedLaunchCore1();
+
+    // Local dispatch: no other core involved
+    Task task = { 0 };
+    uint32_t start = benchCycles();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++)
+    {
+        schedSubmit(&task, benchNothing, 0, 0);
+        schedRunOne();
+    }
+    uint32_t localCycles = benchCycles() - start;
+
+    // Cross-core: core 1 wakes up, runs the task and wakes core 0 up
+    benchDoneCount[0] = benchDoneCount[1] = 0;
+    start = benchCycles();
+    uint64_t t0 = timerGetUs();
+    for (uint32_t r = 0; r < BENCH_ROUNDS; r++)
+    {
+        schedSubmit(&task, benchPing, 0, 1);
+        while (benchDoneCount[1] == r)
+        {
+            cpuWfe();
+        }
+    }
+    uint32_t crossUs = (uint32_t)(timerGetUs() - t0);
+    uint32_t crossCycles = benchCycles() - start;
+
+    // Speedup: same tasks on one core, then on both
+    uint32_t oneCoreUs = benchRunKernel(0);
+    uint32_t expected[BENCH_CHUNKS];
+    for (uint32_t chunk = 0; chunk < BENCH_CHUNKS; chunk++)
+    {
+        expected[chunk] = benchCrc[chunk];
+        benchCrc[chunk] = 0;
+    }
+    SchedStats before;
+    schedGetStats(1, &before);
+    uint32_t twoCoresUs = benchRunKernel(SCHED_ANY_CORE);
+    uint32_t core1Tasks = benchDoneCount[1];
+    uint32_t errors = 0;
+    for (uint32_t chunk = 0; chunk < BENCH_CHUNKS; chunk++)
+    {
+        errors += (benchCrc[chunk] != expected[chunk]);
+    }
+    SchedStats after;
+    schedGetStats(1, &after);
+
+    // Race: the same ANY_CORE task submitted by both cores at once
+    schedSubmit(&benchRaceTask, benchRaceCore1, 0, 1);
+    benchRace();
+    while (!benchRaceDone)
+    {
+        if (!schedRunOne())
+        {
+            cpuWfe();
+        }
+    }
+    uint32_t raceSubmits = benchRaceSubmits[0] + benchRaceSubmits[1];
+    uint64_t deadline = timerGetUs() + 100000;
+    while (((benchRaceRuns[0] + benchRaceRuns[1]) != raceSubmits) && (timerGetUs() < deadline))
+    {
+        schedRunOne();                                                     // The last one may be in either queue
+    }
+    uint32_t raceRuns = benchRaceRuns[0] + benchRaceRuns[1];
+    uint32_t raceErrors = (raceRuns != raceSubmits) + (benchRacer.queued != 0);
+
+    benchResult("local submit + run", localCycles / BENCH_ROUNDS, "cycles/task");
+    benchPrint("cross-core task\r\n");
+    benchResult("  round trip", (crossUs * 1000) / BENCH_ROUNDS, "ns");
+    benchResult("  core 0 cycles", crossCycles / BENCH_ROUNDS, "cycles/round trip");
+    benchPrint("CRC-32 of 8 KB in 64 tasks\r\n");
+    benchResult("  core 0 only", oneCoreUs, "us");
+    benchResult("  both cores", twoCoresUs, "us");
+    benchResult("  speedup", twoCoresUs ? (oneCoreUs * 100) / twoCoresUs : 0, "% (200 = twice as fast)");
+    benchResult("  run by core 1", core1Tasks, "tasks");
+    benchResult("  stolen by core 1", after.stolen - before.stolen, "tasks");
+    benchResult("checksum", errors, "errors");
+    benchPrint("same ANY_CORE task from both cores (board only)\r\n");
+    benchResult("  submitted by core 0", benchRaceSubmits[0], "tasks");
+    benchResult("  submitted by core 1", benchRaceSubmits[1], "tasks");
+    benchResult("  run", raceRuns, "tasks");
+    benchResult("  race", raceErrors, "errors");
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,285 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* SHA-256 benchmark: the accelerator driver of ../bsp/sha256.c against a
+   portable software implementation (below).
+   - self-test: the test vectors of FIPS 180-2 ("", "abc", the 448 and 896 bit
+     messages, one million 'a') with the three implementations, and a 16 KB
+     message cut in odd sized, unaligned pieces given in turn to
+     sha256Update() and sha256UpdateDma(), checked against the software one.
+   - throughput: cycles per KB and MB/s to hash 16 KB with the software
+     implementation, sha256Update() and sha256UpdateDma(). For the DMA the CPU
+     cycles are the ones of the call (the core is free while the DMA runs) and
+     the MB/s the ones of the whole hash.
+   On the simulator code costs no cycles: there the software implementation
+   shows 0 cycles, its figures only mean something on the board.
+*/
+#include "rp2350.h"
+#include "sha256.h"
+#include "bench.h"
+
+#define BENCH_SIZE      (16 * 1024)
+
+static uint8_t benchData[BENCH_SIZE + 4] __attribute__((aligned(4)));
+
+/* Portable software SHA-256 (FIPS 180-2) */
+typedef struct {
+    uint32_t h[8];
+    uint8_t  block[64];
+    uint64_t length;
+} SwSha256;
+
+static const uint32_t swK[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static uint32_t swRotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static void swCompress(SwSha256 *sha)
+{
+    uint32_t w[64];
+    uint32_t a = sha->h[0], b = sha->h[1], c = sha->h[2], d = sha->h[3];
+    uint32_t e = sha->h[4], f = sha->h[5], g = sha->h[6], h = sha->h[7];
+    for (int i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)sha->block[4 * i] << 24) | ((uint32_t)sha->block[4 * i + 1] << 16) |
+               ((uint32_t)sha->block[4 * i + 2] << 8) | sha->block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++)
+    {
+        uint32_t s0 = swRotr(w[i - 15], 7) ^ swRotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = swRotr(w[i - 2], 17) ^ swRotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t t1 = h + (swRotr(e, 6) ^ swRotr(e, 11) ^ swRotr(e, 25)) + ((e & f) ^ (~e & g)) + swK[i] + w[i];
+        uint32_t t2 = (swRotr(a, 2) ^ swRotr(a, 13) ^ swRotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    sha->h[0] += a; sha->h[1] += b; sha->h[2] += c; sha->h[3] += d;
+    sha->h[4] += e; sha->h[5] += f; sha->h[6] += g; sha->h[7] += h;
+}
+
+static void swInit(SwSha256 *sha)
+{
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    for (int i = 0; i < 8; i++)
+    {
+        sha->h[i] = initial[i];
+    }
+    sha->length = 0;
+}
+
+static void swUpdate(SwSha256 *sha, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = data;
+    while (len-- > 0)
+    {
+        sha->block[sha->length++ & 0x3f] = *bytes++;
+        if ((sha->length & 0x3f) == 0)
+        {
+            swCompress(sha);
+        }
+    }
+}
+
+static void swFinal(SwSha256 *sha, uint8_t *digest)
+{
+    uint64_t bits = sha->length * 8;
+    uint8_t pad = 0x80;
+    swUpdate(sha, &pad, 1);
+    pad = 0;
+    while ((sha->length & 0x3f) != 56)
+    {
+        swUpdate(sha, &pad, 1);
+    }
+    for (int i = 7; i >= 0; i--)
+    {
+        pad = (uint8_t)(bits >> (8 * i));
+        swUpdate(sha, &pad, 1);
+    }
+    for (int i = 0; i < 32; i++)
+    {
+        digest[i] = (uint8_t)(sha->h[i / 4] >> (24 - 8 * (i % 4)));
+    }
+}
+
+/* FIPS 180-2 test vectors: the message is repeat times text */
+typedef struct {
+    const char *text;
+    uint32_t    repeat;
+    uint8_t     digest[SHA256_DIGEST_SIZE];
+} Sha256Vector;
+
+static const Sha256Vector sha256Vectors[] = {
+    { "", 1, { 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+               0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 } },
+    { "abc", 1, { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+                  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad } },
+    { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+      { 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+        0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 } },
+    { "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu", 1,
+      { 0xcf, 0x5b, 0x16, 0xa7, 0x78, 0xaf, 0x83, 0x80, 0x03, 0x6c, 0xe5, 0x9e, 0x7b, 0x04, 0x92, 0x37,
+        0x0b, 0x24, 0x9b, 0x11, 0xe8, 0xf0, 0x7a, 0x51, 0xaf, 0xac, 0x45, 0x03, 0x7a, 0xfe, 0xe9, 0xd1 } },
+    { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 10000,
+      { 0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+        0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0 } },
+};
+
+#define SHA256_VECTORS  (sizeof(sha256Vectors) / sizeof(sha256Vectors[0]))
+
+enum { ENGINE_SOFTWARE, ENGINE_CPU, ENGINE_DMA };
+
+/* Hashes len bytes of data repeat times with one of the implementations */
+static void sha256Run(int engine, const uint8_t *data, uint32_t len, uint32_t repeat, uint8_t *digest)
+{
+    if (engine == ENGINE_SOFTWARE)
+    {
+        SwSha256 sha;
+        swInit(&sha);
+        for (uint32_t i = 0; i < repeat; i++)
+        {
+            swUpdate(&sha, data, len);
+        }
+        swFinal(&sha, digest);
+        return;
+    }
+    Sha256 sha;
+    sha256Init(&sha);
+    for (uint32_t i = 0; i < repeat; i++)
+    {
+        if (engine == ENGINE_CPU)
+        {
+            sha256Update(&sha, data, len);
+        }
+        else
+        {
+            sha256UpdateDma(&sha, data, len);
+        }
+    }
+    sha256Final(&sha, digest);
+}
+
+static int sha256Differ(const uint8_t *a, const uint8_t *b)
+{
+    int differ = 0;
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++)
+    {
+        differ |= a[i] ^ b[i];
+    }
+    return differ != 0;
+}
+
+/* Test vectors, failures of one implementation. The text is copied into
+   benchData: a DMA buffer must be static (and in SRAM on the board). */
+static uint32_t sha256SelfTest(int engine)
+{
+    uint32_t failures = 0;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    for (uint32_t v = 0; v < SHA256_VECTORS; v++)
+    {
+        uint32_t len = 0;
+        while (sha256Vectors[v].text[len])
+        {
+            benchData[len] = (uint8_t)sha256Vectors[v].text[len];
+            len++;
+        }
+        sha256Run(engine, benchData, len, sha256Vectors[v].repeat, digest);
+        failures += sha256Differ(digest, sha256Vectors[v].digest);
+    }
+    return failures;
+}
+
+/* 16 KB from an odd address, in pieces of 1 to 67 bytes, CPU and DMA in turn */
+static uint32_t sha256SelfTestChunks(void)
+{
+    uint8_t expected[SHA256_DIGEST_SIZE];
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    const uint8_t *data = &benchData[1];
+    Sha256 sha;
+    sha256Run(ENGINE_SOFTWARE, data, BENCH_SIZE, 1, expected);
+    sha256Init(&sha);
+    for (uint32_t done = 0, piece = 1, turn = 0; done < BENCH_SIZE; done += piece, piece = (piece * 7 + 3) % 67 + 1, turn++)
+    {
+        piece = (piece < BENCH_SIZE - done) ? piece : BENCH_SIZE - done;
+        if (turn & 1)
+        {
+            sha256UpdateDma(&sha, &data[done], piece);
+        }
+        else
+        {
+            sha256Update(&sha, &data[done], piece);
+        }
+    }
+    sha256Final(&sha, digest);
+    return sha256Differ(digest, expected);
+}
+
+/* MB/s of bytes hashed in cycles */
+static uint32_t sha256Mbps(uint32_t bytes, uint32_t cycles)
+{
+    return cycles ? (uint32_t)(((uint64_t)bytes * CLK_SYS_HZ) / cycles / 1000000) : 0;
+}
+
+int main(void)
+{
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    benchInit("SHA-256 benchmark");
+
+    benchResult("self-test software", sha256SelfTest(ENGINE_SOFTWARE), "failures");
+    benchResult("self-test sha256Update", sha256SelfTest(ENGINE_CPU), "failures");
+    benchResult("self-test sha256UpdateDma", sha256SelfTest(ENGINE_DMA), "failures");
+    for (uint32_t i = 0; i < BENCH_SIZE + 4; i++)
+    {
+        benchData[i] = (uint8_t)((i * 7) + (i >> 8));
+    }
+    benchResult("self-test unaligned pieces", sha256SelfTestChunks(), "failures");
+
+    uint32_t start = benchCycles();
+    uint32_t overhead = benchCycles() - start;                             // Cost of reading the counter
+    start = benchCycles();
+    sha256Run(ENGINE_SOFTWARE, benchData, BENCH_SIZE, 1, digest);
+    uint32_t swCycles = benchCycles() - start - overhead;
+
+    Sha256 sha;
+    start = benchCycles();
+    sha256Init(&sha);
+    sha256Update(&sha, benchData, BENCH_SIZE);
+    sha256Final(&sha, digest);
+    uint32_t cpuCycles = benchCycles() - start - overhead;
+
+    start = benchCycles();
+    sha256Init(&sha);
+    sha256UpdateDma(&sha, benchData, BENCH_SIZE);
+    uint32_t dmaCycles = benchCycles() - start - overhead;
+    while (sha256Busy(&sha));                                              // The core could do other work here
+    sha256Final(&sha, digest);
+    uint32_t dmaTotal = benchCycles() - start - overhead;
+
+    benchResult("software", swCycles / (BENCH_SIZE / 1024), "cycles/KB");
+    benchResult("software", sha256Mbps(BENCH_SIZE, swCycles), "MB/s");
+    benchResult("sha256Update", cpuCycles / (BENCH_SIZE / 1024), "cycles/KB");
+    benchResult("sha256Update", sha256Mbps(BENCH_SIZE, cpuCycles), "MB/s");
+    benchResult("sha256UpdateDma CPU", dmaCycles / (BENCH_SIZE / 1024), "cycles/KB");
+    benchResult("sha256UpdateDma", sha256Mbps(BENCH_SIZE, dmaTotal), "MB/s");
+
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,141 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Synchronization benchmark: both cores increment the same counter 1000
+   times each, at the same time, with the primitives of ../bsp/sync.c:
+   - unprotected: a plain read-modify-write, to show the lost updates
+   - spinlock:    spinlockAcquire()/spinlockRelease()
+   - critical:    syncCriticalEnter()/syncCriticalExit() (interrupts masked)
+   - mutex:       mutexLock()/mutexUnlock(), waiting in wfe
+   - atomic:      syncAtomicAdd() (LDREX/STREX, no lock)
+   For each one: the core 0 cycles per increment, the updates lost (must be
+   0 but for the first one) and, for the locks, the statistics of the lock:
+   acquisitions that had to wait, mean and max wait and the max hold time.
+   Each increment holds the lock for a few register reads, so the cores do
+   collide.
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "multicore.h"
+#include "sync.h"
+#include "bench.h"
+
+#define BENCH_ROUNDS    (1000)          // increments per core
+#define BENCH_TESTS     (5)
+
+static volatile uint32_t benchCounter;
+static Spinlock benchLock;
+static Spinlock benchGuard;
+static Mutex benchMutex;
+static SyncStats benchLockStats;
+static SyncStats benchMutexStats;
+
+/* Work done while holding the lock: the increment and a few SIO reads */
+static void benchWork(void)
+{
+    uint32_t value = benchCounter;
+    GET32(SIO_BASE + 0x004);                                               // GPIO_IN
+    GET32(SIO_BASE + 0x004);
+    benchCounter = value + 1;
+}
+
+static void benchRun(uint32_t test)
+{
+    for (uint32_t i = 0; i < BENCH_ROUNDS; i++)
+    {
+        switch (test)
+        {
+            case 0:
+                benchWork();
+                break;
+            case 1:
+                spinlockAcquire(&benchLock);
+                benchWork();
+                spinlockRelease(&benchLock);
+                break;
+            case 2:
+            {
+                uint32_t primask = syncCriticalEnter(&benchLock);
+                benchWork();
+                syncCriticalExit(&benchLock, primask);
+                break;
+            }
+            case 3:
+                mutexLock(&benchMutex);
+                benchWork();
+                mutexUnlock(&benchMutex);
+                break;
+            default:
+                GET32(SIO_BASE + 0x004);                                   // The same reads, outside of the update
+                GET32(SIO_BASE + 0x004);
+                syncAtomicAdd(&benchCounter, 1);
+                break;
+        }
+    }
+}
+
+/* Core 1 runs every test when core 0 sends its number */
+static void benchCore1(void)
+{
+    cpuCycleCounterStart();                                                // Cycles of the lock statistics
+    while (1)
+    {
+        uint32_t test = multicoreFifoPop();
+        benchRun(test);
+        multicoreFifoPush(test);
+    }
+}
+
+static void benchStats(const char *name, const SyncStats *stats)
+{
+    benchPrint(name);
+    benchResult(" contended", stats->contended, "acquisitions");
+    benchPrint(name);
+    benchResult(" mean wait", stats->contended ? (stats->waitCycles / stats->contended) : 0, "cycles");
+    benchPrint(name);
+    benchResult(" max wait", stats->maxWaitCycles, "cycles");
+    benchPrint(name);
+    benchResult(" max hold", stats->maxHoldCycles, "cycles");
+}
+
+int main(void)
+{
+    static const char *const names[BENCH_TESTS] = { "unprotected", "spinlock", "critical", "mutex", "atomic" };
+
+    benchInit("Synchronization benchmark");
+    spinlockInit(&benchLock, SYNC_SPINLOCK_FIRST, &benchLockStats);
+    spinlockInit(&benchGuard, SYNC_SPINLOCK_FIRST + 1, 0);
+    mutexInit(&benchMutex, &benchGuard, &benchMutexStats);
+    multicoreLaunchCore1(benchCore1);
+
+    for (uint32_t test = 0; test < BENCH_TESTS; test++)
+    {
+        benchCounter = 0;
+        syncStatsClear(&benchLockStats);
+        syncStatsClear(&benchMutexStats);
+        cpuDmb();
+        multicoreFifoPush(test);
+        uint32_t start = benchCycles();
+        benchRun(test);
+        uint32_t cycles = benchCycles() - start;
+        multicoreFifoPop();                                                // Core 1 is done
+
+        benchPrint(names[test]);
+        benchResult("", cycles / BENCH_ROUNDS, "cycles/increment");
+        benchPrint(names[test]);
+        benchResult(" lost updates", (2 * BENCH_ROUNDS) - benchCounter, "");
+        if ((test == 1) || (test == 2))
+        {
+            benchStats(names[test], &benchLockStats);
+        }
+        else if (test == 3)
+        {
+            benchStats(names[test], &benchMutexStats);
+        }
+    }
+
+    benchDone();
+    return 0;
+}
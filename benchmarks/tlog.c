@@ -0,0 +1,170 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Tokenized log benchmark: the same 256 messages
+       "sample %u: adc %u mV, temperature %d C"
+   sent on UART1 (3 Mbaud, RTS/CTS on GPIO6/GPIO7) as text and with TLOG()
+   of ../bsp/tlog.c.
+   - text: the numbers converted to decimal by hand (no printf with
+     -nostdlib) and the line queued with uartWriteAll()
+   - TLOG: 32 messages logged in a row, then tlogDrain() until the rings are
+     empty
+   For each one: CPU cycles per message in the call (the conversion and the
+   queueing for text), in tlogDrain() and in the UART1 interrupt, and the
+   bytes per message on the wire. At the end, 100 messages are logged
+   without draining to show a full ring: the next drain reports the lost
+   ones.
+   On the simulator code costs no cycles: the decimal conversion of the text
+   path is free there, so its cost per call only shows on the board.
+   The UART1 output can be decoded with tools/tlogdecode.py:
+       SIM_UART1_OUT=tlog.bin make BENCH=tlog hostrun
+       ../tools/tlogdecode.py tlog.host tlog.bin
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "timer.h"
+#include "uart.h"
+#include "tlog.h"
+#include "text.h"
+#include "bench.h"
+
+#define BENCH_UART      (1)
+#define BENCH_BAUD      (3000000)
+#define BENCH_MESSAGES  (256)
+#define BENCH_BATCH     (32)
+
+static uint32_t benchAdc(uint32_t n)
+{
+    return 1200 + ((n * 37) % 2100);
+}
+
+static int32_t benchTemperature(uint32_t n)
+{
+    return (int32_t)(n % 61) - 20;
+}
+
+/* Appends the decimal text of value, returns the new end */
+static char *benchDecimal(char *out, int32_t value, int isSigned)
+{
+    uint32_t magnitude = (uint32_t)value;
+    if (isSigned && (value < 0))
+    {
+        *out++ = '-';
+        magnitude = 0u - magnitude;                                        // Also for INT32_MIN
+    }
+    return out + textFormatValue(out, magnitude, 10, 0);
+}
+
+/* No UART0 interrupt during a measure: waits until the results are sent */
+static void benchQuiet(void)
+{
+    while (uartTxFree(0) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();
+    }
+}
+
+/* Waits until UART1 has sent everything */
+static void benchFlush(void)
+{
+    while (uartTxFree(BENCH_UART) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();
+    }
+    while (GET32(UART_FR(BENCH_UART)) & UART_FR_BUSY);
+}
+
+static void benchReport(const char *name, uint32_t callCycles, uint32_t drainCycles, uint32_t irqCycles, uint32_t bytes)
+{
+    benchPrint(name);
+    benchPrint("\r\n");
+    benchResult("  call", callCycles / BENCH_MESSAGES, "cycles/message");
+    benchResult("  drain", drainCycles / BENCH_MESSAGES, "cycles/message");
+    benchResult("  interrupt", irqCycles / BENCH_MESSAGES, "cycles/message");
+    benchResult("  wire", bytes / BENCH_MESSAGES, "bytes/message");
+}
+
+int main(void)
+{
+    benchInit("Tokenized log benchmark");
+    timerInit();
+    uartInit(BENCH_UART, BENCH_BAUD, UART_FLOW_RTS_CTS);
+    benchQuiet();
+
+    // Text
+    uint32_t callCycles = 0;
+    uint32_t bytes = 0;
+    uint32_t irqCycles = benchIrqCycles;
+    for (uint32_t n = 0; n < BENCH_MESSAGES; n++)
+    {
+        char line[64];
+        while (uartTxFree(BENCH_UART) < sizeof(line))
+        {
+            cpuWfi();                                                      // Waiting for room is not counted
+        }
+        uint32_t start = benchCycles();
+        char *end = line + textCopy(line, "sample ");
+        end = benchDecimal(end, (int32_t)n, 0);
+        end += textCopy(end, ": adc ");
+        end = benchDecimal(end, (int32_t)benchAdc(n), 0);
+        end += textCopy(end, " mV, temperature ");
+        end = benchDecimal(end, benchTemperature(n), 1);
+        end += textCopy(end, " C\r\n");
+        uartWriteAll(BENCH_UART, (const uint8_t *)line, (uint32_t)(end - line));
+        callCycles += benchCycles() - start;
+        bytes += (uint32_t)(end - line);
+    }
+    benchFlush();
+    benchReport("text", callCycles, 0, benchIrqCycles - irqCycles, bytes);
+
+    // TLOG
+    benchQuiet();
+    TlogStats stats;
+    uint32_t drainCycles = 0;
+    callCycles = 0;
+    irqCycles = benchIrqCycles;
+    for (uint32_t n = 0; n < BENCH_MESSAGES; n++)
+    {
+        uint32_t start = benchCycles();
+        TLOG("sample %u: adc %u mV, temperature %d C", n, benchAdc(n), benchTemperature(n));
+        callCycles += benchCycles() - start;
+        if ((n % BENCH_BATCH) == (BENCH_BATCH - 1))
+        {
+            while (tlogPending())
+            {
+                start = benchCycles();
+                tlogDrain(BENCH_UART);
+                drainCycles += benchCycles() - start;
+                if (tlogPending())
+                {
+                    cpuWfi();                                              // The TX buffer has no room for a frame
+                }
+            }
+        }
+    }
+    benchFlush();
+    tlogGetStats(&stats);
+    benchReport("TLOG", callCycles, drainCycles, benchIrqCycles - irqCycles, stats.bytes);
+    benchResult("  frames", stats.frames, "");
+
+    // Full ring: 100 messages of 3 words
+    for (uint32_t n = 0; n < 100; n++)
+    {
+        TLOG("burst %u", n);
+    }
+    tlogGetStats(&stats);
+    benchResult("ring full", stats.dropped, "messages dropped");
+    while (tlogPending())
+    {
+        if (tlogDrain(BENCH_UART) == 0)
+        {
+            cpuWfi();
+        }
+    }
+    benchFlush();
+
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,94 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* UART baud rate benchmark
+   - divisors: IBRD/FBRD, rate obtained and error of uartBaudCompute() for
+     common rates on the current clk_peri, up to clk_peri / 16 and one above
+   - throughput: 4 KB sent on UART1 (GPIO4, RTS/CTS on GPIO6/GPIO7) with
+     uartWriteAll() at 115200, 3 Mbaud and clk_peri / 16. Prints the KB/s
+     measured with TIMER0 and the CPU cycles per KB spent in the UART1
+     interrupt (refilling the TX FIFO).
+   The results are printed on UART0 as usual. On the simulator the UART1
+   characters go to stdout too, unless SIM_UART1_OUT names another file
+   (make run sends them to /dev/null).
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "clocks.h"
+#include "timer.h"
+#include "uart.h"
+#include "bench.h"
+
+#define BENCH_UART      (1)
+#define BENCH_SIZE      (4 * 1024)
+
+static const uint32_t benchRates[] = { 9600, 115200, 921600, 1000000, 3000000, CLK_SYS_HZ / 16, CLK_SYS_HZ / 8 };
+static const uint32_t benchThroughput[] = { 115200, 3000000, CLK_SYS_HZ / 16 };
+
+static uint8_t benchData[BENCH_SIZE];
+
+static void benchDivisor(uint32_t rate)
+{
+    UartBaud baud;
+    benchResult("requested", rate, "baud");
+    if (uartBaudCompute(clocksGetPeriHz(), rate, &baud) != 0)
+    {
+        benchPrint("  out of reach\r\n");
+        return;
+    }
+    benchResult("  IBRD", baud.ibrd, "");
+    benchResult("  FBRD", baud.fbrd, "");
+    benchResult("  obtained", baud.baud, "baud");
+    benchResult("  error", (uint32_t)((baud.errorPpm < 0) ? -baud.errorPpm : baud.errorPpm),
+                (baud.errorPpm < 0) ? "ppm slow" : "ppm fast");
+}
+
+static void benchSend(uint32_t rate)
+{
+    benchResult("UART1", rate, "baud");
+    if (uartInit(BENCH_UART, rate, UART_FLOW_RTS_CTS) != 0)
+    {
+        benchPrint("  out of reach\r\n");
+        return;
+    }
+    while (uartTxFree(0) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();                                                          // No UART0 interrupt during the measure
+    }
+    uint32_t irqCycles = benchIrqCycles;
+    uint64_t start = timerGetUs();
+    uartWriteAll(BENCH_UART, benchData, BENCH_SIZE);
+    while (uartTxFree(BENCH_UART) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();                                                          // Sleep until the TX interrupt empties the buffer
+    }
+    while (GET32(UART_FR(BENCH_UART)) & UART_FR_BUSY);                     // Last characters of the FIFO
+    uint32_t us = (uint32_t)(timerGetUs() - start);
+    irqCycles = benchIrqCycles - irqCycles;
+    benchResult("  throughput", (uint32_t)(((uint64_t)BENCH_SIZE * 1000000) / (us ? us : 1) / 1024), "KB/s");
+    benchResult("  interrupt", irqCycles / (BENCH_SIZE / 1024), "cycles/KB");
+}
+
+int main(void)
+{
+    benchInit("UART baud rate benchmark");
+    timerInit();
+    for (uint32_t i = 0; i < BENCH_SIZE; i++)
+    {
+        benchData[i] = (i % 64 == 63) ? '\n' : (uint8_t)('0' + (i % 64) % 10);
+    }
+
+    for (uint32_t i = 0; i < sizeof(benchRates) / sizeof(benchRates[0]); i++)
+    {
+        benchDivisor(benchRates[i]);
+    }
+    for (uint32_t i = 0; i < sizeof(benchThroughput) / sizeof(benchThroughput[0]); i++)
+    {
+        benchSend(benchThroughput[i]);
+    }
+
+    benchDone();
+    return 0;
+}
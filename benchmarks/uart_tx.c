@@ -0,0 +1,94 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* UART TX benchmark: CPU cycles needed to send 1 KB over UART0 at 115200
+   - polled: the uartTxString() of 03_MultiCore, which waits on UARTFR.TXFF
+     for every character
+   - DMA:    uartDmaWrite() of ../bsp/uart_dma.c, cycles spent queueing the
+     lines plus the cycles of the DMA interrupt
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "uart.h"
+#include "uart_dma.h"
+#include "bench.h"
+
+#define BENCH_LINES (16)        // 16 lines of 62 characters + "\r\n" = 1 KB
+
+static const uint8_t benchLine[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/* Polled transmission, as done by 03_MultiCore before the UART drivers */
+static void uartTxChar(int8_t txData)
+{
+    while(GET32(UART0_BASE + 0x018) & (1 << 5));       // Wait until UART0 FIFO is not full
+    PUT32((UART0_BASE + 0x0), txData);                 // UARTDR: Write data to Tx.
+}
+
+static void uartTxString(const int8_t *txData)
+{
+    while(*txData != '\0')
+    {
+        uartTxChar(*txData++);
+    }
+    uartTxChar('\r');
+    uartTxChar('\n');
+}
+
+/* Waits until the UART has sent everything, so the next run starts idle */
+static void uartTxIdle(void)
+{
+    while (uartTxFree(0) < UART_TX_BUF_SIZE)
+    {
+        cpuWfi();
+    }
+    while (GET32(UART0_BASE + 0x018) & (1 << 3));      // UARTFR.BUSY
+}
+
+int main(void)
+{
+    benchInit("UART TX benchmark");
+    uartTxIdle();
+
+    // Polled: the CPU copies every character and waits for room in the FIFO
+    uint32_t start = benchCycles();
+    for (uint32_t line = 0; line < BENCH_LINES; line++)
+    {
+        uartTxString((const int8_t *)benchLine);
+    }
+    uint32_t polledCycles = benchCycles() - start;
+    uartTxIdle();
+
+    // DMA: the CPU queues the lines, the DMA interrupt runs once per control block list
+    uartDmaInit();
+    uint32_t irqStart = benchIrqCycles;
+    start = benchCycles();
+    for (uint32_t line = 0; line < BENCH_LINES; line++)
+    {
+        while (uartDmaWrite(benchLine, sizeof(benchLine) - 1, UART_DMA_CRLF, 0, 0) != 0)
+        {
+            cpuWfi();
+        }
+    }
+    uint32_t irqQueue = benchIrqCycles - irqStart;
+    uint32_t queueCycles = benchCycles() - start - irqQueue;               // Interrupts are counted apart
+    while (uartDmaBusy())
+    {
+        cpuWfi();
+    }
+    uint32_t irqCycles = benchIrqCycles - irqStart;
+    uartTxIdle();
+
+    UartDmaStats stats;
+    uartDmaGetStats(&stats);
+    uartWriteAll(0, (const uint8_t *)"\r\n", 2);
+    benchResult("polled uartTxString", polledCycles, "cycles/KB");
+    benchResult("DMA uartDmaWrite", queueCycles + irqCycles, "cycles/KB");
+    benchResult("  queueing", queueCycles, "cycles");
+    benchResult("  DMA interrupt", irqCycles, "cycles");
+    benchResult("  control block lists", stats.chains, "lists");
+    benchResult("  sent", stats.bytes, "bytes");
+    benchDone();
+    return 0;
+}
@@ -0,0 +1,117 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* XIP benchmark: the same loop run from flash and from SRAM (TIME_CRITICAL,
+   see ../bsp/crt0.h)
+   - flash, cold cache: the XIP cache is invalidated before every run, the
+     instruction fetches miss and wait for the QSPI flash
+   - flash, warm cache: the loop is already in the cache
+   - SRAM, cold cache: the cache is invalidated too, but the loop does not
+     go through it
+   Every case runs BENCH_RUNS times with the interrupts disabled: min, mean
+   and max cycles of a run, and the jitter (max - min).
+   The kernel (bitwise CRC-32) has a nop per bit, so that it also costs time
+   on the simulator, which has no XIP cache: there both copies take the same
+   cycles, only the board shows the difference.
+*/
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "bench.h"
+
+#define BENCH_RUNS      (32)
+#define BENCH_BYTES     (64)
+
+typedef uint32_t (*BenchKernel)(const uint8_t *data, uint32_t len);
+
+static uint8_t benchData[BENCH_BYTES];
+
+/* Body of both kernels, so that they only differ by their address */
+#define BENCH_CRC32(data, len)                                              \
+    uint32_t crc = 0xffffffffu;                                             \
+    for (uint32_t i = 0; i < (len); i++)                                    \
+    {                                                                       \
+        crc ^= (data)[i];                                                   \
+        for (uint32_t bit = 0; bit < 8; bit++)                              \
+        {                                                                   \
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));            \
+            cpuNop();                                                       \
+        }                                                                   \
+    }                                                                       \
+    return ~crc
+
+/* noipa: -O2 must neither inline it nor merge it with the SRAM copy */
+static __attribute__((noipa)) uint32_t benchFlash(const uint8_t *data, uint32_t len)
+{
+    BENCH_CRC32(data, len);
+}
+
+static uint32_t TIME_CRITICAL(benchSram)(const uint8_t *data, uint32_t len)
+{
+    BENCH_CRC32(data, len);
+}
+
+/* Invalidates every line of the XIP cache by set/way */
+static void TIME_CRITICAL(benchXipInvalidate)(void)
+{
+    for (uint32_t line = 0; line < XIP_CACHE_SIZE; line += XIP_CACHE_LINE)
+    {
+        PUT32((XIP_MAINTENANCE_BASE + line + XIP_INVALIDATE_BY_SET_WAY), 0);
+    }
+    cpuDsb();
+    cpuIsb();
+}
+
+/* Runs the kernel BENCH_RUNS times and prints the statistics, returns the CRC */
+static uint32_t benchRun(const char *name, BenchKernel kernel, int cold)
+{
+    uint32_t min = 0xffffffffu;
+    uint32_t max = 0;
+    uint32_t sum = 0;
+    uint32_t crc = 0;
+    if (!cold)
+    {
+        kernel(benchData, BENCH_BYTES);                                    // Loads the cache
+    }
+    for (uint32_t run = 0; run < BENCH_RUNS; run++)
+    {
+        if (cold)
+        {
+            benchXipInvalidate();
+        }
+        uint32_t primask = cpuIrqSave();
+        uint32_t start = benchCycles();
+        crc = kernel(benchData, BENCH_BYTES);
+        uint32_t cycles = benchCycles() - start;
+        cpuIrqRestore(primask);
+        min = (cycles < min) ? cycles : min;
+        max = (cycles > max) ? cycles : max;
+        sum += cycles;
+    }
+    benchPrint(name);
+    benchPrint("\r\n");
+    benchResult("  min", min, "cycles");
+    benchResult("  mean", sum / BENCH_RUNS, "cycles");
+    benchResult("  max", max, "cycles");
+    benchResult("  jitter", max - min, "cycles");
+    return crc;
+}
+
+int main(void)
+{
+    benchInit("XIP benchmark");
+    for (uint32_t i = 0; i < BENCH_BYTES; i++)
+    {
+        benchData[i] = (uint8_t)(i * 7 + 3);
+    }
+
+    uint32_t crc = benchRun("flash, cold cache", benchFlash, 1);
+    uint32_t errors = (benchRun("flash, warm cache", benchFlash, 0) != crc) ? 1 : 0;
+    errors += (benchRun("SRAM, cold cache", benchSram, 1) != crc) ? 1 : 0;
+    benchResult("checksum errors", errors, "");
+
+    benchDone();
+    return 0;
+}
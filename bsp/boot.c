@@ -0,0 +1,87 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "clocks.h"
+#include "boot.h"
+
+#define BOOT_MAGIC (0x424f4f54)         // "BOOT"
+
+static BootRecord bootRecord __attribute__((section(".noinit")));
+
+/* Latest stamp, the start of the next interval */
+static uint32_t bootStarted;
+static uint32_t bootLastCycles;
+static uint32_t bootLastUs;
+static uint32_t bootLastHz;
+
+void bootReset(uint32_t start)
+{
+    int valid = (bootRecord.magic == BOOT_MAGIC);
+    for (uint32_t phase = 0; phase < BOOT_PHASES; phase++)
+    {
+        bootRecord.previousUs[phase] = valid ? bootRecord.us[phase] : BOOT_NONE;
+        bootRecord.us[phase] = BOOT_NONE;
+    }
+    bootRecord.resets = valid ? (bootRecord.resets + 1) : 1;
+    bootRecord.magic = BOOT_MAGIC;
+    bootRecord.us[BOOT_RESET] = 0;
+
+    bootStarted = 1;
+    bootLastCycles = start;
+    bootLastUs = 0;
+    bootLastHz = clocksGetSysHz() ? clocksGetSysHz() : ROSC_HZ;
+}
+
+void bootStamp(uint32_t phase)
+{
+    if (!bootStarted)
+    {
+        cpuCycleCounterStart();                                            // Host build: no Reset_Handler
+        bootReset(0);
+    }
+    uint32_t cycles = cpuCycles();
+    uint32_t us = bootLastUs + (uint32_t)(((uint64_t)(cycles - bootLastCycles) * 1000000) / bootLastHz);
+    if ((phase < BOOT_PHASES) && (bootRecord.us[phase] == BOOT_NONE))
+    {
+        bootRecord.us[phase] = us;
+    }
+    bootLastCycles = cycles;
+    bootLastUs = us;
+    bootLastHz = clocksGetSysHz() ? clocksGetSysHz() : ROSC_HZ;           // clk_sys of the next interval
+}
+
+const BootRecord *bootGetRecord(void)
+{
+    return &bootRecord;
+}
+
+void bootPrint(TextWriter write)
+{
+    static const char *const names[BOOT_PHASES] = { "reset", "main", "clocks", "peripherals", "core 1", "first byte" };
+    textWrite(write, "boot count: ");
+    textWriteValue(write, bootRecord.resets, 10);
+    textWrite(write, "\r\n");
+    for (uint32_t phase = 0; phase < BOOT_PHASES; phase++)
+    {
+        if (bootRecord.us[phase] == BOOT_NONE)
+        {
+            continue;
+        }
+        textWrite(write, "boot ");
+        textWrite(write, names[phase]);
+        textWrite(write, ": ");
+        textWriteValue(write, bootRecord.us[phase], 10);
+        textWrite(write, " us");
+        if (bootRecord.previousUs[phase] != BOOT_NONE)
+        {
+            textWrite(write, " (previous boot: ");
+            textWriteValue(write, bootRecord.previousUs[phase], 10);
+            textWrite(write, " us)");
+        }
+        textWrite(write, "\r\n");
+    }
+}
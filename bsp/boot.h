@@ -0,0 +1,61 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Boot time stamps
+   The boot of core 0 is cut in phases, each one stamped once with the cycle
+   counter that Reset_Handler starts first thing: crt0.c stamps BOOT_RESET
+   and BOOT_MAIN, the application the others (bootStamp()) as it reaches
+   them, in any order. The stamps are converted to microseconds since the
+   reset vector with the clk_sys of each interval (clocksGetSysHz(), the
+   nominal ROSC_HZ of the ring oscillator before clocksInit(): the phases up
+   to BOOT_CLOCKS are approximate). The cycle counter stops while the core
+   sleeps: the boot path does not sleep.
+   The record is in .noinit (see linker_script.ld), which Reset_Handler
+   neither copies nor zeroes: it survives a reset (not a power cycle), so it
+   also holds the stamps of the previous boot and counts the resets. It can
+   be printed once the UART runs (bootPrint()), or read by a debugger.
+   On a host build the simulation starts at cycle 0, Reset_Handler does not
+   run: the first bootStamp() starts the record.
+*/
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include "text.h"
+
+#define BOOT_RESET       (0)            // Reset_Handler entered (crt0.c)
+#define BOOT_MAIN        (1)            // .data/.bss ready, main() called (crt0.c)
+#define BOOT_CLOCKS      (2)            // clocksInit() done: XOSC, PLLs, clk_sys
+#define BOOT_PERIPHERALS (3)            // peripherals out of reset and configured
+#define BOOT_CORE1       (4)            // core 1 launched
+#define BOOT_FIRST_BYTE  (5)            // first byte handed to the UART
+#define BOOT_PHASES      (6)
+#define BOOT_NONE        (0xffffffff)   // phase not reached
+
+#define ROSC_HZ          (11000000)     // nominal ring oscillator, clk_sys out of the bootrom
+
+typedef struct {
+    uint32_t magic;                     // BOOT_MAGIC once the record is valid
+    uint32_t resets;                    // boots since the power-on, 1 for the first one
+    uint32_t us[BOOT_PHASES];           // this boot, BOOT_NONE if not reached
+    uint32_t previousUs[BOOT_PHASES];   // the boot before (BOOT_NONE after a power-on)
+} BootRecord;
+
+/* Starts the record of this boot, whose reset vector was at the cycle count
+   start. Called by Reset_Handler once .bss is zeroed */
+void bootReset(uint32_t start);
+
+/* Stamps a phase (BOOT_*) with the time since the reset vector. Core 0,
+   thread mode. A phase keeps its first stamp */
+void bootStamp(uint32_t phase);
+
+/* The record, in .noinit */
+const BootRecord *bootGetRecord(void);
+
+/* Writes the record as text, e.g. on the UART: "boot count: <resets>", then
+   a line per phase reached, "boot <phase>: <us> us (previous boot: <us> us)" */
+void bootPrint(TextWriter write);
+
+#endif /* BOOT_H */
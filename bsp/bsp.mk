@@ -0,0 +1,132 @@
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+# Shared build of the firmwares, included by the Makefiles of the examples and
+# of the benchmarks. They set NAME (and APPOBJS when the firmware has more
+# sources than $(NAME).c) before including it.
+#   make [ISA=arm|riscv] [PROFILE=debug|release|size] [CLK_SYS_HZ=...] [PROF=1] [target]
+#   all:    builds $(NAME).elf/.uf2 and prints the size report
+#           (ISA=riscv: $(NAME)_riscv.elf/.uf2 for the Hazard3 cores)
+#   load:   flashes the .elf using openocd with the pi debug probe
+#   loadpt: flashes the .elf using picotool (board in BOOTSEL mode)
+#   size:   prints the size report again (CYCLES=report.csv adds the cycles
+#           of the host simulator, see ../host/README.md)
+#   stack:  prints the stack report (needs STACKUSAGE=1, CAPTURE=uart.log
+#           adds the watermarks printed by stackPrint(), see ../bsp/stack.h,
+#           STACKROOTS="main schedCore1" the entry points, main by default)
+#   host / hostrun: see ../host/host.mk
+#   clean:  removes all generated files
+# Every driver of this directory is built into a library, so a firmware only
+# links the modules it uses. The objects of each profile are kept apart in
+# obj/$(ISA)/$(PROFILE), run make clean after changing CLK_SYS_HZ, PROF or
+# STACKUSAGE.
+.PHONY: all load loadpt size stack clean
+
+CPU      = cortex-m33
+ARMGNU   = arm-none-eabi
+RISCVGNU = riscv32-unknown-elf
+OPENOCD  = openocd
+OOCDINT  = cmsis-dap#cmsis-dap for picoprobe
+PICOTOOL = picotool
+PYTHON   = python3
+FLOAT    = -mfloat-abi=soft#options: ‘soft’, ‘softfp’ and ‘hard’.
+BSPDIR   = ../bsp
+TOOLSDIR = ../tools
+CLK_SYS_HZ ?= 150000000#clk_sys frequency in Hz generated by PLL_SYS (see ../bsp/clocks.h)
+PROF     ?= 0#1: builds the profiling probes (see ../bsp/prof.h and ../tools/profdecode.py)
+STACKUSAGE ?= 0#1: writes the stack usage and the calls of every function next to its object (../tools/stackreport.py)
+PROFILE  ?= debug#debug: -O0, release: -O2 with LTO, size: -Os with LTO
+ISA      ?= arm#arm: Cortex-M33, riscv: Hazard3 (rv32imac with the bit manipulation extensions)
+APPOBJS  ?= $(NAME).o
+
+ifeq ($(PROFILE),debug)
+OPTI     = -O0
+else ifeq ($(PROFILE),release)
+OPTI     = -O2 -flto
+else ifeq ($(PROFILE),size)
+OPTI     = -Os -flto
+else
+$(error PROFILE must be debug, release or size)
+endif
+
+ifeq ($(ISA),arm)
+GNU      = $(ARMGNU)
+ARCH     = -mcpu=$(CPU) -mthumb $(FLOAT)
+SPECS    = --specs=nosys.specs --specs=nano.specs
+TARGET   = $(NAME)
+UF2FAMILY = rp2350-arm-s
+OOCDTARGET = rp2350
+else ifeq ($(ISA),riscv)
+GNU      = $(RISCVGNU)
+ARCH     = -march=rv32imac_zicsr_zifencei_zba_zbb_zbs_zbkb -mabi=ilp32
+SPECS    =
+TARGET   = $(NAME)_riscv
+UF2FAMILY = rp2350-riscv
+OOCDTARGET = rp2350-riscv
+else
+$(error ISA must be arm or riscv)
+endif
+
+# The optimizer must not turn the copy loops into memcpy/memset calls: they do
+# not exist with -nostdlib. libgcc provides the 64-bit divisions.
+OPTI    += -fno-tree-loop-distribute-patterns
+
+OBJDIR   = obj/$(ISA)/$(PROFILE)
+BSPSRCS  = $(wildcard $(BSPDIR)/*.c)
+BSPLIB   = $(OBJDIR)/libbsp.a
+OBJS     = $(addprefix $(OBJDIR)/,$(APPOBJS) crt0.o)
+LDSCRIPT = $(BSPDIR)/linker_script.ld
+DEFINES  = -I$(BSPDIR) -DCLK_SYS_HZ=$(CLK_SYS_HZ) -DPROF_ENABLE=$(PROF)
+CFLAGS   = $(ARCH) -std=gnu11 -g $(OPTI) -ffreestanding -nostdlib -ffunction-sections -fdata-sections $(DEFINES)
+ifeq ($(STACKUSAGE),1)
+CFLAGS  += -fstack-usage -fcallgraph-info=su
+endif
+LDFLAGS  = $(ARCH) $(OPTI) -nostdlib -nostartfiles $(SPECS) -Wl,--gc-sections -Wl,-Map=output.map
+SIZEREPORT = $(PYTHON) $(TOOLSDIR)/size_report.py output.map --top 10
+
+all: $(TARGET).elf
+
+$(OBJDIR):
+	mkdir -p $@
+
+$(OBJDIR)/%.o: %.c $(wildcard *.h) $(BSPDIR)/*.h | $(OBJDIR)
+	$(GNU)-gcc $(CFLAGS) -c $< -o $@
+
+$(OBJDIR)/%.o: $(BSPDIR)/%.c $(BSPDIR)/*.h | $(OBJDIR)
+	$(GNU)-gcc $(CFLAGS) -c $< -o $@
+
+# crt0.o is linked as an object (nothing refers to Reset_Handler), the other
+# drivers are only taken from the library when the firmware calls them
+$(BSPLIB): $(addprefix $(OBJDIR)/,$(notdir $(patsubst %.c,%.o,$(filter-out $(BSPDIR)/crt0.c,$(BSPSRCS)))))
+	rm -f $@
+	$(GNU)-gcc-ar rcs $@ $^
+
+$(TARGET).elf: $(LDSCRIPT) $(OBJS) $(BSPLIB)
+	$(GNU)-gcc $(LDFLAGS) -T $(LDSCRIPT) $(OBJS) $(BSPLIB) -lgcc -o $(TARGET).elf
+	objdump -x $(OBJDIR)/$(NAME).o > $(TARGET).list
+	$(PICOTOOL) uf2 convert $(TARGET).elf $(TARGET).uf2 --family $(UF2FAMILY)
+	$(SIZEREPORT) --baseline $(TARGET).size.json --save $(TARGET).size.json
+
+size: $(TARGET).elf
+	$(SIZEREPORT) $(if $(CYCLES),--cycles $(CYCLES))
+
+# Frames of the functions, worst call paths and the watermarks of a capture
+stack: $(TARGET).elf
+	$(PYTHON) $(TOOLSDIR)/stackreport.py $(OBJDIR) $(if $(CAPTURE),--capture $(CAPTURE)) $(addprefix --root ,$(STACKROOTS))
+
+# Load .elf using openocd
+load: $(TARGET).elf
+	$(OPENOCD) -f interface/$(OOCDINT).cfg -f target/$(OOCDTARGET).cfg -c "adapter speed 5000" -c "program $(TARGET).elf verify reset exit"
+
+# Load .elf using picotool when pico board is in BOOTSEL mode
+loadpt: $(TARGET).elf
+	sudo picotool load $(TARGET).elf -x
+
+# Build and run on the PC against the RP2350 simulator
+HOSTSRCS = $(APPOBJS:.o=.c) $(BSPSRCS)
+include ../host/host.mk
+
+clean:
+	rm -rf obj
+	rm -f *.bin *.o *.elf *.list *.map *.uf2 *.host *.size.json
@@ -0,0 +1,200 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "multicore.h"
+#include "channel.h"
+
+#define CHANNEL_SKIP     (0xffffffffu)  // header of the unused words at the end of the ring
+#define CHANNEL_DOORBELL (0x0000c4a7u)  // FIFO word of a doorbell, the value is not checked
+
+static uint32_t channelMsgWords(uint32_t len)
+{
+    return 1 + ((len + 3) / 4);
+}
+
+/* Copies len bytes, a word at a time when both pointers are aligned
+   (no memcpy with -nostdlib) */
+static void channelCopy(void *dst, const void *src, uint32_t len)
+{
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    if ((((uintptr_t)d | (uintptr_t)s) & 3) == 0)
+    {
+        for (; len >= 4; len -= 4, d += 4, s += 4)
+        {
+            *(uint32_t *)d = *(const uint32_t *)s;
+        }
+    }
+    while (len--)
+    {
+        *d++ = *s++;
+    }
+}
+
+void channelInit(Channel *channel, uint32_t *ring, uint32_t words)
+{
+    channel->head = channel->tail = 0;
+    channel->sleeping = 0;
+    channel->sent = channel->full = channel->doorbells = 0;
+    channel->received = channel->sleeps = 0;
+    channel->ring = ring;
+    channel->words = words;
+    cpuDmb();
+}
+
+/* Writes a message at head if there is room for it (and for the skip marker
+   when it has to wrap). Returns the new head, or head if it does not fit */
+static uint32_t channelWrite(Channel *channel, uint32_t head, uint32_t tail, const void *data, uint32_t len)
+{
+    uint32_t need = channelMsgWords(len);
+    uint32_t pos = head & (channel->words - 1);
+    uint32_t toEnd = channel->words - pos;
+    uint32_t total = (need > toEnd) ? (toEnd + need) : need;
+    if ((need > (channel->words / 2)) || (total > (channel->words - (head - tail))))
+    {
+        return head;
+    }
+    if (total != need)
+    {
+        channel->ring[pos] = CHANNEL_SKIP;
+        pos = 0;
+    }
+    channel->ring[pos] = len;
+    channelCopy(&channel->ring[pos + 1], data, len);
+    return head + total;
+}
+
+/* Makes the messages up to head visible to the consumer and wakes it up */
+static void channelPublish(Channel *channel, uint32_t head)
+{
+    cpuDmb();                                                              // Release: the data before head
+    channel->head = head;
+    cpuDmb();                                                              // head before sleeping (see channelWait)
+    if (channel->sleeping)
+    {
+        channel->doorbells++;
+        if (multicoreFifoTryPush(CHANNEL_DOORBELL) != 0)
+        {
+            cpuSev();                                                      // FIFO full: doorbells are already waiting
+        }
+    }
+}
+
+int channelSend(Channel *channel, const void *data, uint32_t len)
+{
+    ChannelMsg msg = { data, len };
+    return (channelSendBatch(channel, &msg, 1) == 1) ? 0 : -1;
+}
+
+uint32_t channelSendBatch(Channel *channel, const ChannelMsg *msgs, uint32_t count)
+{
+    uint32_t head = channel->head;
+    uint32_t tail = channel->tail;
+    uint32_t sent = 0;
+    cpuDmb();                                                              // The consumer is done with the words before tail
+    while (sent < count)
+    {
+        uint32_t next = channelWrite(channel, head, tail, msgs[sent].data, msgs[sent].len);
+        if (next == head)
+        {
+            channel->full++;
+            break;
+        }
+        head = next;
+        sent++;
+    }
+    if (sent > 0)
+    {
+        channel->sent += sent;
+        channelPublish(channel, head);
+    }
+    return sent;
+}
+
+/* Position of the message at tail, skipping the marker at the end of the ring */
+static uint32_t channelMsgAt(const Channel *channel, uint32_t *tail)
+{
+    uint32_t pos = *tail & (channel->words - 1);
+    if (channel->ring[pos] == CHANNEL_SKIP)
+    {
+        *tail += channel->words - pos;
+        pos = 0;
+    }
+    return pos;
+}
+
+int channelReceive(Channel *channel, void *data, uint32_t maxLen)
+{
+    uint32_t tail = channel->tail;
+    if (tail == channel->head)
+    {
+        return -1;
+    }
+    cpuDmb();                                                              // Acquire: the data after head
+    uint32_t pos = channelMsgAt(channel, &tail);
+    uint32_t len = channel->ring[pos];
+    channelCopy(data, &channel->ring[pos + 1], (len < maxLen) ? len : maxLen);
+    cpuDmb();                                                              // Done with the data before tail
+    channel->tail = tail + channelMsgWords(len);
+    channel->received++;
+    return (int)len;
+}
+
+uint32_t channelReceiveBatch(Channel *channel, ChannelHandler handler, void *context, uint32_t max)
+{
+    uint32_t tail = channel->tail;
+    uint32_t head = channel->head;
+    uint32_t count = 0;
+    cpuDmb();                                                              // Acquire: the data after head
+    while ((count < max) && (tail != head))
+    {
+        uint32_t pos = channelMsgAt(channel, &tail);
+        uint32_t len = channel->ring[pos];
+        handler(context, &channel->ring[pos + 1], len);
+        tail += channelMsgWords(len);
+        count++;
+    }
+    if (count > 0)
+    {
+        cpuDmb();                                                          // Done with the data before tail
+        channel->tail = tail;
+        channel->received += count;
+    }
+    return count;
+}
+
+/* sleeping is set before head is checked, and the producer writes head before
+   it checks sleeping: one of the two always sees the other (dmb on both sides) */
+void channelWait(Channel *channel)
+{
+    while (channel->tail == channel->head)
+    {
+        channel->sleeping = 1;
+        cpuDmb();
+        if (channel->tail == channel->head)
+        {
+            channel->sleeps++;
+            cpuWfe();                                                      // Woken up by the doorbell (or any other event)
+        }
+        channel->sleeping = 0;
+        multicoreFifoDrain();                                              // Doorbells carry no data
+    }
+}
+
+uint32_t channelPending(const Channel *channel)
+{
+    return channel->head - channel->tail;
+}
+
+void channelGetStats(const Channel *channel, ChannelStats *stats)
+{
+    stats->sent = channel->sent;
+    stats->full = channel->full;
+    stats->doorbells = channel->doorbells;
+    stats->received = channel->received;
+    stats->sleeps = channel->sleeps;
+}
@@ -0,0 +1,90 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Single producer / single consumer message channel between the two cores
+   The messages travel through a ring of words in shared SRAM, not through the
+   8 words of the SIO FIFO: the producer (one core) only writes head, the
+   consumer (the other core) only writes tail, so no lock is needed. A dmb
+   orders the message data before head (release) and the reads of the data
+   after head (acquire).
+   A message is a header word with its length in bytes followed by the data,
+   padded to a word. It is never split: when it does not fit before the end of
+   the ring, a skip marker fills the end and the message starts at word 0, so
+   the consumer can read it in place (channelReceiveBatch).
+   The SIO FIFO is only a doorbell: when the consumer sleeps (channelWait),
+   the producer pushes a word into its FIFO and sends an event. The value of
+   the word is not used, so the FIFO must not carry data while channels are in
+   use.
+*/
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <stdint.h>
+
+/* head and tail are written by different cores: they are kept in separate
+   32 byte blocks (the size of a cache line of the M33 caches, SRAM itself is
+   not cached on the RP2350), so each core polls a word only it writes */
+#define CHANNEL_ALIGN (32)
+
+typedef struct {
+    uint32_t sent;              // messages sent
+    uint32_t full;              // sends rejected because the ring was full
+    uint32_t doorbells;         // consumer wake ups sent through the SIO FIFO
+    uint32_t received;          // messages received
+    uint32_t sleeps;            // times the consumer slept in channelWait
+} ChannelStats;
+
+typedef struct {
+    // Producer side
+    volatile uint32_t head __attribute__((aligned(CHANNEL_ALIGN)));   // words written, runs freely
+    uint32_t sent;
+    uint32_t full;
+    uint32_t doorbells;
+    // Consumer side
+    volatile uint32_t tail __attribute__((aligned(CHANNEL_ALIGN)));   // words read, runs freely
+    volatile uint32_t sleeping;                                       // consumer waits for a doorbell
+    uint32_t received;
+    uint32_t sleeps;
+    // Read only after channelInit
+    uint32_t *ring __attribute__((aligned(CHANNEL_ALIGN)));
+    uint32_t words;
+} Channel;
+
+typedef struct {
+    const void *data;
+    uint32_t len;
+} ChannelMsg;
+
+/* Called for every message by channelReceiveBatch, data points into the ring */
+typedef void (*ChannelHandler)(void *context, const void *data, uint32_t len);
+
+/* ring has words 32-bit words, a power of two. A message can carry up to
+   (words / 2 - 1) * 4 bytes. Called before any of the cores uses the channel. */
+void channelInit(Channel *channel, uint32_t *ring, uint32_t words);
+
+/* Producer: queues a message. Returns 0, or -1 if there is no room */
+int channelSend(Channel *channel, const void *data, uint32_t len);
+
+/* Producer: queues up to count messages with a single head update and a
+   single doorbell. Returns the number of messages queued */
+uint32_t channelSendBatch(Channel *channel, const ChannelMsg *msgs, uint32_t count);
+
+/* Consumer: copies the next message into data (up to maxLen bytes) and
+   returns its length, or -1 if the channel is empty */
+int channelReceive(Channel *channel, void *data, uint32_t maxLen);
+
+/* Consumer: calls handler for up to max messages in place, then frees their
+   space at once. Returns the number of messages handled */
+uint32_t channelReceiveBatch(Channel *channel, ChannelHandler handler, void *context, uint32_t max);
+
+/* Consumer: sleeps (wfe) until the channel has a message */
+void channelWait(Channel *channel);
+
+/* Number of words waiting in the ring */
+uint32_t channelPending(const Channel *channel);
+
+void channelGetStats(const Channel *channel, ChannelStats *stats);
+
+#endif /* CHANNEL_H */
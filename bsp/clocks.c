@@ -0,0 +1,184 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "regs.h"
+#include "clocks.h"
+
+/* PLL limits (see section 8.6 "PLL" on RP2350 datasheet) */
+#define PLL_VCO_MIN_HZ (750000000)
+#define PLL_VCO_MAX_HZ (1600000000)
+#define PLL_FBDIV_MIN  (16)
+#define PLL_FBDIV_MAX  (320)
+
+/* XOSC startup delay in units of 256 crystal cycles: about 1ms, the value of
+   the pico-sdk (the reset value 0xc4 is 4.2ms). A crystal that needs longer
+   to settle can override it (make ... DEFINES+=-DXOSC_STARTUP_UNITS=...) */
+#ifndef XOSC_STARTUP_UNITS
+#define XOSC_STARTUP_UNITS (((XOSC_HZ / 1000) + 128) / 256)
+#endif
+
+typedef struct {
+    uint32_t fbdiv;
+    uint32_t postDiv1;
+    uint32_t postDiv2;
+} PllConfig;
+
+static uint32_t clkRefHz;
+static uint32_t clkSysHz;
+static uint32_t clkPeriHz;
+static uint32_t clkUsbHz;
+
+/* Searches the PLL dividers for outHz with REFDIV = 1, starting with the
+   lowest VCO frequency (lowest power). Returns 0 if found.
+*/
+static int pllFindConfig(uint32_t outHz, PllConfig *config)
+{
+    for (uint32_t fbdiv = PLL_FBDIV_MIN; fbdiv <= PLL_FBDIV_MAX; fbdiv++)
+    {
+        uint32_t vcoHz = XOSC_HZ * fbdiv;
+        if ((vcoHz < PLL_VCO_MIN_HZ) || (vcoHz > PLL_VCO_MAX_HZ))
+        {
+            continue;
+        }
+        for (uint32_t postDiv1 = 7; postDiv1 >= 1; postDiv1--)
+        {
+            for (uint32_t postDiv2 = postDiv1; postDiv2 >= 1; postDiv2--)
+            {
+                if ((vcoHz / (postDiv1 * postDiv2) == outHz) && (vcoHz % (postDiv1 * postDiv2) == 0))
+                {
+                    config->fbdiv = fbdiv;
+                    config->postDiv1 = postDiv1;
+                    config->postDiv2 = postDiv2;
+                    return 0;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/* Starts a PLL following section 8.6.3 "Configuration" on RP2350 datasheet,
+   up to the power up of the VCO: pllFinish() waits for the lock, so both
+   PLLs lock at the same time */
+static void pllStart(uint32_t base, const PllConfig *config)
+{
+    REG_WRITE(base, PLL_CS_REFDIV, REG_VALUE(PLL_CS_REFDIV, 1));
+    REG_WRITE(base, PLL_FBDIV_INT, REG_VALUE(PLL_FBDIV_INT, config->fbdiv));  // Feedback divider
+    REG_CLR(base, (PLL_PWR_VCOPD | PLL_PWR_PD));                           // Power up VCO and PLL
+}
+
+static void pllFinish(uint32_t base, const PllConfig *config)
+{
+    while (!REG_TEST(base, PLL_CS_LOCK));
+    REG_WRITE(base, (PLL_PRIM_POSTDIV1 | PLL_PRIM_POSTDIV2),
+              (REG_VALUE(PLL_PRIM_POSTDIV1, config->postDiv1) | REG_VALUE(PLL_PRIM_POSTDIV2, config->postDiv2)));
+    REG_CLR(base, PLL_PWR_POSTDIVPD);                                      // Power up post dividers
+}
+
+void clocksStartXosc(void)
+{
+    if (REG_TEST(XOSC_BASE, XOSC_STATUS_STABLE) || (REG_READ(XOSC_BASE, XOSC_CTRL_ENABLE) == XOSC_ENABLE_VALUE))
+    {
+        return;                                                            // Running, or starting already
+    }
+    // Startup delay, then range 1-15MHz and enable in one store
+    REG_WRITE(XOSC_BASE, XOSC_STARTUP_DELAY, REG_VALUE(XOSC_STARTUP_DELAY, XOSC_STARTUP_UNITS));
+    REG_WRITE(XOSC_BASE, (XOSC_CTRL_FREQ_RANGE | XOSC_CTRL_ENABLE),
+              (REG_VALUE(XOSC_CTRL_FREQ_RANGE, XOSC_FREQ_RANGE_1_15MHZ) | REG_VALUE(XOSC_CTRL_ENABLE, XOSC_ENABLE_VALUE)));
+}
+
+int clocksInit(uint32_t sysHz)
+{
+    PllConfig sysPll;
+    PllConfig usbPll;
+    int sysFromXosc = (sysHz == XOSC_HZ);
+
+    if (!sysFromXosc && (pllFindConfig(sysHz, &sysPll) != 0))
+    {
+        return -1;
+    }
+    pllFindConfig(CLK_USB_HZ, &usbPll);
+
+    // Setup XOC clock (nothing to do when it is already running, e.g. changing
+    // frequency at run time, or started early by clocksStartXosc())
+    clocksStartXosc();
+    while (!REG_TEST(XOSC_BASE, XOSC_STATUS_STABLE));                      // Wait for XOC stable
+
+    // clk_ref = XOSC. Glitchless mux: wait until the new source is selected
+    REG_WRITE(CLOCKS_BASE, CLK_REF_DIV_INT, REG_VALUE(CLK_REF_DIV_INT, 1));
+    REG_WRITE(CLOCKS_BASE, CLK_REF_CTRL_SRC, REG_VALUE(CLK_REF_CTRL_SRC, 2));   // xosc_clksrc
+    while (REG_READ(CLOCKS_BASE, CLK_REF_SELECTED) != (1 << 2));
+    clkRefHz = XOSC_HZ;
+
+    // Move clk_sys to clk_ref while PLL_SYS is (re)configured, and stop
+    // clk_usb before PLL_USB, its source, goes through reset
+    REG_CLR(CLOCKS_BASE, CLK_SYS_CTRL_SRC);                                // SRC = clk_ref
+    while (REG_READ(CLOCKS_BASE, CLK_SYS_SELECTED) != (1 << 0));
+    REG_CLR(CLOCKS_BASE, CLK_USB_CTRL_ENABLE);
+
+    // Both PLLs out of reset with one write, then they lock in parallel
+    uint32_t pllResets = (sysFromXosc ? 0 : RESETS_PLL_SYS) | RESETS_PLL_USB;
+    PUT32((RESETS_BASE + WRITE_SET + 0x0), pllResets);                     // Put the PLLs in reset
+    PUT32((RESETS_BASE + WRITE_CLR + 0x0), pllResets);                     // De-assert the reset
+    while ((GET32(RESETS_BASE + 0x08) & pllResets) != pllResets);          // Wait for the PLLs to be ready
+    if (!sysFromXosc)
+    {
+        pllStart(PLL_SYS_BASE, &sysPll);
+    }
+    pllStart(PLL_USB_BASE, &usbPll);
+    if (!sysFromXosc)
+    {
+        pllFinish(PLL_SYS_BASE, &sysPll);
+    }
+    pllFinish(PLL_USB_BASE, &usbPll);
+
+    // clk_sys = PLL_SYS (or XOSC). The aux mux is only changed while clk_sys runs from clk_ref
+    REG_WRITE(CLOCKS_BASE, CLK_SYS_DIV_INT, REG_VALUE(CLK_SYS_DIV_INT, 1));
+    REG_WRITE(CLOCKS_BASE, CLK_SYS_CTRL_AUXSRC, REG_VALUE(CLK_SYS_CTRL_AUXSRC, (sysFromXosc ? 3 : 0)));   // pll_sys / xosc
+    REG_SET(CLOCKS_BASE, CLK_SYS_CTRL_SRC);                                // SRC = clksrc_clk_sys_aux
+    while (REG_READ(CLOCKS_BASE, CLK_SYS_SELECTED) != (1 << 1));
+    clkSysHz = sysHz;
+
+    // clk_peri = clk_sys. It has no glitchless mux: stop it, wait for the
+    // enable to propagate (2 cycles of the slowest clock) and switch
+    REG_CLR(CLOCKS_BASE, CLK_PERI_CTRL_ENABLE);
+    for (uint32_t i = 0; i < 3 * (sysHz / XOSC_HZ); i++)
+    {
+        asm("nop");
+    }
+    REG_WRITE(CLOCKS_BASE, CLK_PERI_DIV_INT, REG_VALUE(CLK_PERI_DIV_INT, 1));
+    REG_WRITE(CLOCKS_BASE, (CLK_PERI_CTRL_ENABLE | CLK_PERI_CTRL_AUXSRC),  // AUXSRC = clk_sys + Enable
+              (REG_VALUE(CLK_PERI_CTRL_ENABLE, 1) | REG_VALUE(CLK_PERI_CTRL_AUXSRC, 0)));
+    clkPeriHz = sysHz;
+
+    // clk_usb = PLL_USB, stopped since the PLL reset
+    REG_WRITE(CLOCKS_BASE, CLK_USB_DIV_INT, REG_VALUE(CLK_USB_DIV_INT, 1));
+    REG_WRITE(CLOCKS_BASE, (CLK_USB_CTRL_ENABLE | CLK_USB_CTRL_AUXSRC),    // AUXSRC = pll_usb + Enable
+              (REG_VALUE(CLK_USB_CTRL_ENABLE, 1) | REG_VALUE(CLK_USB_CTRL_AUXSRC, 0)));
+    clkUsbHz = CLK_USB_HZ;
+
+    return 0;
+}
+
+uint32_t clocksGetRefHz(void)
+{
+    return clkRefHz;
+}
+
+uint32_t clocksGetSysHz(void)
+{
+    return clkSysHz;
+}
+
+uint32_t clocksGetPeriHz(void)
+{
+    return clkPeriHz;
+}
+
+uint32_t clocksGetUsbHz(void)
+{
+    return clkUsbHz;
+}
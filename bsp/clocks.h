@@ -0,0 +1,47 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Clock tree
+   Starts the crystal oscillator and both PLLs and switches the system clocks:
+   - clk_ref  = XOSC (12MHz)
+   - clk_sys  = PLL_SYS (target frequency, e.g. 150MHz)
+   - clk_peri = clk_sys (UART, SPI)
+   - clk_usb  = PLL_USB (48MHz)
+   See chapter 8 "Clocks" on RP2350 datasheet.
+*/
+#ifndef CLOCKS_H
+#define CLOCKS_H
+
+#include <stdint.h>
+
+#define XOSC_HZ    (12000000)   // Pico2 board has a ABM8-272-T3 crystal that oscillates at 12MHz
+#define CLK_USB_HZ (48000000)
+
+/* Target clk_sys frequency selected at build time (make CLK_SYS_HZ=...) */
+#ifndef CLK_SYS_HZ
+#define CLK_SYS_HZ (150000000)
+#endif
+
+/* Starts the crystal oscillator without waiting for it: clocksInit() waits
+   for the rest of its startup delay (about 1ms). Called first thing at boot,
+   the startup of the crystal overlaps the initialization that does not
+   depend on the clocks. Nothing happens if it runs or is starting already. */
+void clocksStartXosc(void);
+
+/* Configures the clock tree for a clk_sys of sysHz.
+   Can be called again at run time to change the frequency. Peripherals
+   running from clk_peri (UART) have to be reconfigured afterwards.
+   Returns 0 on success, or -1 if the PLL cannot generate sysHz exactly
+   (the clocks are then left unchanged).
+*/
+int clocksInit(uint32_t sysHz);
+
+/* Resulting frequencies in Hz (0 before clocksInit) */
+uint32_t clocksGetRefHz(void);
+uint32_t clocksGetSysHz(void);
+uint32_t clocksGetPeriHz(void);
+uint32_t clocksGetUsbHz(void);
+
+#endif /* CLOCKS_H */
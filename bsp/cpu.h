@@ -0,0 +1,214 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Core instructions, Cortex-M33 or Hazard3 (make ISA=riscv)
+   Interrupt masking (PRIMASK, mstatus.MIE on RISC-V), sleep and event
+   instructions and the cycle counter used by the drivers. On a host build
+   they are executed by the RP2350 simulator, which models the Arm cores.
+*/
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+#include "rp2350.h"
+
+#ifdef HOST_SIM
+#include "rp2350_sim.h"
+
+static inline void cpuIrqDisable(void) { sim_asm("cpsid i"); }
+static inline void cpuIrqEnable(void)  { sim_asm("cpsie i"); }
+static inline void cpuWfi(void)        { sim_asm("wfi"); }
+static inline void cpuWfe(void)        { sim_asm("wfe"); }
+static inline void cpuSev(void)        { sim_asm("sev"); }
+static inline void cpuDmb(void)        { sim_asm("dmb"); }
+static inline void cpuDsb(void)        { sim_asm("dsb"); }
+static inline void cpuIsb(void)        { sim_asm("isb"); }
+static inline void cpuNop(void)        { sim_asm("nop"); }
+
+static inline uint32_t cpuIrqSave(void)
+{
+    uint32_t primask = sim_mrs("primask");
+    sim_asm("cpsid i");
+    return primask;
+}
+
+static inline void cpuIrqRestore(uint32_t primask)
+{
+    sim_msr("primask", primask);
+}
+
+static inline uint32_t cpuGetIpsr(void)
+{
+    return sim_mrs("ipsr");
+}
+
+static inline uint32_t cpuGetBasepri(void)
+{
+    return sim_mrs("basepri");
+}
+
+static inline void cpuSetBasepri(uint32_t basepri)
+{
+    sim_msr("basepri", basepri);
+}
+
+static inline void cpuSetMsplim(uint32_t limit)
+{
+    sim_msr("msplim", limit);
+}
+
+static inline void cpuCycleCounterStart(void)
+{
+    PUT32(DEMCR, (GET32(DEMCR) | (1 << 24)));                              // TRCENA: enable the DWT
+    PUT32(DWT_CTRL, (GET32(DWT_CTRL) | (1 << 0)));                         // CYCCNTENA: start the cycle counter
+}
+
+static inline uint32_t cpuCycles(void)
+{
+    return GET32(DWT_CYCCNT);
+}
+#elif defined(__riscv)
+/* Hazard3 CSRs, see section 3.8.6 "Hazard3 CSRs" on RP2350 datasheet. The
+   IRQ arrays (MEIEA, MEIPA, MEIFA, MEIPRA) are accessed through a 16-bit
+   window in bits 31:16, selected by the index in bits 4:0 */
+#define CPU_CSR_MCOUNTINHIBIT (0x320)
+#define CPU_CSR_MEIEA         (0xbe0)   // external IRQ enable array
+#define CPU_CSR_MEIPA         (0xbe1)   // external IRQ pending array
+#define CPU_CSR_MEIFA         (0xbe2)   // external IRQ force array
+#define CPU_CSR_MEIPRA        (0xbe3)   // external IRQ priority array, 4 bits per IRQ
+#define CPU_CSR_MEINEXT       (0xbe4)   // next pending enabled IRQ, bit 31 when none
+#define CPU_CSR_MSLEEP        (0xbf0)   // sleep state of wfi and h3.block
+#define CPU_MSTATUS_MIE       (1u << 3)
+#define CPU_MIE_MSIE          (1u << 3) // software interrupt (SIO RISCV_SOFTIRQ)
+#define CPU_MIE_MTIE          (1u << 7) // timer interrupt (SIO MTIMECMP)
+#define CPU_MIE_MEIE          (1u << 11)
+#define CPU_MSLEEP_DEEPSLEEP  (1u << 0) // the clock of the core stops while it sleeps
+
+#define CPU_STR(x)  #x
+#define CPU_XSTR(x) CPU_STR(x)
+#define cpuCsrRead(csr) \
+    ({ uint32_t cpuValue; __asm volatile ("csrr %0, " CPU_XSTR(csr) : "=r" (cpuValue) :: "memory"); cpuValue; })
+#define cpuCsrReadSet(csr, bits) \
+    ({ uint32_t cpuValue; __asm volatile ("csrrs %0, " CPU_XSTR(csr) ", %1" : "=r" (cpuValue) : "r" ((uint32_t)(bits)) : "memory"); cpuValue; })
+#define cpuCsrWrite(csr, value) __asm volatile ("csrw " CPU_XSTR(csr) ", %0" :: "r" ((uint32_t)(value)) : "memory")
+#define cpuCsrSet(csr, bits)    __asm volatile ("csrs " CPU_XSTR(csr) ", %0" :: "r" ((uint32_t)(bits)) : "memory")
+#define cpuCsrClear(csr, bits)  __asm volatile ("csrc " CPU_XSTR(csr) ", %0" :: "r" ((uint32_t)(bits)) : "memory")
+
+/* Exception number being handled by each core, kept by the trap handler of
+   crt0.c in the numbering of the Arm vector table */
+extern volatile uint32_t crt0Exception[2];
+
+static inline void cpuIrqDisable(void) { __asm volatile ("csrci mstatus, 8" ::: "memory"); }
+static inline void cpuIrqEnable(void)  { __asm volatile ("csrsi mstatus, 8" ::: "memory"); }
+static inline void cpuWfi(void)        { __asm volatile ("wfi" ::: "memory"); }
+static inline void cpuWfe(void)        { __asm volatile ("slt x0, x0, x0" ::: "memory"); }   // h3.block
+static inline void cpuSev(void)        { __asm volatile ("slt x0, x0, x1" ::: "memory"); }   // h3.unblock
+static inline void cpuDmb(void)        { __asm volatile ("fence rw, rw" ::: "memory"); }
+static inline void cpuDsb(void)        { __asm volatile ("fence iorw, iorw" ::: "memory"); }
+static inline void cpuIsb(void)        { __asm volatile ("fence.i" ::: "memory"); }
+static inline void cpuNop(void)        { __asm volatile ("nop"); }
+
+/* Disables the interrupts and returns the previous mstatus */
+static inline uint32_t cpuIrqSave(void)
+{
+    uint32_t mstatus;
+    __asm volatile ("csrrci %0, mstatus, 8" : "=r" (mstatus) :: "memory");
+    return mstatus;
+}
+
+/* Restores the MIE bit of the mstatus returned by cpuIrqSave() */
+static inline void cpuIrqRestore(uint32_t mstatus)
+{
+    cpuCsrSet(mstatus, mstatus & CPU_MSTATUS_MIE);
+}
+
+/* Exception number being handled (16 + IRQ), 0 in thread mode */
+static inline uint32_t cpuGetIpsr(void)
+{
+    return crt0Exception[cpuCsrRead(mhartid)];
+}
+
+/* Starts the mcycle counter of the calling core (MCOUNTINHIBIT.CY) */
+static inline void cpuCycleCounterStart(void)
+{
+    cpuCsrClear(CPU_CSR_MCOUNTINHIBIT, 1);
+}
+
+static inline uint32_t cpuCycles(void)
+{
+    return cpuCsrRead(mcycle);
+}
+#else
+static inline void cpuIrqDisable(void) { __asm volatile ("cpsid i" ::: "memory"); }
+static inline void cpuIrqEnable(void)  { __asm volatile ("cpsie i" ::: "memory"); }
+static inline void cpuWfi(void)        { __asm volatile ("wfi" ::: "memory"); }
+static inline void cpuWfe(void)        { __asm volatile ("wfe" ::: "memory"); }
+static inline void cpuSev(void)        { __asm volatile ("sev" ::: "memory"); }
+static inline void cpuDmb(void)        { __asm volatile ("dmb" ::: "memory"); }
+static inline void cpuDsb(void)        { __asm volatile ("dsb" ::: "memory"); }
+static inline void cpuIsb(void)        { __asm volatile ("isb" ::: "memory"); }
+static inline void cpuNop(void)        { __asm volatile ("nop"); }
+
+/* Disables the interrupts and returns the previous PRIMASK */
+static inline uint32_t cpuIrqSave(void)
+{
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n"
+                    "cpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+/* Restores the PRIMASK returned by cpuIrqSave() */
+static inline void cpuIrqRestore(uint32_t primask)
+{
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+
+/* Exception number being handled (16 + IRQ), 0 in thread mode */
+static inline uint32_t cpuGetIpsr(void)
+{
+    uint32_t ipsr;
+    __asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    return ipsr;
+}
+
+/* BASEPRI: masks the interrupts of priority basepri and lower (numerically
+   greater or equal), 0 masks nothing. Unlike PRIMASK it leaves the more
+   urgent interrupts running. Arm only: Hazard3 has no equivalent */
+static inline uint32_t cpuGetBasepri(void)
+{
+    uint32_t basepri;
+    __asm volatile ("mrs %0, basepri" : "=r" (basepri));
+    return basepri;
+}
+
+static inline void cpuSetBasepri(uint32_t basepri)
+{
+    __asm volatile ("msr basepri, %0\n"
+                    "isb" :: "r" (basepri) : "memory");                    // Masked from the next instruction on
+}
+
+/* MSPLIM: lowest address of the main stack, a push or a sub sp under it
+   raises a UsageFault (STKOF) and is not done. 8 bytes aligned, 0 for no
+   limit. Arm only: Hazard3 has no stack limit */
+static inline void cpuSetMsplim(uint32_t limit)
+{
+    __asm volatile ("msr msplim, %0" :: "r" (limit) : "memory");
+}
+
+/* Starts the DWT cycle counter (CYCCNT) of the calling core */
+static inline void cpuCycleCounterStart(void)
+{
+    PUT32(DEMCR, (GET32(DEMCR) | (1 << 24)));                              // TRCENA: enable the DWT
+    PUT32(DWT_CTRL, (GET32(DWT_CTRL) | (1 << 0)));                         // CYCCNTENA: start the cycle counter
+}
+
+static inline uint32_t cpuCycles(void)
+{
+    return GET32(DWT_CYCCNT);
+}
+#endif
+
+#endif /* CPU_H */
@@ -0,0 +1,377 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "boot.h"
+#include "stack.h"
+
+/* Function declaration */
+int main(void);
+void Default_Handler(void);
+void Reset_Handler(void);
+#ifdef __riscv
+void crt0Trap(void);
+#endif
+
+/* Exception and interrupt handlers. They are weak: a driver or the
+   application overrides one by defining a function with the same name. */
+void NMI_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void HardFault_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void MemManage_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void BusFault_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void UsageFault_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SecureFault_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SVC_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void DebugMon_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PendSV_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SysTick_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER0_IRQ_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER0_IRQ_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER0_IRQ_2_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER0_IRQ_3_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER1_IRQ_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER1_IRQ_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER1_IRQ_2_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TIMER1_IRQ_3_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PWM_IRQ_WRAP_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PWM_IRQ_WRAP_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA_IRQ_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA_IRQ_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA_IRQ_2_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void DMA_IRQ_3_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void USBCTRL_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PIO0_IRQ_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PIO0_IRQ_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PIO1_IRQ_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PIO1_IRQ_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PIO2_IRQ_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PIO2_IRQ_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void IO_IRQ_BANK0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void IO_IRQ_BANK0_NS_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void IO_IRQ_QSPI_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void IO_IRQ_QSPI_NS_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SIO_IRQ_FIFO_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SIO_IRQ_BELL_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SIO_IRQ_FIFO_NS_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SIO_IRQ_BELL_NS_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SIO_IRQ_MTIMECMP_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void CLOCKS_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPI0_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPI1_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void UART0_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void UART1_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void ADC_IRQ_FIFO_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void I2C0_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void I2C1_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void OTP_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void TRNG_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PROC0_IRQ_CTI_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PROC1_IRQ_CTI_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PLL_SYS_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void PLL_USB_IRQ_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void POWMAN_IRQ_POW_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void POWMAN_IRQ_TIMER_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPARE_IRQ_0_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPARE_IRQ_1_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPARE_IRQ_2_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPARE_IRQ_3_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPARE_IRQ_4_Handler(void) __attribute__((weak, alias("Default_Handler")));
+void SPARE_IRQ_5_Handler(void) __attribute__((weak, alias("Default_Handler")));
+
+/* Type definitions */
+typedef struct {
+    uint32_t word0;
+    uint32_t word1;
+    uint32_t word2;
+    uint32_t word3;
+    uint32_t word4;
+} PicobinBlockItem;
+
+/* Vector Table
+   On RISC-V the image starts with crt0Entry instead: the table keeps the Arm
+   layout and is read by the trap handler (crt0Trap) */
+#ifdef __riscv
+#define CRT0_VECTOR_SECTION ".rodata.vector_table"
+#else
+#define CRT0_VECTOR_SECTION ".vector_table"
+#endif
+__attribute__( ( used, section( CRT0_VECTOR_SECTION ) ) ) vectors_t vectorTable[CRT0_VECTORS] =
+{
+  (vectors_t)(&__stack_end__), // Initial SP
+  Reset_Handler,               // Reset
+  NMI_Handler,                 // NMI
+  HardFault_Handler,           // HardFault
+  MemManage_Handler,           // MemManage
+  BusFault_Handler,            // BusFaults
+  UsageFault_Handler,          // UsageFault
+  SecureFault_Handler,         // SecureFault
+  0,                           // Reserved
+  0,                           // Reserved
+  0,                           // Reserved.
+  SVC_Handler,                 // SVCall
+  DebugMon_Handler,            // DebugMonitor
+  0,                           // Reserved
+  PendSV_Handler,              // PendSV
+  SysTick_Handler,             // SysTick
+  // External interrupts (see section 3.2 "Interrupts" on RP2350 datasheet)
+  TIMER0_IRQ_0_Handler,        // IRQ0
+  TIMER0_IRQ_1_Handler,        // IRQ1
+  TIMER0_IRQ_2_Handler,        // IRQ2
+  TIMER0_IRQ_3_Handler,        // IRQ3
+  TIMER1_IRQ_0_Handler,        // IRQ4
+  TIMER1_IRQ_1_Handler,        // IRQ5
+  TIMER1_IRQ_2_Handler,        // IRQ6
+  TIMER1_IRQ_3_Handler,        // IRQ7
+  PWM_IRQ_WRAP_0_Handler,      // IRQ8
+  PWM_IRQ_WRAP_1_Handler,      // IRQ9
+  DMA_IRQ_0_Handler,           // IRQ10
+  DMA_IRQ_1_Handler,           // IRQ11
+  DMA_IRQ_2_Handler,           // IRQ12
+  DMA_IRQ_3_Handler,           // IRQ13
+  USBCTRL_IRQ_Handler,         // IRQ14
+  PIO0_IRQ_0_Handler,          // IRQ15
+  PIO0_IRQ_1_Handler,          // IRQ16
+  PIO1_IRQ_0_Handler,          // IRQ17
+  PIO1_IRQ_1_Handler,          // IRQ18
+  PIO2_IRQ_0_Handler,          // IRQ19
+  PIO2_IRQ_1_Handler,          // IRQ20
+  IO_IRQ_BANK0_Handler,        // IRQ21
+  IO_IRQ_BANK0_NS_Handler,     // IRQ22
+  IO_IRQ_QSPI_Handler,         // IRQ23
+  IO_IRQ_QSPI_NS_Handler,      // IRQ24
+  SIO_IRQ_FIFO_Handler,        // IRQ25
+  SIO_IRQ_BELL_Handler,        // IRQ26
+  SIO_IRQ_FIFO_NS_Handler,     // IRQ27
+  SIO_IRQ_BELL_NS_Handler,     // IRQ28
+  SIO_IRQ_MTIMECMP_Handler,    // IRQ29
+  CLOCKS_IRQ_Handler,          // IRQ30
+  SPI0_IRQ_Handler,            // IRQ31
+  SPI1_IRQ_Handler,            // IRQ32
+  UART0_IRQ_Handler,           // IRQ33
+  UART1_IRQ_Handler,           // IRQ34
+  ADC_IRQ_FIFO_Handler,        // IRQ35
+  I2C0_IRQ_Handler,            // IRQ36
+  I2C1_IRQ_Handler,            // IRQ37
+  OTP_IRQ_Handler,             // IRQ38
+  TRNG_IRQ_Handler,            // IRQ39
+  PROC0_IRQ_CTI_Handler,       // IRQ40
+  PROC1_IRQ_CTI_Handler,       // IRQ41
+  PLL_SYS_IRQ_Handler,         // IRQ42
+  PLL_USB_IRQ_Handler,         // IRQ43
+  POWMAN_IRQ_POW_Handler,      // IRQ44
+  POWMAN_IRQ_TIMER_Handler,    // IRQ45
+  SPARE_IRQ_0_Handler,         // IRQ46
+  SPARE_IRQ_1_Handler,         // IRQ47
+  SPARE_IRQ_2_Handler,         // IRQ48
+  SPARE_IRQ_3_Handler,         // IRQ49
+  SPARE_IRQ_4_Handler,         // IRQ50
+  SPARE_IRQ_5_Handler,         // IRQ51
+};
+
+/* RP2350 Spec - 5.9.5. Minimum Viable Image Metadata
+   The Minimum Arm IMAGE_DEF, or the Minimum RISC-V IMAGE_DEF on a RISC-V
+   build: the bootrom then starts Hazard3 at the start of the image
+   (used: nothing refers to it, it must survive LTO and the section GC)
+*/
+PicobinBlockItem picoBinBlockItem __attribute__((used, section(".picobin_block_item"))) = {
+    .word0 = 0xffffded3,    // PICOBIN_BLOCK_MARKER_START (4 byte magic header)
+#ifdef __riscv
+    .word1 = 0x11010142,    // 0x42 PICOBIN_BLOCK_ITEM_1BS_IMAGE_TYPE, 0x01 word in size, 0x1101 image type exe, RISC-V, RP2350
+#else
+    .word1 = 0x10210142,    // 0x42 PICOBIN_BLOCK_ITEM_1BS_IMAGE_TYPE, 0x01 word in size, 0x1021 image type exe secure, ARM, RP2350
+#endif
+    .word2 = 0x000001ff,    // 0x00 pad, 0x0001 size, 0xff(size_type == 1, item_type_ == PICOBIN_BLOCK_ITEM_2BS_LAST)
+    .word3 = 0x00000000,    // loop containing just this block
+    .word4 = 0xab123579,    // PICOBIN_BLOCK_MARKER_END (4 byte magic footer)
+};
+
+static Crt0BootStats crt0BootStats;
+
+/* Copy of the vector table in SRAM (see crt0RelocateVectors). VTOR needs the
+   table aligned to its size rounded up to a power of two: 68 entries, 512 */
+static vectors_t crt0RamVectors[CRT0_VECTORS] __attribute__((aligned(512), section(".ram_vector_table")));
+static uint32_t crt0RamVectorsReady;
+
+#ifdef __riscv
+/* Table read by crt0Trap: vectorTable, or crt0RamVectors once relocated. The
+   cores share it (there is no VTOR per core) */
+static vectors_t *volatile crt0Vectors = vectorTable;
+volatile uint32_t crt0Exception[2];
+
+/* First instruction of the image: the bootrom enters Hazard3 here. Core 1
+   never does (it is started by multicoreLaunchCore1), it is parked anyway.
+   Sets the stack pointer that the Arm core takes from the vector table */
+__attribute__((naked, used, section(".vector_table")))
+void crt0Entry(void)
+{
+  __asm volatile (
+    "csrr a0, mhartid\n"
+    "bnez a0, 1f\n"
+    "la sp, __stack_end__\n"
+    "j Reset_Handler\n"
+    "1: wfi\n"
+    "j 1b\n");
+}
+
+/* Trap handler of both cores (mtvec, direct mode), in SRAM like the Arm
+   vector table after crt0RelocateVectors. Calls the handler of the Arm vector
+   table slot of the trap:
+   - external interrupts: every pending enabled IRQ, the highest priority
+     first (MEINEXT), from slot 16 + IRQ. There is no preemption: the
+     interrupts stay disabled until the handler returns
+   - machine timer (SIO MTIMECMP): SysTick_Handler, see timer.c
+   - machine software interrupt (SIO RISCV_SOFTIRQ): PendSV_Handler
+   - ecall: SVC_Handler, returning after the ecall
+   - other exceptions: HardFault_Handler */
+__attribute__((interrupt("machine"), aligned(4)))
+void TIME_CRITICAL(crt0Trap)(void)
+{
+  uint32_t cause = cpuCsrRead(mcause);
+  uint32_t core = cpuCsrRead(mhartid);
+  uint32_t previous = crt0Exception[core];
+  vectors_t *vectors = crt0Vectors;
+  if (cause == 0x8000000b)                                                 // Machine external interrupt
+  {
+    for (;;)
+    {
+      uint32_t next = cpuCsrRead(CPU_CSR_MEINEXT);
+      if (next & 0x80000000)
+      {
+        break;                                                             // NOIRQ
+      }
+      crt0Exception[core] = 16 + ((next >> 2) & 0x1ff);
+      vectors[crt0Exception[core]]();
+    }
+  }
+  else
+  {
+    uint32_t slot = (cause == 0x80000007) ? 15 : (cause == 0x80000003) ? 14 : (cause == 11) ? 11 : 3;
+    if (cause == 11)
+    {
+      cpuCsrWrite(mepc, cpuCsrRead(mepc) + 4);                             // Return after the ecall
+    }
+    crt0Exception[core] = slot;
+    vectors[slot]();
+  }
+  crt0Exception[core] = previous;
+}
+#endif
+
+void Default_Handler(void)
+{
+  while (1)
+  {
+    asm("nop");
+  }
+}
+
+/* Reset_Handler
+   Core 0 comes here from the bootrom with the stack pointer of the vector
+   table (top of SCRATCH_X). Initializes the C runtime and calls main().
+   The copy loops are kept as plain loops: without the optimization below GCC
+   may replace them by calls to memcpy()/memset(), which do not exist with
+   -nostdlib.
+*/
+__attribute__((optimize("no-tree-loop-distribute-patterns")))
+void Reset_Handler(void)
+{
+  uint32_t cpuId = GET32(SIO_BASE + 0x000);
+  if (cpuId == 1)
+  {
+    // Core 1 is started by the application (see section 5.3 of RP2350 datasheet)
+    while(1)
+    {
+        cpuWfe();
+    }
+  }
+
+  // Start the cycle counter to measure the initialization
+  cpuCycleCounterStart();
+  uint32_t start = cpuCycles();
+
+  // Copy the time critical code from flash to RAM, before anything calls it
+  uint32_t *src = &__time_critical_load__;
+  uint32_t *dst = &__time_critical_start__;
+  while (dst < &__time_critical_end__)
+  {
+    *dst++ = *src++;
+  }
+  cpuDsb();                                                                // Copy done before the first fetch
+  cpuIsb();
+  uint32_t codeDone = cpuCycles();
+
+  // Copy the initialized data from flash to RAM, one word at a time
+  src = &__data_load__;
+  dst = &__data_start__;
+  while (dst < &__data_end__)
+  {
+    *dst++ = *src++;
+  }
+  uint32_t dataDone = cpuCycles();
+
+  // Zero the uninitialized data, one word at a time
+  dst = &__bss_start__;
+  while (dst < &__bss_end__)
+  {
+    *dst++ = 0;
+  }
+  uint32_t bssDone = cpuCycles();
+
+  // .bss is clear now, the statistics can be written
+  crt0BootStats.timeCriticalBytes = (uint32_t)(&__time_critical_end__ - &__time_critical_start__) * 4;
+  crt0BootStats.timeCriticalCycles = codeDone - start;
+  crt0BootStats.dataBytes = (uint32_t)(&__data_end__ - &__data_start__) * 4;
+  crt0BootStats.dataCycles = dataDone - codeDone;
+  crt0BootStats.bssBytes = (uint32_t)(&__bss_end__ - &__bss_start__) * 4;
+  crt0BootStats.bssCycles = bssDone - dataDone;
+  bootReset(start);                                                        // Boot time stamps, from the reset vector
+
+  // Stack watermark and overflow guard of core 0 (core 1: multicoreLaunchCore1)
+  stackPaint(0);
+  stackInit();
+
+#ifdef __riscv
+  // Traps to crt0Trap (in SRAM now), external interrupts enabled like on Arm
+  cpuCsrWrite(mtvec, (uint32_t)(uintptr_t)crt0Trap);
+  cpuCsrSet(mie, CPU_MIE_MEIE);
+  cpuIrqEnable();
+#endif
+
+  bootStamp(BOOT_MAIN);
+  main();
+  while(1)
+  {
+    cpuWfe();
+  }
+}
+
+void crt0GetBootStats(Crt0BootStats *stats)
+{
+  *stats = crt0BootStats;
+}
+
+vectors_t *crt0RelocateVectors(void)
+{
+  if (!crt0RamVectorsReady)
+  {
+    for (uint32_t i = 0; i < CRT0_VECTORS; i++)
+    {
+      crt0RamVectors[i] = vectorTable[i];
+    }
+    crt0RamVectorsReady = 1;
+  }
+#ifdef __riscv
+  cpuDmb();                                                                // Table written before crt0Trap reads it
+  crt0Vectors = crt0RamVectors;
+#else
+  cpuDsb();                                                                // Table written before VTOR points to it
+  PUT32(VTOR, (uint32_t)(uintptr_t)crt0RamVectors);
+  cpuDsb();
+  cpuIsb();
+#endif
+  return crt0RamVectors;
+}
@@ -0,0 +1,91 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* C runtime startup
+   crt0.c holds the vector table, the image definition for the bootrom and
+   the Reset_Handler, which copies .time_critical and .data from flash, zeroes
+   .bss and calls main(). Every exception and interrupt has a weak handler named after the
+   interrupt (e.g. UART0_IRQ_Handler, DMA_IRQ_0_Handler, SysTick_Handler) that
+   a driver overrides by defining it.
+   Memory layout (see linker_script.ld):
+   - code and constants in flash, .data/.bss in the striped SRAM0-7
+   - time critical code (TIME_CRITICAL) loaded in flash and run from SRAM
+   - .noinit in SRAM, kept across a reset (boot.h)
+   - core 0 stack in SCRATCH_X (0x20080000), core 1 stack in SCRATCH_Y
+     (0x20081000), so the stacks of the two cores never share a SRAM bank.
+     Both are painted and limited (stack.h)
+   On a RISC-V build (make ISA=riscv) the image starts with crt0Entry, which
+   sets the stack pointer and jumps to Reset_Handler, and the bootrom reads a
+   RISC-V IMAGE_DEF. Hazard3 has no vector table: every trap goes to crt0Trap,
+   which calls the handler of the same slot of vectorTable (IRQs at 16 + IRQ,
+   the machine timer at SysTick), so the drivers are the same on both cores.
+*/
+#ifndef CRT0_H
+#define CRT0_H
+
+#include <stdint.h>
+
+#define CRT0_VECTORS (16 + 52)  // 16 system exceptions + 52 IRQs
+
+typedef void(*vectors_t)(void);
+
+/* Runs a function from SRAM instead of flash:
+
+       static void TIME_CRITICAL(uartTxFill)(void)
+       {
+           ...
+       }
+
+   Code in flash is fetched through the XIP cache: a miss stalls the core
+   while the line is read from the QSPI flash, so the same code may take a
+   few cycles or several hundred. The function goes to its own section
+   .time_critical.<name> (gc-sections drops it when unused), which the linker
+   script places in RAM with its load address in flash, and Reset_Handler
+   copies it before main(). It is never inlined, so it runs from SRAM from
+   every caller. Calls between flash and SRAM are out of range of a bl, the
+   linker adds a veneer.
+   Interrupt handlers also need crt0RelocateVectors(): the vector fetch of
+   every exception is a flash read otherwise.
+*/
+#define TIME_CRITICAL(name) __attribute__((section(".time_critical." #name), noinline)) name
+
+/* Cost of the C runtime initialization, measured with the cycle counter */
+typedef struct {
+    uint32_t timeCriticalBytes; // .time_critical copied from flash
+    uint32_t timeCriticalCycles;
+    uint32_t dataBytes;         // .data copied from flash
+    uint32_t dataCycles;
+    uint32_t bssBytes;          // .bss zeroed
+    uint32_t bssCycles;
+} Crt0BootStats;
+
+/* Symbols of the linker script */
+extern unsigned int __time_critical_load__;
+extern unsigned int __time_critical_start__;
+extern unsigned int __time_critical_end__;
+extern unsigned int __data_load__;
+extern unsigned int __data_start__;
+extern unsigned int __data_end__;
+extern unsigned int __bss_start__;
+extern unsigned int __bss_end__;
+extern unsigned int __heap_start__;     // RAM after .bss, up to the end of SRAM0-7 (pool.h)
+extern unsigned int __heap_end__;
+extern unsigned int __stack_start__;    // bottom of the core 0 stack (stack.h)
+extern unsigned int __stack_end__;      // top of the core 0 stack
+extern unsigned int __stack1_start__;   // bottom of the core 1 stack
+extern unsigned int __stack1_end__;     // top of the core 1 stack, for the launch sequence
+
+extern vectors_t vectorTable[CRT0_VECTORS];
+
+void crt0GetBootStats(Crt0BootStats *stats);
+
+/* Copies the vector table to SRAM (.ram_vector_table, the first 512 bytes of
+   RAM) on the first call and points VTOR of the calling core to the copy
+   (on RISC-V, crt0Trap of both cores). Returns the copy, where handlers can
+   also be replaced at run time.
+   Core 1 starts with the VTOR of core 0 (multicoreLaunchCore1). */
+vectors_t *crt0RelocateVectors(void);
+
+#endif /* CRT0_H */
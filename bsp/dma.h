@@ -0,0 +1,56 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* DMA registers
+   Every channel has the same 4 registers (READ_ADDR, WRITE_ADDR, TRANS_COUNT,
+   CTRL) mapped 4 times in a different order. The last register of each alias
+   triggers the channel, so a single write can load a value and start it:
+   that is what a control channel uses to program a data channel.
+   See section 12.6 "DMA" on RP2350 datasheet.
+*/
+#ifndef DMA_H
+#define DMA_H
+
+#include "rp2350.h"
+
+#define DMA_CH(ch)                     (DMA_BASE + 0x40 * (ch))
+#define DMA_CH_READ_ADDR(ch)           (DMA_CH(ch) + 0x00)
+#define DMA_CH_WRITE_ADDR(ch)          (DMA_CH(ch) + 0x04)
+#define DMA_CH_TRANS_COUNT(ch)         (DMA_CH(ch) + 0x08)
+#define DMA_CH_CTRL_TRIG(ch)           (DMA_CH(ch) + 0x0c)
+#define DMA_CH_AL1_CTRL(ch)            (DMA_CH(ch) + 0x10)
+#define DMA_CH_AL3_TRANS_COUNT(ch)     (DMA_CH(ch) + 0x38)
+#define DMA_CH_AL3_READ_ADDR_TRIG(ch)  (DMA_CH(ch) + 0x3c)
+
+#define DMA_INTR                       (DMA_BASE + 0x400)   // raw interrupt status, write 1 to clear
+#define DMA_INTE0                      (DMA_BASE + 0x404)   // channels routed to DMA_IRQ_0
+#define DMA_INTS0                      (DMA_BASE + 0x40c)   // DMA_IRQ_0 status, write 1 to clear
+#define DMA_CHAN_ABORT                 (DMA_BASE + 0x464)
+
+/* CTRL register fields */
+#define DMA_CTRL_EN                    (1 << 0)
+#define DMA_CTRL_SIZE_BYTE             (0 << 2)
+#define DMA_CTRL_SIZE_WORD             (2 << 2)
+#define DMA_CTRL_INCR_READ             (1 << 4)
+#define DMA_CTRL_INCR_WRITE            (1 << 6)
+#define DMA_CTRL_RING_SIZE(bits)       ((bits) << 8)        // wrap the address every 2^bits bytes
+#define DMA_CTRL_RING_SEL_WRITE        (1 << 12)            // ring applies to the write address
+#define DMA_CTRL_CHAIN_TO(ch)          ((ch) << 13)         // chain to itself = no chaining
+#define DMA_CTRL_TREQ_SEL(dreq)        ((dreq) << 17)
+#define DMA_CTRL_IRQ_QUIET             (1 << 23)            // IRQ only on a null trigger
+#define DMA_CTRL_BUSY                  (1 << 26)
+
+/* TRANS_COUNT mode (bits 31:28): ENDLESS never decrements the count, the
+   channel runs until it is aborted (e.g. with a read ring, forever) */
+#define DMA_TRANS_COUNT_ENDLESS        (0xfu << 28)
+
+/* Takes the DMA out of reset */
+static inline void dmaInit(void)
+{
+    PUT32((RESETS_BASE + WRITE_CLR + 0x0), RESETS_DMA);                     // De-assert the reset from DMA
+    while (!(GET32(RESETS_BASE + 0x08) & RESETS_DMA));                      // Wait for DMA to be ready
+}
+
+#endif /* DMA_H */
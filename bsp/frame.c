@@ -0,0 +1,192 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "uart.h"
+#include "frame.h"
+
+uint16_t frameCrc16(uint16_t crc, const uint8_t *data, uint32_t len)
+{
+    while (len-- > 0)
+    {
+        // Polynomial 0x1021 a byte at a time, without table
+        uint32_t x = (crc >> 8) ^ *data++;
+        x ^= x >> 4;
+        crc = (uint16_t)((crc << 8) ^ (x << 12) ^ (x << 5) ^ x);
+    }
+    return crc;
+}
+
+/* COBS: buf[code] is the code byte of the current block, it is written when
+   the block ends: at a zero byte (code = distance to it, the zero itself is
+   not sent), after 254 non zero bytes (code 0xff, no zero) or at the end of
+   the frame */
+static void frameTxByte(FrameTx *tx, uint8_t byte)
+{
+    if (byte == 0)
+    {
+        tx->buf[tx->code] = (uint8_t)(tx->len - tx->code);
+        tx->code = tx->len++;
+        return;
+    }
+    tx->buf[tx->len++] = byte;
+    if ((tx->len - tx->code) == 0xff)
+    {
+        tx->buf[tx->code] = 0xff;
+        tx->code = tx->len++;
+    }
+}
+
+void frameTxInit(FrameTx *tx)
+{
+    tx->len = 0;
+    tx->seq = 0;
+}
+
+void frameBegin(FrameTx *tx, uint8_t type)
+{
+    uint8_t header[2] = { type, tx->seq };
+    tx->code = 0;
+    tx->len = 1;
+    tx->payload = 0;
+    tx->crc = frameCrc16(0xffff, header, 2);
+    frameTxByte(tx, type);
+    frameTxByte(tx, tx->seq);
+}
+
+int frameAppend(FrameTx *tx, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = data;
+    if (len > (FRAME_MAX_PAYLOAD - tx->payload))
+    {
+        return -1;
+    }
+    tx->crc = frameCrc16(tx->crc, bytes, len);
+    tx->payload += len;
+    while (len-- > 0)
+    {
+        frameTxByte(tx, *bytes++);
+    }
+    return 0;
+}
+
+uint32_t frameEnd(FrameTx *tx)
+{
+    frameTxByte(tx, (uint8_t)tx->crc);
+    frameTxByte(tx, (uint8_t)(tx->crc >> 8));
+    tx->buf[tx->code] = (uint8_t)(tx->len - tx->code);                     // Last block
+    tx->buf[tx->len++] = 0;                                                // Delimiter
+    tx->seq++;
+    return tx->len;
+}
+
+int frameSend(FrameTx *tx, uint32_t uart, uint8_t type, const void *payload, uint32_t len)
+{
+    frameBegin(tx, type);
+    if (frameAppend(tx, payload, len) != 0)
+    {
+        return -1;
+    }
+    uartWriteAll(uart, tx->buf, frameEnd(tx));
+    return 0;
+}
+
+void frameRxInit(FrameRx *rx)
+{
+    rx->len = 0;
+    rx->overflow = 0;
+    rx->synced = 0;
+    rx->nextSeq = 0;
+    rx->stats.frames = 0;
+    rx->stats.crcErrors = 0;
+    rx->stats.lost = 0;
+    rx->stats.overflows = 0;
+}
+
+/* Decodes the COBS bytes of buf in place (the output never passes the
+   input). Returns the decoded length, 0 when a code byte points past the end */
+static uint32_t frameCobsDecode(uint8_t *buf, uint32_t len)
+{
+    uint32_t in = 0;
+    uint32_t out = 0;
+    while (in < len)
+    {
+        uint32_t code = buf[in++];
+        if ((in + code - 1) > len)
+        {
+            return 0;
+        }
+        for (uint32_t i = 1; i < code; i++)
+        {
+            buf[out++] = buf[in++];
+        }
+        if ((code < 0xff) && (in < len))
+        {
+            buf[out++] = 0;                                                // The zero replaced by the code
+        }
+    }
+    return out;
+}
+
+int frameRxByte(FrameRx *rx, uint8_t byte, Frame *frame)
+{
+    if (byte != 0)
+    {
+        if (rx->len < (FRAME_BUF_SIZE - 1))                                // The delimiter is not kept
+        {
+            rx->buf[rx->len++] = byte;
+        }
+        else
+        {
+            rx->overflow = 1;
+        }
+        return 0;
+    }
+
+    // Delimiter: end of the frame
+    uint32_t len = rx->len;
+    rx->len = 0;
+    if (rx->overflow)
+    {
+        rx->overflow = 0;
+        rx->stats.overflows++;
+        return 0;
+    }
+    if (len == 0)
+    {
+        return 0;                                                          // Delimiters in a row
+    }
+    len = frameCobsDecode(rx->buf, len);
+    if ((len < 4) ||
+        (frameCrc16(0xffff, rx->buf, len - 2) != (rx->buf[len - 2] | (rx->buf[len - 1] << 8))))
+    {
+        rx->stats.crcErrors++;
+        return 0;
+    }
+    frame->type = rx->buf[0];
+    frame->seq = rx->buf[1];
+    frame->len = len - 4;
+    frame->payload = &rx->buf[2];
+    if (rx->synced)
+    {
+        rx->stats.lost += (uint8_t)(frame->seq - rx->nextSeq);
+    }
+    rx->nextSeq = (uint8_t)(frame->seq + 1);
+    rx->synced = 1;
+    rx->stats.frames++;
+    return 1;
+}
+
+int framePoll(FrameRx *rx, uint32_t uart, Frame *frame)
+{
+    uint8_t byte;
+    while (uartRead(uart, &byte, 1) == 1)
+    {
+        if (frameRxByte(rx, byte, frame))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Binary framing on top of the UART driver
+   A frame carries a message type, a sequence number and up to
+   FRAME_MAX_PAYLOAD bytes, protected by a CRC-16:
+       type (1) | seq (1) | payload (0..FRAME_MAX_PAYLOAD) | CRC-16 (2, little endian)
+   The frame is COBS encoded (Consistent Overhead Byte Stuffing): the zero
+   bytes are replaced, so a 0x00 only appears as the delimiter at the end of
+   every frame and the receiver finds the next frame after any garbage. The
+   encoding adds one byte per 254 bytes plus the delimiter.
+   The CRC is CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xffff) of
+   type, seq and payload, the same as binascii.crc_hqx(data, 0xffff) in
+   Python. The sender numbers its frames 0, 1, ... 255, 0, ..., so the
+   receiver counts the frames lost in between (a frame with a bad CRC is
+   dropped and counted in crcErrors, and in lost too once the next frame
+   arrives).
+   The encoder works while the frame is built: frameAppend() encodes the
+   bytes straight into the buffer of the FrameTx and only goes back to fill
+   in the COBS code byte of a block once the block ends. There is no copy of
+   the raw frame and no second pass over it. The decoder gathers the encoded
+   bytes up to the delimiter and decodes them in place.
+   tools/framelink.py is the matching encoder/decoder for the PC.
+*/
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>
+
+#ifndef FRAME_MAX_PAYLOAD
+#define FRAME_MAX_PAYLOAD (256)
+#endif
+
+/* Raw frame (type, seq, payload, CRC) and its COBS encoding with the delimiter */
+#define FRAME_RAW_SIZE      (FRAME_MAX_PAYLOAD + 4)
+#define FRAME_BUF_SIZE      (FRAME_RAW_SIZE + (FRAME_RAW_SIZE / 254) + 2)
+
+typedef struct {
+    uint8_t  buf[FRAME_BUF_SIZE];   // encoded frame
+    uint32_t len;                   // bytes in buf
+    uint32_t code;                  // position of the code byte of the current block
+    uint32_t payload;               // payload bytes appended
+    uint16_t crc;
+    uint8_t  seq;                   // sequence number of the next frame
+} FrameTx;
+
+typedef struct {
+    uint32_t frames;            // valid frames received
+    uint32_t crcErrors;         // frames dropped: bad CRC or bad COBS encoding
+    uint32_t lost;              // frames missing in the sequence numbers
+    uint32_t overflows;         // frames dropped: longer than FRAME_BUF_SIZE
+} FrameStats;
+
+typedef struct {
+    uint8_t  buf[FRAME_BUF_SIZE];   // encoded bytes, decoded in place
+    uint32_t len;
+    uint32_t overflow;              // the current frame is too long, skipped up to the delimiter
+    uint32_t synced;                // a frame was received: nextSeq is valid
+    uint8_t  nextSeq;
+    FrameStats stats;
+} FrameRx;
+
+/* A received frame, payload points into the buffer of the FrameRx and is
+   valid until the next byte is given to it */
+typedef struct {
+    uint8_t  type;
+    uint8_t  seq;
+    uint32_t len;
+    const uint8_t *payload;
+} Frame;
+
+/* CRC-16/CCITT-FALSE of len bytes, crc is 0xffff for a new CRC */
+uint16_t frameCrc16(uint16_t crc, const uint8_t *data, uint32_t len);
+
+/* Sequence numbers start at 0 */
+void frameTxInit(FrameTx *tx);
+
+/* Starts a new frame of the given type in tx->buf */
+void frameBegin(FrameTx *tx, uint8_t type);
+
+/* Adds len payload bytes to the frame. Returns -1 (nothing added) when the
+   payload would exceed FRAME_MAX_PAYLOAD */
+int frameAppend(FrameTx *tx, const void *data, uint32_t len);
+
+/* Adds the CRC and the delimiter. The encoded frame is in tx->buf, the
+   function returns its length */
+uint32_t frameEnd(FrameTx *tx);
+
+/* Builds a frame and queues it on the UART with uartWriteAll() */
+int frameSend(FrameTx *tx, uint32_t uart, uint8_t type, const void *payload, uint32_t len);
+
+void frameRxInit(FrameRx *rx);
+
+/* Gives a received byte to the decoder. Returns 1 when it completes a valid
+   frame (described in frame), 0 otherwise */
+int frameRxByte(FrameRx *rx, uint8_t byte, Frame *frame);
+
+/* Reads the UART until a valid frame is complete (returns 1) or the RX
+   buffer is empty (returns 0) */
+int framePoll(FrameRx *rx, uint32_t uart, Frame *frame);
+
+#endif /* FRAME_H */
@@ -0,0 +1,121 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "multicore.h"
+#include "prof.h"
+#include "stack.h"
+
+/* SIO registers (see section 3.1.11 "List of registers" on RP2350 datasheet) */
+#define SIO_CPUID       (SIO_BASE + 0x000)
+#define SIO_FIFO_ST     (SIO_BASE + 0x050)
+#define SIO_FIFO_WR     (SIO_BASE + 0x054)
+#define SIO_FIFO_RD     (SIO_BASE + 0x058)
+
+#define SIO_FIFO_ST_VLD (1 << 0)        // own RX FIFO is not empty
+#define SIO_FIFO_ST_RDY (1 << 1)        // RX FIFO of the other core is not full
+
+#define PSM_PROC1       (1 << 24)
+
+uint32_t multicoreCoreId(void)
+{
+    return GET32(SIO_CPUID);
+}
+
+void multicoreFifoPush(uint32_t value)
+{
+    while (!(GET32(SIO_FIFO_ST) & SIO_FIFO_ST_RDY));                       // The other core pops without sending an event
+    PUT32(SIO_FIFO_WR, value);
+    cpuSev();
+}
+
+uint32_t multicoreFifoPop(void)
+{
+    while (!(GET32(SIO_FIFO_ST) & SIO_FIFO_ST_VLD))
+    {
+        cpuWfe();                                                          // Woken up by the sev of the pushing core
+    }
+    return GET32(SIO_FIFO_RD);
+}
+
+int multicoreFifoTryPush(uint32_t value)
+{
+    if (!(GET32(SIO_FIFO_ST) & SIO_FIFO_ST_RDY))
+    {
+        return -1;
+    }
+    PUT32(SIO_FIFO_WR, value);
+    cpuSev();
+    return 0;
+}
+
+int multicoreFifoTryPop(uint32_t *value)
+{
+    if (!(GET32(SIO_FIFO_ST) & SIO_FIFO_ST_VLD))
+    {
+        return -1;
+    }
+    *value = GET32(SIO_FIFO_RD);
+    return 0;
+}
+
+void multicoreFifoDrain(void)
+{
+    while (GET32(SIO_FIFO_ST) & SIO_FIFO_ST_VLD)
+    {
+        GET32(SIO_FIFO_RD);
+    }
+}
+
+PROF_PROBE(multicoreLaunchCore1);
+
+static void (*volatile multicoreEntry)(void);
+
+/* First function of core 1: sets its stack limit (stack.h). On RISC-V the
+   bootrom has set its mtvec to the trap handler of core 0, its interrupts
+   are enabled here like on core 0 (an Arm core starts with PRIMASK clear) */
+static void multicoreCore1Start(void)
+{
+#ifdef __riscv
+    cpuCsrSet(mie, CPU_MIE_MEIE);
+    cpuIrqEnable();
+#endif
+    stackInit();
+    multicoreEntry();
+}
+
+void multicoreLaunchCore1(void (*entry)(void))
+{
+    PROF_BEGIN(multicoreLaunchCore1);
+    multicoreEntry = entry;
+    stackPaint(1);                                                         // Core 1 does not run yet: the whole stack
+#ifdef __riscv
+    // The vector table word of the sequence is the mtvec of core 1: crt0Trap
+    const uint32_t cmdList[6] = { 0, 0, 1, cpuCsrRead(mtvec),
+                                  (uint32_t)(uintptr_t)&__stack1_end__, (uint32_t)(uintptr_t)multicoreCore1Start };
+#else
+    // Core 1 starts with the vector table of core 0 (in SRAM after crt0RelocateVectors)
+    const uint32_t cmdList[6] = { 0, 0, 1, GET32(VTOR),
+                                  (uint32_t)(uintptr_t)&__stack1_end__, (uint32_t)(uintptr_t)multicoreCore1Start };
+#endif
+
+    PUT32((PSM_BASE + WRITE_SET + 0x0), PSM_PROC1);                        // FRCE_ON: power up PROC1
+    while (!(GET32(PSM_BASE + 0x0c) & PSM_PROC1));                         // DONE: wait until PROC1 is powered
+
+    // Core 1 echoes every word, a wrong echo restarts the sequence
+    for (uint32_t i = 0; i < 6; )
+    {
+        if (cmdList[i] == 0)
+        {
+            multicoreFifoDrain();                                          // Core 1 also drains its FIFO on a 0
+            cpuSev();
+        }
+        multicoreFifoPush(cmdList[i]);
+        i = (multicoreFifoPop() == cmdList[i]) ? (i + 1) : 0;
+    }
+    PROF_END(multicoreLaunchCore1);
+}
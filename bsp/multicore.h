@@ -0,0 +1,42 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Core 1 launch and the SIO inter-core FIFOs
+   Each core has a 8 x 32-bit FIFO towards the other one: FIFO_WR pushes into
+   the RX FIFO of the other core, FIFO_RD pops from the own RX FIFO. The
+   bootrom of core 1 waits on its FIFO for the launch sequence
+   0, 0, 1, vector table, stack pointer, entry point, and echoes every word.
+   See sections 3.1.5 "Inter-processor FIFOs" and 5.3 "Launching code on
+   processor core 1" on RP2350 datasheet.
+*/
+#ifndef MULTICORE_H
+#define MULTICORE_H
+
+#include <stdint.h>
+
+/* Powers up core 1 and starts it at entry, with the vector table of core 0
+   (VTOR, the SRAM copy after crt0RelocateVectors; on RISC-V mtvec, the trap
+   handler of crt0.c) and its stack in SCRATCH_Y (__stack1_end__), painted
+   and limited (stack.h). Called by core 0. */
+void multicoreLaunchCore1(void (*entry)(void));
+
+/* 0 on core 0, 1 on core 1 */
+uint32_t multicoreCoreId(void);
+
+/* Pushes a word to the other core (waits while its FIFO is full) and sends an
+   event, so a core sleeping in wfe wakes up */
+void multicoreFifoPush(uint32_t value);
+
+/* Pops a word from the own FIFO, sleeping (wfe) while it is empty */
+uint32_t multicoreFifoPop(void);
+
+/* Non blocking versions: return 0 on success, -1 if the FIFO is full/empty */
+int multicoreFifoTryPush(uint32_t value);
+int multicoreFifoTryPop(uint32_t *value);
+
+/* Discards the words waiting in the own FIFO */
+void multicoreFifoDrain(void);
+
+#endif /* MULTICORE_H */
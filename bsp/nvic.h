@@ -0,0 +1,144 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* NVIC (Nested Vectored Interrupt Controller)
+   Each core has its own NVIC, so an interrupt is taken by the core(s) that
+   enabled it. The RP2350 implements 4 priority bits: 0x00 (highest) to 0xf0
+   (lowest) in steps of 0x10. A pending interrupt preempts the running
+   handler if its group priority is higher: the priority grouping (AIRCR
+   PRIGROUP) splits the 4 bits into a group priority and a subpriority, which
+   only orders the pending interrupts of the same group (the IRQ number
+   breaks the remaining ties). The reset value 0..3 keeps 16 preemption
+   levels. BASEPRI (cpuSetBasepri() in cpu.h) masks the interrupts from a
+   priority down, PRIMASK (cpuIrqSave()) masks them all.
+   See section 3.7.2 "NVIC" on RP2350 datasheet and B3.9 "Exception
+   priorities and preemption" on Armv8-M Architecture Reference Manual.
+   On a RISC-V build the same functions drive the interrupt controller of
+   Hazard3 (Xh3irq, section 3.8.4.2): its IRQ arrays are CSRs of the calling
+   core, and its 4-bit priorities run the other way (15 is the highest), so
+   the NVIC priority is converted. See crt0Trap (crt0.c) for the dispatch.
+   Hazard3 has no active bits, priority grouping or BASEPRI: those functions
+   are Arm only.
+*/
+#ifndef NVIC_H
+#define NVIC_H
+
+#include "rp2350.h"
+#include "cpu.h"
+
+#ifdef __riscv
+static inline void nvicEnableIrq(uint32_t irq)
+{
+    cpuCsrSet(CPU_CSR_MEIEA, ((1u << (16 + (irq % 16))) | (irq / 16)));
+}
+
+static inline void nvicDisableIrq(uint32_t irq)
+{
+    cpuCsrClear(CPU_CSR_MEIEA, ((1u << (16 + (irq % 16))) | (irq / 16)));
+}
+
+static inline void nvicSetPending(uint32_t irq)
+{
+    cpuCsrSet(CPU_CSR_MEIFA, ((1u << (16 + (irq % 16))) | (irq / 16)));
+}
+
+static inline void nvicClearPending(uint32_t irq)
+{
+    cpuCsrClear(CPU_CSR_MEIFA, ((1u << (16 + (irq % 16))) | (irq / 16)));
+}
+
+static inline void nvicSetPriority(uint32_t irq, uint8_t priority)
+{
+    uint32_t shift = 16 + 4 * (irq % 4);                                   // MEIPRA: 4 IRQs per window
+    cpuCsrClear(CPU_CSR_MEIPRA, ((0xfu << shift) | (irq / 4)));
+    cpuCsrSet(CPU_CSR_MEIPRA, ((((uint32_t)(~priority >> 4) & 0xf) << shift) | (irq / 4)));
+}
+
+/* A CSR access with the window index selects the 16 IRQs it returns */
+static inline uint32_t nvicIsEnabled(uint32_t irq)
+{
+    return (cpuCsrReadSet(CPU_CSR_MEIEA, (irq / 16)) >> (16 + (irq % 16))) & 1;
+}
+
+static inline uint32_t nvicIsPending(uint32_t irq)
+{
+    return (cpuCsrReadSet(CPU_CSR_MEIPA, (irq / 16)) >> (16 + (irq % 16))) & 1;
+}
+
+static inline uint8_t nvicGetPriority(uint32_t irq)
+{
+    uint32_t level = (cpuCsrReadSet(CPU_CSR_MEIPRA, (irq / 4)) >> (16 + 4 * (irq % 4))) & 0xf;
+    return (uint8_t)((15 - level) << 4);
+}
+#else
+#define NVIC_BASE (0xe000e100)
+
+static inline void nvicEnableIrq(uint32_t irq)
+{
+    PUT32((NVIC_BASE + 0x000 + 4 * (irq / 32)), (1u << (irq % 32)));      // NVIC_ISERn
+}
+
+static inline void nvicDisableIrq(uint32_t irq)
+{
+    PUT32((NVIC_BASE + 0x080 + 4 * (irq / 32)), (1u << (irq % 32)));      // NVIC_ICERn
+}
+
+static inline void nvicSetPending(uint32_t irq)
+{
+    PUT32((NVIC_BASE + 0x100 + 4 * (irq / 32)), (1u << (irq % 32)));      // NVIC_ISPRn
+}
+
+static inline void nvicClearPending(uint32_t irq)
+{
+    PUT32((NVIC_BASE + 0x180 + 4 * (irq / 32)), (1u << (irq % 32)));      // NVIC_ICPRn
+}
+
+static inline void nvicSetPriority(uint32_t irq, uint8_t priority)
+{
+    uint32_t address = NVIC_BASE + 0x300 + (irq & ~3u);                     // NVIC_IPRn: 4 IRQs per register
+    uint32_t shift = 8 * (irq & 3);
+    PUT32(address, ((GET32(address) & ~(0xffu << shift)) | ((uint32_t)priority << shift)));
+}
+
+/* 1 if the IRQ is enabled on the calling core */
+static inline uint32_t nvicIsEnabled(uint32_t irq)
+{
+    return (GET32(NVIC_BASE + 0x000 + 4 * (irq / 32)) >> (irq % 32)) & 1;  // NVIC_ISERn
+}
+
+/* 1 if the IRQ waits to be taken by the calling core */
+static inline uint32_t nvicIsPending(uint32_t irq)
+{
+    return (GET32(NVIC_BASE + 0x100 + 4 * (irq / 32)) >> (irq % 32)) & 1;  // NVIC_ISPRn
+}
+
+/* 1 if the handler of the IRQ runs, or was preempted, on the calling core */
+static inline uint32_t nvicIsActive(uint32_t irq)
+{
+    return (GET32(NVIC_BASE + 0x200 + 4 * (irq / 32)) >> (irq % 32)) & 1;  // NVIC_IABRn
+}
+
+static inline uint8_t nvicGetPriority(uint32_t irq)
+{
+    return (uint8_t)(GET32(NVIC_BASE + 0x300 + (irq & ~3u)) >> (8 * (irq & 3)));
+}
+
+/* PRIGROUP 0..7: the priority bits above bit PRIGROUP are the group priority,
+   the others the subpriority. With the 4 bits of the RP2350: 0..3 give 16
+   groups, 4: 8 groups of 2, 5: 4 of 4, 6: 2 of 8, 7: a single group (no
+   handler preempts another). Set by each core for itself */
+static inline void nvicSetPriorityGrouping(uint32_t prigroup)
+{
+    uint32_t keep = GET32(AIRCR) & 0x6008;                                 // BFHFNMINS, PRIS, SYSRESETREQS
+    PUT32(AIRCR, ((0x05fau << 16) | keep | ((prigroup & 7) << 8)));        // VECTKEY
+}
+
+static inline uint32_t nvicGetPriorityGrouping(void)
+{
+    return (GET32(AIRCR) >> 8) & 7;
+}
+#endif
+
+#endif /* NVIC_H */
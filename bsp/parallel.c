@@ -0,0 +1,92 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "multicore.h"
+#include "parallel.h"
+
+/* The half given to core 1. Static: its address goes through the 32-bit FIFO */
+typedef struct {
+    ParallelKernel kernel;
+    void *context;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t result;
+    volatile uint32_t done;
+} ParallelJob;
+
+static ParallelJob parallelJob;
+static ParallelStats parallelStats;
+
+/* Core 1: runs the jobs sent by core 0, forever */
+static void parallelWorker(void)
+{
+    while (1)
+    {
+        ParallelJob *job = (ParallelJob *)(uintptr_t)multicoreFifoPop();   // Sleeps (wfe) until a job comes
+        job->result = job->kernel(job->context, job->begin, job->end);
+        cpuDmb();                                                          // Result and data before the done flag
+        job->done = 1;
+        cpuSev();                                                          // Wakes up core 0 if it waits for the join
+    }
+}
+
+void parallelInit(void)
+{
+    multicoreLaunchCore1(parallelWorker);
+}
+
+/* Sends the upper half to core 1, runs the lower half, waits for core 1 */
+static uint32_t parallelRun(uint32_t count, ParallelKernel kernel, ParallelCombine combine, void *context)
+{
+    if (count < 2)
+    {
+        parallelStats.serial++;
+        return kernel(context, 0, count);
+    }
+    uint32_t split = count / 2;
+    ParallelJob *job = &parallelJob;
+    job->kernel = kernel;
+    job->context = context;
+    job->begin = split;
+    job->end = count;
+    job->done = 0;
+    cpuDmb();                                                              // Job written before core 1 gets it
+    multicoreFifoPush((uint32_t)(uintptr_t)job);
+    parallelStats.jobs++;
+
+    uint32_t lower = kernel(context, 0, split);
+
+    // Join
+    if (!job->done)
+    {
+        parallelStats.joinWaits++;
+        while (!job->done)
+        {
+            cpuWfe();
+        }
+    }
+    cpuDmb();                                                              // Result and data of core 1 after the done flag
+    return combine ? combine(context, lower, job->result, count - split) : 0;
+}
+
+void parallelFor(uint32_t count, ParallelKernel kernel, void *context)
+{
+    parallelRun(count, kernel, 0, context);
+}
+
+uint32_t parallelReduce(uint32_t count, ParallelKernel kernel, ParallelCombine combine, void *context)
+{
+    return parallelRun(count, kernel, combine, context);
+}
+
+void parallelGetStats(ParallelStats *stats)
+{
+    stats->jobs = parallelStats.jobs;
+    stats->serial = parallelStats.serial;
+    stats->joinWaits = parallelStats.joinWaits;
+}
@@ -0,0 +1,55 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Data-parallel loops on both cores (fork/join)
+   parallelInit() launches core 1 into a worker loop that waits on its SIO
+   FIFO. parallelFor() then splits the range 0..count in two halves: the job
+   descriptor of the upper half goes to core 1 through the FIFO (the push
+   sends the event that wakes it up), core 0 runs the lower half itself, and
+   waits (wfe) for the done flag of core 1, set after its result and
+   followed by a sev. The halves are contiguous, so a kernel working on
+   consecutive elements keeps its order within each half.
+   parallelReduce() also combines the two partial results, lower half first:
+   combine(context, lower, upper, upperCount), e.g. a sum or a CRC combine.
+   Fork and join cost a FIFO round trip and the wake up of core 1, so small
+   ranges are faster on one core: see the parallel benchmark for the
+   threshold. A range of 0 or 1 element runs on core 0 alone.
+   Core 1 is dedicated to the worker (it does not run the scheduler of
+   sched.h), and the loops are started from core 0 only, one at a time.
+   Reference kernels are in parallel_kernels.h.
+*/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+
+/* Processes the elements begin..end-1, returns the partial result (0 when
+   there is nothing to reduce). Runs on both cores at the same time: it only
+   writes the elements of its range */
+typedef uint32_t (*ParallelKernel)(void *context, uint32_t begin, uint32_t end);
+
+/* Returns the result of the whole range from the results of its lower and
+   upper parts, upperCount is the number of elements of the upper part */
+typedef uint32_t (*ParallelCombine)(void *context, uint32_t lower, uint32_t upper, uint32_t upperCount);
+
+typedef struct {
+    uint32_t jobs;              // ranges split between the cores
+    uint32_t serial;            // ranges run on core 0 alone
+    uint32_t joinWaits;         // times core 0 finished first and slept until core 1 was done
+} ParallelStats;
+
+/* Launches core 1 (multicoreLaunchCore1) into the worker loop. Called once
+   by core 0 */
+void parallelInit(void);
+
+/* Runs kernel over 0..count on both cores and waits for both halves */
+void parallelFor(uint32_t count, ParallelKernel kernel, void *context);
+
+/* Same as parallelFor(), returns the combined result of the two halves */
+uint32_t parallelReduce(uint32_t count, ParallelKernel kernel, ParallelCombine combine, void *context);
+
+void parallelGetStats(ParallelStats *stats);
+
+#endif /* PARALLEL_H */
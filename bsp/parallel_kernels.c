@@ -0,0 +1,111 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "crt0.h"
+#include "parallel.h"
+#include "parallel_kernels.h"
+
+#define CRC32_POLY (0xedb88320)         // reflected 0x04c11db7
+
+/* CRC of one nibble, see parallelCrc32Kernel */
+static const uint32_t crc32Nibble[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+uint32_t TIME_CRITICAL(parallelSumKernel)(void *context, uint32_t begin, uint32_t end)
+{
+    const uint32_t *words = context;
+    uint32_t sum = 0;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        sum += words[i];
+    }
+    return sum;
+}
+
+uint32_t parallelSumCombine(void *context, uint32_t lower, uint32_t upper, uint32_t upperCount)
+{
+    (void)context;
+    (void)upperCount;
+    return lower + upper;
+}
+
+uint32_t TIME_CRITICAL(parallelCrc32Kernel)(void *context, uint32_t begin, uint32_t end)
+{
+    const uint8_t *data = context;
+    uint32_t crc = 0xffffffff;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ crc32Nibble[crc & 0xf];
+        crc = (crc >> 4) ^ crc32Nibble[crc & 0xf];
+    }
+    return ~crc;
+}
+
+/* a * b mod P, the polynomials in the reflected order of the CRC (bit 31 is
+   x^0) */
+static uint32_t crc32MulMod(uint32_t a, uint32_t b)
+{
+    uint32_t product = 0;
+    for (uint32_t m = 1u << 31; m != 0; m >>= 1)
+    {
+        if (a & m)
+        {
+            product ^= b;
+        }
+        b = (b & 1) ? ((b >> 1) ^ CRC32_POLY) : (b >> 1);
+    }
+    return product;
+}
+
+/* The CRC of lower followed by upper: the lower CRC multiplied by
+   x^(8 * upperCount) mod P, plus the upper CRC (the initial and final
+   inversions cancel out), as crc32_combine() of zlib */
+uint32_t parallelCrc32Combine(void *context, uint32_t lower, uint32_t upper, uint32_t upperCount)
+{
+    (void)context;
+    uint32_t shift = 1u << 31;                                             // x^0
+    uint32_t square = 1u << 23;                                            // x^8: one byte
+    while (upperCount != 0)
+    {
+        if (upperCount & 1)
+        {
+            shift = crc32MulMod(square, shift);
+        }
+        square = crc32MulMod(square, square);
+        upperCount >>= 1;
+    }
+    return crc32MulMod(shift, lower) ^ upper;
+}
+
+uint32_t TIME_CRITICAL(parallelTransformKernel)(void *context, uint32_t begin, uint32_t end)
+{
+    ParallelTransform *transform = context;
+    uint8_t *data = transform->data;
+    const uint8_t *table = transform->table;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        data[i] = table[data[i]];
+    }
+    return 0;
+}
+
+uint32_t parallelSum(const uint32_t *words, uint32_t count)
+{
+    return parallelReduce(count, parallelSumKernel, parallelSumCombine, (void *)words);
+}
+
+uint32_t parallelCrc32(const uint8_t *data, uint32_t len)
+{
+    return parallelReduce(len, parallelCrc32Kernel, parallelCrc32Combine, (void *)data);
+}
+
+void parallelTransform(uint8_t *data, uint32_t len, const uint8_t *table)
+{
+    ParallelTransform transform = { data, table };
+    parallelFor(len, parallelTransformKernel, &transform);
+}
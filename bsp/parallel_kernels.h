@@ -0,0 +1,42 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Reference kernels of parallel.h
+   - sum: 32-bit sum of words (wraps), combined by addition
+   - CRC-32 (IEEE 802.3, as zlib and binascii.crc32) of bytes, 4 bits at a
+     time with a 16 entries table. The CRCs of the two halves are combined
+     by shifting the lower one over the length of the upper one (a product
+     of polynomials mod P, about 2 x 32 steps per bit of the length)
+   - transform: every byte replaced through a 256 bytes table, in place
+   The kernels run from SRAM (TIME_CRITICAL), so the two cores do not compete
+   for the XIP cache. Each one comes with its parallel call, and can be
+   called directly (begin 0, end count) for the single core version.
+*/
+#ifndef PARALLEL_KERNELS_H
+#define PARALLEL_KERNELS_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t *data;
+    const uint8_t *table;       // 256 entries
+} ParallelTransform;
+
+/* context: const uint32_t *words */
+uint32_t parallelSumKernel(void *context, uint32_t begin, uint32_t end);
+uint32_t parallelSumCombine(void *context, uint32_t lower, uint32_t upper, uint32_t upperCount);
+
+/* context: const uint8_t *data */
+uint32_t parallelCrc32Kernel(void *context, uint32_t begin, uint32_t end);
+uint32_t parallelCrc32Combine(void *context, uint32_t lower, uint32_t upper, uint32_t upperCount);
+
+/* context: ParallelTransform *, returns 0 */
+uint32_t parallelTransformKernel(void *context, uint32_t begin, uint32_t end);
+
+uint32_t parallelSum(const uint32_t *words, uint32_t count);
+uint32_t parallelCrc32(const uint8_t *data, uint32_t len);
+void parallelTransform(uint8_t *data, uint32_t len, const uint8_t *table);
+
+#endif /* PARALLEL_KERNELS_H */
@@ -0,0 +1,218 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "regs.h"
+#include "clocks.h"
+#include "dma.h"
+#include "pio.h"
+
+#define PIO_BLOCKS          (3)
+#define PIO_INSTR_JMP(addr) (0x0000 | (addr))           // jmp addr (always)
+#define PIO_INSTR_SET_PINS  (0xe000)                    // set pins, value
+#define PIO_INSTR_SET_DIRS  (0xe080)                    // set pindirs, value
+
+/* Instruction memory in use, bit n = instruction n */
+static uint32_t pioUsed[PIO_BLOCKS];
+
+static const uint32_t pioResets[PIO_BLOCKS] = { RESETS_PIO0, RESETS_PIO1, RESETS_PIO2 };
+
+void pioInit(uint32_t pio)
+{
+    PUT32((RESETS_BASE + WRITE_SET + 0x0), pioResets[pio]);                // Set the PIO block to reset
+    PUT32((RESETS_BASE + WRITE_CLR + 0x0), pioResets[pio]);                // De-assert the reset
+    while (!(GET32(RESETS_BASE + 0x08) & pioResets[pio]));                 // Wait for the PIO block to be ready
+    pioUsed[pio] = 0;
+}
+
+int pioLoad(uint32_t pio, const PioProgram *program)
+{
+    uint32_t mask = (program->length < 32) ? ((1u << program->length) - 1) : 0xffffffffu;
+    int offset = -1;
+    if (program->origin >= 0)
+    {
+        if ((program->origin + program->length <= PIO_INSTR_MEM_SIZE) && !(pioUsed[pio] & (mask << program->origin)))
+        {
+            offset = program->origin;
+        }
+    }
+    else
+    {
+        // Highest free range first, like the pico-sdk, so fixed origins at 0 still fit
+        for (int at = PIO_INSTR_MEM_SIZE - program->length; at >= 0; at--)
+        {
+            if (!(pioUsed[pio] & (mask << at)))
+            {
+                offset = at;
+                break;
+            }
+        }
+    }
+    if (offset < 0)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < program->length; i++)
+    {
+        uint32_t instruction = program->instructions[i];
+        if ((instruction & 0xe000) == 0)
+        {
+            instruction += offset;                                         // JMP: target in bits 4:0
+        }
+        PUT32(PIO_INSTR_MEM(pio, offset + i), instruction);
+    }
+    pioUsed[pio] |= mask << offset;
+    return offset;
+}
+
+void pioUnload(uint32_t pio, const PioProgram *program, uint32_t offset)
+{
+    uint32_t mask = (program->length < 32) ? ((1u << program->length) - 1) : 0xffffffffu;
+    pioUsed[pio] &= ~(mask << offset);
+}
+
+uint32_t pioClkdiv(uint32_t hz)
+{
+    if (hz == 0)
+    {
+        return 0;
+    }
+    // Divisor in 1/256: INT (16 bits, 0 = 65536) and FRAC (8 bits)
+    uint64_t div = (((uint64_t)clocksGetSysHz() << 8) + (hz / 2)) / hz;
+    if ((div < 0x100) || (div > 0x1000000))
+    {
+        return 0;
+    }
+    return (uint32_t)(div << 8);                                           // INT in 31:16, FRAC in 15:8
+}
+
+void pioSmInit(uint32_t pio, uint32_t sm, uint32_t offset, const PioProgram *program, const PioSmConfig *config)
+{
+    uint32_t execctrl = config->execctrl | PIO_EXEC_WRAP(offset + program->wrap, offset + program->wrapTarget);
+    if (program->sidesetOptional)
+    {
+        execctrl |= PIO_EXEC_SIDE_EN;
+    }
+    pioSmEnable(pio, (1u << sm), 0);
+    PUT32(PIO_SM_CLKDIV(pio, sm), config->clkdiv);
+    PUT32(PIO_SM_EXECCTRL(pio, sm), execctrl);
+    PUT32(PIO_SM_SHIFTCTRL(pio, sm), config->shiftctrl);
+    PUT32(PIO_SM_PINCTRL(pio, sm), (config->pinctrl | PIO_PIN_SIDESET_COUNT(program->sidesetBits)));
+
+    // Changing FJOIN_RX clears both FIFOs: flip it twice
+    PUT32((PIO_SM_SHIFTCTRL(pio, sm) + WRITE_XOR), PIO_SHIFT_FJOIN_RX);
+    PUT32((PIO_SM_SHIFTCTRL(pio, sm) + WRITE_XOR), PIO_SHIFT_FJOIN_RX);
+    PUT32(PIO_FDEBUG(pio), (PIO_FDEBUG_TXSTALL(sm) | PIO_FDEBUG_TXOVER(sm) |
+                            PIO_FDEBUG_RXUNDER(sm) | PIO_FDEBUG_RXSTALL(sm)));    // Clear the sticky flags
+
+    // SM_RESTART (shift counters, delays, waits) and CLKDIV_RESTART, then the first instruction
+    PUT32((PIO_CTRL(pio) + WRITE_SET), ((1u << (4 + sm)) | (1u << (8 + sm))));
+    pioSmExec(pio, sm, PIO_INSTR_JMP(offset));
+}
+
+void pioSmEnable(uint32_t pio, uint32_t mask, int enable)
+{
+    PUT32((PIO_CTRL(pio) + (enable ? WRITE_SET : WRITE_CLR)), (mask & 0xf));   // SM_ENABLE
+}
+
+void pioGpioInit(uint32_t pio, uint32_t pin)
+{
+    REG_WRITE(IO_BANK0_GPIO(pin), GPIO_CTRL_FUNCSEL, (GPIO_FUNC_PIO0 + pio));
+    REG_CLR(PADS_BANK0_GPIO(pin), PADS_GPIO_ISO);                          // Remove the pad isolation
+    REG_SET(PADS_BANK0_GPIO(pin), PADS_GPIO_IE);                           // Input enabled (IN, WAIT, JMP pin)
+}
+
+void pioSmSetPins(uint32_t pio, uint32_t sm, uint32_t base, uint32_t count, int output, uint32_t value)
+{
+    // "set" drives up to 5 pins from SET_BASE. PINCTRL is borrowed with no
+    // side-set, so the instructions do not drive the side-set pins
+    uint32_t pinctrl = GET32(PIO_SM_PINCTRL(pio, sm));
+    for (uint32_t i = 0; i < count; i += 5)
+    {
+        uint32_t pins = ((count - i) < 5) ? (count - i) : 5;
+        uint32_t mask = (1u << pins) - 1;
+        PUT32(PIO_SM_PINCTRL(pio, sm), PIO_PIN_SET(((base + i) & 0x1f), pins));
+        if (output)
+        {
+            pioSmExec(pio, sm, (PIO_INSTR_SET_PINS | ((value >> i) & mask)));   // Level first: no glitch
+        }
+        pioSmExec(pio, sm, (PIO_INSTR_SET_DIRS | (output ? mask : 0)));
+    }
+    PUT32(PIO_SM_PINCTRL(pio, sm), pinctrl);
+}
+
+void pioSmExec(uint32_t pio, uint32_t sm, uint16_t instruction)
+{
+    PUT32(PIO_SM_INSTR(pio, sm), instruction);
+}
+
+int pioSmPut(uint32_t pio, uint32_t sm, uint32_t word)
+{
+    if (GET32(PIO_FSTAT(pio)) & PIO_FSTAT_TXFULL(sm))
+    {
+        return -1;
+    }
+    PUT32(PIO_TXF(pio, sm), word);
+    return 0;
+}
+
+void pioSmPutBlocking(uint32_t pio, uint32_t sm, uint32_t word)
+{
+    while (GET32(PIO_FSTAT(pio)) & PIO_FSTAT_TXFULL(sm));                  // Wait for room in the TX FIFO
+    PUT32(PIO_TXF(pio, sm), word);
+}
+
+int pioSmGet(uint32_t pio, uint32_t sm, uint32_t *word)
+{
+    if (GET32(PIO_FSTAT(pio)) & PIO_FSTAT_RXEMPTY(sm))
+    {
+        return -1;
+    }
+    *word = GET32(PIO_RXF(pio, sm));
+    return 0;
+}
+
+uint32_t pioSmGetBlocking(uint32_t pio, uint32_t sm)
+{
+    while (GET32(PIO_FSTAT(pio)) & PIO_FSTAT_RXEMPTY(sm));                 // Wait for a word in the RX FIFO
+    return GET32(PIO_RXF(pio, sm));
+}
+
+/* Starts a channel between a FIFO and memory */
+static void pioSmDmaStart(uint32_t ch, uint32_t read, uint32_t write, uint32_t count, uint32_t ctrl)
+{
+    dmaInit();
+    pioSmDmaStop(ch);
+    PUT32(DMA_CH_READ_ADDR(ch), read);
+    PUT32(DMA_CH_WRITE_ADDR(ch), write);
+    PUT32(DMA_CH_TRANS_COUNT(ch), count);
+    PUT32(DMA_CH_CTRL_TRIG(ch), (ctrl | DMA_CTRL_EN | DMA_CTRL_CHAIN_TO(ch) | DMA_CTRL_IRQ_QUIET));
+}
+
+void pioSmDmaTx(uint32_t pio, uint32_t sm, uint32_t ch, const void *data, uint32_t count, uint32_t size, uint32_t flags)
+{
+    uint32_t ring = (flags >> 8) & 0xf;
+    pioSmDmaStart(ch, (uint32_t)(uintptr_t)data, PIO_TXF(pio, sm), (ring ? DMA_TRANS_COUNT_ENDLESS : count),
+                  (((size == 4) ? DMA_CTRL_SIZE_WORD : DMA_CTRL_SIZE_BYTE) | DMA_CTRL_INCR_READ |
+                   DMA_CTRL_RING_SIZE(ring) | DMA_CTRL_TREQ_SEL(DREQ_PIO_TX(pio, sm))));
+}
+
+void pioSmDmaRx(uint32_t pio, uint32_t sm, uint32_t ch, void *data, uint32_t count, uint32_t size)
+{
+    pioSmDmaStart(ch, (PIO_RXF(pio, sm) + 4 - size), (uint32_t)(uintptr_t)data, count,
+                  (((size == 4) ? DMA_CTRL_SIZE_WORD : DMA_CTRL_SIZE_BYTE) | DMA_CTRL_INCR_WRITE |
+                   DMA_CTRL_TREQ_SEL(DREQ_PIO_RX(pio, sm))));
+}
+
+int pioSmDmaBusy(uint32_t ch)
+{
+    return (GET32(DMA_CH_AL1_CTRL(ch)) & DMA_CTRL_BUSY) != 0;
+}
+
+void pioSmDmaStop(uint32_t ch)
+{
+    PUT32(DMA_CHAN_ABORT, (1u << ch));
+    while (GET32(DMA_CHAN_ABORT) & (1u << ch));                            // Wait until the in flight transfers end
+}
@@ -0,0 +1,168 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* PIO: programmable I/O
+   The RP2350 has 3 PIO blocks (pio 0..2) of 4 state machines (sm 0..3).
+   The state machines of a block share 32 instructions of memory, and each
+   one has a 4 word TX FIFO (CPU/DMA -> state machine) and a 4 word RX FIFO
+   (state machine -> CPU/DMA), joinable into one 8 word FIFO.
+   The programs are assembled by hand (see pio_programs.c for the encoding
+   of each instruction): pioLoad() finds room in the instruction memory and
+   relocates the JMP targets, pioSmInit() configures a state machine for a
+   program and pioSmEnable() starts it. The FIFOs are fed and drained by the
+   CPU (pioSmPut/pioSmGet) or by a DMA channel paced by the DREQ of the FIFO
+   (pioSmDmaTx/pioSmDmaRx), so a state machine can run without the CPU.
+   The state machines run at clk_sys divided by CLKDIV (pioClkdiv()).
+   See chapter 11 "PIO" on RP2350 datasheet.
+*/
+#ifndef PIO_H
+#define PIO_H
+
+#include <stdint.h>
+#include "rp2350.h"
+
+#define PIO_BASE(pio)            (PIO0_BASE + 0x100000 * (pio))
+#define PIO_CTRL(pio)            (PIO_BASE(pio) + 0x000)
+#define PIO_FSTAT(pio)           (PIO_BASE(pio) + 0x004)
+#define PIO_FDEBUG(pio)          (PIO_BASE(pio) + 0x008)
+#define PIO_FLEVEL(pio)          (PIO_BASE(pio) + 0x00c)
+#define PIO_TXF(pio, sm)         (PIO_BASE(pio) + 0x010 + 4 * (sm))
+#define PIO_RXF(pio, sm)         (PIO_BASE(pio) + 0x020 + 4 * (sm))
+#define PIO_IRQ(pio)             (PIO_BASE(pio) + 0x030)    // flags 0-7, write 1 to clear
+#define PIO_INSTR_MEM(pio, i)    (PIO_BASE(pio) + 0x048 + 4 * (i))
+#define PIO_SM(pio, sm)          (PIO_BASE(pio) + 0x0c8 + 0x18 * (sm))
+#define PIO_SM_CLKDIV(pio, sm)   (PIO_SM(pio, sm) + 0x00)
+#define PIO_SM_EXECCTRL(pio, sm) (PIO_SM(pio, sm) + 0x04)
+#define PIO_SM_SHIFTCTRL(pio, sm) (PIO_SM(pio, sm) + 0x08)
+#define PIO_SM_ADDR(pio, sm)     (PIO_SM(pio, sm) + 0x0c)   // program counter
+#define PIO_SM_INSTR(pio, sm)    (PIO_SM(pio, sm) + 0x10)   // write: execute at once
+#define PIO_SM_PINCTRL(pio, sm)  (PIO_SM(pio, sm) + 0x14)
+#define PIO_INTR(pio)            (PIO_BASE(pio) + 0x16c)
+#define PIO_IRQ0_INTE(pio)       (PIO_BASE(pio) + 0x170)    // PIOn_IRQ_0
+#define PIO_IRQ1_INTE(pio)       (PIO_BASE(pio) + 0x17c)    // PIOn_IRQ_1
+
+#define PIO_INSTR_MEM_SIZE       (32)
+
+/* FSTAT bits of a state machine */
+#define PIO_FSTAT_RXFULL(sm)     (1u << (0 + (sm)))
+#define PIO_FSTAT_RXEMPTY(sm)    (1u << (8 + (sm)))
+#define PIO_FSTAT_TXFULL(sm)     (1u << (16 + (sm)))
+#define PIO_FSTAT_TXEMPTY(sm)    (1u << (24 + (sm)))
+
+/* FDEBUG bits (sticky, write 1 to clear) */
+#define PIO_FDEBUG_TXSTALL(sm)   (1u << (24 + (sm)))        // pull on an empty TX FIFO
+#define PIO_FDEBUG_TXOVER(sm)    (1u << (16 + (sm)))        // write to a full TX FIFO, word lost
+#define PIO_FDEBUG_RXUNDER(sm)   (1u << (8 + (sm)))         // read of an empty RX FIFO
+#define PIO_FDEBUG_RXSTALL(sm)   (1u << (0 + (sm)))         // push on a full RX FIFO
+
+/* Configuration registers of a state machine: fields to combine with '|' */
+#define PIO_EXEC_SIDE_EN         (1u << 30)                 // side-set enable bit (set by pioSmInit)
+#define PIO_EXEC_SIDE_PINDIR     (1u << 29)                 // side-set drives the pin directions
+#define PIO_EXEC_JMP_PIN(pin)    ((uint32_t)(pin) << 24)    // pin tested by "jmp pin"
+#define PIO_EXEC_WRAP(top, bottom) (((uint32_t)(top) << 12) | ((uint32_t)(bottom) << 7))
+#define PIO_EXEC_STATUS_RX(level) ((1u << 5) | (uint32_t)(level))  // "mov x, status": all ones if RX level < level
+#define PIO_EXEC_STATUS_TX(level) ((0u << 5) | (uint32_t)(level))  // the same with the TX level
+
+#define PIO_SHIFT_FJOIN_RX       (1u << 31)                 // 8 word RX FIFO, no TX FIFO
+#define PIO_SHIFT_FJOIN_TX       (1u << 30)                 // 8 word TX FIFO, no RX FIFO
+#define PIO_SHIFT_PULL_THRESH(n) (((uint32_t)(n) & 0x1f) << 25)   // 32 is written as 0
+#define PIO_SHIFT_PUSH_THRESH(n) (((uint32_t)(n) & 0x1f) << 20)
+#define PIO_SHIFT_OUT_RIGHT      (1u << 19)                 // OUT takes the LSBs first
+#define PIO_SHIFT_IN_RIGHT       (1u << 18)                 // IN enters at the MSB
+#define PIO_SHIFT_AUTOPULL       (1u << 17)
+#define PIO_SHIFT_AUTOPUSH       (1u << 16)
+
+#define PIO_PIN_SIDESET_COUNT(n) ((uint32_t)(n) << 29)      // set by pioSmInit from the program
+#define PIO_PIN_SET(base, count) (((uint32_t)(count) << 26) | ((uint32_t)(base) << 5))
+#define PIO_PIN_OUT(base, count) (((uint32_t)(count) << 20) | ((uint32_t)(base) << 0))
+#define PIO_PIN_IN(base)         ((uint32_t)(base) << 15)
+#define PIO_PIN_SIDESET(base)    ((uint32_t)(base) << 10)
+
+/* A program assembled by hand. JMP targets are relative to the first
+   instruction, pioLoad() adds the load address. */
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t  length;
+    int8_t   origin;            // fixed load address, -1: anywhere
+    uint8_t  wrapTarget;        // .wrap_target, relative to the first instruction
+    uint8_t  wrap;              // .wrap
+    uint8_t  sidesetBits;       // .side_set count, the enable bit included
+    uint8_t  sidesetOptional;   // .side_set opt: the MSB of the side-set enables it
+} PioProgram;
+
+/* Configuration of a state machine. pioSmInit() adds the wrap and the
+   side-set of the program. */
+typedef struct {
+    uint32_t clkdiv;            // pioClkdiv()
+    uint32_t execctrl;          // PIO_EXEC_*
+    uint32_t shiftctrl;         // PIO_SHIFT_*
+    uint32_t pinctrl;           // PIO_PIN_*
+} PioSmConfig;
+
+/* Takes the PIO block out of reset: all state machines stopped, empty
+   instruction memory */
+void pioInit(uint32_t pio);
+
+/* Copies the program into the instruction memory (at its origin, or in the
+   highest free range) and returns its load address, or -1 if it does not fit */
+int pioLoad(uint32_t pio, const PioProgram *program);
+
+/* Frees the instructions of a program loaded at offset */
+void pioUnload(uint32_t pio, const PioProgram *program, uint32_t offset);
+
+/* CLKDIV register value for a state machine clock of hz (clk_sys / hz,
+   rounded to 1/256). 0 when hz is out of range. */
+uint32_t pioClkdiv(uint32_t hz);
+
+/* Stops the state machine, writes its configuration, clears its FIFOs and
+   state, and points it to the first instruction of the program loaded at
+   offset. It stays stopped until pioSmEnable(). */
+void pioSmInit(uint32_t pio, uint32_t sm, uint32_t offset, const PioProgram *program, const PioSmConfig *config);
+
+/* Starts (enable = 1) or stops the state machines of mask (bit n = sm n)
+   at the same clock cycle */
+void pioSmEnable(uint32_t pio, uint32_t mask, int enable);
+
+/* Gives the pin to the PIO block: IO_BANK0 function PIOn, pad isolation
+   removed and input enabled. A pin that is only read (IN, WAIT, JMP pin)
+   needs the pad setup only, the function select drives the output. */
+void pioGpioInit(uint32_t pio, uint32_t pin);
+
+/* Sets the direction (output = 1) and, for outputs, the level (bit n of
+   value for pin base + n) of count pins from the state machine by executing
+   "set pins"/"set pindirs". The pin directions are shared by the 4 state
+   machines of the block. */
+void pioSmSetPins(uint32_t pio, uint32_t sm, uint32_t base, uint32_t count, int output, uint32_t value);
+
+/* Executes one instruction on the state machine, running or not */
+void pioSmExec(uint32_t pio, uint32_t sm, uint16_t instruction);
+
+/* TX FIFO: returns 0, or -1 if it is full. The blocking version waits for room. */
+int pioSmPut(uint32_t pio, uint32_t sm, uint32_t word);
+void pioSmPutBlocking(uint32_t pio, uint32_t sm, uint32_t word);
+
+/* RX FIFO: returns 0 with the word, or -1 if it is empty. The blocking
+   version waits for a word. */
+int pioSmGet(uint32_t pio, uint32_t sm, uint32_t *word);
+uint32_t pioSmGetBlocking(uint32_t pio, uint32_t sm);
+
+/* DMA transfers between memory and the FIFOs, paced by the DREQ of the FIFO.
+   size is 1 (bytes) or 4. A byte written to a TX FIFO is the LSB of the word
+   (for OUT shifting right), a byte read from an RX FIFO is the MSB of the
+   word (for IN shifting right).
+   PIO_DMA_RING(bits) makes a TX channel read the data in a ring of 2^bits
+   bytes forever (the buffer must be aligned to it), count is ignored.
+   The channel is only started: pioSmDmaBusy() tells when it is done. */
+#define PIO_DMA_RING(bits)       ((uint32_t)(bits) << 8)
+void pioSmDmaTx(uint32_t pio, uint32_t sm, uint32_t ch, const void *data, uint32_t count, uint32_t size, uint32_t flags);
+void pioSmDmaRx(uint32_t pio, uint32_t sm, uint32_t ch, void *data, uint32_t count, uint32_t size);
+
+/* Returns 1 while the DMA channel has transfers left */
+int pioSmDmaBusy(uint32_t ch);
+
+/* Stops a DMA channel started by pioSmDmaTx/pioSmDmaRx */
+void pioSmDmaStop(uint32_t ch);
+
+#endif /* PIO_H */
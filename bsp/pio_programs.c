@@ -0,0 +1,148 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "regs.h"
+#include "pio.h"
+#include "pio_programs.h"
+
+/* Instruction encoding (see section 11.4 "Instruction Set" on RP2350 datasheet)
+     15:13 opcode  12:8 delay and side-set  7:0 operands
+   The side-set takes the MSBs of 12:8 (its enable bit first with .side_set
+   opt), the delay the rest. JMP targets are relative to the program. */
+
+/* LED pattern generator
+   A step holds the level (bit 0) for x + 4 cycles (bits 31:1):
+   pull, out, out and x + 1 times jmp */
+static const uint16_t pioLedInstructions[] = {
+            //     .wrap_target
+    0x80a0, //  0: pull block
+    0x6001, //  1: out pins, 1
+    0x603f, //  2: out x, 31
+    0x0043, //  3: jmp x-- 3
+            //     .wrap
+};
+
+const PioProgram pioLedProgram = {
+    .instructions = pioLedInstructions, .length = 4, .origin = -1,
+    .wrapTarget = 0, .wrap = 3, .sidesetBits = 0, .sidesetOptional = 0,
+};
+
+/* UART TX: 8 cycles per bit, the stop bit and the start bit by side-set
+   (.side_set 1 opt, pin = OUT pin = side-set pin) */
+static const uint16_t pioUartTxInstructions[] = {
+            //     .wrap_target
+    0x9fa0, //  0: pull       side 1 [7]    stop bit (idle), waits for a character
+    0xf727, //  1: set x, 7   side 0 [7]    start bit
+    0x6001, //  2: out pins, 1              data bit, LSB first
+    0x0642, //  3: jmp x-- 2         [6]
+            //     .wrap
+};
+
+const PioProgram pioUartTxProgram = {
+    .instructions = pioUartTxInstructions, .length = 4, .origin = -1,
+    .wrapTarget = 0, .wrap = 3, .sidesetBits = 2, .sidesetOptional = 1,
+};
+
+/* UART RX: 8 cycles per bit. After the falling edge of the start bit it
+   waits 12 cycles (1.5 bits) to sample the middle of bit 0. IN pin 0 and
+   JMP pin are the RX pin. */
+static const uint16_t pioUartRxInstructions[] = {
+            //     .wrap_target
+    0x2020, //  0: wait 0 pin 0             start bit
+    0xea27, //  1: set x, 7          [10]
+    0x4001, //  2: in pins, 1               data bit, LSB first
+    0x0642, //  3: jmp x-- 2         [6]
+    0x00c8, //  4: jmp pin 8                stop bit
+    0xc014, //  5: irq 4 rel                framing error: flag and drop it
+    0x20a0, //  6: wait 1 pin 0             wait for the line to be idle again
+    0x0000, //  7: jmp 0
+    0x8020, //  8: push
+            //     .wrap
+};
+
+const PioProgram pioUartRxProgram = {
+    .instructions = pioUartRxInstructions, .length = 9, .origin = -1,
+    .wrapTarget = 0, .wrap = 8, .sidesetBits = 0, .sidesetOptional = 0,
+};
+
+int pioLedInit(uint32_t pio, uint32_t sm, uint32_t pin)
+{
+    int offset = pioLoad(pio, &pioLedProgram);
+    if (offset < 0)
+    {
+        return -1;
+    }
+    PioSmConfig config = {
+        .clkdiv = pioClkdiv(PIO_LED_HZ),
+        .execctrl = 0,
+        .shiftctrl = PIO_SHIFT_OUT_RIGHT | PIO_SHIFT_FJOIN_TX,             // level first, then the count
+        .pinctrl = PIO_PIN_OUT(pin, 1),
+    };
+    pioSmInit(pio, sm, offset, &pioLedProgram, &config);
+    pioGpioInit(pio, pin);
+    pioSmSetPins(pio, sm, pin, 1, 1, 0);
+    pioSmEnable(pio, (1u << sm), 1);
+    return offset;
+}
+
+int pioUartTxInit(uint32_t pio, uint32_t sm, uint32_t pin, uint32_t baud)
+{
+    int offset = pioLoad(pio, &pioUartTxProgram);
+    if (offset < 0)
+    {
+        return -1;
+    }
+    PioSmConfig config = {
+        .clkdiv = pioClkdiv(8 * baud),
+        .execctrl = 0,
+        .shiftctrl = PIO_SHIFT_OUT_RIGHT | PIO_SHIFT_FJOIN_TX,
+        .pinctrl = PIO_PIN_OUT(pin, 1) | PIO_PIN_SIDESET(pin),
+    };
+    pioSmInit(pio, sm, offset, &pioUartTxProgram, &config);
+    pioGpioInit(pio, pin);
+    pioSmSetPins(pio, sm, pin, 1, 1, 1);                                   // Idle high before the first character
+    pioSmEnable(pio, (1u << sm), 1);
+    return offset;
+}
+
+void pioUartTxWrite(uint32_t pio, uint32_t sm, const uint8_t *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+    {
+        pioSmPutBlocking(pio, sm, data[i]);
+    }
+}
+
+int pioUartRxInit(uint32_t pio, uint32_t sm, uint32_t pin, uint32_t baud)
+{
+    int offset = pioLoad(pio, &pioUartRxProgram);
+    if (offset < 0)
+    {
+        return -1;
+    }
+    PioSmConfig config = {
+        .clkdiv = pioClkdiv(8 * baud),
+        .execctrl = PIO_EXEC_JMP_PIN(pin),
+        .shiftctrl = PIO_SHIFT_IN_RIGHT | PIO_SHIFT_FJOIN_RX,              // 8 bits end up in 31:24
+        .pinctrl = PIO_PIN_IN(pin),
+    };
+    pioSmInit(pio, sm, offset, &pioUartRxProgram, &config);
+    REG_CLR(PADS_BANK0_GPIO(pin), PADS_GPIO_ISO);                          // Remove the pad isolation
+    REG_SET(PADS_BANK0_GPIO(pin), PADS_GPIO_IE);                           // Enable the pad for input
+    pioSmEnable(pio, (1u << sm), 1);
+    return offset;
+}
+
+uint32_t pioUartRxRead(uint32_t pio, uint32_t sm, uint8_t *data, uint32_t len)
+{
+    uint32_t count = 0;
+    uint32_t word;
+    while ((count < len) && (pioSmGet(pio, sm, &word) == 0))
+    {
+        data[count++] = (uint8_t)(word >> 24);
+    }
+    return count;
+}
@@ -0,0 +1,51 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Reference PIO programs (see pio.h)
+   - LED pattern generator: every TX word is one step of the pattern, a
+     level and how long to hold it. Fed by a DMA channel reading the pattern
+     in a ring, the LED runs forever without the CPU.
+   - UART TX: 8N1 on any pin, 8 PIO cycles per bit. Bytes from the TX FIFO
+     (CPU or DMA), the TX FIFOs are joined (8 characters).
+   - UART RX: 8N1 on any pin, samples the middle of every bit. The byte is in
+     the MSBs of the RX FIFO word (pioSmDmaRx with size 1 reads it). A
+     missing stop bit raises the relative IRQ flag 4 (flag 4 + sm) and the
+     character is dropped. The RX FIFOs are joined.
+   A program is loaded once per PIO block, the init functions load it and
+   return its offset (-1 if the instruction memory is full).
+*/
+#ifndef PIO_PROGRAMS_H
+#define PIO_PROGRAMS_H
+
+#include <stdint.h>
+#include "pio.h"
+
+extern const PioProgram pioLedProgram;
+extern const PioProgram pioUartTxProgram;
+extern const PioProgram pioUartRxProgram;
+
+/* The LED program runs at PIO_LED_HZ: a step lasts a multiple of 100us,
+   at least 400us (the 4 instructions of a step) */
+#define PIO_LED_HZ              (10000)
+#define PIO_LED_STEP(level, us) (((((us) / (1000000 / PIO_LED_HZ)) - 4) << 1) | ((level) & 1))
+
+/* Runs the LED program on pin (output, low) from the state machine. It
+   waits for the first step in the TX FIFO. */
+int pioLedInit(uint32_t pio, uint32_t sm, uint32_t pin);
+
+/* UART TX on pin (output, idle high) at baud */
+int pioUartTxInit(uint32_t pio, uint32_t sm, uint32_t pin, uint32_t baud);
+
+/* Queues len characters. Waits while the TX FIFO is full. */
+void pioUartTxWrite(uint32_t pio, uint32_t sm, const uint8_t *data, uint32_t len);
+
+/* UART RX on pin at baud. Only the pad of the pin is set up (input enabled),
+   so the pin can also be an output of the same or another block (loopback). */
+int pioUartRxInit(uint32_t pio, uint32_t sm, uint32_t pin, uint32_t baud);
+
+/* Copies up to len received characters into data, returns their number */
+uint32_t pioUartRxRead(uint32_t pio, uint32_t sm, uint8_t *data, uint32_t len);
+
+#endif /* PIO_PROGRAMS_H */
@@ -0,0 +1,223 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "multicore.h"
+#include "sync.h"
+#include "pool.h"
+
+/* A free block holds the link to the next one */
+typedef struct PoolBlock {
+    struct PoolBlock *next;
+} PoolBlock;
+
+typedef struct {
+    uint8_t *start;             // blocks of the class: start..end
+    uint8_t *end;
+    uint32_t blockSize;
+    uint32_t blocks;
+    PoolBlock *shared;          // poolLock
+    uint32_t sharedCount;
+    PoolBlock *cache[2];        // per core, used by its own core with the interrupts masked
+    uint32_t cacheCount[2];
+    volatile uint32_t inUse;    // atomics
+    volatile uint32_t highWater;
+    volatile uint32_t failures;
+    uint32_t refills;           // poolLock
+    uint32_t flushes;
+} PoolClass;
+
+static PoolClass poolClasses[POOL_CLASSES_MAX];
+static uint32_t poolCount;
+static Spinlock poolLock;
+static SyncStats poolLockStats;
+
+int poolInit(const PoolClassConfig *classes, uint32_t count, void *start, void *end)
+{
+    if (count > POOL_CLASSES_MAX)
+    {
+        return -1;
+    }
+    uintptr_t next = ((uintptr_t)start + POOL_ALIGN - 1) & ~(uintptr_t)(POOL_ALIGN - 1);
+    uint32_t previousSize = 0;
+    for (uint32_t c = 0; c < count; c++)
+    {
+        uint32_t blockSize = (classes[c].blockSize + POOL_ALIGN - 1) & ~(uint32_t)(POOL_ALIGN - 1);
+        blockSize = (blockSize < sizeof(PoolBlock)) ? POOL_ALIGN : blockSize;
+        uintptr_t bytes = (uintptr_t)blockSize * classes[c].blocks;
+        if ((blockSize <= previousSize) || (bytes > ((uintptr_t)end - next)) || (next > (uintptr_t)end))
+        {
+            return -1;
+        }
+        PoolClass *pool = &poolClasses[c];
+        pool->start = (uint8_t *)next;
+        pool->end = (uint8_t *)(next + bytes);
+        pool->blockSize = blockSize;
+        pool->blocks = classes[c].blocks;
+
+        // Every block on the shared list, in address order
+        pool->shared = 0;
+        for (uint32_t b = classes[c].blocks; b > 0; b--)
+        {
+            PoolBlock *block = (PoolBlock *)(next + (uintptr_t)(b - 1) * blockSize);
+            block->next = pool->shared;
+            pool->shared = block;
+        }
+        pool->sharedCount = classes[c].blocks;
+        for (uint32_t core = 0; core < 2; core++)
+        {
+            pool->cache[core] = 0;
+            pool->cacheCount[core] = 0;
+        }
+        pool->inUse = 0;
+        pool->highWater = 0;
+        pool->failures = 0;
+        pool->refills = 0;
+        pool->flushes = 0;
+        next += bytes;
+        previousSize = blockSize;
+    }
+    poolCount = count;
+    spinlockInit(&poolLock, POOL_SPINLOCK, &poolLockStats);
+    cpuDmb();                                                              // Pools written before the other core uses them
+    return 0;
+}
+
+/* Moves up to POOL_BATCH blocks from the shared list to the cache of core */
+static void TIME_CRITICAL(poolRefill)(PoolClass *pool, uint32_t core)
+{
+    spinlockAcquire(&poolLock);
+    PoolBlock *block = pool->shared;
+    uint32_t moved = 0;
+    while ((block != 0) && (moved < POOL_BATCH))
+    {
+        PoolBlock *next = block->next;
+        block->next = pool->cache[core];
+        pool->cache[core] = block;
+        block = next;
+        moved++;
+    }
+    pool->shared = block;
+    pool->sharedCount -= moved;
+    pool->refills += (moved != 0);
+    spinlockRelease(&poolLock);
+    pool->cacheCount[core] += moved;
+}
+
+/* Moves POOL_BATCH blocks from the cache of core to the shared list */
+static void TIME_CRITICAL(poolFlush)(PoolClass *pool, uint32_t core)
+{
+    // Unlink the batch first, outside of the lock
+    PoolBlock *first = pool->cache[core];
+    PoolBlock *last = first;
+    for (uint32_t i = 1; i < POOL_BATCH; i++)
+    {
+        last = last->next;
+    }
+    pool->cache[core] = last->next;
+    pool->cacheCount[core] -= POOL_BATCH;
+
+    spinlockAcquire(&poolLock);
+    last->next = pool->shared;
+    pool->shared = first;
+    pool->sharedCount += POOL_BATCH;
+    pool->flushes++;
+    spinlockRelease(&poolLock);
+}
+
+void *TIME_CRITICAL(poolAlloc)(uint32_t size)
+{
+    PoolClass *pool = poolClasses;
+    PoolClass *last = &poolClasses[poolCount];
+    while ((pool < last) && (pool->blockSize < size))
+    {
+        pool++;
+    }
+    if (pool == last)
+    {
+        return 0;
+    }
+
+    uint32_t core = multicoreCoreId();
+    uint32_t primask = cpuIrqSave();
+    if (pool->cache[core] == 0)
+    {
+        poolRefill(pool, core);
+    }
+    PoolBlock *block = pool->cache[core];
+    if (block != 0)
+    {
+        pool->cache[core] = block->next;
+        pool->cacheCount[core]--;
+    }
+    cpuIrqRestore(primask);
+
+    if (block == 0)
+    {
+        syncAtomicAdd(&pool->failures, 1);
+        return 0;
+    }
+    uint32_t inUse = syncAtomicAdd(&pool->inUse, 1);
+    uint32_t highWater = pool->highWater;
+    while ((inUse > highWater) && !syncAtomicCompareExchange(&pool->highWater, highWater, inUse))
+    {
+        highWater = pool->highWater;
+    }
+    return block;
+}
+
+void TIME_CRITICAL(poolFree)(void *block)
+{
+    if (block == 0)
+    {
+        return;
+    }
+    PoolClass *pool = poolClasses;
+    PoolClass *last = &poolClasses[poolCount];
+    while ((pool < last) && ((uint8_t *)block >= pool->end))
+    {
+        pool++;
+    }
+    if ((pool == last) || ((uint8_t *)block < poolClasses[0].start))
+    {
+        return;                                                            // Not from the pools
+    }
+
+    uint32_t core = multicoreCoreId();
+    uint32_t primask = cpuIrqSave();
+    PoolBlock *freed = block;
+    freed->next = pool->cache[core];
+    pool->cache[core] = freed;
+    pool->cacheCount[core]++;
+    if (pool->cacheCount[core] > (2 * POOL_BATCH))
+    {
+        poolFlush(pool, core);
+    }
+    cpuIrqRestore(primask);
+    syncAtomicAdd(&pool->inUse, (uint32_t)-1);
+}
+
+void poolGetStats(uint32_t poolClass, PoolStats *stats)
+{
+    PoolClass *pool = &poolClasses[poolClass];
+    stats->blockSize = pool->blockSize;
+    stats->blocks = pool->blocks;
+    stats->inUse = pool->inUse;
+    stats->highWater = pool->highWater;
+    stats->failures = pool->failures;
+    stats->refills = pool->refills;
+    stats->flushes = pool->flushes;
+}
+
+void poolGetLockStats(SyncStats *stats)
+{
+    stats->acquires = poolLockStats.acquires;
+    stats->contended = poolLockStats.contended;
+    stats->waitCycles = poolLockStats.waitCycles;
+    stats->maxWaitCycles = poolLockStats.maxWaitCycles;
+    stats->maxHoldCycles = poolLockStats.maxHoldCycles;
+}
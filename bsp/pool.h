@@ -0,0 +1,77 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Fixed-block pool allocator, for message buffers and task objects
+   poolInit() carves a memory region (usually the heap of the linker script,
+   __heap_start__ to __heap_end__: the RAM left after .bss) into size
+   classes, each one an array of blocks of the same size. poolAlloc() takes a
+   block of the smallest class that fits the request and poolFree() finds the
+   class of a block from its address, so a block has no header and the pools
+   never fragment. Both are O(1): no search of a free block, no coalescing.
+   Every class has a shared free list, protected by a SIO spinlock
+   (POOL_SPINLOCK), and a small free list per core (the cache), used by its
+   own core only with its interrupts masked: the common path takes no lock.
+   An empty cache takes POOL_BATCH blocks from the shared list (refill), a
+   cache of more than 2 x POOL_BATCH blocks gives POOL_BATCH back (flush), so
+   a block freed by the other core comes back in batches. The blocks in the
+   cache of a core (up to 2 x POOL_BATCH per class) are not available to the
+   other one: a class needs that many blocks more than its peak use.
+   Callable from both cores, in thread mode and from interrupt handlers.
+   A block that is freed twice, or was not allocated, breaks the lists: there
+   is no check of the block contents.
+*/
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdint.h>
+#include "sync.h"
+
+#define POOL_CLASSES_MAX (8)
+#define POOL_BATCH       (8)            // blocks moved at a time between the shared list and a cache
+#define POOL_ALIGN       (8)            // block size and alignment
+#define POOL_SPINLOCK    (10)           // SIO spinlock of the shared lists
+
+typedef struct {
+    uint32_t blockSize;         // bytes, rounded up to POOL_ALIGN
+    uint32_t blocks;
+} PoolClassConfig;
+
+typedef struct {
+    uint32_t blockSize;
+    uint32_t blocks;
+    uint32_t inUse;             // blocks allocated now
+    uint32_t highWater;         // most blocks allocated at the same time
+    uint32_t failures;          // requests that found the class empty
+    uint32_t refills;           // batches taken from the shared list by a cache
+    uint32_t flushes;           // batches given back to the shared list
+} PoolStats;
+
+/* Carves the region start..end into the classes, given by increasing block
+   size. Returns 0, or -1 if there are too many classes, the sizes are not
+   increasing or the region is too small. Called by core 0 before the other
+   core and the interrupt handlers may allocate. E.g.:
+
+       static const PoolClassConfig classes[] = { { 16, 64 }, { 64, 32 }, { 256, 8 } };
+       poolInit(classes, 3, &__heap_start__, &__heap_end__);
+*/
+int poolInit(const PoolClassConfig *classes, uint32_t count, void *start, void *end);
+
+/* Returns a block of at least size bytes, aligned to POOL_ALIGN, or NULL when
+   the class is empty (a larger class is not tried) or size is larger than
+   the largest class */
+void *poolAlloc(uint32_t size);
+
+/* Gives a block back to the cache of the calling core, which may be the other
+   core than the one that allocated it. NULL is ignored */
+void poolFree(void *block);
+
+/* Usage of the class (0 .. count - 1 of poolInit()) */
+void poolGetStats(uint32_t poolClass, PoolStats *stats);
+
+/* Statistics of the spinlock of the shared lists: how often a refill or a
+   flush found the other core holding it */
+void poolGetLockStats(SyncStats *stats);
+
+#endif /* POOL_H */
@@ -0,0 +1,195 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "regs.h"
+#include "cpu.h"
+#include "clocks.h"
+#include "timer.h"
+#include "multicore.h"
+#include "power.h"
+
+#define CLOCKS_WAKE_EN0        (CLOCKS_BASE + 0xac)
+#define CLOCKS_WAKE_EN1        (CLOCKS_BASE + 0xb0)
+#define CLOCKS_SLEEP_EN0       (CLOCKS_BASE + 0xb4)
+#define CLOCKS_SLEEP_EN1       (CLOCKS_BASE + 0xb8)
+#define CLOCKS_ENABLED0        (CLOCKS_BASE + 0xbc)
+#define CLOCKS_ENABLED1        (CLOCKS_BASE + 0xc0)
+#define IO_BANK0_INTR0         (IO_BANK0_BASE + 0x230)     // 4 bits per GPIO, 8 GPIOs per register
+#define IO_BANK0_DORMANT_INTE0 (IO_BANK0_BASE + 0x2d8)
+#define XOSC_DORMANT           (XOSC_BASE + 0x08)
+#define XOSC_DORMANT_VALUE     (0x636f6d61)                 // "coma"
+#define SCR_SLEEPDEEP          (1u << 2)
+#define SCR_SEVONPEND          (1u << 4)                    // a new pending interrupt ends wfe, even masked
+#define POWER_GPIO_COUNT       (48)
+
+/* Everything but the peripherals: buses, SRAM, XIP, ROM, SIO, IO, PADS,
+   PLLs, XOSC, TICKS, WATCHDOG... (bit 63 is reserved) */
+#define POWER_CLK_SYSTEM       (~POWER_CLK_PERIPHERALS & 0x7fffffffffffffffull)
+
+/* Owned by its core, read by powerGetStats() */
+typedef struct {
+    uint32_t mode;              // powerSetIdleMode()
+    uint32_t applied;           // mode in SCR (MSLEEP), 0 before the first powerIdle()
+    uint64_t startUs;
+    uint64_t sleepUs;
+    uint64_t deepSleepUs;
+    uint32_t sleeps;
+    uint32_t deepSleeps;
+    uint32_t dormants;
+    uint32_t wakeCycles;
+} PowerCore;
+
+static PowerCore powerCores[2];
+
+void powerInit(void)
+{
+    uint64_t now = timerGetUs();
+    for (uint32_t core = 0; core < 2; core++)
+    {
+        PowerCore *state = &powerCores[core];
+        state->mode = POWER_SLEEP;
+        state->applied = 0;                                                // SCR is per core: set by its own core
+        state->startUs = now;
+        state->sleepUs = 0;
+        state->deepSleepUs = 0;
+        state->sleeps = 0;
+        state->deepSleeps = 0;
+        state->dormants = 0;
+        state->wakeCycles = 0;
+    }
+}
+
+void powerSetClocks(uint64_t awake, uint64_t asleep)
+{
+    uint64_t wake = POWER_CLK_SYSTEM | (awake & POWER_CLK_PERIPHERALS);
+    uint64_t sleep = POWER_CLK_SYSTEM | (asleep & awake & POWER_CLK_PERIPHERALS);
+    PUT32(CLOCKS_WAKE_EN0, (uint32_t)wake);
+    PUT32(CLOCKS_WAKE_EN1, (uint32_t)(wake >> 32));
+    PUT32(CLOCKS_SLEEP_EN0, (uint32_t)sleep);
+    PUT32(CLOCKS_SLEEP_EN1, (uint32_t)(sleep >> 32));
+}
+
+uint64_t powerGetEnabledClocks(void)
+{
+    return GET32(CLOCKS_ENABLED0) | ((uint64_t)GET32(CLOCKS_ENABLED1) << 32);
+}
+
+/* Writes the idle mode of the calling core */
+static void powerApplyMode(PowerCore *state, uint32_t mode)
+{
+#if defined(__riscv)
+    // h3.block wakes up on a pending interrupt even with mstatus.MIE clear
+    if (mode == POWER_DEEP_SLEEP)
+    {
+        cpuCsrSet(CPU_CSR_MSLEEP, CPU_MSLEEP_DEEPSLEEP);
+    }
+    else
+    {
+        cpuCsrClear(CPU_CSR_MSLEEP, CPU_MSLEEP_DEEPSLEEP);
+    }
+#else
+    uint32_t scr = GET32(SCR) | SCR_SEVONPEND;
+    PUT32(SCR, ((mode == POWER_DEEP_SLEEP) ? (scr | SCR_SLEEPDEEP) : (scr & ~SCR_SLEEPDEEP)));
+#endif
+    state->mode = mode;
+    state->applied = mode;
+}
+
+void powerSetIdleMode(uint32_t mode)
+{
+    powerApplyMode(&powerCores[multicoreCoreId()], mode);
+}
+
+void powerIdle(volatile const uint32_t *value, uint32_t idle)
+{
+    PowerCore *state = &powerCores[multicoreCoreId()];
+    if (state->applied != state->mode)
+    {
+        powerApplyMode(state, (state->mode ? state->mode : POWER_SLEEP));
+    }
+
+    // Masked: the interrupt that wakes the core up is taken after the
+    // accounting. The work is checked again once masked: an interrupt taken
+    // since the caller checked it leaves the event set on Arm, but nothing
+    // on RISC-V (h3.block would wait for the next interrupt)
+    uint32_t primask = cpuIrqSave();
+    if ((value != 0) && (*value != idle))
+    {
+        cpuIrqRestore(primask);
+        return;
+    }
+    uint32_t start = timerGetUs32();
+    cpuWfe();
+    uint32_t slept = timerGetUs32() - start;
+    if (state->mode == POWER_DEEP_SLEEP)
+    {
+        state->deepSleepUs += slept;
+        state->deepSleeps++;
+    }
+    else
+    {
+        state->sleepUs += slept;
+        state->sleeps++;
+    }
+    cpuIrqRestore(primask);
+}
+
+int powerDormant(uint32_t gpio, uint32_t events)
+{
+    uint32_t sysHz = clocksGetSysHz();
+    events &= (POWER_WAKE_LEVEL_LOW | POWER_WAKE_LEVEL_HIGH | POWER_WAKE_EDGE_LOW | POWER_WAKE_EDGE_HIGH);
+    if ((gpio >= POWER_GPIO_COUNT) || (events == 0) || (sysHz == 0))
+    {
+        return -1;
+    }
+    uint32_t shift = 4 * (gpio % 8);
+    uint32_t reg = 4 * (gpio / 8);
+
+    // Only the crystal may be left running: clk_sys on clk_ref (XOSC), PLLs off
+    REG_CLR(CLOCKS_BASE, CLK_SYS_CTRL_SRC);                                // SRC = clk_ref
+    while (REG_READ(CLOCKS_BASE, CLK_SYS_SELECTED) != (1 << 0));
+    REG_CLR(CLOCKS_BASE, CLK_USB_CTRL_ENABLE);
+    REG_SET(PLL_SYS_BASE, (PLL_PWR_PD | PLL_PWR_VCOPD | PLL_PWR_POSTDIVPD));
+    REG_SET(PLL_USB_BASE, (PLL_PWR_PD | PLL_PWR_VCOPD | PLL_PWR_POSTDIVPD));
+
+    PUT32((IO_BANK0_INTR0 + reg), (0xfu << shift));                        // Clear the old edges (write 1 to clear)
+    PUT32((IO_BANK0_DORMANT_INTE0 + reg + WRITE_SET), (events << shift));
+    PUT32(XOSC_DORMANT, XOSC_DORMANT_VALUE);                               // Stops here until the GPIO event
+
+    uint32_t start = cpuCycles();
+    while (!REG_TEST(XOSC_BASE, XOSC_STATUS_STABLE));                      // Startup delay of the crystal
+    PUT32((IO_BANK0_DORMANT_INTE0 + reg + WRITE_CLR), (events << shift));
+    PUT32((IO_BANK0_INTR0 + reg), (0xfu << shift));
+    clocksInit(sysHz);                                                     // PLLs, clk_sys, clk_peri, clk_usb
+
+    PowerCore *state = &powerCores[multicoreCoreId()];
+    state->wakeCycles = cpuCycles() - start;
+    state->dormants++;
+    return 0;
+}
+
+int powerDormantUart(uint32_t uart)
+{
+    if (uart > 1)
+    {
+        return -1;
+    }
+    return powerDormant((4 * uart + 1), POWER_WAKE_EDGE_LOW);              // RX idles high, the start bit is low
+}
+
+void powerGetStats(uint32_t core, PowerStats *stats)
+{
+    PowerCore *state = &powerCores[core];
+    uint64_t elapsed = timerGetUs() - state->startUs;
+    uint64_t idle = state->sleepUs + state->deepSleepUs;
+    stats->runUs = (elapsed > idle) ? (elapsed - idle) : 0;
+    stats->sleepUs = state->sleepUs;
+    stats->deepSleepUs = state->deepSleepUs;
+    stats->sleeps = state->sleeps;
+    stats->deepSleeps = state->deepSleeps;
+    stats->dormants = state->dormants;
+    stats->wakeCycles = state->wakeCycles;
+}
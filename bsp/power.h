@@ -0,0 +1,122 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Power management: clock gating, sleep and dormant
+   - clock gating: every block has its own clock enable in CLOCKS. WAKE_EN0/1
+     select the clocks running while a core is awake, SLEEP_EN0/1 the ones
+     left running while both cores are in deep sleep. powerSetClocks() keeps
+     the system clocks (buses, SRAM, XIP, SIO, IO, TICKS, ...) and gates the
+     peripherals that are not given (POWER_CLK_*).
+   - idle: powerIdle() is the idle hook of a core, called by the application
+     when it has nothing to do (e.g. while (!work) powerIdle(&work, 0);). The core
+     stops in wfe (h3.block on RISC-V) until an interrupt is pending or the
+     other core sends an event. In POWER_DEEP_SLEEP, once both cores sleep,
+     the clocks that are not in SLEEP_EN stop too: more saving, but a longer
+     wake-up.
+   - dormant: powerDormant() stops the crystal, so every clock stops, until
+     a GPIO event (a UART RX start bit, a button). The clocks are restarted
+     at the frequency of clocksInit() afterwards.
+   Each core counts the time it spends awake, asleep and in deep sleep
+   (microseconds of TIMER0) and the dormant wake-ups, see powerGetStats().
+   TIMER0 stops with the crystal: the time spent dormant is not counted.
+   See sections 6.5 "Power management (Arm)", 8.1.3.4 "Clock gating" and
+   8.2.6 "Dormant mode" on RP2350 datasheet.
+*/
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+/* Idle modes of powerSetIdleMode() */
+#define POWER_SLEEP      (1)            // only the clock of the core stops
+#define POWER_DEEP_SLEEP (2)            // and the clocks not in SLEEP_EN, once both cores sleep
+
+/* GPIO events that end powerDormant() */
+#define POWER_WAKE_LEVEL_LOW  (1 << 0)
+#define POWER_WAKE_LEVEL_HIGH (1 << 1)
+#define POWER_WAKE_EDGE_LOW   (1 << 2)
+#define POWER_WAKE_EDGE_HIGH  (1 << 3)
+
+/* Peripheral clocks for powerSetClocks(): bit n of WAKE_EN0/SLEEP_EN0 is bit
+   n, bit n of WAKE_EN1/SLEEP_EN1 is bit 32 + n. Some blocks have two clocks
+   (the bus side and the peripheral side) */
+#define POWER_CLK_ADC    (0x3ull << 2)
+#define POWER_CLK_DMA    (0x1ull << 7)
+#define POWER_CLK_HSTX   (0x3ull << 9)
+#define POWER_CLK_I2C0   (0x1ull << 11)
+#define POWER_CLK_I2C1   (0x1ull << 12)
+#define POWER_CLK_PIO0   (0x1ull << 18)
+#define POWER_CLK_PIO1   (0x1ull << 19)
+#define POWER_CLK_PIO2   (0x1ull << 20)
+#define POWER_CLK_PWM    (0x1ull << 25)
+#define POWER_CLK_SHA256 (0x1ull << 30)
+#define POWER_CLK_SPI0   (0x3ull << 32)
+#define POWER_CLK_SPI1   (0x3ull << 34)
+#define POWER_CLK_TIMER0 (0x1ull << 51)
+#define POWER_CLK_TIMER1 (0x1ull << 52)
+#define POWER_CLK_TRNG   (0x1ull << 53)
+#define POWER_CLK_UART0  (0x3ull << 54)
+#define POWER_CLK_UART1  (0x3ull << 56)
+#define POWER_CLK_USB    (0x3ull << 58)
+#define POWER_CLK_PERIPHERALS (POWER_CLK_ADC | POWER_CLK_DMA | POWER_CLK_HSTX | POWER_CLK_I2C0 | POWER_CLK_I2C1 | \
+                               POWER_CLK_PIO0 | POWER_CLK_PIO1 | POWER_CLK_PIO2 | POWER_CLK_PWM | POWER_CLK_SHA256 | \
+                               POWER_CLK_SPI0 | POWER_CLK_SPI1 | POWER_CLK_TIMER0 | POWER_CLK_TIMER1 | POWER_CLK_TRNG | \
+                               POWER_CLK_UART0 | POWER_CLK_UART1 | POWER_CLK_USB)
+
+typedef struct {
+    uint64_t runUs;             // awake, since powerInit()
+    uint64_t sleepUs;           // in powerIdle(), per idle mode
+    uint64_t deepSleepUs;
+    uint32_t sleeps;            // powerIdle() calls, per idle mode
+    uint32_t deepSleeps;
+    uint32_t dormants;          // powerDormant() wake-ups
+    uint32_t wakeCycles;        // restart of the clocks after the last dormant
+} PowerStats;
+
+/* Clears the statistics of both cores. Called once by core 0 after
+   timerInit(), the idle mode of every core is POWER_SLEEP */
+void powerInit(void);
+
+/* Gates every peripheral clock but the ones in awake (while a core runs) and
+   asleep (while both cores are in deep sleep, only the peripherals that have
+   to wake them up: the UART receiving, TIMER0 for an alarm...). A block must
+   not be accessed while its clock is stopped. powerSetClocks(POWER_CLK_PERIPHERALS,
+   POWER_CLK_PERIPHERALS) gives the reset state back. Called by one core. */
+void powerSetClocks(uint64_t awake, uint64_t asleep);
+
+/* Clocks running now: ENABLED0 in bits 31:0, ENABLED1 in bits 63:32 */
+uint64_t powerGetEnabledClocks(void);
+
+/* Idle mode of the calling core: POWER_SLEEP or POWER_DEEP_SLEEP */
+void powerSetIdleMode(uint32_t mode);
+
+/* Idle hook: sleeps until an interrupt is pending or an event comes from the
+   other core, then takes the interrupt. Returns at the first wake-up, the
+   caller checks again whether it has work. *value is the work flag of the
+   caller (a counter, a queue head...), written by the interrupt handlers:
+   the core does not sleep if it is no longer idle once the interrupts are
+   masked, so an interrupt taken between the check of the caller and the
+   call is not missed. With value 0 there is no check: on Arm that
+   interrupt leaves the event set and wfe returns at once, but on RISC-V
+   h3.block waits for the next interrupt. Thread mode only. */
+void powerIdle(volatile const uint32_t *value, uint32_t idle);
+
+/* Stops the crystal, and every clock with it, until events (POWER_WAKE_*)
+   happen on gpio (0 - 47). Then restarts the crystal and the PLLs at the
+   clk_sys of clocksInit(): the peripherals running from clk_peri (UART)
+   are reconfigured by the caller. Called by core 0 with core 1 idle, the
+   interrupts are not taken while dormant. Returns 0, or -1 if gpio or
+   events is not valid or clocksInit() was not called. */
+int powerDormant(uint32_t gpio, uint32_t events);
+
+/* powerDormant() until the start bit of a character on the RX pin of uart
+   (GPIO 1 for UART0, 5 for UART1). That character is lost: the UART has no
+   clock until the crystal is back */
+int powerDormantUart(uint32_t uart);
+
+/* Statistics of a core (0 or 1) */
+void powerGetStats(uint32_t core, PowerStats *stats);
+
+#endif /* POWER_H */
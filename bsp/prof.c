@@ -0,0 +1,251 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "clocks.h"
+#include "prof.h"
+
+#if PROF_ENABLE
+
+/* Report format, little endian:
+     u32 PROF_MAGIC
+     u32 length of the report after this field, checksum excluded
+     u32 clk_sys in Hz
+     u16 overhead[2]    cycles of an empty begin/end pair, subtracted (per core)
+     u16 cost[2]        cycles a begin/end pair adds to the code around it
+     u16 probes, u8 PROF_BINS, u8 0
+     per probe:
+       u8 name length, name (no terminator), u8 mask of the cores that ran it
+       per core in the mask: u32 count, min, max, sum low, sum high, hist[PROF_BINS]
+     u32 sum of the bytes after the length field
+*/
+
+/* Table of pointers to the probes (PROF_PROBE), placed by the linker */
+extern ProfProbe *const __start_prof_probes[];
+extern ProfProbe *const __stop_prof_probes[];
+
+PROF_PROBE(prof);                                   // empty begin/end pair, its mean should be 0
+
+static uint32_t profOverhead[2];
+static uint32_t profCost[2];
+
+static uint32_t profCore(void)
+{
+    return GET32(SIO_BASE) & 1;                     // SIO CPUID
+}
+
+static uint32_t profBin(uint32_t cycles)
+{
+    uint32_t bin = cycles ? (32 - __builtin_clz(cycles)) : 0;
+    return (bin < PROF_BINS) ? bin : (PROF_BINS - 1);
+}
+
+static void profClear(ProfStats *stats)
+{
+    stats->count = stats->max = 0;
+    stats->min = 0xffffffffu;
+    stats->sum = 0;
+    for (uint32_t i = 0; i < PROF_BINS; i++)
+    {
+        stats->hist[i] = 0;
+    }
+}
+
+void profInit(void)
+{
+    uint32_t core = profCore();
+    cpuCycleCounterStart();
+
+    // Raw cycles of an empty pair (nothing subtracted yet), and of the pair
+    // seen from outside, minus the two back to back reads around it
+    profOverhead[core] = 0;
+    profClear(&profProbe.core[core]);
+    uint32_t cost = 0xffffffffu;
+    uint32_t reads = 0xffffffffu;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        uint32_t outer = profNow();
+        PROF_BEGIN(prof);
+        PROF_END(prof);
+        uint32_t total = profNow() - outer;
+        cost = (total < cost) ? total : cost;
+        outer = profNow();
+        total = profNow() - outer;
+        reads = (total < reads) ? total : reads;
+    }
+    profOverhead[core] = profProbe.core[core].min;
+    profCost[core] = (cost > reads) ? (cost - reads) : 0;
+
+    // What is left after the subtraction
+    profClear(&profProbe.core[core]);
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        PROF_BEGIN(prof);
+        PROF_END(prof);
+    }
+}
+
+void profEnd(ProfProbe *probe, uint32_t start)
+{
+    uint32_t cycles = profNow() - start;
+    uint32_t core = profCore();
+    cycles = (cycles > profOverhead[core]) ? (cycles - profOverhead[core]) : 0;
+
+    // Interrupts off: a handler of this core may end the same probe
+    ProfStats *stats = &probe->core[core];
+    uint32_t primask = cpuIrqSave();
+    if ((stats->count == 0) || (cycles < stats->min))
+    {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max)
+    {
+        stats->max = cycles;
+    }
+    stats->count++;
+    stats->sum += cycles;
+    stats->hist[profBin(cycles)]++;
+    cpuIrqRestore(primask);
+}
+
+void profReset(void)
+{
+    for (ProfProbe *const *probe = __start_prof_probes; probe < __stop_prof_probes; probe++)
+    {
+        uint32_t primask = cpuIrqSave();
+        profClear(&(*probe)->core[0]);
+        profClear(&(*probe)->core[1]);
+        cpuIrqRestore(primask);
+    }
+}
+
+/* The report goes out in blocks of a small buffer */
+typedef struct {
+    ProfWriter write;
+    uint32_t   checksum;
+    uint32_t   used;
+    uint8_t    buf[64];
+} ProfOut;
+
+static void profFlush(ProfOut *out)
+{
+    if (out->used)
+    {
+        out->write(out->buf, out->used);
+        out->used = 0;
+    }
+}
+
+static void profPut(ProfOut *out, uint32_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++, value >>= 8)
+    {
+        if (out->used == sizeof(out->buf))
+        {
+            profFlush(out);
+        }
+        out->buf[out->used++] = (uint8_t)value;
+        out->checksum += (uint8_t)value;
+    }
+}
+
+static uint32_t profNameLen(const char *name)
+{
+    uint32_t len = 0;
+    while ((name[len] != '\0') && (len < 255))
+    {
+        len++;
+    }
+    return len;
+}
+
+/* A core that has never run the probe is left out */
+static uint32_t profCoreMask(const ProfProbe *probe)
+{
+    return (probe->core[0].count ? 1 : 0) | (probe->core[1].count ? 2 : 0);
+}
+
+/* Snapshot of the statistics of a core: the report itself goes through the
+   UART interrupt, which may have a probe (no memcpy with -nostdlib) */
+static void profCopy(ProfStats *dst, const ProfStats *src)
+{
+    uint32_t primask = cpuIrqSave();
+    dst->count = src->count;
+    dst->min = src->min;
+    dst->max = src->max;
+    dst->sum = src->sum;
+    for (uint32_t i = 0; i < PROF_BINS; i++)
+    {
+        dst->hist[i] = src->hist[i];
+    }
+    cpuIrqRestore(primask);
+}
+
+/* Each probe is copied with the interrupts off, but the other core may still
+   update its statistics during the copy: they can be off by the measurement
+   in flight, which the next report fixes */
+void profDump(ProfWriter write)
+{
+    ProfOut out;
+    out.write = write;
+    out.used = 0;
+
+    uint32_t length = 16;
+    uint32_t probes = 0;
+    uint32_t mask[__stop_prof_probes - __start_prof_probes];
+    for (ProfProbe *const *probe = __start_prof_probes; probe < __stop_prof_probes; probe++, probes++)
+    {
+        mask[probes] = profCoreMask(*probe);
+        length += 2 + profNameLen((*probe)->name);
+        length += ((mask[probes] & 1) + (mask[probes] >> 1)) * (4 * (5 + PROF_BINS));
+    }
+
+    profPut(&out, PROF_MAGIC, 4);
+    profPut(&out, length, 4);
+    out.checksum = 0;
+    profPut(&out, clocksGetSysHz(), 4);
+    profPut(&out, profOverhead[0], 2);
+    profPut(&out, profOverhead[1], 2);
+    profPut(&out, profCost[0], 2);
+    profPut(&out, profCost[1], 2);
+    profPut(&out, probes, 2);
+    profPut(&out, PROF_BINS, 1);
+    profPut(&out, 0, 1);
+    for (uint32_t n = 0; n < probes; n++)
+    {
+        const ProfProbe *probe = __start_prof_probes[n];
+        uint32_t len = profNameLen(probe->name);
+        profPut(&out, len, 1);
+        for (uint32_t i = 0; i < len; i++)
+        {
+            profPut(&out, (uint8_t)probe->name[i], 1);
+        }
+        profPut(&out, mask[n], 1);
+        for (uint32_t core = 0; core < 2; core++)
+        {
+            if (!(mask[n] & (1 << core)))
+            {
+                continue;
+            }
+            ProfStats stats;
+            profCopy(&stats, &probe->core[core]);
+            profPut(&out, stats.count, 4);
+            profPut(&out, stats.min, 4);
+            profPut(&out, stats.max, 4);
+            profPut(&out, (uint32_t)stats.sum, 4);
+            profPut(&out, (uint32_t)(stats.sum >> 32), 4);
+            for (uint32_t i = 0; i < PROF_BINS; i++)
+            {
+                profPut(&out, stats.hist[i], 4);
+            }
+        }
+    }
+    uint32_t checksum = out.checksum;
+    profPut(&out, checksum, 4);
+    profFlush(&out);
+}
+
+#endif /* PROF_ENABLE */
@@ -0,0 +1,102 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Cycle profiler on the cycle counter of each core (DWT CYCCNT, mcycle on
+   RISC-V, see cpu.h)
+   A probe measures the cycles between PROF_BEGIN and PROF_END:
+
+       PROF_PROBE(lineStep);                   // at file scope, once
+
+       void lineStep(void *context)
+       {
+           PROF_BEGIN(lineStep);
+           ...
+           PROF_END(lineStep);
+       }
+
+   Every probe keeps, for each core, the number of calls, min, max, the sum
+   (for the mean) and a histogram with one bin per power of two of cycles.
+   A core only writes its own statistics, so both cores can use the same probe
+   without a lock. profDump() sends all of them as a binary report
+   (see tools/profdecode.py), e.g. from a periodic task.
+   The cycles of an empty begin/end pair are measured by profInit() and
+   subtracted from every measurement. A nested probe adds the cost of its
+   begin/end pair to the enclosing one (both are in the report header).
+   Build with PROF=1 (-DPROF_ENABLE=1). Otherwise the macros expand to
+   nothing and profInit()/profDump() are empty: the code has no trace of the
+   probes.
+*/
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include "rp2350.h"
+#include "cpu.h"
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE (0)
+#endif
+
+#define PROF_BINS  (16)                 // bin 0: 0 cycles, bin n: 2^(n-1) <= cycles < 2^n, the last one is open
+#define PROF_MAGIC (0x31465250u)        // "PRF1" at the start of a report
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PROF_BINS];
+} ProfStats;
+
+typedef struct {
+    const char *name;
+    ProfStats  core[2];
+} ProfProbe;
+
+/* Sends a block of the report, e.g. uartWriteAll */
+typedef void (*ProfWriter)(const uint8_t *data, uint32_t len);
+
+#if PROF_ENABLE
+
+/* Defines a probe and adds it to the prof_probes section (a table of
+   pointers, see linker_script.ld) where profDump() finds it */
+#define PROF_PROBE(probe) \
+    static ProfProbe probe##Probe = { #probe, { { 0 } } }; \
+    static ProfProbe *const probe##Entry __attribute__((section("prof_probes"), used)) = &probe##Probe
+
+#define PROF_BEGIN(probe)  uint32_t probe##Start = profNow()
+#define PROF_END(probe)    profEnd(&probe##Probe, probe##Start)
+
+static inline uint32_t profNow(void)
+{
+    return cpuCycles();
+}
+
+/* Starts the cycle counter of the calling core and measures the cost of the
+   probes. Called once by each core that uses probes */
+void profInit(void);
+
+/* Accounts the cycles since start, called by PROF_END */
+void profEnd(ProfProbe *probe, uint32_t start);
+
+/* Sends the statistics of all probes, both cores */
+void profDump(ProfWriter write);
+
+/* Clears the statistics of all probes */
+void profReset(void);
+
+#else
+
+#define PROF_PROBE(probe)  struct profUnused_##probe
+#define PROF_BEGIN(probe)
+#define PROF_END(probe)
+
+static inline void profInit(void) {}
+static inline void profDump(ProfWriter write) { (void)write; }
+static inline void profReset(void) {}
+
+#endif /* PROF_ENABLE */
+
+#endif /* PROF_H */
@@ -0,0 +1,188 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Typed register access
+   A field names the register it belongs to (offset in the peripheral block)
+   and the bits it uses:
+
+       #define XOSC_STATUS_STABLE  REG_FIELD(0x04, 31, 1)
+
+   The access macros take the base address of the block and a field, and
+   expand to the PUT32/GET32 the hand-written code would do. Everything but
+   the access itself is a constant, folded by the compiler also at -O0:
+
+       REG_TEST(XOSC_BASE, XOSC_STATUS_STABLE)           GET32(XOSC_BASE + 0x04) & (1 << 31)
+       REG_SET(RESETS_BASE, RESETS_RESET(RESETS_UART0))  PUT32(RESETS_BASE + WRITE_SET + 0x00, 1 << 26)
+
+   Fields of the same register combine with '|' into a field that covers
+   all their bits, so several bits are set, cleared or toggled with one
+   alias store, and several fields are written with one store:
+
+       REG_WRITE(pll, PLL_PRIM_POSTDIV1 | PLL_PRIM_POSTDIV2,
+                 REG_VALUE(PLL_PRIM_POSTDIV1, 5) | REG_VALUE(PLL_PRIM_POSTDIV2, 2));
+
+   Two mistakes fail to compile (_Static_assert):
+   - fields of different registers combined with '|'
+   - a SET/CLR/XOR alias on SIO, which has none (it has _SET/_CLR/_XOR
+     registers instead, written with REG_STROBE)
+   A field with a mask known at run time only (e.g. RESETS_RESET(bit) with
+   a variable) is not checked, and at -O0 its offset is extracted at run
+   time: use PUT32/GET32 there (see pllStart in clocks.c).
+
+   Encoding of a field (64 bits): bits 0-31 mask, 32-43 register offset,
+   44-55 offset inverted (two different offsets OR-ed together no longer
+   match their inverse), bit 63 block without atomic aliases.
+   Only the blocks moved to this layer are described here: RESETS, the
+   clocks, XOSC and the PLLs, IO_BANK0 and PADS_BANK0 (clocks.c, power.c,
+   the pins of uart.c and pio.c). The other registers keep their macros
+   (the UART registers of uart.c, timer.c, dma.h, sha256.c, uart_dma.c,
+   multicore.c).
+   See section 2.1.3 "Atomic Register Access" on RP2350 datasheet.
+*/
+#ifndef REGS_H
+#define REGS_H
+
+#include <stdint.h>
+#include "rp2350.h"
+
+#define REG_NO_ALIAS             (1ull << 63)
+
+/* Field of the bits of mask in the register at offset, and the same with
+   its position and width */
+#define REG_MASK_FIELD(offset, mask) \
+    (((uint64_t)(0xfff & ~(offset)) << 44) | ((uint64_t)(offset) << 32) | (uint32_t)(mask))
+#define REG_FIELD(offset, lsb, width) \
+    REG_MASK_FIELD((offset), ((0xffffffffu >> (32 - (width))) << (lsb)))
+
+/* The same for a block without atomic aliases (SIO) */
+#define REG_MASK_FIELD_NA(offset, mask) (REG_MASK_FIELD((offset), (mask)) | REG_NO_ALIAS)
+#define REG_FIELD_NA(offset, lsb, width) (REG_FIELD((offset), (lsb), (width)) | REG_NO_ALIAS)
+
+#define REG_OFFSET(field)        ((uint32_t)(((field) >> 32) & 0xfff))
+#define REG_MASK(field)          ((uint32_t)(field))
+#define REG_LSB(field)           ((uint32_t)__builtin_ctz(REG_MASK(field)))
+
+/* Value of a field in its register. Not masked (a variable would cost an
+   instruction more than the hand-written shift): value must fit */
+#define REG_VALUE(field, value)  ((uint32_t)(value) << REG_LSB(field))
+
+/* Compile time checks of a constant field */
+#define REG_CHECK(field) \
+    _Static_assert(__builtin_choose_expr(__builtin_constant_p(field), \
+                   (((((field) >> 32) ^ ((field) >> 44)) & 0xfff) == 0xfff), 1), "fields of different registers")
+#define REG_CHECK_ALIAS(field) \
+    REG_CHECK(field); \
+    _Static_assert(__builtin_choose_expr(__builtin_constant_p(field), \
+                   !((field) & REG_NO_ALIAS), 1), "no SET/CLR/XOR aliases on this block")
+
+/* Value of the field (several fields: their bits, in place) */
+#define REG_READ(base, field) \
+    ({ REG_CHECK(field); (GET32((base) + REG_OFFSET(field)) & REG_MASK(field)) >> REG_LSB(field); })
+
+/* Non zero when one of the bits of the field is set */
+#define REG_TEST(base, field) \
+    ({ REG_CHECK(field); (GET32((base) + REG_OFFSET(field)) & REG_MASK(field)) != 0; })
+
+/* Writes the whole register of the field: the bits outside value are 0 */
+#define REG_WRITE(base, field, value) \
+    do { REG_CHECK(field); PUT32(((base) + REG_OFFSET(field)), (value)); } while (0)
+
+/* Writes the bits of the field (1s) to its register: for the write-1
+   registers, e.g. SIO GPIO_OUT_XOR or an interrupt clear */
+#define REG_STROBE(base, field) \
+    do { REG_CHECK(field); PUT32(((base) + REG_OFFSET(field)), REG_MASK(field)); } while (0)
+
+/* Sets, clears or toggles the bits of the field with one alias store */
+#define REG_SET(base, field) \
+    do { REG_CHECK_ALIAS(field); PUT32(((base) + WRITE_SET + REG_OFFSET(field)), REG_MASK(field)); } while (0)
+#define REG_CLR(base, field) \
+    do { REG_CHECK_ALIAS(field); PUT32(((base) + WRITE_CLR + REG_OFFSET(field)), REG_MASK(field)); } while (0)
+#define REG_XOR(base, field) \
+    do { REG_CHECK_ALIAS(field); PUT32(((base) + WRITE_XOR + REG_OFFSET(field)), REG_MASK(field)); } while (0)
+
+/* Changes the field to value (REG_VALUE) and leaves the other bits alone:
+   one read and one store to the XOR alias of the bits that differ. Unlike
+   a read-modify-write of the whole register, a bit changed by the hardware
+   or by the other core in between is not written back. */
+#define REG_UPDATE(base, field, value) \
+    do { \
+        REG_CHECK_ALIAS(field); \
+        PUT32(((base) + WRITE_XOR + REG_OFFSET(field)), \
+              ((GET32((base) + REG_OFFSET(field)) ^ (value)) & REG_MASK(field))); \
+    } while (0)
+
+/* RESETS: one bit per peripheral, the RESETS_* masks of rp2350.h
+   See section 7.5 "Resets" on RP2350 datasheet */
+#define RESETS_RESET(mask)       REG_MASK_FIELD(0x00, (mask))  // 1: held in reset
+#define RESETS_RESET_DONE(mask)  REG_MASK_FIELD(0x08, (mask))  // 1: out of reset
+
+/* IO_BANK0: base of the registers of a pin
+   See "IO_BANK0" in the GPIO chapter of RP2350 datasheet */
+#define IO_BANK0_GPIO(pin)       (IO_BANK0_BASE + 0x004 + 8 * (pin))   // GPIOn_CTRL
+#define GPIO_CTRL_FUNCSEL        REG_FIELD(0x00, 0, 5)
+#define GPIO_FUNC_UART           (2)
+#define GPIO_FUNC_SIO            (5)
+#define GPIO_FUNC_PIO0           (6)           // PIO1 (7), PIO2 (8)
+
+/* PADS_BANK0: base of the pad register of a pin
+   See "PADS_BANK0" in the GPIO chapter of RP2350 datasheet */
+#define PADS_BANK0_GPIO(pin)     (PADS_BANK0_BASE + 0x004 + 4 * (pin))
+#define PADS_GPIO_SLEWFAST       REG_FIELD(0x00, 0, 1)
+#define PADS_GPIO_SCHMITT        REG_FIELD(0x00, 1, 1)
+#define PADS_GPIO_PDE            REG_FIELD(0x00, 2, 1)         // pull down
+#define PADS_GPIO_PUE            REG_FIELD(0x00, 3, 1)         // pull up
+#define PADS_GPIO_DRIVE          REG_FIELD(0x00, 4, 2)         // 0: 2mA, 1: 4mA, 2: 8mA, 3: 12mA
+#define PADS_GPIO_IE             REG_FIELD(0x00, 6, 1)         // input enable
+#define PADS_GPIO_OD             REG_FIELD(0x00, 7, 1)         // output disable
+#define PADS_GPIO_ISO            REG_FIELD(0x00, 8, 1)         // isolation latch, set at reset
+
+/* XOSC
+   See section 8.2 "Crystal Oscillator (XOSC)" on RP2350 datasheet */
+#define XOSC_CTRL_FREQ_RANGE     REG_FIELD(0x00, 0, 12)
+#define XOSC_CTRL_ENABLE         REG_FIELD(0x00, 12, 12)
+#define XOSC_STATUS_STABLE       REG_FIELD(0x04, 31, 1)
+#define XOSC_STARTUP_DELAY       REG_FIELD(0x0c, 0, 14)        // units of 256 crystal cycles
+#define XOSC_FREQ_RANGE_1_15MHZ  (0xaa0)
+#define XOSC_ENABLE_VALUE        (0xfab)
+
+/* CLOCKS: the clock generators used by clocks.c
+   See section 8.1 "Overview" (list of registers) on RP2350 datasheet */
+#define CLK_REF_CTRL_SRC         REG_FIELD(0x30, 0, 2)         // 2: xosc_clksrc
+#define CLK_REF_DIV_INT          REG_FIELD(0x34, 16, 16)
+#define CLK_REF_SELECTED         REG_FIELD(0x38, 0, 32)        // one hot: the source in use
+#define CLK_SYS_CTRL_SRC         REG_FIELD(0x3c, 0, 1)         // 0: clk_ref, 1: aux
+#define CLK_SYS_CTRL_AUXSRC      REG_FIELD(0x3c, 5, 3)         // 0: pll_sys, 3: xosc_clksrc
+#define CLK_SYS_DIV_INT          REG_FIELD(0x40, 16, 16)
+#define CLK_SYS_SELECTED         REG_FIELD(0x44, 0, 32)
+#define CLK_PERI_CTRL_AUXSRC     REG_FIELD(0x48, 5, 3)         // 0: clk_sys
+#define CLK_PERI_CTRL_ENABLE     REG_FIELD(0x48, 11, 1)
+#define CLK_PERI_DIV_INT         REG_FIELD(0x4c, 16, 2)
+#define CLK_USB_CTRL_AUXSRC      REG_FIELD(0x60, 5, 3)         // 0: pll_usb
+#define CLK_USB_CTRL_ENABLE      REG_FIELD(0x60, 11, 1)
+#define CLK_USB_DIV_INT          REG_FIELD(0x64, 16, 4)
+
+/* PLL_SYS / PLL_USB
+   See section 8.6 "PLL" on RP2350 datasheet */
+#define PLL_CS_REFDIV            REG_FIELD(0x0, 0, 6)
+#define PLL_CS_LOCK              REG_FIELD(0x0, 31, 1)
+#define PLL_PWR_PD               REG_FIELD(0x4, 0, 1)
+#define PLL_PWR_POSTDIVPD        REG_FIELD(0x4, 3, 1)
+#define PLL_PWR_VCOPD            REG_FIELD(0x4, 5, 1)
+#define PLL_FBDIV_INT            REG_FIELD(0x8, 0, 12)
+#define PLL_PRIM_POSTDIV2        REG_FIELD(0xc, 12, 3)
+#define PLL_PRIM_POSTDIV1        REG_FIELD(0xc, 16, 3)
+
+/* SIO GPIO registers: a mask of pins, written with REG_STROBE
+   See section 3.1 "SIO" on RP2350 datasheet */
+#define SIO_GPIO_IN(mask)        REG_MASK_FIELD_NA(0x004, (mask))
+#define SIO_GPIO_OUT(mask)       REG_MASK_FIELD_NA(0x010, (mask))
+#define SIO_GPIO_OUT_SET(mask)   REG_MASK_FIELD_NA(0x018, (mask))
+#define SIO_GPIO_OUT_CLR(mask)   REG_MASK_FIELD_NA(0x020, (mask))
+#define SIO_GPIO_OUT_XOR(mask)   REG_MASK_FIELD_NA(0x028, (mask))
+#define SIO_GPIO_OE(mask)        REG_MASK_FIELD_NA(0x030, (mask))
+#define SIO_GPIO_OE_SET(mask)    REG_MASK_FIELD_NA(0x038, (mask))
+#define SIO_GPIO_OE_CLR(mask)    REG_MASK_FIELD_NA(0x040, (mask))
+
+#endif /* REGS_H */
@@ -0,0 +1,114 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* RP2350 register access and peripheral base addresses
+   Shared by the modules of the bsp directory.
+*/
+#ifndef RP2350_H
+#define RP2350_H
+
+#include <stdint.h>
+
+/* Define register access function
+   On a host build (make host) the accesses go to the RP2350 simulator */
+#ifdef HOST_SIM
+#include "rp2350_sim.h"
+#else
+#define PUT32(address, value) (*((volatile unsigned int *)(address))) = value
+#define GET32(address) (*(volatile unsigned int *)(address))
+#endif
+
+/* Define Atomic Register Access
+   See section 2.1.3 "Atomic Register Access" on RP2350 datasheet */
+#define WRITE_NORMAL (0x0000)   // normal read write access
+#define WRITE_XOR    (0x1000)   // atomic XOR on write
+#define WRITE_SET    (0x2000)   // atomic bitmask set on write
+#define WRITE_CLR    (0x3000)   // atomic bitmask clear on write
+
+/* Peripheral base addresses
+   See section 2.2 "Address map" on RP2350 datasheet */
+#define CLOCKS_BASE     (0x40010000)
+#define PSM_BASE        (0x40018000)
+#define RESETS_BASE     (0x40020000)
+#define IO_BANK0_BASE   (0x40028000)
+#define PADS_BANK0_BASE (0x40038000)
+#define XOSC_BASE       (0x40048000)
+#define PLL_SYS_BASE    (0x40050000)
+#define PLL_USB_BASE    (0x40058000)
+#define UART0_BASE      (0x40070000)
+#define UART1_BASE      (0x40078000)
+#define TIMER0_BASE     (0x400b0000)
+#define SHA256_BASE     (0x400f8000)
+#define TICKS_BASE      (0x40108000)
+#define DMA_BASE        (0x50000000)
+#define PIO0_BASE       (0x50200000)
+#define PIO1_BASE       (0x50300000)
+#define PIO2_BASE       (0x50400000)
+#define SIO_BASE        (0xd0000000)
+
+/* XIP cache maintenance
+   See section 4.4.1 "XIP cache" on RP2350 datasheet: a write anywhere in the
+   window runs the operation of its 3 low address bits on the cache line
+   selected by the other bits (16 KB, 2 ways, 8 byte lines) */
+#define XIP_MAINTENANCE_BASE  (0x18000000)
+#define XIP_CACHE_SIZE        (16 * 1024)
+#define XIP_CACHE_LINE        (8)
+#define XIP_INVALIDATE_BY_SET_WAY (0)
+
+/* Cortex-M33 private peripherals */
+#define DWT_CTRL        (0xe0001000)
+#define DWT_CYCCNT      (0xe0001004)    // cycle counter
+#define SYST_CSR        (0xe000e010)    // SysTick control and status
+#define SYST_RVR        (0xe000e014)    // SysTick reload value
+#define SYST_CVR        (0xe000e018)    // SysTick current value
+#define VTOR            (0xe000ed08)    // vector table offset
+#define AIRCR           (0xe000ed0c)    // application interrupt and reset control (PRIGROUP)
+#define SCR             (0xe000ed10)    // system control (SLEEPDEEP, SEVONPEND), per core
+#define SHPR3           (0xe000ed20)    // SysTick and PendSV priority
+#define DEMCR           (0xe000edfc)
+
+/* RESETS bits
+   See section 7.5.2 "Reset controller" on RP2350 datasheet */
+#define RESETS_DMA      (1 << 2)
+#define RESETS_PIO0     (1 << 11)
+#define RESETS_PIO1     (1 << 12)
+#define RESETS_PIO2     (1 << 13)
+#define RESETS_PLL_SYS  (1 << 14)
+#define RESETS_PLL_USB  (1 << 15)
+#define RESETS_SHA256   (1 << 17)
+#define RESETS_TIMER0   (1 << 23)
+#define RESETS_UART0    (1 << 26)
+#define RESETS_UART1    (1 << 27)
+
+/* Interrupt numbers
+   See section 3.2 "Interrupts" on RP2350 datasheet */
+#define TIMER0_IRQ_0    (0)
+#define TIMER0_IRQ_1    (1)
+#define TIMER0_IRQ_2    (2)
+#define TIMER0_IRQ_3    (3)
+#define DMA_IRQ_0       (10)
+#define DMA_IRQ_1       (11)
+#define PIO0_IRQ_0      (15)
+#define PIO0_IRQ_1      (16)
+#define PIO1_IRQ_0      (17)
+#define PIO1_IRQ_1      (18)
+#define PIO2_IRQ_0      (19)
+#define PIO2_IRQ_1      (20)
+#define UART0_IRQ       (33)
+#define UART1_IRQ       (34)
+#define SPARE_IRQ_0     (46)    // SPARE_IRQ_0..5: no hardware source, raised by software
+
+/* DMA transfer requests (DREQ)
+   See section 12.6.4.1 "System DREQ table" on RP2350 datasheet */
+#define DREQ_PIO_TX(pio, sm) (8 * (pio) + (sm))         // PIO0_TX0 (0) .. PIO2_TX3 (19)
+#define DREQ_PIO_RX(pio, sm) (8 * (pio) + 4 + (sm))     // PIO0_RX0 (4) .. PIO2_RX3 (23)
+#define DREQ_UART0_TX   (28)
+#define DREQ_UART0_RX   (29)
+#define DREQ_UART1_TX   (30)
+#define DREQ_UART1_RX   (31)
+#define DREQ_SHA256     (54)
+#define DREQ_FORCE      (0x3f)  // permanent request, the channel runs at full speed
+
+#endif /* RP2350_H */
@@ -0,0 +1,178 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "multicore.h"
+#include "sched.h"
+
+/* SIO spinlocks: reading claims the lock (0 if it is already taken), writing
+   releases it. See section 3.1.4 "Hardware spinlocks" on RP2350 datasheet */
+#define SIO_SPINLOCK(n) (SIO_BASE + 0x100 + 4 * (n))
+
+typedef struct {
+    Task *head;
+    Task *tail;
+} SchedQueue;
+
+static SchedQueue schedQueue[2];
+static SchedStats schedStats[2];
+
+/* Locks the queue of a core against the other core and the own interrupts.
+   Returns the PRIMASK for schedUnlock() */
+static uint32_t schedLock(uint32_t core)
+{
+    uint32_t primask = cpuIrqSave();
+    while (GET32(SIO_SPINLOCK(SCHED_SPINLOCK + core)) == 0);
+    cpuDmb();                                                              // Acquire: read the queue after the lock
+    return primask;
+}
+
+static void schedUnlock(uint32_t core, uint32_t primask)
+{
+    cpuDmb();                                                              // Release: write the queue before the unlock
+    PUT32(SIO_SPINLOCK(SCHED_SPINLOCK + core), 0);
+    cpuIrqRestore(primask);
+}
+
+void schedInit(void)
+{
+    for (uint32_t core = 0; core < 2; core++)
+    {
+        PUT32(SIO_SPINLOCK(SCHED_SPINLOCK + core), 0);                     // Release, whatever the state after reset
+        schedQueue[core].head = schedQueue[core].tail = 0;
+        schedStats[core].submitted = schedStats[core].executed = 0;
+        schedStats[core].stolen = schedStats[core].sleeps = 0;
+    }
+}
+
+static void schedCore1(void)
+{
+    schedRun();
+}
+
+void schedLaunchCore1(void)
+{
+    multicoreLaunchCore1(schedCore1);
+}
+
+int schedSubmit(Task *task, TaskFn fn, void *arg, uint32_t affinity)
+{
+    uint32_t self = multicoreCoreId();
+    uint32_t core = (affinity == SCHED_ANY_CORE) ? self : (affinity & 1);
+
+    // The task is claimed under the lock of queue 0 whatever its queue: the
+    // two cores may submit the same SCHED_ANY_CORE task at once, each to its
+    // own queue under its own lock
+    uint32_t primask = schedLock(0);
+    uint32_t queued = task->queued;
+    task->queued = 1;
+    if (queued || (core != 0))
+    {
+        schedUnlock(0, primask);
+        if (queued)
+        {
+            return -1;
+        }
+        primask = schedLock(core);
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->affinity = affinity;
+    task->next = 0;
+    if (schedQueue[core].tail)
+    {
+        schedQueue[core].tail->next = task;
+    }
+    else
+    {
+        schedQueue[core].head = task;
+    }
+    schedQueue[core].tail = task;
+    schedStats[self].submitted++;
+    schedUnlock(core, primask);
+    cpuSev();                                                              // Wake up an idle core
+    return 0;
+}
+
+/* Takes the first task of a queue that the calling core may run: any task of
+   its own queue, or the first unpinned one of the other queue */
+static Task *schedTake(uint32_t core, uint32_t self)
+{
+    uint32_t primask = schedLock(core);
+    Task *prev = 0;
+    Task *task = schedQueue[core].head;
+    while (task && (core != self) && (task->affinity != SCHED_ANY_CORE))
+    {
+        prev = task;
+        task = task->next;
+    }
+    if (task)
+    {
+        if (prev)
+        {
+            prev->next = task->next;
+        }
+        else
+        {
+            schedQueue[core].head = task->next;
+        }
+        if (schedQueue[core].tail == task)
+        {
+            schedQueue[core].tail = prev;
+        }
+        task->next = 0;
+    }
+    schedUnlock(core, primask);
+    return task;
+}
+
+int schedRunOne(void)
+{
+    uint32_t self = multicoreCoreId();
+    Task *task = schedTake(self, self);
+    if (task == 0)
+    {
+        if (schedQueue[self ^ 1].head == 0)
+        {
+            return 0;                                                      // Nothing to steal, skip the lock
+        }
+        task = schedTake(self ^ 1, self);
+        if (task == 0)
+        {
+            return 0;
+        }
+        schedStats[self].stolen++;
+    }
+    TaskFn fn = task->fn;
+    void *arg = task->arg;
+    cpuDmb();                                                              // fn and arg read before the task is released
+    task->queued = 0;                                                      // The task may submit itself again
+    fn(arg);
+    schedStats[self].executed++;
+    return 1;
+}
+
+void schedRun(void)
+{
+    uint32_t self = multicoreCoreId();
+    while (1)
+    {
+        if (!schedRunOne())
+        {
+            schedStats[self].sleeps++;
+            cpuWfe();                                                      // sev of schedSubmit, FIFO or interrupt
+        }
+    }
+}
+
+void schedGetStats(uint32_t core, SchedStats *stats)
+{
+    const SchedStats *src = &schedStats[core & 1];
+    stats->submitted = src->submitted;                                     // no memcpy with -nostdlib
+    stats->executed = src->executed;
+    stats->stolen = src->stolen;
+    stats->sleeps = src->sleeps;
+}
@@ -0,0 +1,69 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Run-to-completion task scheduler for the two cores
+   A task is a function and its argument. It runs until it returns, it is
+   never preempted by another task (interrupts still run). Every core has its
+   own queue, protected by a SIO spinlock, and takes its tasks in order:
+   - a task pinned to a core (affinity 0 or 1) only runs on that core, e.g.
+     the ones that use a peripheral whose interrupt is enabled on that core
+   - a task with SCHED_ANY_CORE is queued on the submitting core, and a core
+     whose queue is empty steals it from the other queue
+   An idle core sleeps in wfe. schedSubmit() sends an event (sev) and the SIO
+   FIFO writes and the interrupts also wake it up, so the queues are checked
+   again after any of them.
+   Tasks may be submitted from both cores, from tasks and from interrupt
+   handlers (e.g. a timer callback). A task is claimed (queued) under the
+   lock of queue 0 before it is linked, so only one of two simultaneous
+   submissions of the same task succeeds.
+*/
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+#define SCHED_ANY_CORE (0xffffffffu)
+
+/* SIO spinlocks of the queue of core 0 and core 1 */
+#define SCHED_SPINLOCK (8)
+
+typedef void (*TaskFn)(void *arg);
+
+/* Provided by the caller (no heap), it must stay valid until the task ran.
+   A queued task cannot be submitted again. */
+typedef struct Task {
+    TaskFn fn;
+    void *arg;
+    uint32_t affinity;          // 0, 1 or SCHED_ANY_CORE
+    volatile uint32_t queued;
+    struct Task *next;
+} Task;
+
+typedef struct {
+    uint32_t submitted;         // tasks submitted by the core
+    uint32_t executed;          // tasks run by the core
+    uint32_t stolen;            // tasks the core took from the queue of the other core
+    uint32_t sleeps;            // times the core slept with nothing to run
+} SchedStats;
+
+/* Empties the queues. Called by core 0 before any other function */
+void schedInit(void);
+
+/* Launches core 1 (multicoreLaunchCore1) into schedRun() */
+void schedLaunchCore1(void);
+
+/* Queues fn(arg) for the given core (or SCHED_ANY_CORE). Returns 0, or -1 if
+   the task is already queued */
+int schedSubmit(Task *task, TaskFn fn, void *arg, uint32_t affinity);
+
+/* Runs one task of the calling core, or steals one. Returns 1 if a task ran */
+int schedRunOne(void);
+
+/* Runs the tasks of the calling core forever, sleeping when there are none */
+void schedRun(void);
+
+void schedGetStats(uint32_t core, SchedStats *stats);
+
+#endif /* SCHED_H */
@@ -0,0 +1,170 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "dma.h"
+#include "sha256.h"
+
+/* SHA-256 registers
+   See section 12.13 "SHA-256 accelerator" on RP2350 datasheet */
+#define SHA256_CSR          (SHA256_BASE + 0x00)
+#define SHA256_WDATA        (SHA256_BASE + 0x04)
+#define SHA256_SUM(i)       (SHA256_BASE + 0x08 + 4 * (i))
+
+#define SHA256_CSR_START    (1 << 0)    // write 1: initial hash values, new message
+#define SHA256_CSR_WDATA_RDY (1 << 1)   // low for 57 cycles after the 16th word of a block
+#define SHA256_CSR_SUM_VLD  (1 << 2)    // SUM0-7 hold the digest of the blocks written
+#define SHA256_CSR_DMA_WORD (2 << 8)    // DMA_SIZE: words (bytes = 0)
+#define SHA256_CSR_BSWAP    (1 << 12)   // little endian words from memory to big endian
+
+/* Writes a word of the message. Before the first word of a block, the
+   previous block must be done. */
+static void sha256Word(Sha256 *sha, uint32_t word)
+{
+    if ((sha->length & 0x3f) == 0)
+    {
+        while (!(GET32(SHA256_CSR) & SHA256_CSR_WDATA_RDY));
+    }
+    PUT32(SHA256_WDATA, word);
+    sha->length += 4;
+}
+
+/* Adds a byte to the incomplete word, writes it once complete */
+static void sha256Byte(Sha256 *sha, uint8_t byte)
+{
+    uint32_t offset = (uint32_t)sha->length & 3;
+    sha->partial |= (uint32_t)byte << (8 * offset);
+    if (offset == 3)
+    {
+        sha->length -= 3;                                                  // sha256Word() counts the whole word
+        sha256Word(sha, sha->partial);
+        sha->partial = 0;
+    }
+    else
+    {
+        sha->length++;
+    }
+}
+
+/* Waits for the DMA transfer of sha256UpdateDma() */
+static void sha256Wait(Sha256 *sha)
+{
+    while (sha256Busy(sha));
+}
+
+void sha256Init(Sha256 *sha)
+{
+    if (!(GET32(RESETS_BASE + 0x08) & RESETS_SHA256))
+    {
+        PUT32((RESETS_BASE + WRITE_CLR + 0x0), RESETS_SHA256);             // De-assert the reset from SHA256
+        while (!(GET32(RESETS_BASE + 0x08) & RESETS_SHA256));              // Wait for SHA256 to be ready
+    }
+    PUT32(SHA256_CSR, (SHA256_CSR_BSWAP | SHA256_CSR_DMA_WORD | SHA256_CSR_START));
+    sha->length = 0;
+    sha->partial = 0;
+    sha->dma = 0;
+}
+
+void sha256Update(Sha256 *sha, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = data;
+    sha256Wait(sha);
+    while ((len > 0) && (sha->length & 3))                                 // Up to the next word of the message
+    {
+        sha256Byte(sha, *bytes++);
+        len--;
+    }
+    if (((uintptr_t)bytes & 3) == 0)
+    {
+        for (; len >= 4; len -= 4, bytes += 4)
+        {
+            sha256Word(sha, *(const uint32_t *)bytes);
+        }
+    }
+    else
+    {
+        for (; len >= 4; len -= 4, bytes += 4)
+        {
+            sha256Word(sha, (bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24)));
+        }
+    }
+    while (len-- > 0)
+    {
+        sha256Byte(sha, *bytes++);
+    }
+}
+
+void sha256UpdateDma(Sha256 *sha, const void *data, uint32_t len)
+{
+    const uint8_t *bytes = data;
+    sha256Wait(sha);
+    while ((len > 0) && (sha->length & 3))                                 // Up to the next word of the message
+    {
+        sha256Byte(sha, *bytes++);
+        len--;
+    }
+    uint32_t whole = len & ~3u;
+    if (whole > 0)
+    {
+        // The hardware gathers DMA bytes into words like the CPU does, only
+        // the DREQ has to know the size of the transfers
+        uint32_t aligned = (((uintptr_t)bytes & 3) == 0);
+        dmaInit();
+        PUT32(SHA256_CSR, (SHA256_CSR_BSWAP | (aligned ? SHA256_CSR_DMA_WORD : 0)));
+        PUT32(DMA_CH_READ_ADDR(SHA256_DMA_CH), (uint32_t)(uintptr_t)bytes);
+        PUT32(DMA_CH_WRITE_ADDR(SHA256_DMA_CH), SHA256_WDATA);
+        PUT32(DMA_CH_TRANS_COUNT(SHA256_DMA_CH), (aligned ? (whole / 4) : whole));
+        PUT32(DMA_CH_CTRL_TRIG(SHA256_DMA_CH), (DMA_CTRL_EN | (aligned ? DMA_CTRL_SIZE_WORD : DMA_CTRL_SIZE_BYTE) |
+                                                DMA_CTRL_INCR_READ | DMA_CTRL_CHAIN_TO(SHA256_DMA_CH) |
+                                                DMA_CTRL_TREQ_SEL(DREQ_SHA256) | DMA_CTRL_IRQ_QUIET));
+        sha->length += whole;
+        sha->dma = 1;
+        bytes += whole;
+        len -= whole;
+    }
+    while (len-- > 0)
+    {
+        sha256Byte(sha, *bytes++);                                         // Less than a word: kept in partial
+    }
+}
+
+int sha256Busy(Sha256 *sha)
+{
+    if (!sha->dma)
+    {
+        return 0;
+    }
+    if (GET32(DMA_CH_AL1_CTRL(SHA256_DMA_CH)) & DMA_CTRL_BUSY)
+    {
+        return 1;
+    }
+    PUT32(SHA256_CSR, (SHA256_CSR_BSWAP | SHA256_CSR_DMA_WORD));           // Back to words for the next transfer
+    sha->dma = 0;
+    return 0;
+}
+
+void sha256Final(Sha256 *sha, uint8_t *digest)
+{
+    uint64_t bits = sha->length * 8;
+    sha256Wait(sha);
+    sha256Byte(sha, 0x80);                                                 // Padding: a 1 bit, zeros up to 56 mod 64
+    while ((sha->length & 0x3f) != 56)
+    {
+        sha256Byte(sha, 0);
+    }
+    for (int i = 7; i >= 0; i--)
+    {
+        sha256Byte(sha, (uint8_t)(bits >> (8 * i)));                       // Message length in bits, big endian
+    }
+    while (!(GET32(SHA256_CSR) & SHA256_CSR_SUM_VLD));
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        uint32_t sum = GET32(SHA256_SUM(i));
+        digest[4 * i + 0] = (uint8_t)(sum >> 24);
+        digest[4 * i + 1] = (uint8_t)(sum >> 16);
+        digest[4 * i + 2] = (uint8_t)(sum >> 8);
+        digest[4 * i + 3] = (uint8_t)sum;
+    }
+}
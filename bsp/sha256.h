@@ -0,0 +1,58 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* SHA-256 accelerator
+   The hardware hashes 64 byte blocks (57 clk_sys cycles each) written word
+   by word into WDATA, and keeps the digest of the blocks written so far in
+   SUM0-7. This driver streams any number of bytes into it: the bytes are
+   gathered into words in message order (BSWAP turns them into the big endian
+   words of the standard), so the buffers need no alignment, and
+   sha256Final() adds the padding and the message length.
+   sha256Update() writes the words with the CPU. sha256UpdateDma() hands the
+   whole words of a large buffer to a DMA channel paced by the SHA-256 DREQ
+   and returns at once: the core can do other work until sha256Busy() says
+   it is done (the next update or sha256Final() wait for it anyway). The
+   buffer must stay valid until then.
+   There is a single accelerator: one hash at a time.
+   See section 12.13 "SHA-256 accelerator" on RP2350 datasheet.
+*/
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+
+/* DMA channel of sha256UpdateDma() */
+#ifndef SHA256_DMA_CH
+#define SHA256_DMA_CH (2)
+#endif
+
+#define SHA256_DIGEST_SIZE (32)
+
+typedef struct {
+    uint64_t length;            // bytes hashed so far
+    uint32_t partial;           // bytes of the incomplete word, the first one in bits 7:0
+    int      dma;               // a DMA transfer may be in flight
+} Sha256;
+
+/* Takes the accelerator out of reset (the first time) and starts a new hash */
+void sha256Init(Sha256 *sha);
+
+/* Hashes len bytes with the CPU */
+void sha256Update(Sha256 *sha, const void *data, uint32_t len);
+
+/* Hashes len bytes with the DMA: the CPU writes the bytes up to the next
+   word of the message, then the DMA channel writes the words (or the bytes,
+   when data is not word aligned) and the CPU keeps the last 0-3 bytes for
+   later. Returns while the DMA runs. */
+void sha256UpdateDma(Sha256 *sha, const void *data, uint32_t len);
+
+/* Returns 1 while the DMA transfer of sha256UpdateDma() runs */
+int sha256Busy(Sha256 *sha);
+
+/* Pads the message, waits for the last block and copies the digest
+   (32 bytes, in the byte order of the standard) */
+void sha256Final(Sha256 *sha, uint8_t *digest);
+
+#endif /* SHA256_H */
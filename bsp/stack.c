@@ -0,0 +1,279 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "multicore.h"
+#include "stack.h"
+
+#define STACK_MAGIC       (0x53544b46)          // "STKF"
+#define SHCSR             (0xe000ed24)          // system handler control and state
+#define SHCSR_MEMFAULTENA (1u << 16)
+#define SHCSR_USGFAULTENA (1u << 18)
+#define CFSR              (0xe000ed28)          // configurable fault status
+#define CFSR_MMARVALID    (1u << 7)
+#define CFSR_STKOF        (1u << 20)            // stack limit violation
+#define MMFAR             (0xe000ed34)          // address of the MemManage fault
+#define MPU_CTRL          (0xe000ed94)
+#define MPU_RNR           (0xe000ed98)
+#define MPU_RBAR          (0xe000ed9c)
+#define MPU_RLAR          (0xe000eda0)
+#define MPU_MAIR0         (0xe000edc0)
+#define MPU_CTRL_ENABLE   (1u << 0)
+#define MPU_CTRL_PRIVDEFENA (1u << 2)           // the default memory map for what no region covers
+#define MPU_RBAR_RO_XN    ((2u << 1) | 1u)      // AP read-only (privileged), execute never
+#define MPU_RLAR_EN       (1u << 0)             // attribute index 0
+#define STACK_MPU_REGION  (7)                   // the highest priority region
+#define AIRCR_RESET       ((0x05fau << 16) | (1u << 2))   // VECTKEY, SYSRESETREQ
+
+static StackFault stackFault __attribute__((section(".noinit")));
+static uint32_t stackPainted[2];
+
+static uint32_t *stackBottom(uint32_t core)
+{
+    return core ? &__stack1_start__ : &__stack_start__;
+}
+
+static uint32_t *stackTop(uint32_t core)
+{
+    return core ? &__stack1_end__ : &__stack_end__;
+}
+
+void stackPaint(uint32_t core)
+{
+    uint32_t *dst = stackBottom(core);
+    uint32_t *end = stackTop(core);
+    uint32_t *frame = (uint32_t *)__builtin_frame_address(0);
+    if ((frame > dst) && (frame <= end))
+    {
+        end = frame - 16;                                                  // Running on it: keeps this frame and 64 bytes
+    }
+    while (dst < end)
+    {
+        *dst++ = STACK_PAINT;
+    }
+    stackPainted[core & 1] = 1;
+}
+
+void stackInit(void)
+{
+#ifndef __riscv
+    uint32_t core = multicoreCoreId();
+    uint32_t bottom = (uint32_t)(uintptr_t)stackBottom(core);
+
+    PUT32(SHCSR, (GET32(SHCSR) | SHCSR_MEMFAULTENA | SHCSR_USGFAULTENA));  // Not escalated to HardFault
+    PUT32(MPU_CTRL, 0);
+    PUT32(MPU_MAIR0, ((GET32(MPU_MAIR0) & ~0xffu) | 0x44));                // Attribute 0: normal memory, not cached
+    PUT32(MPU_RNR, STACK_MPU_REGION);
+    PUT32(MPU_RBAR, (bottom | MPU_RBAR_RO_XN));
+    PUT32(MPU_RLAR, (((bottom + STACK_GUARD - 32) & ~0x1fu) | MPU_RLAR_EN));
+    PUT32(MPU_CTRL, (MPU_CTRL_PRIVDEFENA | MPU_CTRL_ENABLE));
+    cpuDsb();
+    cpuIsb();
+    cpuSetMsplim(bottom + STACK_RESERVE);
+#endif
+}
+
+int stackGetStats(uint32_t core, StackStats *stats)
+{
+    core &= 1;
+    if (!stackPainted[core])
+    {
+        return -1;
+    }
+    uint32_t *word = stackBottom(core);
+    uint32_t *top = stackTop(core);
+    while ((word < top) && (*word == STACK_PAINT))
+    {
+        word++;
+    }
+    stats->size = (uint32_t)(top - stackBottom(core)) * 4;
+    stats->usable = stats->size - STACK_RESERVE;
+    stats->used = (uint32_t)(top - word) * 4;
+    return 0;
+}
+
+const StackFault *stackGetFault(void)
+{
+    return (stackFault.magic == STACK_MAGIC) ? &stackFault : 0;
+}
+
+#if !defined(__riscv) && !defined(HOST_SIM)
+/* Bytes that the Thumb instruction at pc takes from the stack, for the
+   instructions of the function prologues: push, sub sp, str with pre-index
+   on sp. 0 for any other */
+static uint32_t stackInstructionBytes(uint32_t pc)
+{
+    const uint16_t *code = (const uint16_t *)(uintptr_t)(pc & ~1u);
+    uint32_t first = code[0];
+    uint32_t second = code[1];
+    uint32_t bytes = 0;
+    if ((first & 0xfe00) == 0xb400)                                        // PUSH <registers>{, lr}
+    {
+        for (uint32_t list = (first & 0x1ff); list != 0; list &= list - 1)
+        {
+            bytes += 4;
+        }
+    }
+    else if ((first & 0xff80) == 0xb080)                                   // SUB sp, sp, #imm7 * 4
+    {
+        bytes = (first & 0x7f) * 4;
+    }
+    else if (first == 0xe92d)                                              // PUSH.W (STMDB sp!)
+    {
+        for (uint32_t list = (second & 0x5fff); list != 0; list &= list - 1)
+        {
+            bytes += 4;
+        }
+    }
+    else if ((first == 0xf84d) && ((second & 0x0f00) == 0x0d00))           // STR.W rt, [sp, #-imm8]!
+    {
+        bytes = second & 0xff;
+    }
+    else if (((first & 0xfbff) == 0xf2ad) && ((second & 0x8f00) == 0x0d00))   // SUBW sp, sp, #imm12
+    {
+        bytes = ((first & 0x400) << 1) | ((second & 0x7000) >> 4) | (second & 0xff);
+    }
+    else if (((first & 0xfbef) == 0xf1ad) && ((second & 0x8f00) == 0x0d00))   // SUB.W sp, sp, #const
+    {
+        uint32_t imm12 = ((first & 0x400) << 1) | ((second & 0x7000) >> 4) | (second & 0xff);
+        uint32_t imm8 = imm12 & 0xff;
+        switch (imm12 >> 8)
+        {
+            case 0:  bytes = imm8; break;
+            case 1:  bytes = imm8 | (imm8 << 16); break;
+            case 2:  bytes = (imm8 << 8) | (imm8 << 24); break;
+            case 3:  bytes = imm8 * 0x01010101u; break;
+            default:
+            {
+                uint32_t rotation = imm12 >> 7;
+                uint32_t value = 0x80 | (imm12 & 0x7f);
+                bytes = (value >> rotation) | (value << (32 - rotation));
+                break;
+            }
+        }
+    }
+    return bytes;
+}
+
+/* Called by stackFaultEntry with the stack pointer and EXC_RETURN of the
+   fault, the stack limit of the core already removed */
+__attribute__((used))
+void stackFaultHandler(uint32_t *sp, uint32_t excReturn)
+{
+    uint32_t core = multicoreCoreId();
+    uint32_t cfsr = GET32(CFSR);
+    uint32_t bottom = (uint32_t)(uintptr_t)stackBottom(core);
+    uint32_t limit = bottom + STACK_RESERVE;
+    uint32_t address = GET32(MMFAR);
+    int guard = (cfsr & CFSR_MMARVALID) && (address >= bottom) && (address < bottom + STACK_GUARD);
+    if (!(cfsr & CFSR_STKOF) && !guard)
+    {
+        while (1)
+        {
+            cpuNop();                                                      // Not a stack overflow: as Default_Handler
+        }
+    }
+
+    uint32_t pc = 0;
+    uint32_t before = 0;
+    uint32_t overflow = 0;
+    uint32_t frame = (uint32_t)(uintptr_t)sp;
+    if (guard)
+    {
+        overflow = limit - address;                                        // The handler went through the reserve
+    }
+    else if (frame > limit)
+    {
+        // The exception frame was stacked: the instruction that overflowed
+        // did not run, its pc and the stack pointer before it are known. On
+        // an overflow while stacking the frame, sp is the limit and the frame
+        // is lost
+        pc = sp[6];
+        before = frame + ((excReturn & (1u << 4)) ? 32 : 104) + ((sp[7] & (1u << 9)) ? 4 : 0);
+        uint32_t bytes = stackInstructionBytes(pc);
+        overflow = ((bytes > 0) && (before - bytes < limit)) ? (limit - (before - bytes)) : 0;
+    }
+
+    if (stackFault.magic != STACK_MAGIC)
+    {
+        stackFault.magic = STACK_MAGIC;
+        stackFault.faults = 0;
+    }
+    stackFault.faults++;
+    stackFault.core = core;
+    stackFault.pc = pc;
+    stackFault.sp = before;
+    stackFault.overflow = overflow;
+    stackFault.cfsr = cfsr;
+    cpuDsb();
+    PUT32(AIRCR, AIRCR_RESET);                                             // The next boot reports it
+    while (1)
+    {
+        cpuNop();
+    }
+}
+
+/* Fault handlers of both cores. Removes the stack limit first: the handler
+   runs in the reserve under it */
+__attribute__((naked))
+void stackFaultEntry(void)
+{
+    __asm volatile (
+        "movs r2, #0\n"
+        "msr msplim, r2\n"
+        "mrs r0, msp\n"
+        "mov r1, lr\n"
+        "b stackFaultHandler\n");
+}
+
+void HardFault_Handler(void) __attribute__((alias("stackFaultEntry")));
+void MemManage_Handler(void) __attribute__((alias("stackFaultEntry")));
+void UsageFault_Handler(void) __attribute__((alias("stackFaultEntry")));
+#endif
+
+void stackPrint(TextWriter write)
+{
+    const StackFault *fault = stackGetFault();
+    if (fault)
+    {
+        textWrite(write, "stack overflow: core ");
+        textWriteValue(write, fault->core, 10);
+        textWrite(write, ", ");
+        if (fault->overflow)
+        {
+            textWriteValue(write, fault->overflow, 10);
+            textWrite(write, " bytes");
+        }
+        else
+        {
+            textWrite(write, "unknown bytes");
+        }
+        if (fault->pc)
+        {
+            textWrite(write, ", pc 0x");
+            textWriteValue(write, fault->pc, 16);
+        }
+        textWrite(write, " (");
+        textWriteValue(write, fault->faults, 10);
+        textWrite(write, " since power-on)\r\n");
+    }
+    for (uint32_t core = 0; core < 2; core++)
+    {
+        StackStats stats;
+        if (stackGetStats(core, &stats) != 0)
+        {
+            continue;
+        }
+        textWrite(write, "stack core ");
+        textWriteValue(write, core, 10);
+        textWrite(write, ": used ");
+        textWriteValue(write, stats.used, 10);
+        textWrite(write, " of ");
+        textWriteValue(write, stats.usable, 10);
+        textWrite(write, (stats.used > stats.usable) ? " bytes, over the limit\r\n" : " bytes\r\n");
+    }
+}
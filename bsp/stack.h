@@ -0,0 +1,79 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Stack watermarks and overflow guards
+   Each core has its own stack bank (linker_script.ld): core 0 SCRATCH_X,
+   core 1 SCRATCH_Y, 4 KB each, growing down from the top.
+   - painting: the free part of a stack is filled with STACK_PAINT before
+     its core uses it (Reset_Handler for core 0, multicoreLaunchCore1() for
+     core 1). The deepest word that lost the pattern is the high-water mark,
+     see stackGetStats().
+   - limit: the lowest STACK_RESERVE bytes of a bank are kept for the fault
+     handler. On Arm, MSPLIM of the core is set at the top of the reserve: a
+     push or a sub sp that goes below it is not done, and raises a UsageFault
+     (STKOF) instead of writing the bank below (the heap below core 0, the
+     stack of core 0 below core 1). The lowest STACK_GUARD bytes are also a
+     read-only MPU region, for the handler running in the reserve.
+   - fault: the handler of crt0.c is replaced: on a stack overflow it
+     records the core, the pc and the bytes missing in .noinit (like boot.h)
+     and resets the chip, stackPrint() reports it at the next boot. Any other
+     fault stops the core as Default_Handler does.
+   Hazard3 has no stack limit: on RISC-V (and on a host build, where the
+   code runs on the stacks of the PC) only the watermarks are available, a
+   stack over the limit shows in stackPrint().
+   The stack usage per function (make STACKUSAGE=1) and the watermarks are
+   put together by tools/stackreport.py.
+   See section 3.7 "Cortex-M33 processor" on RP2350 datasheet, and the stack
+   limit checks and the MPU in the Armv8-M Architecture Reference Manual.
+*/
+#ifndef STACK_H
+#define STACK_H
+
+#include <stdint.h>
+#include "text.h"
+
+#define STACK_PAINT   (0x5354434b)      // "STCK", free stack words
+#define STACK_RESERVE (256)             // bytes under the limit, for the fault handler
+#define STACK_GUARD   (32)              // read-only MPU region at the bottom of a bank
+
+typedef struct {
+    uint32_t size;              // bytes of the bank
+    uint32_t usable;            // above the limit: size - STACK_RESERVE
+    uint32_t used;              // high-water mark since painting
+} StackStats;
+
+typedef struct {
+    uint32_t magic;             // STACK_MAGIC once a fault was recorded
+    uint32_t faults;            // stack overflows since the power-on
+    uint32_t core;              // of the last one
+    uint32_t pc;                // instruction that overflowed, 0 if not known
+    uint32_t sp;                // stack pointer before it
+    uint32_t overflow;          // bytes missing under the limit, 0 if not known
+    uint32_t cfsr;              // fault status of the core
+} StackFault;
+
+/* Paints the stack of core with STACK_PAINT: the whole bank when that core
+   does not run it, the part below the caller otherwise. Called before the
+   core starts (core 1) or first thing (core 0, Reset_Handler) */
+void stackPaint(uint32_t core);
+
+/* Sets the stack limit and the guard of the calling core, and enables the
+   MemManage and UsageFault exceptions. Nothing on RISC-V */
+void stackInit(void);
+
+/* High-water mark of a core (0 or 1). Returns 0, or -1 if its stack was
+   not painted */
+int stackGetStats(uint32_t core, StackStats *stats);
+
+/* The last stack overflow, kept across a reset: 0 if none since the
+   power-on */
+const StackFault *stackGetFault(void);
+
+/* Writes the last stack overflow, if any, and a line per painted stack:
+   "stack overflow: core <core>, <overflow> bytes, pc 0x<pc> (<faults> since power-on)"
+   "stack core <core>: used <used> of <usable> bytes" */
+void stackPrint(TextWriter write);
+
+#endif /* STACK_H */
@@ -0,0 +1,179 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "sync.h"
+
+/* SIO spinlocks: reading claims the lock (0 if it is already taken), writing
+   releases it. See section 3.1.4 "Hardware spinlocks" on RP2350 datasheet */
+#define SIO_SPINLOCK(n) (SIO_BASE + 0x100 + 4 * (n))
+
+static uint32_t syncCore(void)
+{
+    return GET32(SIO_BASE + 0x000);                                        // CPUID
+}
+
+/* Called by the owner of the lock, right after the acquisition */
+static void TIME_CRITICAL(syncAcquired)(SyncStats *stats, uint32_t *acquired, uint32_t start, uint32_t waited)
+{
+    *acquired = cpuCycles();
+    stats->acquires++;
+    if (waited)
+    {
+        uint32_t cycles = *acquired - start;
+        stats->contended++;
+        stats->waitCycles += cycles;
+        stats->maxWaitCycles = (cycles > stats->maxWaitCycles) ? cycles : stats->maxWaitCycles;
+    }
+}
+
+/* Called by the owner of the lock, right before the release */
+static void TIME_CRITICAL(syncReleasing)(SyncStats *stats, uint32_t acquired)
+{
+    uint32_t cycles = cpuCycles() - acquired;
+    stats->maxHoldCycles = (cycles > stats->maxHoldCycles) ? cycles : stats->maxHoldCycles;
+}
+
+void syncStatsClear(SyncStats *stats)
+{
+    stats->acquires = 0;
+    stats->contended = 0;
+    stats->waitCycles = 0;
+    stats->maxWaitCycles = 0;
+    stats->maxHoldCycles = 0;
+}
+
+void spinlockInit(Spinlock *lock, uint32_t number, SyncStats *stats)
+{
+    lock->number = number;
+    lock->stats = stats;
+    if (stats)
+    {
+        syncStatsClear(stats);
+    }
+    PUT32(SIO_SPINLOCK(number), 0);
+}
+
+int TIME_CRITICAL(spinlockTryAcquire)(Spinlock *lock)
+{
+    uint32_t start = cpuCycles();
+    if (GET32(SIO_SPINLOCK(lock->number)) == 0)
+    {
+        return 0;
+    }
+    cpuDmb();                                                              // Acquire: the shared data after the lock
+    if (lock->stats)
+    {
+        syncAcquired(lock->stats, &lock->acquired, start, 0);
+    }
+    return 1;
+}
+
+void TIME_CRITICAL(spinlockAcquire)(Spinlock *lock)
+{
+    uint32_t start = cpuCycles();
+    uint32_t waited = 0;
+    while (GET32(SIO_SPINLOCK(lock->number)) == 0)
+    {
+        waited = 1;
+    }
+    cpuDmb();                                                              // Acquire: the shared data after the lock
+    if (lock->stats)
+    {
+        syncAcquired(lock->stats, &lock->acquired, start, waited);
+    }
+}
+
+void TIME_CRITICAL(spinlockRelease)(Spinlock *lock)
+{
+    if (lock->stats)
+    {
+        syncReleasing(lock->stats, lock->acquired);
+    }
+    cpuDmb();                                                              // Release: the shared data before the unlock
+    PUT32(SIO_SPINLOCK(lock->number), 0);
+}
+
+uint32_t TIME_CRITICAL(syncCriticalEnter)(Spinlock *lock)
+{
+    uint32_t primask = cpuIrqSave();
+    spinlockAcquire(lock);
+    return primask;
+}
+
+void TIME_CRITICAL(syncCriticalExit)(Spinlock *lock, uint32_t primask)
+{
+    spinlockRelease(lock);
+    cpuIrqRestore(primask);
+}
+
+void mutexInit(Mutex *mutex, Spinlock *guard, SyncStats *stats)
+{
+    mutex->guard = guard;
+    mutex->owner = 0;
+    mutex->stats = stats;
+    if (stats)
+    {
+        syncStatsClear(stats);
+    }
+}
+
+/* Takes the mutex if it is free, without statistics */
+static int mutexClaim(Mutex *mutex)
+{
+    int claimed = 0;
+    uint32_t primask = syncCriticalEnter(mutex->guard);
+    if (mutex->owner == 0)
+    {
+        mutex->owner = 1 + syncCore();
+        claimed = 1;
+    }
+    syncCriticalExit(mutex->guard, primask);
+    return claimed;
+}
+
+int mutexTryLock(Mutex *mutex)
+{
+    uint32_t start = cpuCycles();
+    if (!mutexClaim(mutex))
+    {
+        return 0;
+    }
+    if (mutex->stats)
+    {
+        syncAcquired(mutex->stats, &mutex->acquired, start, 0);
+    }
+    return 1;
+}
+
+void mutexLock(Mutex *mutex)
+{
+    uint32_t start = cpuCycles();
+    uint32_t waited = 0;
+    while (!mutexClaim(mutex))
+    {
+        // An unlock between the claim and the wfe leaves the event set: no lost wake up
+        waited = 1;
+        cpuWfe();
+    }
+    if (mutex->stats)
+    {
+        syncAcquired(mutex->stats, &mutex->acquired, start, waited);
+    }
+}
+
+void mutexUnlock(Mutex *mutex)
+{
+    if (mutex->stats)
+    {
+        syncReleasing(mutex->stats, mutex->acquired);
+    }
+    uint32_t primask = syncCriticalEnter(mutex->guard);
+    mutex->owner = 0;
+    syncCriticalExit(mutex->guard, primask);
+    cpuSev();                                                              // Wakes up the core waiting in mutexLock()
+}
@@ -0,0 +1,186 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Synchronization between the cores
+   - Spinlock: one of the 32 SIO hardware spinlocks (a read claims it, a write
+     releases it). For short sections: the waiting core spins on the SIO.
+   - critical section: a spinlock taken with the interrupts of the core
+     masked, for state shared with interrupt handlers of either core
+   - Mutex: a lock for longer sections, owned by a core. The waiting core
+     sleeps in wfe and the unlock sends an event (sev). Its state is
+     protected by a spinlock (guard), which several mutexes can share
+   - atomics: lock-free add, exchange and compare-and-swap on a word in SRAM
+     (LDREX/STREX on Arm, the A extension on RISC-V), through the global
+     exclusive monitor of the RP2350 (section 2.1.6 on RP2350 datasheet)
+   A lock can record statistics: acquisitions, how many of them had to wait,
+   the cycles spent waiting and the longest hold time, in cycles of the
+   cycle counter (cpuCycles(), started by each core with
+   cpuCycleCounterStart() or profInit()). They are written by the owner of
+   the lock only, so they need no lock of their own.
+   SIO spinlock numbers in use by the bsp: 8 and 9 (SCHED_SPINLOCK), 10
+   (POOL_SPINLOCK), 11 and 12 (UART_SPINLOCK). The application takes its own
+   from SYNC_SPINLOCK_FIRST up.
+   See section 3.1.4 "Hardware spinlocks" on RP2350 datasheet.
+*/
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <stdint.h>
+#include "cpu.h"
+
+#define SYNC_SPINLOCK_FIRST (16)        // 16..31 are free for the application
+
+typedef struct {
+    uint32_t acquires;          // successful acquisitions
+    uint32_t contended;         // acquisitions that found the lock taken
+    uint32_t waitCycles;        // cycles spent waiting for the lock
+    uint32_t maxWaitCycles;
+    uint32_t maxHoldCycles;     // longest time between acquisition and release
+} SyncStats;
+
+typedef struct {
+    uint32_t number;            // SIO spinlock 0..31
+    SyncStats *stats;           // NULL: no statistics
+    uint32_t acquired;          // cycle counter at the acquisition (statistics)
+} Spinlock;
+
+typedef struct {
+    Spinlock *guard;            // protects owner
+    volatile uint32_t owner;    // 0 when free, 1 + core of the owner
+    SyncStats *stats;           // NULL: no statistics
+    uint32_t acquired;
+} Mutex;
+
+/* Releases the SIO spinlock (whatever its state after reset) and clears the
+   statistics if any. Called before the other core may use the lock */
+void spinlockInit(Spinlock *lock, uint32_t number, SyncStats *stats);
+
+/* Returns 1 with the lock taken, 0 if the other core (or the own core, an
+   interrupt handler must not wait for its thread) has it */
+int spinlockTryAcquire(Spinlock *lock);
+void spinlockAcquire(Spinlock *lock);
+void spinlockRelease(Spinlock *lock);
+
+/* Masks the interrupts of the core and takes the lock. Returns the PRIMASK
+   (mstatus) for syncCriticalExit() */
+uint32_t syncCriticalEnter(Spinlock *lock);
+void syncCriticalExit(Spinlock *lock, uint32_t primask);
+
+/* The guard may be shared by several mutexes, its statistics show how busy
+   it is. Called before the other core may use the mutex */
+void mutexInit(Mutex *mutex, Spinlock *guard, SyncStats *stats);
+
+/* Returns 1 if the calling core now owns the mutex */
+int mutexTryLock(Mutex *mutex);
+
+/* Sleeps (wfe) until the mutex is free. Thread mode only, the mutex must
+   not be owned by the calling core already (no recursion) */
+void mutexLock(Mutex *mutex);
+void mutexUnlock(Mutex *mutex);
+
+void syncStatsClear(SyncStats *stats);
+
+/* Atomics on a word in SRAM (not in flash or in a peripheral), safe between
+   the cores and the interrupt handlers, with the ordering of cpuDmb() on
+   both sides. The host build uses the atomics of the compiler */
+#ifdef HOST_SIM
+static inline uint32_t syncAtomicAdd(volatile uint32_t *value, uint32_t delta)
+{
+    return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t syncAtomicExchange(volatile uint32_t *value, uint32_t desired)
+{
+    return __atomic_exchange_n(value, desired, __ATOMIC_SEQ_CST);
+}
+
+static inline int syncAtomicCompareExchange(volatile uint32_t *value, uint32_t expected, uint32_t desired)
+{
+    return __atomic_compare_exchange_n(value, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+#elif defined(__riscv)
+/* Returns the new value */
+static inline uint32_t syncAtomicAdd(volatile uint32_t *value, uint32_t delta)
+{
+    uint32_t old;
+    __asm volatile ("amoadd.w.aqrl %0, %2, (%1)" : "=r" (old) : "r" (value), "r" (delta) : "memory");
+    return old + delta;
+}
+
+/* Stores desired, returns the previous value */
+static inline uint32_t syncAtomicExchange(volatile uint32_t *value, uint32_t desired)
+{
+    uint32_t old;
+    __asm volatile ("amoswap.w.aqrl %0, %2, (%1)" : "=r" (old) : "r" (value), "r" (desired) : "memory");
+    return old;
+}
+
+/* Stores desired if the value is expected, returns 1 if it did */
+static inline int syncAtomicCompareExchange(volatile uint32_t *value, uint32_t expected, uint32_t desired)
+{
+    uint32_t old;
+    uint32_t failed;
+    __asm volatile ("1: lr.w.aqrl %0, (%2)\n"
+                    "bne %0, %3, 2f\n"
+                    "sc.w.rl %1, %4, (%2)\n"
+                    "bnez %1, 1b\n"
+                    "2:"
+                    : "=&r" (old), "=&r" (failed) : "r" (value), "r" (expected), "r" (desired) : "memory");
+    return old == expected;
+}
+#else
+/* Returns the new value */
+static inline uint32_t syncAtomicAdd(volatile uint32_t *value, uint32_t delta)
+{
+    uint32_t result;
+    uint32_t failed;
+    cpuDmb();
+    __asm volatile ("1: ldrex %0, [%2]\n"
+                    "add %0, %0, %3\n"
+                    "strex %1, %0, [%2]\n"
+                    "cmp %1, #0\n"
+                    "bne 1b"
+                    : "=&r" (result), "=&r" (failed) : "r" (value), "r" (delta) : "cc", "memory");
+    cpuDmb();
+    return result;
+}
+
+/* Stores desired, returns the previous value */
+static inline uint32_t syncAtomicExchange(volatile uint32_t *value, uint32_t desired)
+{
+    uint32_t old;
+    uint32_t failed;
+    cpuDmb();
+    __asm volatile ("1: ldrex %0, [%2]\n"
+                    "strex %1, %3, [%2]\n"
+                    "cmp %1, #0\n"
+                    "bne 1b"
+                    : "=&r" (old), "=&r" (failed) : "r" (value), "r" (desired) : "cc", "memory");
+    cpuDmb();
+    return old;
+}
+
+/* Stores desired if the value is expected, returns 1 if it did */
+static inline int syncAtomicCompareExchange(volatile uint32_t *value, uint32_t expected, uint32_t desired)
+{
+    uint32_t old;
+    uint32_t failed;
+    cpuDmb();
+    __asm volatile ("1: ldrex %0, [%2]\n"
+                    "cmp %0, %3\n"
+                    "bne 2f\n"
+                    "strex %1, %4, [%2]\n"
+                    "cmp %1, #0\n"
+                    "bne 1b\n"
+                    "b 3f\n"
+                    "2: clrex\n"                                           // Drop the reservation of the failed compare
+                    "3:"
+                    : "=&r" (old), "=&r" (failed) : "r" (value), "r" (expected), "r" (desired) : "cc", "memory");
+    cpuDmb();
+    return old == expected;
+}
+#endif
+
+#endif /* SYNC_H */
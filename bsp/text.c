@@ -0,0 +1,60 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "text.h"
+
+uint32_t textLength(const char *text)
+{
+    uint32_t len = 0;
+    while (text[len] != '\0')
+    {
+        len++;
+    }
+    return len;
+}
+
+uint32_t textCopy(char *out, const char *text)
+{
+    uint32_t len = 0;
+    while (text[len] != '\0')
+    {
+        out[len] = text[len];
+        len++;
+    }
+    return len;
+}
+
+uint32_t textFormatValue(char *out, uint32_t value, uint32_t base, uint32_t width)
+{
+    char digits[TEXT_VALUE_MAX];
+    uint32_t pos = sizeof(digits);
+    do
+    {
+        digits[--pos] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value > 0);
+    while ((pos > 0) && ((sizeof(digits) - pos) < width))
+    {
+        digits[--pos] = ' ';
+    }
+    uint32_t len = sizeof(digits) - pos;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        out[i] = digits[pos + i];
+    }
+    return len;
+}
+
+void textWrite(TextWriter write, const char *text)
+{
+    write((const uint8_t *)text, textLength(text));
+}
+
+void textWriteValue(TextWriter write, uint32_t value, uint32_t base)
+{
+    char digits[TEXT_VALUE_MAX];
+    uint32_t len = textFormatValue(digits, value, base, 0);
+    write((const uint8_t *)digits, len);
+}
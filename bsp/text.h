@@ -0,0 +1,41 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Text output without the C library
+   The reports of the bsp (bootPrint(), stackPrint()) are written through a
+   TextWriter, the function of the application that sends the bytes (e.g.
+   to a UART), with these helpers: the code is built with -nostdlib, there
+   is no printf.
+   A value is formatted in any base from 2 to 16, lower case digits,
+   without prefix.
+*/
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <stdint.h>
+
+#define TEXT_VALUE_MAX (32)             // characters of a value: 32 bits in base 2
+
+typedef void (*TextWriter)(const uint8_t *data, uint32_t len);
+
+/* Characters of a null-terminated text */
+uint32_t textLength(const char *text);
+
+/* Copies a null-terminated text into out, without the terminator. Returns
+   the number of characters */
+uint32_t textCopy(char *out, const char *text);
+
+/* Formats value in base, right aligned on width characters (padded with
+   spaces, at most TEXT_VALUE_MAX) into out, not null-terminated. Returns
+   the number of characters */
+uint32_t textFormatValue(char *out, uint32_t value, uint32_t base, uint32_t width);
+
+/* Writes a null-terminated text */
+void textWrite(TextWriter write, const char *text);
+
+/* Writes value in base, without padding */
+void textWriteValue(TextWriter write, uint32_t value, uint32_t base);
+
+#endif /* TEXT_H */
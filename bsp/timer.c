@@ -0,0 +1,342 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "nvic.h"
+#include "clocks.h"
+#include "timer.h"
+
+/* TIMER0 registers
+   See section 12.8.5 "List of registers" on RP2350 datasheet */
+#define TIMER_ALARM0    (TIMER0_BASE + 0x10)
+#define TIMER_ARMED     (TIMER0_BASE + 0x20)
+#define TIMER_TIMERAWH  (TIMER0_BASE + 0x24)
+#define TIMER_TIMERAWL  (TIMER0_BASE + 0x28)
+#define TIMER_INTR      (TIMER0_BASE + 0x3c)
+#define TIMER_INTE      (TIMER0_BASE + 0x40)
+
+/* TIMER0 tick generator (see section 8.5 "Tick generators" on RP2350 datasheet) */
+#define TICKS_TIMER0_CTRL   (TICKS_BASE + 0x18)
+#define TICKS_TIMER0_CYCLES (TICKS_BASE + 0x1c)
+
+/* RISC-V platform timer of SIO, the SysTick of a RISC-V build: MTIME is
+   shared, each core has its own MTIMECMP and machine timer interrupt
+   See section 3.1.8 "RISC-V platform timer" on RP2350 datasheet */
+#define SIO_MTIME_CTRL  (SIO_BASE + 0x1a4)
+#define SIO_MTIME       (SIO_BASE + 0x1b0)
+#define SIO_MTIMEH      (SIO_BASE + 0x1b4)
+#define SIO_MTIMECMP    (SIO_BASE + 0x1b8)
+#define SIO_MTIMECMPH   (SIO_BASE + 0x1bc)
+
+/* An alarm compares the lower 32 bits of the counter only: deadlines further
+   away are reached in steps */
+#define TIMER_MAX_ALARM_US  (1u << 30)
+
+static Timer *timerList[2];             // pending timers of each core, sorted by deadline
+static Timer sleepTimer[2];             // wakes up timerSleepUntil()
+static uint8_t timerIrqReady[2];
+static TimerCallback tickCallback[2];
+static void *tickContext[2];
+static volatile uint32_t tickCount[2];
+#ifdef __riscv
+static uint64_t tickDeadline[2];        // MTIMECMP of each core
+static uint32_t tickReload[2];
+#endif
+
+static uint32_t timerCore(void)
+{
+    return GET32(SIO_BASE + 0x000);                                        // CPUID
+}
+
+/* Called with the interrupts disabled */
+static void TIME_CRITICAL(timerInsert)(uint32_t core, Timer *timer)
+{
+    Timer **link = &timerList[core];
+    while (*link && ((*link)->deadline <= timer->deadline))
+    {
+        link = &(*link)->next;
+    }
+    timer->next = *link;
+    *link = timer;
+}
+
+/* Called with the interrupts disabled. Returns 1 if the timer was pending */
+static int timerRemove(uint32_t core, Timer *timer)
+{
+    for (Timer **link = &timerList[core]; *link; link = &(*link)->next)
+    {
+        if (*link == timer)
+        {
+            *link = timer->next;
+            timer->next = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Programs the alarm of the core for its first timer. A deadline that is
+   already reached (or passes while the alarm is written) pends the interrupt
+   directly, as the alarm would only match after the counter wraps.
+   Called from the interrupt or with the interrupts disabled.
+*/
+static void TIME_CRITICAL(timerArm)(uint32_t core)
+{
+    Timer *first = timerList[core];
+    if (first == 0)
+    {
+        PUT32(TIMER_ARMED, (1u << core));                                  // Disarm
+        return;
+    }
+    uint64_t target = first->deadline;
+    uint64_t now = timerGetUs();
+    if ((target > now) && ((target - now) > TIMER_MAX_ALARM_US))
+    {
+        target = now + TIMER_MAX_ALARM_US;
+    }
+    PUT32((TIMER_ALARM0 + 4 * core), (uint32_t)target);                    // Writing the alarm arms it
+    if (timerGetUs() >= target)
+    {
+        nvicSetPending(TIMER0_IRQ_0 + core);
+    }
+}
+
+/* Starts the interrupt of the core's alarm on the calling core's NVIC */
+static void timerIrqInit(uint32_t core)
+{
+    if (!timerIrqReady[core])
+    {
+        timerIrqReady[core] = 1;
+        PUT32((TIMER_INTE + WRITE_SET), (1u << core));
+        nvicClearPending(TIMER0_IRQ_0 + core);
+        nvicEnableIrq(TIMER0_IRQ_0 + core);
+    }
+}
+
+void timerInit(void)
+{
+    timerList[0] = timerList[1] = 0;
+    timerIrqReady[0] = timerIrqReady[1] = 0;
+
+    // 1 us tick: clk_ref cycles per tick
+    PUT32(TICKS_TIMER0_CTRL, 0);                                           // Stop the tick generator
+    PUT32(TICKS_TIMER0_CYCLES, (clocksGetRefHz() / 1000000));              // 12 cycles of the 12MHz XOSC
+    PUT32(TICKS_TIMER0_CTRL, 1);                                           // Enable the tick generator
+
+    // De-asserts the reset of TIMER0, the counter starts from 0
+    PUT32((RESETS_BASE + WRITE_SET + 0x0), RESETS_TIMER0);                 // Set TIMER0 to reset
+    PUT32((RESETS_BASE + WRITE_CLR + 0x0), RESETS_TIMER0);                 // De-assert the reset from TIMER0
+    while (!(GET32(RESETS_BASE + 0x08) & RESETS_TIMER0));                  // Wait for TIMER0 to be ready
+}
+
+/* The latched TIMELR/TIMEHR pair is shared by the cores, so the raw registers
+   are read instead: high, low, high again until the high word is stable */
+uint64_t TIME_CRITICAL(timerGetUs)(void)
+{
+    uint32_t high = GET32(TIMER_TIMERAWH);
+    uint32_t low;
+    uint32_t check;
+    for (;;)
+    {
+        low = GET32(TIMER_TIMERAWL);
+        check = GET32(TIMER_TIMERAWH);
+        if (check == high)
+        {
+            break;
+        }
+        high = check;
+    }
+    return ((uint64_t)high << 32) | low;
+}
+
+uint32_t TIME_CRITICAL(timerGetUs32)(void)
+{
+    return GET32(TIMER_TIMERAWL);
+}
+
+void timerStart(Timer *timer, uint64_t deadline, uint32_t period, TimerCallback callback, void *context)
+{
+    uint32_t core = timerCore();
+    timerIrqInit(core);
+
+    uint32_t primask = cpuIrqSave();
+    timerRemove(core, timer);
+    timer->deadline = deadline;
+    timer->period = period;
+    timer->callback = callback;
+    timer->context = context;
+    timerInsert(core, timer);
+    if (timerList[core] == timer)
+    {
+        timerArm(core);                                                    // New first deadline
+    }
+    cpuIrqRestore(primask);
+}
+
+void timerStop(Timer *timer)
+{
+    uint32_t core = timerCore();
+    uint32_t primask = cpuIrqSave();
+    int first = (timerList[core] == timer);
+    if (timerRemove(core, timer) && first)
+    {
+        timerArm(core);
+    }
+    cpuIrqRestore(primask);
+}
+
+void timerSleepUntil(uint64_t deadline)
+{
+    uint32_t core = timerCore();
+    if (timerGetUs() >= deadline)
+    {
+        return;
+    }
+    timerStart(&sleepTimer[core], deadline, 0, 0, 0);
+    while (timerGetUs() < deadline)
+    {
+        cpuWfi();                                                          // Woken up by the alarm or any other interrupt
+    }
+}
+
+void timerSleepUs(uint32_t us)
+{
+    timerSleepUntil(timerGetUs() + us);
+}
+
+void timerSleepMs(uint32_t ms)
+{
+    timerSleepUntil(timerGetUs() + (uint64_t)ms * 1000);
+}
+
+/* Runs the expired timers of the core and programs the alarm for the next one */
+static void TIME_CRITICAL(timerIrq)(uint32_t core)
+{
+    PUT32(TIMER_INTR, (1u << core));                                       // Clear the alarm interrupt
+    for (;;)
+    {
+        uint32_t primask = cpuIrqSave();
+        Timer *timer = timerList[core];
+        if ((timer == 0) || (timer->deadline > timerGetUs()))
+        {
+            timerArm(core);
+            cpuIrqRestore(primask);
+            break;
+        }
+        timerList[core] = timer->next;
+        timer->next = 0;
+        if (timer->period)
+        {
+            timer->deadline += timer->period;
+            timerInsert(core, timer);
+        }
+        cpuIrqRestore(primask);
+        if (timer->callback)
+        {
+            timer->callback(timer->context);
+        }
+    }
+}
+
+void TIME_CRITICAL(TIMER0_IRQ_0_Handler)(void)
+{
+    timerIrq(0);
+}
+
+void TIME_CRITICAL(TIMER0_IRQ_1_Handler)(void)
+{
+    timerIrq(1);
+}
+
+#ifdef __riscv
+/* Called with the machine timer interrupt disabled */
+static void TIME_CRITICAL(timerTickSetCompare)(uint64_t deadline)
+{
+    PUT32(SIO_MTIMECMPH, 0xffffffff);                                      // No early match while the halves change
+    PUT32(SIO_MTIMECMP, (uint32_t)deadline);
+    PUT32(SIO_MTIMECMPH, (uint32_t)(deadline >> 32));
+}
+
+static uint64_t timerTickNow(void)
+{
+    uint32_t high;
+    uint32_t low;
+    do
+    {
+        high = GET32(SIO_MTIMEH);
+        low = GET32(SIO_MTIME);
+    } while (GET32(SIO_MTIMEH) != high);
+    return ((uint64_t)high << 32) | low;
+}
+
+int timerTickStart(uint32_t hz, TimerCallback callback, void *context)
+{
+    uint32_t core = timerCore();
+    uint32_t reload = hz ? (clocksGetSysHz() / hz) : 0;
+    if (reload == 0)
+    {
+        return -1;
+    }
+    cpuCsrClear(mie, CPU_MIE_MTIE);
+    tickCallback[core] = callback;
+    tickContext[core] = context;
+    tickCount[core] = 0;
+    tickReload[core] = reload;
+    PUT32(SIO_MTIME_CTRL, (GET32(SIO_MTIME_CTRL) | (1 << 1) | (1 << 0)));  // FULLSPEED (clk_sys), EN
+    tickDeadline[core] = timerTickNow() + reload;
+    timerTickSetCompare(tickDeadline[core]);
+    cpuCsrSet(mie, CPU_MIE_MTIE);
+    return 0;
+}
+
+void timerTickStop(void)
+{
+    cpuCsrClear(mie, CPU_MIE_MTIE);
+}
+#else
+int timerTickStart(uint32_t hz, TimerCallback callback, void *context)
+{
+    uint32_t core = timerCore();
+    uint32_t reload = (hz ? (clocksGetSysHz() / hz) : 0) - 1;
+    if ((hz == 0) || (reload == 0) || (reload > 0xffffff))
+    {
+        return -1;
+    }
+    PUT32(SYST_CSR, 0);                                                    // Stop SysTick
+    tickCallback[core] = callback;
+    tickContext[core] = context;
+    tickCount[core] = 0;
+    PUT32(SYST_RVR, reload);
+    PUT32(SYST_CVR, 0);                                                    // Clear the counter, it reloads on the next cycle
+    PUT32(SYST_CSR, ((1 << 2) | (1 << 1) | (1 << 0)));                     // Processor clock, interrupt, enable
+    return 0;
+}
+
+void timerTickStop(void)
+{
+    PUT32(SYST_CSR, 0);
+}
+#endif
+
+uint32_t timerGetTicks(void)
+{
+    return tickCount[timerCore()];
+}
+
+void TIME_CRITICAL(SysTick_Handler)(void)
+{
+    uint32_t core = timerCore();
+#ifdef __riscv
+    tickDeadline[core] += tickReload[core];                                // No drift: from the previous deadline
+    timerTickSetCompare(tickDeadline[core]);
+#endif
+    tickCount[core]++;
+    if (tickCallback[core])
+    {
+        tickCallback[core](tickContext[core]);
+    }
+}
@@ -0,0 +1,73 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Time base on TIMER0 and SysTick
+   TIMER0 counts microseconds in a 64-bit counter (1 MHz tick from clk_ref)
+   that never wraps, so a point in time is a plain uint64_t and deadlines can
+   be compared directly. Each core owns one alarm of TIMER0:
+   - core 0: ALARM0, TIMER0_IRQ_0 (IRQ 0) -> TIMER0_IRQ_0_Handler
+   - core 1: ALARM1, TIMER0_IRQ_1 (IRQ 1) -> TIMER0_IRQ_1_Handler
+   The software timers of a core are kept in a list sorted by deadline and the
+   alarm is programmed for the first one, so there is no periodic interrupt:
+   a core waiting for a deadline sleeps (wfi) until the alarm wakes it up.
+   SysTick gives each core an optional periodic tick on the processor clock.
+   On a RISC-V build the tick comes from the platform timer of SIO (MTIME
+   counting clk_sys, MTIMECMP of the core), still through SysTick_Handler.
+   See section 12.8 "System timers" on RP2350 datasheet.
+*/
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+typedef void (*TimerCallback)(void *context);
+
+/* A software timer. It belongs to the core that started it, and must be
+   stopped from that core. The callback runs in the alarm interrupt. */
+typedef struct Timer {
+    uint64_t      deadline;     // expiry time in us (timerGetUs)
+    uint32_t      period;       // reload in us, 0 for a one shot timer
+    TimerCallback callback;
+    void          *context;
+    struct Timer  *next;
+} Timer;
+
+/* Takes TIMER0 out of reset and starts its 1 MHz tick. Called once by core 0
+   after clocksInit(), before any other function of this module. */
+void timerInit(void);
+
+/* Microseconds since timerInit(), safe to call from both cores */
+uint64_t timerGetUs(void);
+
+/* Low 32 bits of timerGetUs(): a single register read, wraps every 71
+   minutes. For time stamps and short intervals (unsigned differences) */
+uint32_t timerGetUs32(void);
+
+/* Sleeps (wfi) until timerGetUs() >= deadline. Thread mode only: the core
+   keeps taking its interrupts while it waits. */
+void timerSleepUntil(uint64_t deadline);
+void timerSleepUs(uint32_t us);
+void timerSleepMs(uint32_t ms);
+
+/* Starts a timer expiring at deadline (absolute, in us), then every period us
+   if period is not 0. Periodic timers do not drift: the next deadline is the
+   previous one plus the period. A running timer is restarted. */
+void timerStart(Timer *timer, uint64_t deadline, uint32_t period, TimerCallback callback, void *context);
+void timerStop(Timer *timer);
+
+/* Starts the SysTick of the calling core at hz interrupts per second on the
+   processor clock, calling callback (if not NULL) from SysTick_Handler.
+   Returns -1 if the reload value does not fit in 24 bits (Arm). */
+int timerTickStart(uint32_t hz, TimerCallback callback, void *context);
+void timerTickStop(void);
+
+/* SysTick interrupts taken by the calling core since timerTickStart() */
+uint32_t timerGetTicks(void);
+
+void TIMER0_IRQ_0_Handler(void);
+void TIMER0_IRQ_1_Handler(void);
+void SysTick_Handler(void);
+
+#endif /* TIMER_H */
@@ -0,0 +1,170 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "timer.h"
+#include "uart.h"
+#include "frame.h"
+#include "tlog.h"
+
+#define TLOG_MASK       (TLOG_RING_WORDS - 1)
+#define TLOG_ALIGN      (32)            // head and tail in separate blocks, see channel.h
+
+/* A message in the ring: header (ID << 3 | argument count), time stamp in
+   us, arguments. On the wire the same words follow each other as variable
+   length integers (7 bits per byte, bit 7 set on all bytes but the last),
+   with the time stamp replaced by the difference to the previous message of
+   the frame (the first one of a frame is absolute). */
+typedef struct {
+    // Written by the core that logs
+    volatile uint32_t head __attribute__((aligned(TLOG_ALIGN)));   // words written, runs freely
+    uint32_t messages;
+    volatile uint32_t dropped;
+    // Written by tlogDrain
+    volatile uint32_t tail __attribute__((aligned(TLOG_ALIGN)));   // words read, runs freely
+    uint32_t lost;                                                 // dropped messages already reported
+    uint32_t words[TLOG_RING_WORDS] __attribute__((aligned(TLOG_ALIGN)));
+} TlogRing;
+
+static TlogRing tlogRing[2];
+static FrameTx tlogTx;
+static uint32_t tlogSent;
+static uint32_t tlogFrames;
+static uint32_t tlogBytes;
+static uint32_t tlogStarted;
+
+static const char tlogLostFmt[] TLOG_SECTION = "tlog: %u messages lost (ring full)";
+
+void TIME_CRITICAL(tlogWrite)(uint32_t id, const uint32_t *args, uint32_t count)
+{
+    TlogRing *ring = &tlogRing[GET32(SIO_BASE) & 1];                       // SIO CPUID
+    uint32_t primask = cpuIrqSave();
+    uint32_t head = ring->head;
+    if ((TLOG_RING_WORDS - (head - ring->tail)) < (2 + count))
+    {
+        ring->dropped++;
+    }
+    else
+    {
+        ring->words[head & TLOG_MASK] = (id << 3) | count;
+        ring->words[(head + 1) & TLOG_MASK] = timerGetUs32();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            ring->words[(head + 2 + i) & TLOG_MASK] = args[i];
+        }
+        ring->messages++;
+        cpuDmb();                                                          // Release: the words before head
+        ring->head = head + 2 + count;
+    }
+    cpuIrqRestore(primask);
+}
+
+static uint32_t tlogVarint(uint8_t *out, uint32_t value)
+{
+    uint32_t len = 0;
+    while (value >= 0x80)
+    {
+        out[len++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[len++] = (uint8_t)value;
+    return len;
+}
+
+/* Adds a message to the frame being built. Returns -1 when it does not fit */
+static int tlogAppend(uint32_t header, uint32_t delta, const uint32_t *words, uint32_t mask, uint32_t first)
+{
+    uint8_t bytes[5 * (2 + TLOG_MAX_ARGS)];
+    uint32_t len = tlogVarint(bytes, header);
+    len += tlogVarint(&bytes[len], delta);
+    for (uint32_t i = 0; i < (header & 7); i++)
+    {
+        len += tlogVarint(&bytes[len], words[(first + i) & mask]);
+    }
+    if ((tlogTx.payload + len) > TLOG_FRAME_PAYLOAD)
+    {
+        return -1;
+    }
+    return frameAppend(&tlogTx, bytes, len);
+}
+
+uint32_t tlogDrain(uint32_t uart)
+{
+    uint32_t sent = 0;
+    for (uint32_t core = 0; core < 2; core++)
+    {
+        TlogRing *ring = &tlogRing[core];
+        uint32_t dropped = ring->dropped;
+        uint32_t head = ring->head;
+        uint32_t tail = ring->tail;
+        cpuDmb();                                                          // Acquire: the words before head
+        while (((tail != head) || (dropped != ring->lost)) && (uartTxFree(uart) >= TLOG_FRAME_SIZE))
+        {
+            uint32_t time = 0;
+            if (!tlogStarted)
+            {
+                // A delimiter before the first frame ends whatever the UART sent before
+                static const uint8_t delimiter = 0;
+                uartWriteAll(uart, &delimiter, 1);
+                tlogStarted = 1;
+            }
+            frameBegin(&tlogTx, (uint8_t)(TLOG_FRAME + core));
+            while (tail != head)
+            {
+                uint32_t header = ring->words[tail & TLOG_MASK];
+                uint32_t stamp = ring->words[(tail + 1) & TLOG_MASK];
+                if (tlogAppend(header, stamp - time, ring->words, TLOG_MASK, tail + 2) != 0)
+                {
+                    break;                                                 // Frame full
+                }
+                time = stamp;
+                tail += 2 + (header & 7);
+                sent++;
+            }
+            if ((tail == head) && (dropped != ring->lost))
+            {
+                // The messages were dropped after the ones of the ring
+                uint32_t lost = dropped - ring->lost;
+                uint32_t now = timerGetUs32();
+                uint32_t id = (uint32_t)((uintptr_t)tlogLostFmt - (uintptr_t)__start_tlog_fmt);
+                if (tlogAppend((id << 3) | 1, now - time, &lost, 0, 0) == 0)
+                {
+                    ring->lost = dropped;
+                }
+            }
+            cpuDmb();                                                      // The words are read before they are released
+            ring->tail = tail;
+            uint32_t len = frameEnd(&tlogTx);
+            uartWriteAll(uart, tlogTx.buf, len);
+            tlogFrames++;
+            tlogBytes += len;
+        }
+    }
+    tlogSent += sent;
+    return sent;
+}
+
+int tlogPending(void)
+{
+    for (uint32_t core = 0; core < 2; core++)
+    {
+        if ((tlogRing[core].head != tlogRing[core].tail) || (tlogRing[core].dropped != tlogRing[core].lost))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void tlogGetStats(TlogStats *stats)
+{
+    stats->messages = tlogRing[0].messages + tlogRing[1].messages;
+    stats->dropped = tlogRing[0].dropped + tlogRing[1].dropped;
+    stats->sent = tlogSent;
+    stats->frames = tlogFrames;
+    stats->bytes = tlogBytes;
+}
@@ -0,0 +1,81 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Tokenized log: the text is formatted on the PC, not on the RP2350
+       TLOG("adc %u mV, temperature %d C", mv, temperature);
+   The format string is placed in the tlog_fmt section, which is kept in the
+   ELF file but not loaded (see linker_script.ld), and its offset in the
+   section is the ID of the message. A call only stores the ID, a time stamp
+   (TIMER0, us) and the raw 32-bit arguments in the ring of the calling
+   core: no formatting, no UART access. The interrupts of the core are
+   masked for the few stores, so handlers can log too. The cores never share
+   a ring, so there is no lock between them.
+   tlogDrain() empties the rings in the background (idle loop, low priority
+   task): it packs the records into frames (see frame.h, type TLOG_FRAME +
+   core) with the numbers as variable length integers, and sends them on a
+   UART as long as its TX buffer has room, so it never waits.
+   tools/tlogdecode.py reads the strings back from the ELF file and prints
+   the messages. The arguments are integers: %d %i %u %x %X %o %c and %p
+   (cast the pointer to uintptr_t), with the usual flags and width. There is
+   no %s and no %f. When a ring is full, the message is dropped and counted,
+   and the next drain sends a "messages lost" message.
+*/
+#ifndef TLOG_H
+#define TLOG_H
+
+#include <stdint.h>
+
+/* Ring size per core in 32-bit words, must be a power of two. A message
+   takes 2 words plus one per argument */
+#ifndef TLOG_RING_WORDS
+#define TLOG_RING_WORDS (256)
+#endif
+
+/* Payload of the frames sent by tlogDrain(), at most FRAME_MAX_PAYLOAD.
+   A frame is only started when the UART TX buffer has room for the whole of
+   it (TLOG_FRAME_SIZE), so it must be smaller than UART_TX_BUF_SIZE */
+#ifndef TLOG_FRAME_PAYLOAD
+#define TLOG_FRAME_PAYLOAD (128)
+#endif
+#define TLOG_FRAME_SIZE (TLOG_FRAME_PAYLOAD + 6 + TLOG_FRAME_PAYLOAD / 254)
+
+#define TLOG_MAX_ARGS   (7)
+#define TLOG_FRAME      (0x20)          // frame type of core 0, core 1 is TLOG_FRAME + 1
+
+/* Start of the format strings: address 0 on the target (section not loaded) */
+extern const char __start_tlog_fmt[];
+
+#define TLOG_SECTION __attribute__((section("tlog_fmt"), used))
+
+#define TLOG(fmt, ...) \
+    do { \
+        static const char tlogFmt[] TLOG_SECTION = fmt; \
+        const uint32_t tlogArgs[] = { 0, ##__VA_ARGS__ }; \
+        _Static_assert(sizeof(tlogArgs) / 4 - 1 <= TLOG_MAX_ARGS, "too many TLOG arguments"); \
+        tlogWrite((uint32_t)((uintptr_t)tlogFmt - (uintptr_t)__start_tlog_fmt), &tlogArgs[1], sizeof(tlogArgs) / 4 - 1); \
+    } while (0)
+
+typedef struct {
+    uint32_t messages;          // messages stored in the rings
+    uint32_t dropped;           // messages lost because a ring was full
+    uint32_t sent;              // messages sent by tlogDrain
+    uint32_t frames;            // frames sent by tlogDrain
+    uint32_t bytes;             // bytes of these frames
+} TlogStats;
+
+/* Stores a message in the ring of the calling core, called by TLOG() */
+void tlogWrite(uint32_t id, const uint32_t *args, uint32_t count);
+
+/* Sends the messages waiting in the rings of both cores on the UART, as
+   long as its TX buffer can take a whole frame. Called from one place only
+   (either core). Returns the number of messages sent */
+uint32_t tlogDrain(uint32_t uart);
+
+/* Returns 1 while messages (or a "messages lost" report) wait in the rings */
+int tlogPending(void);
+
+void tlogGetStats(TlogStats *stats);
+
+#endif /* TLOG_H */
@@ -0,0 +1,286 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "regs.h"
+#include "multicore.h"
+#include "crt0.h"
+#include "nvic.h"
+#include "clocks.h"
+#include "uart.h"
+#include "prof.h"
+
+_Static_assert((UART_TX_BUF_SIZE & (UART_TX_BUF_SIZE - 1)) == 0, "UART_TX_BUF_SIZE must be a power of two");
+_Static_assert((UART_RX_BUF_SIZE & (UART_RX_BUF_SIZE - 1)) == 0, "UART_RX_BUF_SIZE must be a power of two");
+
+#define UARTDR_FE   (1 << 8)    // framing error
+#define UARTDR_PE   (1 << 9)    // parity error
+#define UARTDR_BE   (1 << 10)   // break error
+#define UARTDR_OE   (1 << 11)   // overrun error
+
+#define UART_INT_RX (1 << 4)    // RX FIFO level
+#define UART_INT_TX (1 << 5)    // TX FIFO level
+#define UART_INT_RT (1 << 6)    // RX timeout
+#define UART_INT_ERR ((1 << 7) | (1 << 8) | (1 << 9) | (1 << 10))   // FE, PE, BE, OE
+
+#define UARTCR_RTSEN (1 << 14)  // RTS hardware flow control
+#define UARTCR_CTSEN (1 << 15)  // CTS hardware flow control
+
+#define SIO_SPINLOCK(n) (SIO_BASE + 0x100 + 4 * (n))
+
+/* Ring buffers. The indexes run freely and are masked on access:
+   head is written by the producer, tail by the consumer. */
+typedef struct {
+    uint8_t txBuf[UART_TX_BUF_SIZE];
+    uint8_t rxBuf[UART_RX_BUF_SIZE];
+    volatile uint32_t txHead;       // application
+    volatile uint32_t txTail;       // interrupt
+    volatile uint32_t rxHead;       // interrupt
+    volatile uint32_t rxTail;       // application
+    UartStats stats;
+    UartBaud baud;
+    uint32_t irqCore;               // core that takes the interrupt (uartInit)
+} UartState;
+
+static UartState uartState[UART_INSTANCES];
+
+static const uint32_t uartResets[UART_INSTANCES] = { RESETS_UART0, RESETS_UART1 };
+static const uint32_t uartIrqs[UART_INSTANCES] = { UART0_IRQ, UART1_IRQ };
+
+/* Moves bytes from the TX buffer into the TX FIFO. The TX interrupt is only
+   enabled while there is data left in the buffer.
+   Called from the interrupt or with the interrupts disabled, on either core:
+   the spinlock keeps the two from sending the same bytes.
+*/
+static void TIME_CRITICAL(uartTxFill)(uint32_t uart)
+{
+    UartState *state = &uartState[uart];
+    while (GET32(SIO_SPINLOCK(UART_SPINLOCK + uart)) == 0);
+    cpuDmb();                                                              // Acquire: read tail after the lock
+    uint32_t tail = state->txTail;
+    while ((tail != state->txHead) && !(GET32(UART_FR(uart)) & UART_FR_TXFF))
+    {
+        PUT32(UART_DR(uart), state->txBuf[tail & (UART_TX_BUF_SIZE - 1)]);
+        tail++;
+    }
+    state->txTail = tail;
+    if (tail == state->txHead)
+    {
+        PUT32((UART_IMSC(uart) + WRITE_CLR), UART_INT_TX);
+    }
+    else
+    {
+        PUT32((UART_IMSC(uart) + WRITE_SET), UART_INT_TX);
+    }
+    cpuDmb();                                                              // Release: write tail before the unlock
+    PUT32(SIO_SPINLOCK(UART_SPINLOCK + uart), 0);
+}
+
+int uartBaudCompute(uint32_t periHz, uint32_t baud, UartBaud *result)
+{
+    if (baud == 0)
+    {
+        return -1;
+    }
+    // Baud Rate Divisor = clk_peri / (16 * baud), in units of 1/64, rounded
+    uint64_t divisor = ((8 * (uint64_t)periHz) / baud + 1) / 2;
+    if ((divisor < 64) || (divisor > (0xffffu << 6)))                      // IBRD 1..65535 (FBRD 0 at 65535)
+    {
+        return -1;
+    }
+    uint32_t actual = (uint32_t)(((4 * (uint64_t)periHz) + (divisor / 2)) / divisor);
+    result->ibrd = (uint32_t)(divisor >> 6);
+    result->fbrd = (uint32_t)(divisor & 0x3f);
+    result->baud = actual;
+    result->errorPpm = (int32_t)((((int64_t)actual - baud) * 1000000) / baud);
+    return 0;
+}
+
+int uartInit(uint32_t uart, uint32_t baud, uint32_t flags)
+{
+    UartState *state = &uartState[uart];
+    if (uartBaudCompute(clocksGetPeriHz(), baud, &state->baud) != 0)
+    {
+        return -1;
+    }
+    uint32_t *stats = (uint32_t *)&state->stats;
+    for (uint32_t i = 0; i < sizeof(UartStats) / sizeof(uint32_t); i++)
+    {
+        stats[i] = 0;
+    }
+    state->txHead = state->txTail = state->rxHead = state->rxTail = 0;
+
+    // De-asserts the reset of the UART
+    REG_SET(RESETS_BASE, RESETS_RESET(uartResets[uart]));                  // Set the UART to reset
+    REG_CLR(RESETS_BASE, RESETS_RESET(uartResets[uart]));                  // De-assert the reset from the UART
+    while (!REG_TEST(RESETS_BASE, RESETS_RESET_DONE(uartResets[uart])));   // Wait for the UART to be ready
+
+    // TX, RX (and CTS, RTS) are 4 consecutive pins: GPIO0-3 for UART0, GPIO4-7 for UART1
+    uint32_t pin = 4 * uart;
+    uint32_t pins = (flags & UART_FLOW_RTS_CTS) ? 4 : 2;
+    for (uint32_t i = 0; i < pins; i++)
+    {
+        REG_WRITE(IO_BANK0_GPIO(pin + i), GPIO_CTRL_FUNCSEL, GPIO_FUNC_UART);
+        REG_CLR(PADS_BANK0_GPIO(pin + i), PADS_GPIO_ISO);                  // Remove the pad isolation
+    }
+    REG_SET(PADS_BANK0_GPIO(pin + 1), PADS_GPIO_IE);                       // Enable the RX pad for input
+    if (flags & UART_FLOW_RTS_CTS)
+    {
+        REG_SET(PADS_BANK0_GPIO(pin + 2), PADS_GPIO_IE);                   // Enable the CTS pad for input
+    }
+
+    PUT32(UART_IBRD(uart), state->baud.ibrd);                              // Integer part of the baudrate divisor
+    PUT32(UART_FBRD(uart), state->baud.fbrd);                              // Fractional part of the baudrate divisor
+    PUT32(UART_LCR_H(uart), ((0x3 << 5) | (1 << 4)));                      // Word lenght = 8, FIFO RX/TX enabled (latches IBRD/FBRD)
+    PUT32(UART_IFLS(uart), ((2 << 3) | (0 << 0)));                         // RX interrupt at 1/2 full, TX at 1/8 full
+    PUT32(UART_ICR(uart), 0x7ff);                                          // Clear all interrupts
+    PUT32(UART_IMSC(uart), (UART_INT_RX | UART_INT_RT | UART_INT_ERR));    // TX interrupt is enabled by uartWrite
+    PUT32(UART_CR(uart), (((flags & UART_FLOW_RTS_CTS) ? (UARTCR_CTSEN | UARTCR_RTSEN) : 0) |
+                          (1 << 9) | (1 << 8) | (1 << 0)));                // UART Enabled, Tx enabled, Rx enabled
+
+    PUT32(SIO_SPINLOCK(UART_SPINLOCK + uart), 0);                          // Release, whatever the state after reset
+    state->irqCore = multicoreCoreId();
+    nvicClearPending(uartIrqs[uart]);
+    nvicEnableIrq(uartIrqs[uart]);
+    return 0;
+}
+
+void uartGetBaud(uint32_t uart, UartBaud *baud)
+{
+    baud->ibrd = uartState[uart].baud.ibrd;
+    baud->fbrd = uartState[uart].baud.fbrd;
+    baud->baud = uartState[uart].baud.baud;
+    baud->errorPpm = uartState[uart].baud.errorPpm;
+}
+
+uint32_t uartWrite(uint32_t uart, const uint8_t *data, uint32_t len)
+{
+    UartState *state = &uartState[uart];
+    uint32_t head = state->txHead;
+    uint32_t count = 0;
+    while ((count < len) && ((head - state->txTail) < UART_TX_BUF_SIZE))
+    {
+        state->txBuf[head & (UART_TX_BUF_SIZE - 1)] = data[count++];
+        head++;
+    }
+
+    uint32_t primask = cpuIrqSave();
+    state->txHead = head;                                                  // Publish the new data
+    if ((head - state->txTail) > state->stats.txHighWater)
+    {
+        state->stats.txHighWater = head - state->txTail;
+    }
+    uartTxFill(uart);                                                      // Prime the FIFO, the interrupt does the rest
+    cpuIrqRestore(primask);
+    return count;
+}
+
+void uartWriteAll(uint32_t uart, const uint8_t *data, uint32_t len)
+{
+    while (len > 0)
+    {
+        uint32_t count = uartWrite(uart, data, len);
+        data += count;
+        len -= count;
+        if ((len > 0) && (multicoreCoreId() == uartState[uart].irqCore))
+        {
+            cpuWfi();                                                      // Sleep until the TX interrupt makes room
+        }
+    }
+}
+
+uint32_t uartRead(uint32_t uart, uint8_t *data, uint32_t len)
+{
+    UartState *state = &uartState[uart];
+    uint32_t tail = state->rxTail;
+    uint32_t count = 0;
+    while ((count < len) && (tail != state->rxHead))
+    {
+        data[count++] = state->rxBuf[tail & (UART_RX_BUF_SIZE - 1)];
+        tail++;
+    }
+    state->rxTail = tail;
+    return count;
+}
+
+uint32_t uartRxAvail(uint32_t uart)
+{
+    return uartState[uart].rxHead - uartState[uart].rxTail;
+}
+
+uint32_t uartTxFree(uint32_t uart)
+{
+    return UART_TX_BUF_SIZE - (uartState[uart].txHead - uartState[uart].txTail);
+}
+
+void uartGetStats(uint32_t uart, UartStats *stats)
+{
+    const uint32_t *src = (const uint32_t *)&uartState[uart].stats;
+    uint32_t *dst = (uint32_t *)stats;
+    uint32_t primask = cpuIrqSave();
+    for (uint32_t i = 0; i < sizeof(UartStats) / sizeof(uint32_t); i++)   // no memcpy with -nostdlib
+    {
+        dst[i] = src[i];
+    }
+    cpuIrqRestore(primask);
+}
+
+/* Interrupt of one UART: drains the RX FIFO, refills the TX FIFO */
+static void TIME_CRITICAL(uartIrq)(uint32_t uart)
+{
+    UartState *state = &uartState[uart];
+    uint32_t status = GET32(UART_MIS(uart));
+
+    if (status & (UART_INT_RX | UART_INT_RT | UART_INT_ERR))
+    {
+        uint32_t head = state->rxHead;
+        while (!(GET32(UART_FR(uart)) & UART_FR_RXFE))
+        {
+            uint32_t data = GET32(UART_DR(uart));
+            state->stats.rxFramingErrors += (data & UARTDR_FE) ? 1 : 0;
+            state->stats.rxParityErrors += (data & UARTDR_PE) ? 1 : 0;
+            state->stats.rxBreaks += (data & UARTDR_BE) ? 1 : 0;
+            state->stats.rxOverruns += (data & UARTDR_OE) ? 1 : 0;
+            if ((head - state->rxTail) < UART_RX_BUF_SIZE)
+            {
+                state->rxBuf[head & (UART_RX_BUF_SIZE - 1)] = (uint8_t)data;
+                head++;
+            }
+            else
+            {
+                state->stats.rxDropped++;
+            }
+        }
+        state->rxHead = head;
+        if ((head - state->rxTail) > state->stats.rxHighWater)
+        {
+            state->stats.rxHighWater = head - state->rxTail;
+        }
+        PUT32(UART_ICR(uart), (UART_INT_RT | UART_INT_ERR));               // RX level clears by reading the FIFO
+    }
+
+    if (status & UART_INT_TX)
+    {
+        uartTxFill(uart);
+    }
+}
+
+PROF_PROBE(UART0_IRQ_Handler);
+PROF_PROBE(UART1_IRQ_Handler);
+
+void TIME_CRITICAL(UART0_IRQ_Handler)(void)
+{
+    PROF_BEGIN(UART0_IRQ_Handler);
+    uartIrq(0);
+    PROF_END(UART0_IRQ_Handler);
+}
+
+void TIME_CRITICAL(UART1_IRQ_Handler)(void)
+{
+    PROF_BEGIN(UART1_IRQ_Handler);
+    uartIrq(1);
+    PROF_END(UART1_IRQ_Handler);
+}
@@ -0,0 +1,123 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* Interrupt driven UART driver (UART0 and UART1)
+   Data is exchanged with the application through two ring buffers per UART.
+   The UART interrupt moves the received characters from the RX FIFO into the
+   RX buffer and refills the TX FIFO from the TX buffer, so the application
+   never waits for the UART status flags.
+   - RX interrupt at 1/2 of the RX FIFO, plus the RX timeout for the last bytes
+     of a message
+   - TX interrupt at 1/8 of the TX FIFO, only enabled while there is data
+   The baud rate divisor is computed from the current clk_peri and rounded to
+   the nearest 1/64 (uartBaudCompute), so the rate obtained and its error are
+   known. Any rate from clk_peri / (16 * 65535) up to clk_peri / 16 (9.375
+   Mbaud at 150 MHz) can be set. With UART_FLOW_RTS_CTS the UART stops
+   sending while CTS is high and raises RTS while its RX FIFO is full.
+   The pins are the ones of the Pico 2 header:
+   - UART0: TX GPIO0, RX GPIO1, CTS GPIO2, RTS GPIO3
+   - UART1: TX GPIO4, RX GPIO5, CTS GPIO6, RTS GPIO7
+   The UART0/UART1 interrupts (IRQ 33/34) have to point to UART0_IRQ_Handler
+   and UART1_IRQ_Handler in the vector table. The interrupt of a UART runs on
+   the core that called uartInit(). Each UART has a single producer (the
+   writer of the TX buffer) and a single consumer (the reader of the RX
+   buffer), which may run on either core: the TX FIFO is refilled under a
+   SIO spinlock (UART_SPINLOCK), by the interrupt on one core and by
+   uartWrite() on the other.
+*/
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+#include "rp2350.h"
+
+/* UART registers (ARM PrimeCell PL011)
+   See section 12.1 "UART" on RP2350 datasheet */
+#define UART_BASE(uart)     (UART0_BASE + 0x8000 * (uart))
+#define UART_DR(uart)       (UART_BASE(uart) + 0x000)
+#define UART_FR(uart)       (UART_BASE(uart) + 0x018)
+#define UART_IBRD(uart)     (UART_BASE(uart) + 0x024)
+#define UART_FBRD(uart)     (UART_BASE(uart) + 0x028)
+#define UART_LCR_H(uart)    (UART_BASE(uart) + 0x02c)
+#define UART_CR(uart)       (UART_BASE(uart) + 0x030)
+#define UART_IFLS(uart)     (UART_BASE(uart) + 0x034)
+#define UART_IMSC(uart)     (UART_BASE(uart) + 0x038)
+#define UART_MIS(uart)      (UART_BASE(uart) + 0x040)
+#define UART_ICR(uart)      (UART_BASE(uart) + 0x044)
+#define UART_DMACR(uart)    (UART_BASE(uart) + 0x048)
+
+#define UART_FR_BUSY        (1 << 3)    // transmitting (TX FIFO not empty or character in the shifter)
+#define UART_FR_RXFE        (1 << 4)    // RX FIFO empty
+#define UART_FR_TXFF        (1 << 5)    // TX FIFO full
+
+#define UART_INSTANCES      (2)
+
+/* SIO spinlocks of the TX FIFO of UART0 and UART1 */
+#define UART_SPINLOCK       (11)
+
+/* Ring buffer sizes in bytes, must be a power of two */
+#ifndef UART_TX_BUF_SIZE
+#define UART_TX_BUF_SIZE (256)
+#endif
+#ifndef UART_RX_BUF_SIZE
+#define UART_RX_BUF_SIZE (256)
+#endif
+
+/* uartInit() flags */
+#define UART_FLOW_RTS_CTS   (1 << 0)    // hardware flow control on the CTS/RTS pins
+
+typedef struct {
+    uint32_t rxOverruns;        // characters lost because the RX FIFO was full
+    uint32_t rxFramingErrors;   // characters received without a valid stop bit
+    uint32_t rxParityErrors;    // characters received with a parity error
+    uint32_t rxBreaks;          // break conditions received
+    uint32_t rxDropped;         // characters lost because the RX buffer was full
+    uint32_t rxHighWater;       // maximum number of bytes in the RX buffer
+    uint32_t txHighWater;       // maximum number of bytes in the TX buffer
+} UartStats;
+
+typedef struct {
+    uint32_t ibrd;              // integer part of the divisor
+    uint32_t fbrd;              // fractional part, in 1/64
+    uint32_t baud;              // rate obtained
+    int32_t  errorPpm;          // (obtained - requested) / requested, in parts per million
+} UartBaud;
+
+/* Baud rate divisor for baud on a clk_peri of periHz: clk_peri / (16 * baud)
+   rounded to the nearest 1/64. Returns -1 (result untouched) when the rate
+   is out of reach.
+*/
+int uartBaudCompute(uint32_t periHz, uint32_t baud, UartBaud *result);
+
+/* Configures the pins and the UART (8N1, FIFOs) for the given baud rate on
+   the current clk_peri, and enables its interrupt on the calling core.
+   Returns -1 (nothing done) when the rate is out of reach.
+*/
+int uartInit(uint32_t uart, uint32_t baud, uint32_t flags);
+
+/* Divisor and rate set by uartInit() */
+void uartGetBaud(uint32_t uart, UartBaud *baud);
+
+/* Queues up to len bytes for transmission. Returns the number of bytes queued */
+uint32_t uartWrite(uint32_t uart, const uint8_t *data, uint32_t len);
+
+/* Queues len bytes for transmission. While the TX buffer is full it sleeps
+   (wfi) on the core that runs the UART interrupt, and polls on the other
+   core, which that interrupt does not wake up */
+void uartWriteAll(uint32_t uart, const uint8_t *data, uint32_t len);
+
+/* Copies up to len received bytes into data. Returns the number of bytes read */
+uint32_t uartRead(uint32_t uart, uint8_t *data, uint32_t len);
+
+/* Bytes waiting in the RX buffer / free space in the TX buffer */
+uint32_t uartRxAvail(uint32_t uart);
+uint32_t uartTxFree(uint32_t uart);
+
+void uartGetStats(uint32_t uart, UartStats *stats);
+
+void UART0_IRQ_Handler(void);
+void UART1_IRQ_Handler(void);
+
+#endif /* UART_H */
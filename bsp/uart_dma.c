@@ -0,0 +1,173 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+#include "rp2350.h"
+#include "cpu.h"
+#include "crt0.h"
+#include "nvic.h"
+#include "dma.h"
+#include "uart.h"
+#include "uart_dma.h"
+
+_Static_assert((UART_DMA_QUEUE_SIZE & (UART_DMA_QUEUE_SIZE - 1)) == 0, "UART_DMA_QUEUE_SIZE must be a power of two");
+
+typedef struct {
+    const uint8_t   *data;
+    uint32_t        len;
+    uint32_t        flags;
+    UartDmaCallback callback;
+    void            *context;
+} UartDmaDesc;
+
+/* Descriptor queue. The indexes run freely and are masked on access:
+   done <= sent <= head. [done, sent) is in the running list, [sent, head)
+   waits for the next one. */
+static UartDmaDesc queue[UART_DMA_QUEUE_SIZE];
+static volatile uint32_t queueHead;
+static volatile uint32_t queueSent;
+static volatile uint32_t queueDone;
+static volatile int chainBusy;
+
+/* Control blocks {count, read address}: payload and terminator of every
+   descriptor, plus the null block that ends the list */
+static uint32_t controlBlocks[2 * (2 * UART_DMA_QUEUE_SIZE + 1)];
+static const uint8_t lineEnd[2] = { '\r', '\n' };
+static UartDmaStats uartDmaStats;
+
+/* Builds the control block list of the waiting descriptors and starts the
+   control channel. Called with the interrupts disabled and the DMA idle.
+*/
+static void TIME_CRITICAL(uartDmaStart)(void)
+{
+    uint32_t *block = controlBlocks;
+    uint32_t index;
+    for (index = queueSent; index != queueHead; index++)
+    {
+        UartDmaDesc *desc = &queue[index & (UART_DMA_QUEUE_SIZE - 1)];
+        if (desc->len > 0)                                                 // a zero count would not stop the chain
+        {
+            *block++ = desc->len;
+            *block++ = (uint32_t)(uintptr_t)desc->data;
+        }
+        if (desc->flags & UART_DMA_CRLF)
+        {
+            *block++ = sizeof(lineEnd);
+            *block++ = (uint32_t)(uintptr_t)lineEnd;
+        }
+        uartDmaStats.bytes += desc->len + ((desc->flags & UART_DMA_CRLF) ? sizeof(lineEnd) : 0);
+    }
+    *block++ = 0;                                                          // null trigger: end of the list
+    *block++ = 0;
+    queueSent = index;
+    chainBusy = 1;
+    uartDmaStats.chains++;
+
+    cpuDmb();                                                              // control blocks written before the DMA reads them
+    PUT32(DMA_CH_READ_ADDR(UART_DMA_CTRL_CH), (uint32_t)(uintptr_t)controlBlocks);
+    PUT32(DMA_CH_WRITE_ADDR(UART_DMA_CTRL_CH), DMA_CH_AL3_TRANS_COUNT(UART_DMA_DATA_CH));
+    PUT32(DMA_CH_TRANS_COUNT(UART_DMA_CTRL_CH), 2);                        // one control block per trigger
+    PUT32(DMA_CH_CTRL_TRIG(UART_DMA_CTRL_CH), (DMA_CTRL_EN | DMA_CTRL_SIZE_WORD | DMA_CTRL_INCR_READ |
+                                               DMA_CTRL_INCR_WRITE | DMA_CTRL_RING_SIZE(3) | DMA_CTRL_RING_SEL_WRITE |
+                                               DMA_CTRL_CHAIN_TO(UART_DMA_CTRL_CH) | DMA_CTRL_TREQ_SEL(DREQ_FORCE)));
+}
+
+void uartDmaInit(void)
+{
+    uint32_t *stats = (uint32_t *)&uartDmaStats;
+    for (uint32_t i = 0; i < sizeof(UartDmaStats) / sizeof(uint32_t); i++)
+    {
+        stats[i] = 0;
+    }
+    queueHead = queueSent = queueDone = 0;
+    chainBusy = 0;
+    dmaInit();
+    PUT32(DMA_CHAN_ABORT, ((1 << UART_DMA_DATA_CH) | (1 << UART_DMA_CTRL_CH)));
+    while (GET32(DMA_CHAN_ABORT) & ((1 << UART_DMA_DATA_CH) | (1 << UART_DMA_CTRL_CH)));
+
+    // Data channel: bytes to UARTDR at the pace of the UART0 TX DREQ. Loaded by
+    // the control channel, chains back to it, and interrupts on the null trigger only
+    PUT32(DMA_CH_WRITE_ADDR(UART_DMA_DATA_CH), UART_DR(0));
+    PUT32(DMA_CH_AL1_CTRL(UART_DMA_DATA_CH), (DMA_CTRL_EN | DMA_CTRL_SIZE_BYTE | DMA_CTRL_INCR_READ |
+                                              DMA_CTRL_CHAIN_TO(UART_DMA_CTRL_CH) | DMA_CTRL_TREQ_SEL(DREQ_UART0_TX) |
+                                              DMA_CTRL_IRQ_QUIET));
+    PUT32(DMA_INTR, (1 << UART_DMA_DATA_CH));                              // Clear a stale interrupt
+    PUT32((DMA_INTE0 + WRITE_SET), (1 << UART_DMA_DATA_CH));               // Data channel on DMA_IRQ_0
+
+    PUT32((UART_DMACR(0) + WRITE_SET), (1 << 1));                          // TXDMAE: UART0 TX DMA request enabled
+
+    nvicClearPending(DMA_IRQ_0);
+    nvicEnableIrq(DMA_IRQ_0);
+}
+
+int uartDmaWrite(const uint8_t *data, uint32_t len, uint32_t flags, UartDmaCallback callback, void *context)
+{
+    uint32_t primask = cpuIrqSave();
+    if ((queueHead - queueDone) >= UART_DMA_QUEUE_SIZE)
+    {
+        uartDmaStats.queueFull++;
+        cpuIrqRestore(primask);
+        return -1;
+    }
+    UartDmaDesc *desc = &queue[queueHead & (UART_DMA_QUEUE_SIZE - 1)];
+    desc->data = data;
+    desc->len = len;
+    desc->flags = flags;
+    desc->callback = callback;
+    desc->context = context;
+    queueHead++;
+    if (!chainBusy)
+    {
+        uartDmaStart();                                                    // Otherwise it goes with the next list
+    }
+    cpuIrqRestore(primask);
+    return 0;
+}
+
+int uartDmaBusy(void)
+{
+    return queueDone != queueHead;
+}
+
+void uartDmaGetStats(UartDmaStats *stats)
+{
+    const uint32_t *src = (const uint32_t *)&uartDmaStats;
+    uint32_t *dst = (uint32_t *)stats;
+    uint32_t primask = cpuIrqSave();
+    for (uint32_t i = 0; i < sizeof(UartDmaStats) / sizeof(uint32_t); i++)    // no memcpy with -nostdlib
+    {
+        dst[i] = src[i];
+    }
+    cpuIrqRestore(primask);
+}
+
+void TIME_CRITICAL(DMA_IRQ_0_Handler)(void)
+{
+    if (!(GET32(DMA_INTS0) & (1 << UART_DMA_DATA_CH)))
+    {
+        return;
+    }
+    PUT32(DMA_INTS0, (1 << UART_DMA_DATA_CH));                             // Acknowledge the null trigger
+
+    // The list is finished: start the strings queued in the meantime first, so
+    // the UART FIFO never runs dry, then complete the finished descriptors
+    uint32_t end = queueSent;
+    chainBusy = 0;
+    if (queueSent != queueHead)
+    {
+        uartDmaStart();
+    }
+    while (queueDone != end)
+    {
+        UartDmaDesc *desc = &queue[queueDone & (UART_DMA_QUEUE_SIZE - 1)];
+        UartDmaCallback callback = desc->callback;
+        void *context = desc->context;
+        queueDone++;                                                       // The slot can be reused by the callback
+        uartDmaStats.descriptors++;
+        if (callback)
+        {
+            callback(context);
+        }
+    }
+}
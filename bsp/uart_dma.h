@@ -0,0 +1,71 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* DMA driven UART0 transmitter (zero copy)
+   The caller hands over a buffer and continues, the DMA feeds the UART0 TX
+   FIFO paced by the UART0 TX DREQ. Two channels are used:
+   - the data channel copies one buffer into UARTDR
+   - the control channel loads the next {count, address} control block into
+     the data channel (AL3_TRANS_COUNT, AL3_READ_ADDR_TRIG) every time the
+     data channel finishes and chains to it
+   All the strings queued while the DMA is idle form one control block list
+   (payload, "\r\n" terminator, payload, ...) terminated by a null trigger,
+   which raises DMA_IRQ_0. The interrupt starts the next list with the strings
+   queued in the meantime (the UART FIFO keeps the line busy) and then calls
+   the completion callbacks.
+   The buffers are not copied: they must stay valid until their callback.
+   UART0 has to be configured first (uartInit(0, ...)), and uartWrite() must
+   not be used on UART0 while DMA transfers are pending. DMA_IRQ_0 has to
+   point to DMA_IRQ_0_Handler in the vector table.
+*/
+#ifndef UART_DMA_H
+#define UART_DMA_H
+
+#include <stdint.h>
+
+/* DMA channels used by the driver */
+#ifndef UART_DMA_DATA_CH
+#define UART_DMA_DATA_CH (0)
+#endif
+#ifndef UART_DMA_CTRL_CH
+#define UART_DMA_CTRL_CH (1)
+#endif
+
+/* Pending descriptors, must be a power of two */
+#ifndef UART_DMA_QUEUE_SIZE
+#define UART_DMA_QUEUE_SIZE (16)
+#endif
+
+#define UART_DMA_CRLF (1 << 0)  // append the "\r\n" line terminator
+
+/* Called from the DMA interrupt once the buffer has been handed to the UART */
+typedef void (*UartDmaCallback)(void *context);
+
+typedef struct {
+    uint32_t descriptors;       // completed descriptors
+    uint32_t bytes;             // bytes handed to the UART, terminators included
+    uint32_t chains;            // control block lists started
+    uint32_t queueFull;         // uartDmaWrite() calls rejected
+} UartDmaStats;
+
+/* Takes the DMA out of reset, configures both channels and enables the UART0
+   TX DMA request and DMA_IRQ_0 on the calling core.
+*/
+void uartDmaInit(void);
+
+/* Queues len bytes of data (plus "\r\n" with UART_DMA_CRLF). The callback
+   (may be 0) is called with context when the buffer can be reused.
+   Returns 0, or -1 if the queue is full.
+*/
+int uartDmaWrite(const uint8_t *data, uint32_t len, uint32_t flags, UartDmaCallback callback, void *context);
+
+/* Returns 1 while descriptors are queued or being sent */
+int uartDmaBusy(void);
+
+void uartDmaGetStats(UartDmaStats *stats);
+
+void DMA_IRQ_0_Handler(void);
+
+#endif /* UART_DMA_H */
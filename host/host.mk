@@ -0,0 +1,25 @@
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+# Host build of an example against the RP2350 register simulator.
+# Included by the example Makefiles, which provide NAME, HOSTSRCS and DEFINES.
+#   make host      builds $(NAME).host for x86-64 Linux
+#   make hostrun   builds and runs it (see ../host/README.md for the SIM_* options)
+.PHONY: host hostrun
+
+SIMDIR      = ../host
+HOSTCC      = gcc
+HOSTSRCS   ?= $(NAME).c
+HOSTFLAGS   = -std=gnu11 -g -O0 -no-pie -fno-pic -pthread
+HOSTCFLAGS  = $(HOSTFLAGS) $(DEFINES) -DHOST_SIM -I$(SIMDIR) -finstrument-functions -finstrument-functions-exclude-file-list=cpu.h -Wno-pointer-to-int-cast -Wno-int-to-pointer-cast
+HOSTLDFLAGS = -no-pie -rdynamic -pthread -ldl
+
+host: $(NAME).host
+
+$(NAME).host: $(HOSTSRCS) $(wildcard $(BSPDIR)/*.h) $(SIMDIR)/rp2350_sim.c $(SIMDIR)/rp2350_sim.h
+	$(HOSTCC) $(HOSTFLAGS) -c $(SIMDIR)/rp2350_sim.c -o rp2350_sim.host.o
+	$(HOSTCC) $(HOSTCFLAGS) $(HOSTSRCS) rp2350_sim.host.o $(HOSTLDFLAGS) -o $(NAME).host
+
+hostrun: $(NAME).host
+	./$(NAME).host
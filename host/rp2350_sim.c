@@ -0,0 +1,3522 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* RP2350 register simulator for host builds
+
+   Models the registers used by the examples so that they can run, be measured
+   and be regression tested on a Linux PC:
+   - XOSC:      enable sequence, startup delay and STABLE flag. DORMANT stops
+                the clocks until the start bit of the next SIM_UARTn_RX
+                character, when the RX pin of that UART is a wake-up source
+   - CLOCKS:    clk_ref/clk_sys/clk_peri/clk_usb source selection and dividers
+                (frequencies drive the simulated time base and the UART bit timing).
+                ENABLED0/1 follow WAKE_EN0/1, a gated block still works
+   - PLL_SYS / PLL_USB: power up, lock time and output frequency
+   - RESETS:    RESET/RESET_DONE, peripherals ignore accesses while in reset
+   - PSM:       FRCE_ON/DONE for the processor 1 power domain
+   - IO_BANK0 / PADS_BANK0: plain registers with atomic SET/CLR/XOR aliases,
+                FUNCSEL selects who drives a pin (PIO0-2, otherwise SIO)
+   - SIO:       CPUID, GPIO out/OE (with SET/CLR/XOR), inter-core FIFOs, the
+                32 spinlocks and the core 1 bootrom launch protocol
+   - PIO0/1/2:  the state machines run their programs (whole instruction set)
+                on their own clock, with FIFOs, IRQ flags, DREQs and interrupts
+   - UART0/1:   32 entry TX/RX FIFOs, baud rate timing from IBRD/FBRD and clk_peri,
+                FIFO level, RX timeout and overrun interrupts, RTS flow control
+   - NVIC:      per core enable/pending/priority registers, VTOR and PRIMASK.
+                Interrupts are taken between two register accesses or asm()
+                statements by calling the handler found in the vector table
+   - DMA:       16 channels, register aliases, chaining, rings, null triggers,
+                ENDLESS transfer counts and the PIO, UART and SHA-256 DREQs. Transfers
+                cost no CPU cycles
+   - TICKS / TIMER0: tick generators, 64-bit counter and the 4 alarms
+   - SHA256:    message words (byte and halfword DMA writes gathered), BSWAP,
+                the real compression function, 57 cycles per block with
+                WDATA_RDY/SUM_VLD/ERR_WDATA_NOT_RDY and the DREQ
+   - SysTick:   per core, with its exception and SHPR3 priority
+   - DWT:       CYCCNT returns the simulated cycle counter of the calling core
+   - XIP:       writes to the cache maintenance window are ignored, code
+                fetches are free wherever the code is (flash or SRAM)
+
+   Every core has its own cycle counter. Register accesses and asm() statements
+   are the only things that consume cycles, so the counters measure the I/O cost
+   of a function, not its instruction count. Core 0 runs on the main thread and
+   core 1 on a second thread that plays the bootrom until it is launched.
+   A core in wfi with interrupts enabled skips ahead to the next UART event or
+   timer alarm instead of spinning, the skipped time is reported as sleep time.
+   The PIO state machines catch up with the core that accesses the bus.
+
+   Functions of the example are instrumented (-finstrument-functions) and the
+   simulator keeps, per core and per function, the number of calls, register
+   reads/writes and cycles. The table is printed on stderr when the simulation
+   ends and can be written as CSV for CI (SIM_REPORT=file.csv).
+
+   Environment variables:
+   - SIM_MAX_MS      simulated time of core 0 before the run ends (default 2000)
+   - SIM_REPORT      write the per function statistics as CSV into this file
+   - SIM_UART0_RX    characters received on UART0 RX (back to back, at baud rate)
+   - SIM_UART0_RX_MS time of arrival of the first RX character (default 10 ms)
+   - SIM_UART1_RX, SIM_UART1_RX_MS: the same for UART1
+   - SIM_UART1_OUT   file that receives the UART1 TX characters (default stdout)
+   - SIM_TRACE_GPIO  print every change of the GPIO outputs on stderr
+*/
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "rp2350_sim.h"
+
+/* Clock sources */
+#define SIM_XOSC_HZ     12000000ull     // ABM8-272-T3 crystal on the Pico 2 board
+#define SIM_ROSC_HZ     11000000ull     // nominal ring oscillator frequency
+
+/* Bus cost of a register access in clk_sys cycles */
+#define SIM_COST_APB    4               // 0x40000000: APB peripherals behind the bridge
+#define SIM_COST_AHB    2               // 0x50000000: AHB peripherals
+#define SIM_COST_SIO    1               // 0xd0000000: single cycle IO
+#define SIM_COST_PPB    1               // 0xe0000000: private peripheral bus
+#define SIM_COST_ASM    1               // any asm() statement
+
+/* Peripheral base addresses */
+#define SIM_XIP_MAINT   0x18000000u
+#define SIM_CLOCKS      0x40010000u
+#define SIM_PSM         0x40018000u
+#define SIM_RESETS      0x40020000u
+#define SIM_IO_BANK0    0x40028000u
+#define SIM_PADS_BANK0  0x40038000u
+#define SIM_XOSC        0x40048000u
+#define SIM_PLL_SYS     0x40050000u
+#define SIM_PLL_USB     0x40058000u
+#define SIM_UART0       0x40070000u
+#define SIM_UART1       0x40078000u
+#define SIM_TIMER0      0x400b0000u
+#define SIM_SHA256      0x400f8000u
+#define SIM_TICKS       0x40108000u
+#define SIM_DMA         0x50000000u
+#define SIM_PIO0        0x50200000u     // PIO1 and PIO2 follow every 1 MB
+#define SIM_SIO         0xd0000000u
+#define SIM_DWT         0xe0001000u
+#define SIM_SYSTICK     0xe000e010u
+#define SIM_NVIC        0xe000e100u
+#define SIM_VTOR        0xe000ed08u
+#define SIM_AIRCR       0xe000ed0cu
+#define SIM_SHPR3       0xe000ed20u
+
+#define SIM_RESET_DMA   (1u << 2)
+#define SIM_RESET_PIO0  (1u << 11)      // PIO1 and PIO2: bits 12 and 13
+#define SIM_RESET_PLL_SYS (1u << 14)
+#define SIM_RESET_PLL_USB (1u << 15)
+#define SIM_RESET_SHA256 (1u << 17)
+#define SIM_RESET_TIMER0 (1u << 23)
+#define SIM_RESET_UART0 (1u << 26)
+#define SIM_RESET_UART1 (1u << 27)
+
+#define SIM_MAX_DEPTH   64
+#define SIM_MAX_FUNCS   512
+#define SIM_STORE_SIZE  4096
+#define SIM_FIFO_DEPTH  8
+#define SIM_UART_DEPTH  32
+#define SIM_PLL_LOCK_PS 50000000ull     // 50 us from power up to lock
+#define SIM_NUM_IRQS    52
+#define SIM_SYSTICK_IRQ SIM_NUM_IRQS    // SysTick (exception 15) is handled as one more line
+#define SIM_NUM_LINES   (SIM_NUM_IRQS + 1)
+#define SIM_MAX_NESTING 8
+#define SIM_IRQ_CYCLES  12              // exception entry and return (stacking 8 registers)
+#define SIM_TAILCHAIN_CYCLES 6          // return straight into the next pending handler (no unstacking)
+#define SIM_TIMER0_IRQ_0 0
+#define SIM_DMA_IRQ_0   10
+#define SIM_PIO0_IRQ_0  15              // PIOn_IRQ_0/1: 15 + 2 * n, 16 + 2 * n
+#define SIM_UART0_IRQ   33
+#define SIM_DMA_CHANNELS 16
+#define SIM_DREQ_UART0_TX 28            // UART0_TX, UART0_RX, UART1_TX, UART1_RX
+#define SIM_DREQ_SHA256 54
+#define SIM_DREQ_FORCE  0x3f
+#define SIM_PIO_BLOCKS  3
+#define SIM_PIO_DREQS   24              // PIOn TX0-3 (8 * n), RX0-3 (8 * n + 4)
+#define SIM_SHA256_CYCLES 57             // clk_sys cycles to hash a 64 byte block
+#define SIM_IDLE_PS     1000000000ull   // wfi with nothing scheduled sleeps in steps of 1 ms
+
+/* Type definitions */
+typedef struct {
+    void     *fn;
+    uint64_t calls;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t selfCycles;
+    uint64_t inclCycles;
+    uint64_t minCycles;
+    uint64_t maxCycles;
+} SimFuncStats;
+
+typedef struct {
+    void     *fn;
+    uint64_t startCycles;
+} SimFrame;
+
+typedef struct {
+    uint32_t     id;
+    uint64_t     cycles;
+    uint64_t     timePs;
+    int          event;                 // event register for wfe/sev
+    int          idle;                  // waiting in wfe/wfi (or core 1 in the bootrom)
+    int          depth;
+    SimFrame     stack[SIM_MAX_DEPTH];
+    SimFuncStats funcs[SIM_MAX_FUNCS];
+    uint64_t     reads;
+    uint64_t     writes;
+    uint64_t     sleepPs;               // time skipped in wfi
+    uint32_t     primask;
+    uint32_t     special[8];            // other special registers (msr/mrs)
+    uint32_t     vtor;
+    uint32_t     prigroup;              // AIRCR.PRIGROUP
+    uint64_t     nvicEnabled;
+    uint64_t     nvicPending;
+    uint8_t      nvicPriority[SIM_NUM_LINES];
+    int          irqDepth;              // nesting level of the running handlers
+    int          irqActive[SIM_MAX_NESTING];
+    uint64_t     irqCount[SIM_NUM_LINES];
+    uint32_t     systCsr;               // SysTick control and status
+    uint32_t     systRvr;               // SysTick reload value
+    uint64_t     systStartPs;           // SysTick (re)started counting from RVR
+    uint64_t     systWrapsSeen;         // wraps reported by COUNTFLAG
+    uint64_t     systWrapsIrq;          // wraps that pended the exception
+} SimCore;
+
+typedef struct {
+    uint32_t data[SIM_FIFO_DEPTH];
+    int      head;
+    int      count;
+} SimFifo;
+
+typedef struct {
+    uint32_t    base;
+    uint32_t    resetBit;
+    const char *name;
+    uint32_t    cr;
+    uint32_t    lcrh;
+    uint32_t    ibrd;
+    uint32_t    fbrd;
+    uint32_t    ifls;
+    uint32_t    imsc;
+    uint32_t    ris;
+    uint32_t    rsr;
+    uint32_t    dmacr;
+    uint8_t     txFifo[SIM_UART_DEPTH];
+    int         txHead;
+    int         txCount;
+    uint16_t    rxFifo[SIM_UART_DEPTH];
+    int         rxHead;
+    int         rxCount;
+    int         shiftBusy;
+    uint8_t     shiftChar;
+    uint64_t    shiftEndPs;
+    uint64_t    shiftIdlePs;
+    const char *rxInput;                // pending characters on the RX line
+    uint64_t    rxNextPs;
+    uint64_t    rxTimeoutPs;            // RX timeout deadline (0 = not armed)
+    uint64_t    txBytes;
+    uint64_t    rxBytes;
+    uint64_t    txDropped;
+    uint64_t    rxOverruns;
+    FILE        *out;
+} SimUart;
+
+typedef struct {
+    uint32_t    base;
+    uint32_t    resetBit;
+    uint32_t    cs;
+    uint32_t    pwr;
+    uint32_t    fbdiv;
+    uint32_t    prim;
+    uint64_t    lockPs;
+} SimPll;
+
+typedef struct {
+    uint32_t    read;
+    uint32_t    write;
+    uint32_t    count;                  // remaining transfers
+    uint32_t    countReload;            // TRANS_COUNT written by software, loaded on trigger
+    uint32_t    ctrl;
+    int         busy;
+    int         endless;                // TRANS_COUNT MODE = ENDLESS
+    uint64_t    transfers;
+} SimDmaChannel;
+
+typedef struct {
+    uint32_t    clkdiv;
+    uint32_t    execctrl;
+    uint32_t    shiftctrl;
+    uint32_t    pinctrl;
+    uint32_t    pc;
+    uint32_t    x;
+    uint32_t    y;
+    uint32_t    isr;
+    uint32_t    osr;
+    uint32_t    isrCount;               // bits shifted into the ISR
+    uint32_t    osrCount;               // bits shifted out of the OSR (32: empty)
+    uint32_t    delay;                  // delay cycles left
+    uint32_t    exec;                   // instruction from SMx_INSTR or OUT/MOV EXEC
+    int         execPending;            // exec runs instead of the instruction at pc
+    int         stalled;                // waiting for a FIFO, a pin or an IRQ flag
+    int         irqWait;                // "irq wait": flag set, waiting for it to be cleared
+    double      nextPs;                 // next clock cycle of the state machine
+    SimFifo     tx;
+    SimFifo     rx;
+    uint64_t    instructions;
+} SimPioSm;
+
+typedef struct {
+    uint32_t    ctrl;                   // SM_ENABLE
+    uint32_t    fdebug;
+    uint32_t    irq;                    // the 8 IRQ flags
+    uint32_t    inte[2];
+    uint32_t    intf[2];
+    uint32_t    pins;                   // outputs of the block
+    uint32_t    pindirs;
+    uint16_t    instr[32];
+    SimPioSm    sm[4];
+} SimPio;
+
+typedef struct {
+    uint32_t    csr;                    // DMA_SIZE and BSWAP, the flags are computed
+    uint32_t    h[8];                   // SUM0-7
+    uint32_t    block[16];
+    int         words;                  // words of the block received
+    uint32_t    partial;                // bytes and halfwords gathered into a word
+    uint32_t    partialBytes;
+    int         busy;                   // hashing a block until readyPs
+    uint64_t    readyPs;
+    int         sumValid;
+    int         errNotReady;            // ERR_WDATA_NOT_RDY
+    uint64_t    blocks;
+} SimSha;
+
+typedef struct {
+    uint64_t    baseCount;              // counter value at basePs
+    uint64_t    basePs;
+    uint64_t    tickPs;                 // period of the tick, 0 while stopped
+    uint32_t    latchHigh;              // TIMEHR, latched by reading TIMELR
+    uint32_t    writeLow;               // TIMELW, loaded by writing TIMEHW
+    uint32_t    alarm[4];
+    uint32_t    alarmFrom[4];           // counter value when the alarm was armed
+    uint32_t    armed;
+    uint32_t    intr;
+    uint32_t    inte;
+    uint32_t    intf;
+    uint32_t    pause;
+    uint32_t    source;
+    uint32_t    dbgpause;
+} SimTimer;
+
+/* Simulator state */
+static pthread_mutex_t simLock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static pthread_cond_t  simCond = PTHREAD_COND_INITIALIZER;
+static SimCore         simCores[2];
+static __thread SimCore *simCore;
+static uint64_t        simMaxPs;
+static int             simTraceGpio;
+static int             simFinished;
+static double          simPsPerCycle = 1e12 / SIM_ROSC_HZ;
+
+static struct { uint32_t addr; uint32_t value; int used; } simStore[SIM_STORE_SIZE];
+
+static uint32_t simXoscCtrl;
+static uint32_t simXoscStartup = 0xc4;
+static uint64_t simXoscStablePs = UINT64_MAX;
+static uint32_t simResets = 0x1fffffff & ~((1u << 1) | (1u << 6) | (1u << 7) | (1u << 9) | (1u << 10) | (1u << 20) | (1u << 21));
+static uint32_t simPsmOn;
+static uint32_t simGpioOut;
+static uint32_t simGpioOe;
+static SimFifo  simFifo[2];             // simFifo[n] is the RX FIFO of core n
+static uint32_t simFifoStatus[2];       // sticky WOF/ROE flags per core
+static uint32_t simSpinlocks;           // claimed SIO spinlocks
+static uint64_t simGpioEdges[32];
+static uint32_t simGpioPio[SIM_PIO_BLOCKS]; // pins given to PIO0-2 (IO_BANK0 FUNCSEL 6-8)
+static uint32_t simGpioLevel;           // pins driven high (by SIO or by a PIO block)
+static uint32_t simGpioDriven;          // pins driven at all
+static SimPll   simPll[2] = {
+    { .base = SIM_PLL_SYS, .resetBit = SIM_RESET_PLL_SYS, .cs = 1, .pwr = 0x2d, .prim = 0x77000, .lockPs = UINT64_MAX },
+    { .base = SIM_PLL_USB, .resetBit = SIM_RESET_PLL_USB, .cs = 1, .pwr = 0x2d, .prim = 0x77000, .lockPs = UINT64_MAX },
+};
+static SimDmaChannel simDma[SIM_DMA_CHANNELS];
+static uint32_t simDmaIntr;
+static uint32_t simDmaInte[4];
+static uint32_t simDmaIntf[4];
+static SimPio   simPio[SIM_PIO_BLOCKS];
+static SimSha   simSha = { .csr = 0x1200, .sumValid = 1 };
+static uint32_t simBusSize = 4;         // bytes of the bus transfer (DMA byte and halfword writes)
+static uint32_t simTicks[6][2];        // CTRL, CYCLES of the tick generators PROC0, PROC1, TIMER0, TIMER1, WATCHDOG, RISCV
+static SimTimer simTimer = { .dbgpause = 0x6 };
+static SimUart  simUart[2] = {
+    { .base = SIM_UART0, .resetBit = SIM_RESET_UART0, .name = "UART0" },
+    { .base = SIM_UART1, .resetBit = SIM_RESET_UART1, .name = "UART1" },
+};
+
+/* Provided by the linker script on the target. On the host the C runtime of
+   the PC initializes the data and Reset_Handler (crt0.c) is not used. */
+unsigned int __time_critical_load__;
+unsigned int __time_critical_start__;
+unsigned int __time_critical_end__;
+unsigned int __data_load__;
+unsigned int __data_start__;
+unsigned int __data_end__;
+unsigned int __bss_start__;
+unsigned int __bss_end__;
+
+/* The heap (pool.h), 64 KB of the program instead of the rest of SRAM:
+   __heap_end__ must follow __heap_start__, which C cannot place */
+__asm__(".bss\n"
+        ".balign 8\n"
+        ".globl __heap_start__\n"
+        "__heap_start__:\n"
+        ".space 65536\n"
+        ".globl __heap_end__\n"
+        "__heap_end__:\n"
+        ".previous");
+
+/* The stack banks (stack.h), 4 KB each like SCRATCH_X and SCRATCH_Y. The
+   code runs on the stacks of the PC threads: they are painted but stay
+   unused */
+__asm__(".bss\n"
+        ".balign 32\n"
+        ".globl __stack_start__\n"
+        "__stack_start__:\n"
+        ".space 4096\n"
+        ".globl __stack_end__\n"
+        "__stack_end__:\n"
+        ".globl __stack1_start__\n"
+        "__stack1_start__:\n"
+        ".space 4096\n"
+        ".globl __stack1_end__\n"
+        "__stack1_end__:\n"
+        ".previous");
+
+static void simFinish(void);
+static SimFuncStats *simFuncStats(SimCore *core, void *fn);
+static void simPllReset(SimPll *pll);
+static void simUartAdvance(SimUart *uart);
+static void simDmaRun(void);
+static void simGpioChanged(int pio, uint64_t ps);
+static void simPioAdvance(uint64_t nowPs);
+static void simPioWake(uint64_t ps);
+static void simPioReset(int p);
+static void simShaStart(void);
+static void simTimerRebase(void);
+static uint32_t simBusRead(uint32_t address);
+static void simBusWrite(uint32_t address, uint32_t value);
+
+/* ---------------------------------------------------------------------------
+   Time keeping
+*/
+static SimCore *simSelf(void)
+{
+    return simCore ? simCore : &simCores[0];
+}
+
+static uint64_t simNowPs(void)
+{
+    return simSelf()->timePs;
+}
+
+static void simConsume(uint32_t cycles)
+{
+    SimCore *core = simSelf();
+    core->cycles += cycles;
+    core->timePs += (uint64_t)(cycles * simPsPerCycle);
+    if ((core->depth > 0) && (core->depth <= SIM_MAX_DEPTH))
+    {
+        SimFuncStats *stats = simFuncStats(core, core->stack[core->depth - 1].fn);
+        if (stats)
+        {
+            stats->selfCycles += cycles;
+        }
+    }
+    if ((core->id == 0) && (core->timePs >= simMaxPs))
+    {
+        simFinish();
+    }
+}
+
+/* A core waking up from wfe cannot be behind the core that woke it up */
+static void simSyncTime(SimCore *core)
+{
+    SimCore *other = &simCores[core->id ^ 1];
+    if (other->timePs > core->timePs)
+    {
+        core->timePs = other->timePs;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   Generic register storage, used for every register without side effects
+*/
+static uint32_t *simStoreSlot(uint32_t addr)
+{
+    for (uint32_t i = (addr >> 2) % SIM_STORE_SIZE; ; i = (i + 1) % SIM_STORE_SIZE)
+    {
+        if (!simStore[i].used)
+        {
+            simStore[i].used = 1;
+            simStore[i].addr = addr;
+            simStore[i].value = 0;
+        }
+        if (simStore[i].addr == addr)
+        {
+            return &simStore[i].value;
+        }
+    }
+}
+
+/* See section 2.1.3 "Atomic Register Access" on RP2350 datasheet */
+static uint32_t simAlias(uint32_t old, uint32_t value, uint32_t alias)
+{
+    switch (alias)
+    {
+        case 1:  return old ^ value;
+        case 2:  return old | value;
+        case 3:  return old & ~value;
+        default: return value;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   Clocks
+*/
+static uint64_t simXoscHz(void)
+{
+    return (simNowPs() >= simXoscStablePs) ? SIM_XOSC_HZ : 0;
+}
+
+static int simPllLocked(SimPll *pll)
+{
+    return !(simResets & pll->resetBit) && ((pll->pwr & 0x21) == 0) && (simNowPs() >= pll->lockPs);
+}
+
+/* FOUTPOSTDIV = (FREF / REFDIV) * FBDIV / (POSTDIV1 * POSTDIV2) */
+static uint64_t simPllHz(SimPll *pll)
+{
+    uint32_t refdiv = pll->cs & 0x3f;
+    uint32_t postDiv = ((pll->prim >> 16) & 0x7) * ((pll->prim >> 12) & 0x7);
+    if (!simPllLocked(pll) || (pll->pwr & (1 << 3)) || (refdiv == 0) || (postDiv == 0))
+    {
+        return 0;
+    }
+    return (simXoscHz() / refdiv) * pll->fbdiv / postDiv;
+}
+
+static uint64_t simClkRefHz(void)
+{
+    uint32_t ctrl = *simStoreSlot(SIM_CLOCKS + 0x30);
+    uint32_t div = (*simStoreSlot(SIM_CLOCKS + 0x34) >> 16) & 0xff;
+    uint64_t hz;
+    switch (ctrl & 0x3)
+    {
+        case 0:  hz = SIM_ROSC_HZ; break;
+        case 1:  hz = (((ctrl >> 5) & 0x3) == 0) ? simPllHz(&simPll[1]) : 0; break;   // GPIN is not modelled
+        case 2:  hz = simXoscHz(); break;
+        default: hz = 32768; break;
+    }
+    return hz / (div ? div : 1);
+}
+
+static uint64_t simClkSysHz(void)
+{
+    uint32_t ctrl = *simStoreSlot(SIM_CLOCKS + 0x3c);
+    uint32_t div = *simStoreSlot(SIM_CLOCKS + 0x40) >> 16;
+    uint64_t hz;
+    if ((ctrl & 1) == 0)
+    {
+        hz = simClkRefHz();
+    }
+    else
+    {
+        switch ((ctrl >> 5) & 0x7)
+        {
+            case 0:  hz = simPllHz(&simPll[0]); break;
+            case 1:  hz = simPllHz(&simPll[1]); break;
+            case 2:  hz = SIM_ROSC_HZ; break;
+            case 3:  hz = simXoscHz(); break;
+            default: hz = 0; break;    // GPIN is not modelled
+        }
+    }
+    return hz / (div ? div : 1);
+}
+
+static uint64_t simClkPeriHz(void)
+{
+    uint32_t ctrl = *simStoreSlot(SIM_CLOCKS + 0x48);
+    uint32_t div = (*simStoreSlot(SIM_CLOCKS + 0x4c) >> 16) & 0x3;
+    uint64_t hz;
+    if ((ctrl & (1 << 11)) == 0)
+    {
+        return 0;
+    }
+    switch ((ctrl >> 5) & 0x7)
+    {
+        case 0:  hz = simClkSysHz(); break;
+        case 1:  hz = simPllHz(&simPll[0]); break;
+        case 2:  hz = simPllHz(&simPll[1]); break;
+        case 3:  hz = SIM_ROSC_HZ; break;
+        case 4:  hz = simXoscHz(); break;
+        default: hz = 0; break;         // GPIN is not modelled
+    }
+    return hz / (div ? div : 1);
+}
+
+static uint64_t simClkUsbHz(void)
+{
+    uint32_t ctrl = *simStoreSlot(SIM_CLOCKS + 0x60);
+    uint32_t div = (*simStoreSlot(SIM_CLOCKS + 0x64) >> 16) & 0xf;
+    uint64_t hz;
+    if ((ctrl & (1 << 11)) == 0)
+    {
+        return 0;
+    }
+    switch ((ctrl >> 5) & 0x7)
+    {
+        case 0:  hz = simPllHz(&simPll[1]); break;
+        case 1:  hz = simPllHz(&simPll[0]); break;
+        case 2:  hz = SIM_ROSC_HZ; break;
+        case 3:  hz = simXoscHz(); break;
+        default: hz = 0; break;
+    }
+    return hz / (div ? div : 1);
+}
+
+static void simClocksChanged(void)
+{
+    uint64_t hz = simClkSysHz();
+    if (hz == 0)
+    {
+        fprintf(stderr, "[sim] clk_sys has no running source, keeping the previous frequency\n");
+        return;
+    }
+    simPsPerCycle = 1e12 / (double)hz;
+    simTimerRebase();
+}
+
+static uint32_t simClocksRead(uint32_t offset)
+{
+    switch (offset)
+    {
+        case 0x38: return 1u << (*simStoreSlot(SIM_CLOCKS + 0x30) & 0x3);   // CLK_REF_SELECTED
+        case 0x44: return 1u << (*simStoreSlot(SIM_CLOCKS + 0x3c) & 0x1);   // CLK_SYS_SELECTED
+        case 0x50: return 1;                                                // CLK_PERI_SELECTED
+        case 0xbc: return *simStoreSlot(SIM_CLOCKS + 0xac);                 // ENABLED0: the cores are awake
+        case 0xc0: return *simStoreSlot(SIM_CLOCKS + 0xb0);                 // ENABLED1
+        default:   return *simStoreSlot(SIM_CLOCKS + offset);
+    }
+}
+
+static void simClocksWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    uint32_t *reg = simStoreSlot(SIM_CLOCKS + offset);
+    *reg = simAlias(*reg, value, alias);
+    simClocksChanged();
+}
+
+/* ---------------------------------------------------------------------------
+   XOSC, RESETS and PSM
+*/
+static uint32_t simXoscRead(uint32_t offset)
+{
+    switch (offset)
+    {
+        case 0x00: return simXoscCtrl;
+        case 0x04: return ((((simXoscCtrl >> 12) & 0xfff) == 0xfab) ? (1u << 12) : 0) |
+                          ((simNowPs() >= simXoscStablePs) ? (1u << 31) : 0);
+        case 0x0c: return simXoscStartup;
+        default:   return *simStoreSlot(SIM_XOSC + offset);
+    }
+}
+
+/* DORMANT: the crystal stops and every clock with it. The wake-up events of
+   IO_BANK0 (DORMANT_WAKE_INTE) are only modelled on the UART RX pins (GPIO 1
+   and 5, low level or falling edge): the chip wakes up at the start bit of
+   the next SIM_UARTn_RX character and the crystal restarts with its startup
+   delay. TIMER0 does not count meanwhile. Without a wake-up source the chip
+   never wakes up: the simulation ends. */
+static void simXoscDormant(void)
+{
+    SimCore *core = simSelf();
+    uint64_t wake = UINT64_MAX;
+    for (int i = 0; i < 2; i++)
+    {
+        uint32_t pin = 4 * i + 1;
+        uint32_t events = *simStoreSlot(SIM_IO_BANK0 + 0x2d8 + 4 * (pin / 8)) >> (4 * (pin % 8));
+        SimUart *uart = &simUart[i];
+        if ((events & 0x5) && uart->rxInput && *uart->rxInput && (uart->rxNextPs < wake))
+        {
+            wake = (uart->rxNextPs > core->timePs) ? uart->rxNextPs : core->timePs;
+        }
+    }
+    if (wake == UINT64_MAX)
+    {
+        fprintf(stderr, "[sim] DORMANT without a UART RX wake-up source, the chip never wakes up\n");
+        simFinish();
+        return;
+    }
+    simXoscStablePs = UINT64_MAX;
+    simTimerRebase();                                           // clk_ref stops: TIMER0 holds its count
+    core->sleepPs += wake - core->timePs;
+    core->timePs = wake;
+    simTimer.basePs = wake;
+    simXoscStablePs = wake + ((uint64_t)(simXoscStartup & 0x3fff) * 256 * 1000000000000ull) / SIM_XOSC_HZ;
+    pthread_cond_broadcast(&simCond);
+}
+
+static void simXoscWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    switch (offset)
+    {
+        case 0x08:
+            if (value == 0x636f6d61)                            // DORMANT = "coma"
+            {
+                simXoscDormant();
+            }
+            return;                                             // clk_sys keeps its frequency once the crystal is back
+        case 0x00:
+        {
+            uint32_t old = simXoscCtrl;
+            simXoscCtrl = simAlias(simXoscCtrl, value, alias);
+            uint32_t enable = (simXoscCtrl >> 12) & 0xfff;
+            if ((enable == 0xfab) && (((old >> 12) & 0xfff) != 0xfab))
+            {
+                // STARTUP.DELAY is counted in units of 256 crystal cycles
+                simXoscStablePs = simNowPs() + ((uint64_t)(simXoscStartup & 0x3fff) * 256 * 1000000000000ull) / SIM_XOSC_HZ;
+            }
+            else if (enable == 0xd1e)
+            {
+                simXoscStablePs = UINT64_MAX;
+            }
+            break;
+        }
+        case 0x0c:
+            simXoscStartup = simAlias(simXoscStartup, value, alias);
+            break;
+        default:
+            *simStoreSlot(SIM_XOSC + offset) = simAlias(*simStoreSlot(SIM_XOSC + offset), value, alias);
+            break;
+    }
+    simClocksChanged();
+}
+
+static uint32_t simResetsRead(uint32_t offset)
+{
+    switch (offset)
+    {
+        case 0x00: return simResets;
+        case 0x08: return ~simResets & 0x1fffffff;                          // RESET_DONE
+        default:   return *simStoreSlot(SIM_RESETS + offset);
+    }
+}
+
+static void simResetsWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    if (offset == 0x00)
+    {
+        simResets = simAlias(simResets, value, alias) & 0x1fffffff;
+        for (int i = 0; i < 2; i++)
+        {
+            if (simResets & simPll[i].resetBit)
+            {
+                simPllReset(&simPll[i]);
+            }
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            if (simResets & simUart[i].resetBit)
+            {
+                SimUart *uart = &simUart[i];
+                uart->cr = 0x300;
+                uart->lcrh = uart->ibrd = uart->fbrd = uart->imsc = uart->ris = uart->rsr = uart->dmacr = 0;
+                uart->ifls = 0x12;
+                uart->txCount = uart->rxCount = uart->shiftBusy = 0;
+            }
+        }
+        if (simResets & SIM_RESET_TIMER0)
+        {
+            memset(&simTimer, 0, sizeof(simTimer));
+            simTimer.dbgpause = 0x6;
+        }
+        simTimerRebase();
+        if (simResets & SIM_RESET_DMA)
+        {
+            for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++)
+            {
+                uint64_t transfers = simDma[ch].transfers;
+                memset(&simDma[ch], 0, sizeof(simDma[ch]));
+                simDma[ch].ctrl = (uint32_t)ch << 13;           // CHAIN_TO = itself (no chaining)
+                simDma[ch].transfers = transfers;
+            }
+            simDmaIntr = simDmaInte[0] = simDmaInte[1] = simDmaInte[2] = simDmaInte[3] = 0;
+            simDmaIntf[0] = simDmaIntf[1] = simDmaIntf[2] = simDmaIntf[3] = 0;
+        }
+        for (int p = 0; p < SIM_PIO_BLOCKS; p++)
+        {
+            if (simResets & (SIM_RESET_PIO0 << p))
+            {
+                simPioReset(p);
+            }
+        }
+        if (simResets & SIM_RESET_SHA256)
+        {
+            uint64_t blocks = simSha.blocks;
+            memset(&simSha, 0, sizeof(simSha));
+            simSha.csr = 0x1200;                        // BSWAP, DMA_SIZE 32 bits
+            simSha.blocks = blocks;
+            simShaStart();
+        }
+        simGpioChanged(-1, simNowPs());
+    }
+    else
+    {
+        *simStoreSlot(SIM_RESETS + offset) = simAlias(*simStoreSlot(SIM_RESETS + offset), value, alias);
+    }
+}
+
+static uint32_t simPsmRead(uint32_t offset)
+{
+    switch (offset)
+    {
+        case 0x00: return simPsmOn;
+        case 0x0c: return 0x01ffffff;                                       // DONE: all domains powered
+        default:   return *simStoreSlot(SIM_PSM + offset);
+    }
+}
+
+static void simPsmWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    if (offset == 0x00)
+    {
+        simPsmOn = simAlias(simPsmOn, value, alias);
+    }
+    else
+    {
+        *simStoreSlot(SIM_PSM + offset) = simAlias(*simStoreSlot(SIM_PSM + offset), value, alias);
+    }
+}
+
+static void simPllReset(SimPll *pll)
+{
+    pll->cs = 1;
+    pll->pwr = 0x2d;
+    pll->fbdiv = 0;
+    pll->prim = 0x77000;
+    pll->lockPs = UINT64_MAX;
+}
+
+static uint32_t simPllRead(SimPll *pll, uint32_t offset)
+{
+    if (simResets & pll->resetBit)
+    {
+        return 0;
+    }
+    switch (offset)
+    {
+        case 0x0: return pll->cs | (simPllLocked(pll) ? (1u << 31) : 0);
+        case 0x4: return pll->pwr;
+        case 0x8: return pll->fbdiv;
+        case 0xc: return pll->prim;
+        default:  return 0;
+    }
+}
+
+static void simPllWrite(SimPll *pll, uint32_t offset, uint32_t value, uint32_t alias)
+{
+    if (simResets & pll->resetBit)
+    {
+        return;
+    }
+    switch (offset)
+    {
+        case 0x0: pll->cs = simAlias(pll->cs, value, alias) & 0x13f; break;
+        case 0x4:
+        {
+            int wasRunning = (pll->pwr & 0x21) == 0;
+            pll->pwr = simAlias(pll->pwr, value, alias) & 0x2d;
+            if ((pll->pwr & 0x21) == 0)
+            {
+                if (!wasRunning)
+                {
+                    pll->lockPs = simNowPs() + SIM_PLL_LOCK_PS;
+                }
+            }
+            else
+            {
+                pll->lockPs = UINT64_MAX;
+            }
+            break;
+        }
+        case 0x8:
+            pll->fbdiv = simAlias(pll->fbdiv, value, alias) & 0xfff;
+            pll->lockPs = ((pll->pwr & 0x21) == 0) ? simNowPs() + SIM_PLL_LOCK_PS : UINT64_MAX;
+            break;
+        case 0xc: pll->prim = simAlias(pll->prim, value, alias) & 0x77000; break;
+        default:  break;
+    }
+    simClocksChanged();
+}
+
+/* ---------------------------------------------------------------------------
+   UART (ARM PrimeCell PL011)
+*/
+static uint32_t simUartBits(SimUart *uart)
+{
+    return 1 + (5 + ((uart->lcrh >> 5) & 0x3)) + ((uart->lcrh >> 1) & 1) + (((uart->lcrh >> 3) & 1) ? 2 : 1);
+}
+
+static uint64_t simUartCharPs(SimUart *uart)
+{
+    uint64_t periHz = simClkPeriHz();
+    uint64_t divisor = ((uint64_t)(uart->ibrd & 0xffff) << 6) | (uart->fbrd & 0x3f);
+    if ((periHz == 0) || (divisor < 64))
+    {
+        return UINT64_MAX;                      // no clock or invalid divisor: the UART stalls
+    }
+    // Baud rate = clk_peri / (16 * divisor), divisor is in units of 1/64
+    return (simUartBits(uart) * divisor * 1000000000000ull) / (4 * periHz);
+}
+
+static int simUartDepth(SimUart *uart)
+{
+    return (uart->lcrh & (1 << 4)) ? SIM_UART_DEPTH : 1;
+}
+
+static void simUartUpdateIrq(SimUart *uart)
+{
+    static const int levels[] = { 4, 8, 16, 24, 28 };           // 1/8, 1/4, 1/2, 3/4, 7/8 of 32
+    int txLevel = levels[(uart->ifls & 0x7) < 5 ? (uart->ifls & 0x7) : 2];
+    int rxLevel = levels[((uart->ifls >> 3) & 0x7) < 5 ? ((uart->ifls >> 3) & 0x7) : 2];
+    if (simUartDepth(uart) == 1)
+    {
+        txLevel = rxLevel = 1;
+    }
+    if (uart->txCount <= (simUartDepth(uart) == 1 ? 0 : txLevel))
+    {
+        uart->ris |= (1 << 5);                  // TXRIS
+    }
+    else
+    {
+        uart->ris &= ~(1 << 5);
+    }
+    if (uart->rxCount >= rxLevel)
+    {
+        uart->ris |= (1 << 4);                  // RXRIS
+    }
+    else
+    {
+        uart->ris &= ~(1 << 4);
+    }
+    if (uart->rxCount == 0)
+    {
+        uart->ris &= ~(1 << 6);                 // RTRIS clears when the RX FIFO is emptied
+    }
+}
+
+static void simUartAdvance(SimUart *uart)
+{
+    uint64_t now = simNowPs();
+    uint64_t charPs = simUartCharPs(uart);
+    int enabled = (uart->cr & 1) && !(simResets & uart->resetBit);
+
+    // Transmitter: the character being shifted leaves the FIFO when it starts
+    while (enabled && (charPs != UINT64_MAX))
+    {
+        if (uart->shiftBusy)
+        {
+            if (uart->shiftEndPs > now)
+            {
+                break;
+            }
+            fputc(uart->shiftChar, uart->out);
+            fflush(uart->out);
+            uart->txBytes++;
+            uart->shiftBusy = 0;
+            uart->shiftIdlePs = uart->shiftEndPs;
+        }
+        if ((uart->txCount == 0) || !(uart->cr & (1 << 8)))
+        {
+            break;
+        }
+        uart->shiftChar = uart->txFifo[uart->txHead];
+        uart->txHead = (uart->txHead + 1) % SIM_UART_DEPTH;
+        uart->txCount--;
+        uart->shiftBusy = 1;
+        uart->shiftEndPs = uart->shiftIdlePs + charPs;
+        simDmaRun();                            // TX DREQ: the DMA refills the FIFO
+    }
+    if (!uart->shiftBusy && (uart->shiftIdlePs < now))
+    {
+        uart->shiftIdlePs = now;
+    }
+
+    // Receiver: characters arrive back to back once the RX line is active.
+    // The sender holds back while the receiver has no baud clock.
+    if (!enabled || (charPs == UINT64_MAX))
+    {
+        uart->rxNextPs = (uart->rxNextPs > now) ? uart->rxNextPs : now;
+    }
+    while (enabled && (charPs != UINT64_MAX) && uart->rxInput && *uart->rxInput && (uart->rxNextPs <= now))
+    {
+        if ((uart->cr & (1 << 14)) && (uart->rxCount >= simUartDepth(uart)))
+        {
+            uart->rxNextPs = now + charPs;      // RTSEN: RTS is high, the sender waits for room
+            break;
+        }
+        if (uart->cr & (1 << 9))
+        {
+            if (uart->rxCount < simUartDepth(uart))
+            {
+                uart->rxFifo[(uart->rxHead + uart->rxCount) % SIM_UART_DEPTH] = (uint8_t)*uart->rxInput;
+                uart->rxCount++;
+                uart->rxBytes++;
+            }
+            else
+            {
+                uart->rxFifo[(uart->rxHead + uart->rxCount - 1) % SIM_UART_DEPTH] |= (1 << 11);  // DR.OE on the last entry
+                uart->rsr |= (1 << 3);          // OE: overrun error
+                uart->ris |= (1 << 10);         // OERIS
+                uart->rxOverruns++;
+            }
+            uart->rxTimeoutPs = uart->rxNextPs + (32 * charPs) / simUartBits(uart);   // 32 bit periods
+        }
+        uart->rxInput++;
+        uart->rxNextPs += charPs;
+        simDmaRun();                            // RX DREQ: the DMA drains the FIFO
+    }
+    if (uart->rxTimeoutPs && (uart->rxTimeoutPs <= now))
+    {
+        if (uart->rxCount > 0)
+        {
+            uart->ris |= (1 << 6);              // RTRIS: RX FIFO not empty and the line is idle
+        }
+        uart->rxTimeoutPs = 0;
+    }
+    simUartUpdateIrq(uart);
+}
+
+static uint32_t simUartRead(SimUart *uart, uint32_t offset)
+{
+    if (simResets & uart->resetBit)
+    {
+        return 0;
+    }
+    simUartAdvance(uart);
+    switch (offset)
+    {
+        case 0x00:                                              // UARTDR
+        {
+            if (uart->rxCount == 0)
+            {
+                return 0;
+            }
+            uint32_t data = uart->rxFifo[uart->rxHead];
+            uart->rxHead = (uart->rxHead + 1) % SIM_UART_DEPTH;
+            uart->rxCount--;
+            simUartUpdateIrq(uart);
+            return data;
+        }
+        case 0x04: return uart->rsr;                            // UARTRSR
+        case 0x18:                                              // UARTFR
+            return ((uart->txCount == 0) ? (1 << 7) : 0) |
+                   ((uart->rxCount >= simUartDepth(uart)) ? (1 << 6) : 0) |
+                   ((uart->txCount >= simUartDepth(uart)) ? (1 << 5) : 0) |
+                   ((uart->rxCount == 0) ? (1 << 4) : 0) |
+                   ((uart->txCount || uart->shiftBusy) ? (1 << 3) : 0) |
+                   (1 << 0);                                    // CTS: nothing connected, the pad pull-down asserts it
+        case 0x24: return uart->ibrd;
+        case 0x28: return uart->fbrd;
+        case 0x2c: return uart->lcrh;
+        case 0x30: return uart->cr;
+        case 0x34: return uart->ifls;
+        case 0x38: return uart->imsc;
+        case 0x3c: return uart->ris;
+        case 0x40: return uart->ris & uart->imsc;
+        case 0x48: return uart->dmacr;
+        default:   return 0;
+    }
+}
+
+static void simUartWrite(SimUart *uart, uint32_t offset, uint32_t value, uint32_t alias)
+{
+    if (simResets & uart->resetBit)
+    {
+        return;
+    }
+    simUartAdvance(uart);
+    switch (offset)
+    {
+        case 0x00:                                              // UARTDR
+            if (uart->txCount >= simUartDepth(uart))
+            {
+                uart->txDropped++;
+                break;
+            }
+            uart->txFifo[(uart->txHead + uart->txCount) % SIM_UART_DEPTH] = (uint8_t)value;
+            uart->txCount++;
+            simUartAdvance(uart);
+            break;
+        case 0x04: uart->rsr = 0; break;                        // UARTECR: clear errors
+        case 0x24: uart->ibrd = simAlias(uart->ibrd, value, alias) & 0xffff; break;
+        case 0x28: uart->fbrd = simAlias(uart->fbrd, value, alias) & 0x3f; break;
+        case 0x2c: uart->lcrh = simAlias(uart->lcrh, value, alias) & 0xff; break;
+        case 0x30: uart->cr = simAlias(uart->cr, value, alias) & 0xff87; break;
+        case 0x34: uart->ifls = simAlias(uart->ifls, value, alias) & 0x3f; break;
+        case 0x38: uart->imsc = simAlias(uart->imsc, value, alias) & 0x7ff; break;
+        case 0x44: uart->ris &= ~value; break;                  // UARTICR
+        case 0x48: uart->dmacr = simAlias(uart->dmacr, value, alias) & 0x7; break;
+        default:   break;
+    }
+    simUartUpdateIrq(uart);
+}
+
+/* ---------------------------------------------------------------------------
+   SIO: GPIO, inter-core FIFOs and spinlocks
+   The examples write the SIO registers through the atomic aliases offsets
+   (e.g. 0xd0000000 + WRITE_SET + 0x028). SIO has no atomic aliases, those
+   address bits are not decoded, so they are ignored here as well.
+*/
+static void simGpioChanged(int pio, uint64_t ps)
+{
+    uint32_t sio = ~(simGpioPio[0] | simGpioPio[1] | simGpioPio[2]);
+    uint32_t driven = simGpioOe & sio;
+    uint32_t level = simGpioOut & simGpioOe & sio;
+    for (int p = 0; p < SIM_PIO_BLOCKS; p++)
+    {
+        driven |= simPio[p].pindirs & simGpioPio[p];
+        level |= simPio[p].pins & simPio[p].pindirs & simGpioPio[p];
+    }
+    uint32_t changed = (level ^ simGpioLevel) | (driven ^ simGpioDriven);
+    simGpioLevel = level;
+    simGpioDriven = driven;
+    for (int pin = 0; pin < 32; pin++)
+    {
+        if (changed & (1u << pin))
+        {
+            simGpioEdges[pin]++;
+            if (simTraceGpio && (pio < 0))
+            {
+                fprintf(stderr, "[sim] core%u %10.3f ms GPIO%d = %d\n", simSelf()->id, ps / 1e9, pin, (level >> pin) & 1);
+            }
+            else if (simTraceGpio)
+            {
+                fprintf(stderr, "[sim] PIO%d  %10.3f ms GPIO%d = %d\n", pio, ps / 1e9, pin, (level >> pin) & 1);
+            }
+        }
+    }
+    if (changed)
+    {
+        simPioWake(ps);                                         // WAIT on a pin
+    }
+}
+
+/* IO_BANK0: plain registers, FUNCSEL of GPIO0-31 tells who drives the pin */
+static void simIoBank0Write(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    uint32_t *reg = simStoreSlot(SIM_IO_BANK0 + offset);
+    *reg = simAlias(*reg, value, alias);
+    if (((offset & 0x7) == 0x4) && (offset < 0x100))            // GPIOn_CTRL
+    {
+        uint32_t pin = offset / 8;
+        uint32_t funcsel = *reg & 0x1f;
+        for (int p = 0; p < SIM_PIO_BLOCKS; p++)
+        {
+            simGpioPio[p] = (funcsel == 6u + p) ? (simGpioPio[p] | (1u << pin)) : (simGpioPio[p] & ~(1u << pin));
+        }
+        simGpioChanged(-1, simNowPs());
+    }
+}
+
+static int simFifoPush(SimFifo *fifo, uint32_t value)
+{
+    if (fifo->count == SIM_FIFO_DEPTH)
+    {
+        return 0;
+    }
+    fifo->data[(fifo->head + fifo->count) % SIM_FIFO_DEPTH] = value;
+    fifo->count++;
+    return 1;
+}
+
+static uint32_t simFifoPop(SimFifo *fifo)
+{
+    uint32_t value = fifo->data[fifo->head];
+    fifo->head = (fifo->head + 1) % SIM_FIFO_DEPTH;
+    fifo->count--;
+    return value;
+}
+
+static uint32_t simSioRead(uint32_t offset)
+{
+    uint32_t id = simSelf()->id;
+    switch (offset & 0xfff)
+    {
+        case 0x000: return id;                                  // CPUID
+        case 0x004: return simGpioLevel;                        // GPIO_IN: outputs read back
+        case 0x010: return simGpioOut;
+        case 0x030: return simGpioOe;
+        case 0x050:                                             // FIFO_ST
+            return (simFifo[id].count ? 1 : 0) | ((simFifo[id ^ 1].count < SIM_FIFO_DEPTH) ? 2 : 0) | simFifoStatus[id];
+        case 0x058:                                             // FIFO_RD
+            if (simFifo[id].count == 0)
+            {
+                simFifoStatus[id] |= (1 << 3);                  // ROE: read on empty
+                return 0;
+            }
+            return simFifoPop(&simFifo[id]);
+        case 0x05c: return simSpinlocks;                        // SPINLOCK_ST
+        default:    break;
+    }
+    if (((offset & 0xfff) >= 0x100) && ((offset & 0xfff) < 0x180))
+    {
+        uint32_t bit = 1u << (((offset & 0xfff) - 0x100) / 4);  // SPINLOCKn: a read claims the lock
+        if (simSpinlocks & bit)
+        {
+            return 0;
+        }
+        simSpinlocks |= bit;
+        return bit;
+    }
+    return *simStoreSlot(SIM_SIO + (offset & 0xfff));
+}
+
+static void simSioWrite(uint32_t offset, uint32_t value)
+{
+    uint32_t id = simSelf()->id;
+    switch (offset & 0xfff)
+    {
+        case 0x010: simGpioOut = value; break;
+        case 0x018: simGpioOut |= value; break;
+        case 0x020: simGpioOut &= ~value; break;
+        case 0x028: simGpioOut ^= value; break;
+        case 0x030: simGpioOe = value; break;
+        case 0x038: simGpioOe |= value; break;
+        case 0x040: simGpioOe &= ~value; break;
+        case 0x048: simGpioOe ^= value; break;
+        case 0x050: simFifoStatus[id] = 0; break;               // FIFO_ST: clear sticky flags
+        case 0x054:                                             // FIFO_WR
+            if (!simFifoPush(&simFifo[id ^ 1], value))
+            {
+                simFifoStatus[id] |= (1 << 2);                  // WOF: write on full
+            }
+            pthread_cond_broadcast(&simCond);
+            break;
+        default:
+            if (((offset & 0xfff) >= 0x100) && ((offset & 0xfff) < 0x180))
+            {
+                simSpinlocks &= ~(1u << (((offset & 0xfff) - 0x100) / 4));   // SPINLOCKn: any write releases
+            }
+            else
+            {
+                *simStoreSlot(SIM_SIO + (offset & 0xfff)) = value;
+            }
+            break;
+    }
+    simGpioChanged(-1, simNowPs());
+}
+
+/* ---------------------------------------------------------------------------
+   PIO: 3 blocks of 4 state machines running the PIO instruction set (with
+   side-set, delays, wrap, autopull/autopush and the RP2350 IRQ index modes),
+   their TX/RX FIFOs (joinable), the DREQs and the PIOn_IRQ_0/1 lines.
+   The state machines run on their own clock (clk_sys / CLKDIV) and are
+   stepped in time order up to the time of the core that accesses the bus. A
+   state machine that stalls (empty/full FIFO, WAIT, irq wait) is not stepped
+   until a FIFO, an IRQ flag or a pin changes.
+   See chapter 11 "PIO" on RP2350 datasheet.
+*/
+static void simPioReset(int p)
+{
+    SimPio *pio = &simPio[p];
+    uint64_t instructions[4];
+    for (int n = 0; n < 4; n++)
+    {
+        instructions[n] = pio->sm[n].instructions;
+    }
+    memset(pio, 0, sizeof(*pio));
+    for (int n = 0; n < 4; n++)
+    {
+        SimPioSm *sm = &pio->sm[n];
+        sm->clkdiv = 0x00010000;                                // INT = 1
+        sm->execctrl = 0x0001f000;                              // WRAP_TOP = 31
+        sm->shiftctrl = 0x000c0000;                             // IN/OUT shift right
+        sm->pinctrl = 0x14000000;                               // SET_COUNT = 5
+        sm->osrCount = 32;
+        sm->instructions = instructions[n];
+    }
+}
+
+static double simPioPeriodPs(SimPioSm *sm)
+{
+    uint32_t div = sm->clkdiv >> 16;
+    return simPsPerCycle * ((div ? div : 65536) + ((sm->clkdiv >> 8) & 0xff) / 256.0);
+}
+
+static int simPioTxDepth(SimPioSm *sm)
+{
+    return (sm->shiftctrl & (1u << 30)) ? 8 : (sm->shiftctrl & (1u << 31)) ? 0 : 4;
+}
+
+static int simPioRxDepth(SimPioSm *sm)
+{
+    return (sm->shiftctrl & (1u << 31)) ? 8 : (sm->shiftctrl & (1u << 30)) ? 0 : 4;
+}
+
+static uint32_t simPioThreshold(uint32_t bits)
+{
+    return bits ? bits : 32;                                    // PULL_THRESH/PUSH_THRESH: 0 means 32
+}
+
+/* Wakes up the stalled state machines at ps, on their next clock edge */
+static void simPioWake(uint64_t ps)
+{
+    for (int p = 0; p < SIM_PIO_BLOCKS; p++)
+    {
+        for (int n = 0; n < 4; n++)
+        {
+            SimPioSm *sm = &simPio[p].sm[n];
+            if (sm->stalled)
+            {
+                double period = simPioPeriodPs(sm);
+                if (sm->nextPs < ps)
+                {
+                    uint64_t cycles = (uint64_t)((ps - sm->nextPs) / period);
+                    sm->nextPs += period * ((sm->nextPs + period * cycles < ps) ? cycles + 1 : cycles);
+                }
+                sm->stalled = 0;
+            }
+        }
+    }
+}
+
+/* Writes count pins (or pin directions) from base, wrapping at 32 */
+static void simPioWritePins(int p, uint32_t base, uint32_t count, uint32_t value, int dirs, uint64_t ps)
+{
+    SimPio *pio = &simPio[p];
+    uint32_t *reg = dirs ? &pio->pindirs : &pio->pins;
+    uint32_t old = *reg;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t bit = 1u << ((base + i) & 31);
+        *reg = ((value >> i) & 1) ? (*reg | bit) : (*reg & ~bit);
+    }
+    if (*reg != old)
+    {
+        simGpioChanged(p, ps);
+    }
+}
+
+/* The GPIO levels seen by IN/MOV pins: rotated so that IN_BASE is bit 0 */
+static uint32_t simPioInputs(SimPioSm *sm)
+{
+    uint32_t base = (sm->pinctrl >> 15) & 0x1f;
+    return base ? ((simGpioLevel >> base) | (simGpioLevel << (32 - base))) : simGpioLevel;
+}
+
+/* Block and flag of an IRQ index: bits 4:3 select this block, the previous
+   one, relative to the state machine, or the next one */
+static SimPio *simPioIrqFlag(int p, int n, uint32_t index, uint32_t *flag)
+{
+    switch ((index >> 3) & 3)
+    {
+        case 1:  *flag = index & 7; return &simPio[(p + SIM_PIO_BLOCKS - 1) % SIM_PIO_BLOCKS];
+        case 2:  *flag = (index & 4) | ((index + n) & 3); return &simPio[p];
+        case 3:  *flag = index & 7; return &simPio[(p + 1) % SIM_PIO_BLOCKS];
+        default: *flag = index & 7; return &simPio[p];
+    }
+}
+
+static uint32_t simPioReverse(uint32_t value)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < 32; i++)
+    {
+        reversed |= ((value >> i) & 1) << (31 - i);
+    }
+    return reversed;
+}
+
+/* Executes one instruction, returns 0 when it stalls, 2 when it jumped */
+static int simPioOp(int p, int n, uint32_t instr, uint64_t ps)
+{
+    SimPio *pio = &simPio[p];
+    SimPioSm *sm = &pio->sm[n];
+    uint32_t index = instr & 0x1f;
+    uint32_t bits = index ? index : 32;
+    uint32_t mask = (bits == 32) ? 0xffffffffu : ((1u << bits) - 1);
+    uint32_t pullThresh = simPioThreshold((sm->shiftctrl >> 25) & 0x1f);
+    uint32_t pushThresh = simPioThreshold((sm->shiftctrl >> 20) & 0x1f);
+    uint32_t data;
+    uint32_t flag;
+    SimPio *target;
+    switch (instr >> 13)
+    {
+        case 0:                                                 // JMP
+        {
+            int taken;
+            switch ((instr >> 5) & 7)
+            {
+                case 1:  taken = (sm->x == 0); break;
+                case 2:  taken = (sm->x != 0); sm->x--; break;
+                case 3:  taken = (sm->y == 0); break;
+                case 4:  taken = (sm->y != 0); sm->y--; break;
+                case 5:  taken = (sm->x != sm->y); break;
+                case 6:  taken = (simGpioLevel >> ((sm->execctrl >> 24) & 0x1f)) & 1; break;
+                case 7:  taken = (sm->osrCount < pullThresh); break;
+                default: taken = 1; break;
+            }
+            if (taken)
+            {
+                sm->pc = index;
+                return 2;
+            }
+            return 1;
+        }
+        case 1:                                                 // WAIT
+        {
+            uint32_t polarity = (instr >> 7) & 1;
+            switch ((instr >> 5) & 3)
+            {
+                case 0:  return ((simGpioLevel >> index) & 1) == polarity;
+                case 1:  return ((simPioInputs(sm) >> index) & 1) == polarity;
+                case 2:
+                    target = simPioIrqFlag(p, n, index, &flag);
+                    if (((target->irq >> flag) & 1) != polarity)
+                    {
+                        return 0;
+                    }
+                    if (polarity)
+                    {
+                        target->irq &= ~(1u << flag);           // wait 1 irq clears the flag
+                        simPioWake(ps);
+                    }
+                    return 1;
+                default: return ((simGpioLevel >> (((sm->execctrl >> 24) + index) & 0x1f)) & 1) == polarity;
+            }
+        }
+        case 2:                                                 // IN
+        {
+            if ((sm->shiftctrl & (1u << 16)) && (sm->isrCount >= pushThresh))
+            {
+                if (sm->rx.count >= simPioRxDepth(sm))
+                {
+                    return 0;                                   // autopush: RX FIFO full
+                }
+                simFifoPush(&sm->rx, sm->isr);
+                sm->isr = sm->isrCount = 0;
+                simDmaRun();
+            }
+            switch ((instr >> 5) & 7)
+            {
+                case 0:  data = simPioInputs(sm); break;
+                case 1:  data = sm->x; break;
+                case 2:  data = sm->y; break;
+                case 6:  data = sm->isr; break;
+                case 7:  data = sm->osr; break;
+                default: data = 0; break;
+            }
+            data &= mask;
+            if (bits == 32)
+            {
+                sm->isr = data;
+            }
+            else if (sm->shiftctrl & (1u << 18))
+            {
+                sm->isr = (sm->isr >> bits) | (data << (32 - bits));
+            }
+            else
+            {
+                sm->isr = (sm->isr << bits) | data;
+            }
+            sm->isrCount = (sm->isrCount + bits > 32) ? 32 : sm->isrCount + bits;
+            if ((sm->shiftctrl & (1u << 16)) && (sm->isrCount >= pushThresh) && (sm->rx.count < simPioRxDepth(sm)))
+            {
+                simFifoPush(&sm->rx, sm->isr);
+                sm->isr = sm->isrCount = 0;
+                simDmaRun();
+            }
+            return 1;
+        }
+        case 3:                                                 // OUT
+        {
+            if ((sm->shiftctrl & (1u << 17)) && (sm->osrCount >= pullThresh))
+            {
+                if (sm->tx.count == 0)
+                {
+                    return 0;                                   // autopull: TX FIFO empty
+                }
+                sm->osr = simFifoPop(&sm->tx);
+                sm->osrCount = 0;
+                simDmaRun();
+            }
+            if (bits == 32)
+            {
+                data = sm->osr;
+                sm->osr = 0;
+            }
+            else if (sm->shiftctrl & (1u << 19))
+            {
+                data = sm->osr & mask;
+                sm->osr >>= bits;
+            }
+            else
+            {
+                data = sm->osr >> (32 - bits);
+                sm->osr <<= bits;
+            }
+            sm->osrCount = (sm->osrCount + bits > 32) ? 32 : sm->osrCount + bits;
+            switch ((instr >> 5) & 7)
+            {
+                case 0:  simPioWritePins(p, sm->pinctrl & 0x1f, (sm->pinctrl >> 20) & 0x3f, data, 0, ps); break;
+                case 1:  sm->x = data; break;
+                case 2:  sm->y = data; break;
+                case 4:  simPioWritePins(p, sm->pinctrl & 0x1f, (sm->pinctrl >> 20) & 0x3f, data, 1, ps); break;
+                case 5:  sm->pc = data & 0x1f; return 2;
+                case 6:  sm->isr = data; sm->isrCount = bits; break;
+                case 7:  sm->exec = data & 0xffff; sm->execPending = 1; break;
+                default: break;
+            }
+            return 1;
+        }
+        case 4:                                                 // PUSH/PULL
+            if (instr & (1u << 7))                              // PULL
+            {
+                if ((instr & (1u << 6)) && (sm->osrCount < pullThresh))
+                {
+                    return 1;                                   // ifempty: OSR not empty yet
+                }
+                if (sm->tx.count == 0)
+                {
+                    if (instr & (1u << 5))
+                    {
+                        pio->fdebug |= 1u << (24 + n);          // TXSTALL
+                        return 0;
+                    }
+                    sm->osr = sm->x;                            // non blocking: copies X
+                }
+                else
+                {
+                    sm->osr = simFifoPop(&sm->tx);
+                    simDmaRun();                                // TX DREQ: room in the FIFO
+                }
+                sm->osrCount = 0;
+                return 1;
+            }
+            if ((instr & (1u << 6)) && (sm->isrCount < pushThresh))
+            {
+                return 1;                                       // iffull: ISR not full yet
+            }
+            if (sm->rx.count >= simPioRxDepth(sm))
+            {
+                pio->fdebug |= 1u << n;                         // RXSTALL
+                if (instr & (1u << 5))
+                {
+                    return 0;
+                }
+            }
+            else
+            {
+                simFifoPush(&sm->rx, sm->isr);
+                simDmaRun();                                    // RX DREQ: data in the FIFO
+            }
+            sm->isr = sm->isrCount = 0;
+            return 1;
+        case 5:                                                 // MOV
+        {
+            switch (instr & 7)
+            {
+                case 0:  data = simPioInputs(sm); break;
+                case 1:  data = sm->x; break;
+                case 2:  data = sm->y; break;
+                case 5:
+                {
+                    int level = ((sm->execctrl >> 5) & 3) ? sm->rx.count : sm->tx.count;
+                    data = (level < (int)(sm->execctrl & 0x1f)) ? 0xffffffffu : 0;
+                    break;
+                }
+                case 6:  data = sm->isr; break;
+                case 7:  data = sm->osr; break;
+                default: data = 0; break;
+            }
+            switch ((instr >> 3) & 3)
+            {
+                case 1:  data = ~data; break;
+                case 2:  data = simPioReverse(data); break;
+                default: break;
+            }
+            switch ((instr >> 5) & 7)
+            {
+                case 0:  simPioWritePins(p, sm->pinctrl & 0x1f, (sm->pinctrl >> 20) & 0x3f, data, 0, ps); break;
+                case 1:  sm->x = data; break;
+                case 2:  sm->y = data; break;
+                case 3:  simPioWritePins(p, sm->pinctrl & 0x1f, (sm->pinctrl >> 20) & 0x3f, data, 1, ps); break;
+                case 4:  sm->exec = data & 0xffff; sm->execPending = 1; break;
+                case 5:  sm->pc = data & 0x1f; return 2;
+                case 6:  sm->isr = data; sm->isrCount = 0; break;
+                case 7:  sm->osr = data; sm->osrCount = 0; break;
+            }
+            return 1;
+        }
+        case 6:                                                 // IRQ
+            target = simPioIrqFlag(p, n, index, &flag);
+            if (sm->irqWait)
+            {
+                if ((target->irq >> flag) & 1)
+                {
+                    return 0;                                   // irq wait: not cleared yet
+                }
+                sm->irqWait = 0;
+                return 1;
+            }
+            if (instr & (1u << 6))
+            {
+                target->irq &= ~(1u << flag);
+            }
+            else
+            {
+                target->irq |= 1u << flag;
+                if (instr & (1u << 5))
+                {
+                    sm->irqWait = 1;
+                    simPioWake(ps);
+                    return 0;
+                }
+            }
+            simPioWake(ps);
+            return 1;
+        default:                                                // SET
+            switch ((instr >> 5) & 7)
+            {
+                case 0:  simPioWritePins(p, (sm->pinctrl >> 5) & 0x1f, (sm->pinctrl >> 26) & 0x7, index, 0, ps); break;
+                case 1:  sm->x = index; break;
+                case 2:  sm->y = index; break;
+                case 4:  simPioWritePins(p, (sm->pinctrl >> 5) & 0x1f, (sm->pinctrl >> 26) & 0x7, index, 1, ps); break;
+                default: break;
+            }
+            return 1;
+    }
+}
+
+/* Runs an instruction: side-set, operation, then the delay and the next pc.
+   forced: written to SMx_INSTR, the pc does not move. */
+static void simPioExecute(int p, int n, uint32_t instr, int forced, uint64_t ps)
+{
+    SimPio *pio = &simPio[p];
+    SimPioSm *sm = &pio->sm[n];
+    uint32_t count = sm->pinctrl >> 29;                         // side-set bits, enable bit included
+    uint32_t field = (instr >> 8) & 0x1f;
+    uint32_t side = field >> (5 - count);
+    if (count && (!(sm->execctrl & (1u << 30)) || ((side >> (count - 1)) & 1)))
+    {
+        uint32_t sideBits = (sm->execctrl & (1u << 30)) ? count - 1 : count;
+        simPioWritePins(p, (sm->pinctrl >> 10) & 0x1f, sideBits, side, (sm->execctrl >> 29) & 1, ps);
+    }
+    sm->execPending = 0;
+    int result = simPioOp(p, n, instr, ps);
+    if (result == 0)
+    {
+        sm->stalled = 1;
+        sm->exec = instr;                                       // a forced instruction stays latched
+        sm->execPending = forced;
+        return;
+    }
+    sm->instructions++;
+    sm->delay = field & ((1u << (5 - count)) - 1);
+    if ((result == 1) && !forced)
+    {
+        uint32_t wrapTop = (sm->execctrl >> 12) & 0x1f;
+        sm->pc = (sm->pc == wrapTop) ? ((sm->execctrl >> 7) & 0x1f) : ((sm->pc + 1) & 0x1f);
+    }
+}
+
+/* One clock cycle of a state machine */
+static void simPioCycle(int p, int n)
+{
+    SimPio *pio = &simPio[p];
+    SimPioSm *sm = &pio->sm[n];
+    uint64_t ps = (uint64_t)sm->nextPs;
+    sm->nextPs += simPioPeriodPs(sm);
+    if (sm->delay)
+    {
+        sm->delay--;
+        return;
+    }
+    int forced = sm->execPending;
+    simPioExecute(p, n, forced ? sm->exec : pio->instr[sm->pc], forced, ps);
+}
+
+/* Steps the enabled state machines, in time order, up to nowPs */
+static void simPioAdvance(uint64_t nowPs)
+{
+    static int running;
+    if (running)
+    {
+        return;
+    }
+    running = 1;
+    for (;;)
+    {
+        int next = -1;
+        double nextPs = (double)nowPs;
+        for (int i = 0; i < 4 * SIM_PIO_BLOCKS; i++)
+        {
+            SimPioSm *sm = &simPio[i / 4].sm[i % 4];
+            if (!(simResets & (SIM_RESET_PIO0 << (i / 4))) && ((simPio[i / 4].ctrl >> (i % 4)) & 1) &&
+                !sm->stalled && (sm->nextPs <= nextPs))
+            {
+                next = i;
+                nextPs = sm->nextPs;
+            }
+        }
+        if (next < 0)
+        {
+            break;
+        }
+        simPioCycle(next / 4, next % 4);
+    }
+    running = 0;
+}
+
+/* Next clock cycle of a running state machine, when the cores may wait for
+   it: PIO interrupts enabled, or a DMA channel paced by a PIO DREQ that
+   raises its interrupt */
+static uint64_t simPioNextPs(void)
+{
+    int wanted = 0;
+    uint64_t next = UINT64_MAX;
+    for (int p = 0; p < SIM_PIO_BLOCKS; p++)
+    {
+        wanted |= (simPio[p].inte[0] | simPio[p].inte[1] | simPio[p].intf[0] | simPio[p].intf[1]) != 0;
+    }
+    for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++)
+    {
+        wanted |= simDma[ch].busy && (((simDma[ch].ctrl >> 17) & 0x3f) < SIM_PIO_DREQS) &&
+                  !(simDma[ch].ctrl & (1 << 23)) && ((simDmaInte[0] | simDmaInte[1] | simDmaInte[2] | simDmaInte[3]) & (1u << ch));
+    }
+    for (int i = 0; wanted && (i < 4 * SIM_PIO_BLOCKS); i++)
+    {
+        SimPioSm *sm = &simPio[i / 4].sm[i % 4];
+        if (!(simResets & (SIM_RESET_PIO0 << (i / 4))) && ((simPio[i / 4].ctrl >> (i % 4)) & 1) &&
+            !sm->stalled && ((uint64_t)sm->nextPs < next))
+        {
+            next = (uint64_t)sm->nextPs;
+        }
+    }
+    return next;
+}
+
+/* DREQ of a TX FIFO (not full) or of an RX FIFO (not empty) */
+static int simPioDreq(uint32_t treq)
+{
+    SimPio *pio = &simPio[treq / 8];
+    SimPioSm *sm = &pio->sm[treq & 3];
+    if (simResets & (SIM_RESET_PIO0 << (treq / 8)))
+    {
+        return 0;
+    }
+    return (treq & 4) ? (sm->rx.count > 0) : (sm->tx.count < simPioTxDepth(sm));
+}
+
+/* INTR: RXNEMPTY (3:0), TXNFULL (7:4) and the IRQ flags (15:8) */
+static uint32_t simPioIntr(SimPio *pio)
+{
+    uint32_t intr = pio->irq << 8;
+    for (int n = 0; n < 4; n++)
+    {
+        intr |= (pio->sm[n].rx.count > 0) ? (1u << n) : 0;
+        intr |= (pio->sm[n].tx.count < simPioTxDepth(&pio->sm[n])) ? (1u << (4 + n)) : 0;
+    }
+    return intr;
+}
+
+static uint32_t simPioRead(int p, uint32_t offset)
+{
+    SimPio *pio = &simPio[p];
+    simPioAdvance(simNowPs());
+    if ((offset >= 0x0c8) && (offset < 0x128))
+    {
+        SimPioSm *sm = &pio->sm[(offset - 0x0c8) / 0x18];
+        switch ((offset - 0x0c8) % 0x18)
+        {
+            case 0x00: return sm->clkdiv;
+            case 0x04: return sm->execctrl | (sm->execPending ? (1u << 31) : 0);     // EXEC_STALLED
+            case 0x08: return sm->shiftctrl;
+            case 0x0c: return sm->pc;                                               // ADDR
+            case 0x10: return sm->execPending ? sm->exec : pio->instr[sm->pc];      // INSTR
+            default:   return sm->pinctrl;
+        }
+    }
+    if ((offset >= 0x020) && (offset < 0x030))                  // RXFn
+    {
+        SimPioSm *sm = &pio->sm[(offset - 0x020) / 4];
+        if (sm->rx.count == 0)
+        {
+            pio->fdebug |= 1u << (8 + (offset - 0x020) / 4);    // RXUNDER
+            return 0;
+        }
+        uint32_t value = simFifoPop(&sm->rx);
+        simPioWake(simNowPs());                                 // a push may be waiting for room
+        return value;
+    }
+    if ((offset >= 0x048) && (offset < 0x0c8))
+    {
+        return pio->instr[(offset - 0x048) / 4];
+    }
+    switch (offset)
+    {
+        case 0x000: return pio->ctrl;
+        case 0x004:                                             // FSTAT
+        {
+            uint32_t fstat = 0;
+            for (int n = 0; n < 4; n++)
+            {
+                SimPioSm *sm = &pio->sm[n];
+                fstat |= (sm->rx.count >= simPioRxDepth(sm)) ? (1u << n) : 0;
+                fstat |= (sm->rx.count == 0) ? (1u << (8 + n)) : 0;
+                fstat |= (sm->tx.count >= simPioTxDepth(sm)) ? (1u << (16 + n)) : 0;
+                fstat |= (sm->tx.count == 0) ? (1u << (24 + n)) : 0;
+            }
+            return fstat;
+        }
+        case 0x008: return pio->fdebug;
+        case 0x00c:                                             // FLEVEL
+        {
+            uint32_t flevel = 0;
+            for (int n = 0; n < 4; n++)
+            {
+                flevel |= ((pio->sm[n].tx.count & 0xf) | ((pio->sm[n].rx.count & 0xf) << 4)) << (8 * n);
+            }
+            return flevel;
+        }
+        case 0x030: return pio->irq;
+        case 0x03c: return pio->pins;                           // DBG_PADOUT
+        case 0x040: return pio->pindirs;                        // DBG_PADOE
+        case 0x044: return (1u << 28) | (32 << 16) | (4 << 8) | 4;   // DBG_CFGINFO: v1, 32 instructions, 4 SMs, depth 4
+        case 0x16c: return simPioIntr(pio);
+        case 0x170: case 0x17c: return pio->inte[(offset - 0x170) / 0xc];
+        case 0x174: case 0x180: return pio->intf[(offset - 0x174) / 0xc];
+        case 0x178: case 0x184:                                 // IRQn_INTS
+            return (simPioIntr(pio) & pio->inte[(offset - 0x178) / 0xc]) | pio->intf[(offset - 0x178) / 0xc];
+        default:    return *simStoreSlot(SIM_PIO0 + 0x100000 * p + offset);
+    }
+}
+
+static void simPioWrite(int p, uint32_t offset, uint32_t value, uint32_t alias)
+{
+    SimPio *pio = &simPio[p];
+    uint64_t now = simNowPs();
+    simPioAdvance(now);
+    if ((offset >= 0x0c8) && (offset < 0x128))
+    {
+        int n = (offset - 0x0c8) / 0x18;
+        SimPioSm *sm = &pio->sm[n];
+        switch ((offset - 0x0c8) % 0x18)
+        {
+            case 0x00: sm->clkdiv = simAlias(sm->clkdiv, value, alias) & 0xffffff00; break;
+            case 0x04: sm->execctrl = simAlias(sm->execctrl, value, alias) & 0x7fffffff; break;
+            case 0x08:
+            {
+                uint32_t old = sm->shiftctrl;
+                sm->shiftctrl = simAlias(sm->shiftctrl, value, alias);
+                if ((old ^ sm->shiftctrl) & (3u << 30))         // FJOIN changed: both FIFOs are cleared
+                {
+                    sm->tx.count = sm->rx.count = 0;
+                    simPioWake(now);
+                }
+                break;
+            }
+            case 0x0c: break;                                   // ADDR is read only
+            case 0x10: simPioExecute(p, n, value & 0xffff, 1, now); break;
+            default:   sm->pinctrl = simAlias(sm->pinctrl, value, alias); break;
+        }
+        simDmaRun();
+        return;
+    }
+    if ((offset >= 0x010) && (offset < 0x020))                  // TXFn
+    {
+        SimPioSm *sm = &pio->sm[(offset - 0x010) / 4];
+        if (sm->tx.count >= simPioTxDepth(sm))
+        {
+            pio->fdebug |= 1u << (16 + (offset - 0x010) / 4);   // TXOVER: the word is lost
+            return;
+        }
+        simFifoPush(&sm->tx, value);
+        simPioWake(now);
+        return;
+    }
+    if ((offset >= 0x048) && (offset < 0x0c8))
+    {
+        pio->instr[(offset - 0x048) / 4] = simAlias(pio->instr[(offset - 0x048) / 4], value, alias) & 0xffff;
+        return;
+    }
+    switch (offset)
+    {
+        case 0x000:                                             // CTRL
+        {
+            uint32_t strobes = (alias == 1 || alias == 3) ? 0 : value;
+            uint32_t enabled = simAlias(pio->ctrl, value, alias) & 0xf;
+            for (int n = 0; n < 4; n++)
+            {
+                SimPioSm *sm = &pio->sm[n];
+                if (strobes & (1u << (4 + n)))                  // SM_RESTART
+                {
+                    sm->isr = sm->isrCount = sm->delay = 0;
+                    sm->osrCount = 32;
+                    sm->execPending = sm->stalled = sm->irqWait = 0;
+                }
+                if ((strobes & (1u << (8 + n))) || ((enabled & ~pio->ctrl) & (1u << n)))
+                {
+                    sm->nextPs = now;                           // CLKDIV_RESTART, or enabled now
+                    sm->stalled = 0;
+                }
+            }
+            pio->ctrl = enabled;
+            break;
+        }
+        case 0x008: pio->fdebug &= ~value; break;               // write 1 to clear
+        case 0x030: pio->irq &= ~value & 0xff; simPioWake(now); break;
+        case 0x034: pio->irq |= value & 0xff; simPioWake(now); break;   // IRQ_FORCE
+        case 0x170: case 0x17c:
+            pio->inte[(offset - 0x170) / 0xc] = simAlias(pio->inte[(offset - 0x170) / 0xc], value, alias) & 0xffff;
+            break;
+        case 0x174: case 0x180:
+            pio->intf[(offset - 0x174) / 0xc] = simAlias(pio->intf[(offset - 0x174) / 0xc], value, alias) & 0xffff;
+            break;
+        default:
+        {
+            uint32_t *reg = simStoreSlot(SIM_PIO0 + 0x100000 * p + offset);
+            *reg = simAlias(*reg, value, alias);
+            break;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   SHA-256: the message words written into WDATA (bytes and halfwords are
+   gathered into words, BSWAP applied) are hashed block by block with the real
+   compression function. After the 16th word of a block the core is busy for
+   SIM_SHA256_CYCLES: WDATA_RDY and SUM_VLD are low and the DREQ is off.
+   See section 12.13 "SHA-256 accelerator" on RP2350 datasheet.
+*/
+static const uint32_t simShaK[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static uint32_t simShaRotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static void simShaStart(void)
+{
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    for (int i = 0; i < 8; i++)
+    {
+        simSha.h[i] = initial[i];
+    }
+    simSha.words = simSha.partialBytes = 0;
+    simSha.partial = 0;
+    simSha.busy = 0;
+    simSha.sumValid = 1;
+}
+
+static void simShaCompress(void)
+{
+    uint32_t w[64];
+    uint32_t v[8];
+    for (int i = 0; i < 64; i++)
+    {
+        if (i < 16)
+        {
+            w[i] = simSha.block[i];
+        }
+        else
+        {
+            uint32_t s0 = simShaRotr(w[i - 15], 7) ^ simShaRotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = simShaRotr(w[i - 2], 17) ^ simShaRotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        v[i] = simSha.h[i];
+    }
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t s1 = simShaRotr(v[4], 6) ^ simShaRotr(v[4], 11) ^ simShaRotr(v[4], 25);
+        uint32_t t1 = v[7] + s1 + ((v[4] & v[5]) ^ (~v[4] & v[6])) + simShaK[i] + w[i];
+        uint32_t s0 = simShaRotr(v[0], 2) ^ simShaRotr(v[0], 13) ^ simShaRotr(v[0], 22);
+        uint32_t t2 = s0 + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+        for (int j = 7; j > 0; j--)
+        {
+            v[j] = v[j - 1];
+        }
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        simSha.h[i] += v[i];
+    }
+}
+
+/* End of the block being hashed */
+static void simShaAdvance(void)
+{
+    if (simSha.busy && (simNowPs() >= simSha.readyPs))
+    {
+        simSha.busy = 0;
+        simSha.sumValid = 1;
+        simDmaRun();                            // DREQ: room for the next block
+    }
+}
+
+static int simShaDreq(void)
+{
+    return !(simResets & SIM_RESET_SHA256) && !simSha.busy;
+}
+
+/* A word of the message. Written while busy it is lost (ERR_WDATA_NOT_RDY). */
+static void simShaWord(uint32_t word)
+{
+    if (simSha.busy)
+    {
+        simSha.errNotReady = 1;
+        return;
+    }
+    if (simSha.csr & (1u << 12))                                    // BSWAP
+    {
+        word = (word >> 24) | ((word >> 8) & 0xff00) | ((word << 8) & 0xff0000) | (word << 24);
+    }
+    simSha.block[simSha.words++] = word;
+    simSha.sumValid = 0;
+    if (simSha.words == 16)
+    {
+        simShaCompress();
+        simSha.words = 0;
+        simSha.busy = 1;
+        simSha.readyPs = simNowPs() + (uint64_t)(SIM_SHA256_CYCLES * simPsPerCycle);
+        simSha.blocks++;
+    }
+}
+
+static uint32_t simShaRead(uint32_t offset)
+{
+    simShaAdvance();
+    switch (offset)
+    {
+        case 0x00:                                                  // CSR
+            return simSha.csr | (simSha.errNotReady ? (1u << 4) : 0) |
+                   (simSha.sumValid ? (1u << 2) : 0) | (!simSha.busy ? (1u << 1) : 0);
+        case 0x08: case 0x0c: case 0x10: case 0x14: case 0x18: case 0x1c: case 0x20: case 0x24:
+            return simSha.h[(offset - 0x08) / 4];                   // SUM0-7
+        default:
+            return 0;                                               // WDATA is write only
+    }
+}
+
+static void simShaWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    simShaAdvance();
+    if (offset == 0x00)
+    {
+        uint32_t set = (alias == 3) ? 0 : value;                    // START and the W1C flag
+        simSha.csr = simAlias(simSha.csr, value, alias) & 0x1300;  // DMA_SIZE, BSWAP
+        if (set & (1u << 4))
+        {
+            simSha.errNotReady = 0;
+        }
+        if (set & 1)
+        {
+            simShaStart();
+        }
+    }
+    else if (offset == 0x04)                                        // WDATA, in bus transfers of simBusSize bytes
+    {
+        simSha.partial |= (value & (0xffffffffu >> (8 * (4 - simBusSize)))) << (8 * simSha.partialBytes);
+        simSha.partialBytes += simBusSize;
+        if (simSha.partialBytes >= 4)
+        {
+            simShaWord(simSha.partial);
+            simSha.partial = 0;
+            simSha.partialBytes = 0;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   DMA: 16 channels with the 4 register aliases, chaining, rings, null
+   triggers (IRQ_QUIET) and DREQ pacing for the PIO, UART and SHA-256 requests. Channels
+   with a permanent request complete at once, paced channels move one transfer
+   each time their peripheral can take (or give) data.
+   See section 12.6 "DMA" on RP2350 datasheet.
+*/
+static int simDmaReady(uint32_t treq)
+{
+    if (treq == SIM_DREQ_FORCE)
+    {
+        return 1;
+    }
+    if (treq < SIM_PIO_DREQS)
+    {
+        return simPioDreq(treq);
+    }
+    if (treq == SIM_DREQ_SHA256)
+    {
+        return simShaDreq();
+    }
+    if ((treq >= SIM_DREQ_UART0_TX) && (treq <= SIM_DREQ_UART0_TX + 3))
+    {
+        SimUart *uart = &simUart[(treq - SIM_DREQ_UART0_TX) / 2];
+        if ((simResets & uart->resetBit) || !(uart->cr & 1))
+        {
+            return 0;
+        }
+        if ((treq & 1) == 0)
+        {
+            return (uart->dmacr & 2) && (uart->txCount < simUartDepth(uart));   // TXDMAE, FIFO not full
+        }
+        return (uart->dmacr & 1) && (uart->rxCount > 0);                        // RXDMAE, FIFO not empty
+    }
+    return 0;                                                   // other requests are not modelled
+}
+
+static void simDmaTrigger(int ch)
+{
+    SimDmaChannel *chan = &simDma[ch];
+    if (chan->ctrl & 1)                                         // EN
+    {
+        chan->count = chan->countReload & 0x0fffffff;
+        chan->endless = (chan->countReload >> 28) == 0xf;       // MODE ENDLESS: the count does not decrement
+        chan->busy = 1;
+    }
+}
+
+/* Next address of a channel, honouring the ring (RING_SIZE/RING_SEL) */
+static uint32_t simDmaStep(uint32_t addr, uint32_t ctrl, int write)
+{
+    uint32_t size = 1u << ((ctrl >> 2) & 0x3);
+    uint32_t ring = (((ctrl >> 12) & 1) == (uint32_t)write) ? ((ctrl >> 8) & 0xf) : 0;
+    uint32_t incr = (ctrl >> (write ? 6 : 4)) & 0x3;            // INCR, INCR_REV
+    uint32_t next = (incr == 1) ? addr + size : (incr == 3) ? addr - size : addr;
+    if (ring)
+    {
+        uint32_t mask = (1u << ring) - 1;
+        next = (addr & ~mask) | (next & mask);
+    }
+    return next;
+}
+
+static uint32_t simDmaLoad(uint32_t addr, uint32_t size)
+{
+    if (addr >= 0x40000000u)
+    {
+        return simBusRead(addr & ~3u) >> (8 * (addr & 3));
+    }
+    uint32_t value = 0;
+    memcpy(&value, (const void *)(uintptr_t)addr, size);        // host memory (DMA buffers must be static)
+    return value;
+}
+
+static void simDmaStore(uint32_t addr, uint32_t value, uint32_t size)
+{
+    if (addr >= 0x40000000u)
+    {
+        simBusSize = size;
+        simBusWrite(addr & ~3u, (size == 4) ? value : (value & ((1u << (8 * size)) - 1)));
+        simBusSize = 4;
+        return;
+    }
+    memcpy((void *)(uintptr_t)addr, &value, size);
+}
+
+static void simDmaRun(void)
+{
+    static int running;
+    int progress = 1;
+    if (running || (simResets & SIM_RESET_DMA))
+    {
+        return;
+    }
+    running = 1;
+    while (progress)
+    {
+        progress = 0;
+        for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++)
+        {
+            SimDmaChannel *chan = &simDma[ch];
+            uint32_t size = 1u << ((chan->ctrl >> 2) & 0x3);
+            while (chan->busy && ((chan->count > 0) || chan->endless) && simDmaReady((chan->ctrl >> 17) & 0x3f))
+            {
+                simDmaStore(chan->write, simDmaLoad(chan->read, size), size);
+                chan->read = simDmaStep(chan->read, chan->ctrl, 0);
+                chan->write = simDmaStep(chan->write, chan->ctrl, 1);
+                chan->count -= chan->endless ? 0 : 1;
+                chan->transfers++;
+                progress = 1;
+            }
+            if (chan->busy && (chan->count == 0) && !chan->endless)
+            {
+                uint32_t chainTo = (chan->ctrl >> 13) & 0xf;
+                chan->busy = 0;
+                if (!(chan->ctrl & (1 << 23)))                  // IRQ_QUIET
+                {
+                    simDmaIntr |= 1u << ch;
+                }
+                if (chainTo != (uint32_t)ch)
+                {
+                    simDmaTrigger(chainTo);
+                }
+                progress = 1;
+            }
+        }
+    }
+    running = 0;
+}
+
+static uint32_t simDmaRead(uint32_t offset)
+{
+    if (offset < 0x40 * SIM_DMA_CHANNELS)
+    {
+        SimDmaChannel *chan = &simDma[offset / 0x40];
+        uint32_t ctrl = chan->ctrl | (chan->busy ? (1u << 26) : 0);
+        switch (offset & 0x3f)
+        {
+            case 0x00: case 0x14: case 0x28: return chan->read;                             // READ_ADDR
+            case 0x04: case 0x18: case 0x34: return chan->write;                            // WRITE_ADDR
+            case 0x08: case 0x1c: case 0x24: case 0x38: return chan->count;                 // TRANS_COUNT
+            default:                         return ctrl;                                   // CTRL
+        }
+    }
+    switch (offset)
+    {
+        case 0x400: case 0x410: case 0x420: case 0x430:
+            return simDmaIntr;                                  // INTRn: raw status
+        case 0x404: case 0x414: case 0x424: case 0x434:
+            return simDmaInte[(offset - 0x400) / 0x10];         // INTEn
+        case 0x408: case 0x418: case 0x428: case 0x438:
+            return simDmaIntf[(offset - 0x400) / 0x10];         // INTFn
+        case 0x40c: case 0x41c: case 0x42c: case 0x43c:         // INTSn
+            return (simDmaIntr & simDmaInte[(offset - 0x400) / 0x10]) | simDmaIntf[(offset - 0x400) / 0x10];
+        default:
+            return 0;
+    }
+}
+
+static void simDmaWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    if (offset < 0x40 * SIM_DMA_CHANNELS)
+    {
+        int ch = offset / 0x40;
+        SimDmaChannel *chan = &simDma[ch];
+        uint32_t reg = offset & 0x3f;
+        switch (reg)
+        {
+            case 0x00: case 0x14: case 0x28: case 0x3c: chan->read = simAlias(chan->read, value, alias); break;
+            case 0x04: case 0x18: case 0x2c: case 0x34: chan->write = simAlias(chan->write, value, alias); break;
+            case 0x08: case 0x1c: case 0x24: case 0x38: chan->countReload = simAlias(chan->countReload, value, alias); break;
+            default:                                    chan->ctrl = simAlias(chan->ctrl, value, alias) & 0x03ffffff; break;
+        }
+        if ((reg & 0xc) == 0xc)                                 // the last register of each alias is a trigger
+        {
+            if (value == 0)
+            {
+                if (chan->ctrl & (1 << 23))                     // null trigger: end of a control block list
+                {
+                    simDmaIntr |= 1u << ch;
+                }
+            }
+            else
+            {
+                simDmaTrigger(ch);
+            }
+        }
+    }
+    else
+    {
+        switch (offset)
+        {
+            case 0x400: case 0x410: case 0x420: case 0x430:     // INTRn: write 1 to clear
+            case 0x40c: case 0x41c: case 0x42c: case 0x43c:     // INTSn: write 1 to clear
+                simDmaIntr &= ~value;
+                break;
+            case 0x404: case 0x414: case 0x424: case 0x434:
+                simDmaInte[(offset - 0x400) / 0x10] = simAlias(simDmaInte[(offset - 0x400) / 0x10], value, alias) & 0xffff;
+                break;
+            case 0x408: case 0x418: case 0x428: case 0x438:
+                simDmaIntf[(offset - 0x400) / 0x10] = simAlias(simDmaIntf[(offset - 0x400) / 0x10], value, alias) & 0xffff;
+                break;
+            case 0x450:                                         // MULTI_CHAN_TRIGGER
+                for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++)
+                {
+                    if (value & (1u << ch))
+                    {
+                        simDmaTrigger(ch);
+                    }
+                }
+                break;
+            case 0x464:                                         // CHAN_ABORT
+                for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++)
+                {
+                    if (value & (1u << ch))
+                    {
+                        simDma[ch].busy = 0;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    simDmaRun();
+}
+
+/* ---------------------------------------------------------------------------
+   TICKS and TIMER0: the tick generators divide clk_ref (CYCLES clk_ref cycles
+   per tick) and TIMER0 counts the ticks in a 64-bit counter. An alarm fires
+   when the lower 32 bits of the counter reach ALARMn, so an alarm armed in the
+   past fires only after the counter wraps (71 minutes at 1 MHz).
+   The cores run with their own time line: an alarm is checked against the
+   time of the core that has its interrupt enabled (any core if none has).
+   See sections 8.5 "Tick generators" and 12.8 "System timers" on RP2350 datasheet.
+*/
+static uint64_t simTickPs(int gen)
+{
+    uint64_t refHz = simClkRefHz();
+    if (!(simTicks[gen][0] & 1) || (simTicks[gen][1] == 0) || (refHz == 0))
+    {
+        return 0;
+    }
+    return (simTicks[gen][1] & 0x1ff) * 1000000000000ull / refHz;
+}
+
+static uint64_t simTimerCount(uint64_t nowPs)
+{
+    if ((simTimer.tickPs == 0) || (nowPs <= simTimer.basePs))
+    {
+        return simTimer.baseCount;
+    }
+    return simTimer.baseCount + (nowPs - simTimer.basePs) / simTimer.tickPs;
+}
+
+/* Restarts counting from the current value after a change of the tick */
+static void simTimerRebase(void)
+{
+    uint64_t now = simNowPs();
+    simTimer.baseCount = simTimerCount(now);
+    simTimer.basePs = now;
+    if ((simResets & SIM_RESET_TIMER0) || (simTimer.pause & 1))
+    {
+        simTimer.tickPs = 0;
+    }
+    else
+    {
+        simTimer.tickPs = (simTimer.source & 1) ? (uint64_t)simPsPerCycle : simTickPs(2);
+    }
+}
+
+/* Core whose time line decides when alarm n fires */
+static SimCore *simTimerOwner(int n)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if ((simCores[i].nvicEnabled >> (SIM_TIMER0_IRQ_0 + n)) & 1)
+        {
+            return &simCores[i];
+        }
+    }
+    return NULL;
+}
+
+static void simTimerUpdate(SimCore *core)
+{
+    uint32_t count = (uint32_t)simTimerCount(core->timePs);
+    for (int n = 0; n < 4; n++)
+    {
+        SimCore *owner = simTimerOwner(n);
+        if (((simTimer.armed >> n) & 1) && ((owner == NULL) || (owner == core)) &&
+            ((uint32_t)(count - simTimer.alarmFrom[n]) >= (uint32_t)(simTimer.alarm[n] - simTimer.alarmFrom[n])))
+        {
+            simTimer.armed &= ~(1u << n);
+            simTimer.intr |= 1u << n;
+        }
+    }
+}
+
+/* Time of the next alarm of the core */
+static uint64_t simTimerNextPs(SimCore *core)
+{
+    uint64_t next = UINT64_MAX;
+    if (simTimer.tickPs == 0)
+    {
+        return next;
+    }
+    uint64_t count = simTimerCount(core->timePs);
+    for (int n = 0; n < 4; n++)
+    {
+        SimCore *owner = simTimerOwner(n);
+        if (((simTimer.armed >> n) & 1) && ((owner == NULL) || (owner == core)))
+        {
+            uint64_t target = count + (uint32_t)(simTimer.alarm[n] - (uint32_t)count);
+            uint64_t ps = simTimer.basePs + (target - simTimer.baseCount) * simTimer.tickPs;
+            next = (ps < next) ? ps : next;
+        }
+    }
+    return next;
+}
+
+static uint32_t simTicksRead(uint32_t offset)
+{
+    int gen = offset / 0xc;
+    if (gen >= 6)
+    {
+        return 0;
+    }
+    switch (offset % 0xc)
+    {
+        case 0x0: return simTicks[gen][0] | ((simTickPs(gen) != 0) ? (1u << 1) : 0);   // CTRL: ENABLE, RUNNING
+        case 0x4: return simTicks[gen][1];                                  // CYCLES
+        default:  return 0;                                                 // COUNT is not modelled
+    }
+}
+
+static void simTicksWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    int gen = offset / 0xc;
+    if ((gen < 6) && ((offset % 0xc) < 0x8))
+    {
+        uint32_t *reg = &simTicks[gen][(offset % 0xc) / 4];
+        *reg = simAlias(*reg, value, alias) & (((offset % 0xc) == 0) ? 0x1 : 0x1ff);
+        simTimerRebase();
+    }
+}
+
+static uint32_t simTimerRead(uint32_t offset)
+{
+    uint64_t count = simTimerCount(simNowPs());
+    simTimerUpdate(simSelf());
+    switch (offset)
+    {
+        case 0x08: return simTimer.latchHigh;                               // TIMEHR
+        case 0x0c: simTimer.latchHigh = (uint32_t)(count >> 32); return (uint32_t)count;   // TIMELR
+        case 0x10: case 0x14: case 0x18: case 0x1c: return simTimer.alarm[(offset - 0x10) / 4];
+        case 0x20: return simTimer.armed;
+        case 0x24: return (uint32_t)(count >> 32);                          // TIMERAWH
+        case 0x28: return (uint32_t)count;                                  // TIMERAWL
+        case 0x2c: return simTimer.dbgpause;
+        case 0x30: return simTimer.pause;
+        case 0x38: return simTimer.source;
+        case 0x3c: return simTimer.intr;
+        case 0x40: return simTimer.inte;
+        case 0x44: return simTimer.intf;
+        case 0x48: return (simTimer.intr & simTimer.inte) | simTimer.intf;  // INTS
+        default:   return 0;
+    }
+}
+
+static void simTimerWrite(uint32_t offset, uint32_t value, uint32_t alias)
+{
+    switch (offset)
+    {
+        case 0x00:                                                          // TIMEHW
+            simTimer.baseCount = ((uint64_t)value << 32) | simTimer.writeLow;
+            simTimer.basePs = simNowPs();
+            break;
+        case 0x04: simTimer.writeLow = value; break;                        // TIMELW
+        case 0x10: case 0x14: case 0x18: case 0x1c:
+        {
+            int n = (offset - 0x10) / 4;
+            simTimer.alarm[n] = value;
+            simTimer.alarmFrom[n] = (uint32_t)simTimerCount(simNowPs());
+            simTimer.armed |= 1u << n;
+            break;
+        }
+        case 0x20: simTimer.armed &= ~(value & 0xf); break;                 // ARMED: write 1 to disarm
+        case 0x2c: simTimer.dbgpause = simAlias(simTimer.dbgpause, value, alias) & 0x6; break;
+        case 0x30: simTimer.pause = simAlias(simTimer.pause, value, alias) & 1; simTimerRebase(); break;
+        case 0x38: simTimer.source = simAlias(simTimer.source, value, alias) & 1; simTimerRebase(); break;
+        case 0x3c: simTimer.intr &= ~(value & 0xf); break;                  // INTR: write 1 to clear
+        case 0x40: simTimer.inte = simAlias(simTimer.inte, value, alias) & 0xf; break;
+        case 0x44: simTimer.intf = simAlias(simTimer.intf, value, alias) & 0xf; break;
+        default:   break;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   NVIC: every core has its own enable/pending/priority registers, VTOR and
+   SysTick. The peripherals drive level sensitive lines: a line that is still
+   high when the handler returns pends the interrupt again.
+   See section 3.7.2 "NVIC" on RP2350 datasheet.
+*/
+static uint64_t simIrqLines(void)
+{
+    uint64_t lines = 0;
+    if (!(simResets & SIM_RESET_TIMER0))
+    {
+        simTimerUpdate(simSelf());
+        lines |= (uint64_t)((simTimer.intr & simTimer.inte) | simTimer.intf) << SIM_TIMER0_IRQ_0;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        simUartAdvance(&simUart[i]);
+        if (!(simResets & simUart[i].resetBit) && (simUart[i].ris & simUart[i].imsc))
+        {
+            lines |= 1ull << (SIM_UART0_IRQ + i);
+        }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        if (!(simResets & SIM_RESET_DMA) && ((simDmaIntr & simDmaInte[i]) | simDmaIntf[i]))
+        {
+            lines |= 1ull << (SIM_DMA_IRQ_0 + i);
+        }
+    }
+    simPioAdvance(simNowPs());
+    simShaAdvance();
+    for (int p = 0; p < SIM_PIO_BLOCKS; p++)
+    {
+        for (int i = 0; (i < 2) && !(simResets & (SIM_RESET_PIO0 << p)); i++)
+        {
+            if ((simPioIntr(&simPio[p]) & simPio[p].inte[i]) | simPio[p].intf[i])
+            {
+                lines |= 1ull << (SIM_PIO0_IRQ_0 + 2 * p + i);
+            }
+        }
+    }
+    return lines;
+}
+
+/* SysTick counts down from RVR to 0 with the processor clock (CLKSOURCE = 1)
+   or with the tick of the core (PROC0/PROC1 tick generator), then reloads */
+static uint64_t simSysTickPs(SimCore *core)
+{
+    if (!(core->systCsr & 1) || (core->systRvr == 0))
+    {
+        return 0;
+    }
+    return (core->systCsr & (1 << 2)) ? (uint64_t)simPsPerCycle : simTickPs(core->id);
+}
+
+static uint64_t simSysTickWraps(SimCore *core)
+{
+    uint64_t tickPs = simSysTickPs(core);
+    if ((tickPs == 0) || (core->timePs <= core->systStartPs))
+    {
+        return 0;
+    }
+    return (core->timePs - core->systStartPs) / (tickPs * (core->systRvr + 1));
+}
+
+/* Pends the SysTick exception once per wrap while TICKINT is set */
+static void simSysTickPoll(SimCore *core)
+{
+    uint64_t wraps = simSysTickWraps(core);
+    if (wraps > core->systWrapsIrq)
+    {
+        core->systWrapsIrq = wraps;
+        if (core->systCsr & (1 << 1))
+        {
+            core->nvicPending |= 1ull << SIM_SYSTICK_IRQ;
+        }
+    }
+}
+
+static uint64_t simSysTickNextPs(SimCore *core)
+{
+    uint64_t tickPs = simSysTickPs(core);
+    if ((tickPs == 0) || !(core->systCsr & (1 << 1)))
+    {
+        return UINT64_MAX;
+    }
+    return core->systStartPs + (core->systWrapsIrq + 1) * tickPs * (core->systRvr + 1);
+}
+
+static void simSysTickRestart(SimCore *core)
+{
+    core->systStartPs = core->timePs;
+    core->systWrapsSeen = core->systWrapsIrq = 0;
+}
+
+static uint32_t simSysTickRead(uint32_t offset)
+{
+    SimCore *core = simSelf();
+    uint64_t tickPs = simSysTickPs(core);
+    switch (offset)
+    {
+        case 0x0:                                               // CSR: COUNTFLAG clears on read
+        {
+            uint64_t wraps = simSysTickWraps(core);
+            uint32_t value = core->systCsr | ((wraps > core->systWrapsSeen) ? (1u << 16) : 0);
+            core->systWrapsSeen = wraps;
+            return value;
+        }
+        case 0x4: return core->systRvr;                         // RVR
+        case 0x8:                                               // CVR
+            if ((tickPs == 0) || (core->timePs <= core->systStartPs))
+            {
+                return 0;
+            }
+            return core->systRvr - (uint32_t)(((core->timePs - core->systStartPs) / tickPs) % (core->systRvr + 1));
+        default:  return 0x00000000;                            // CALIB: no reference value
+    }
+}
+
+static void simSysTickWrite(uint32_t offset, uint32_t value)
+{
+    SimCore *core = simSelf();
+    switch (offset)
+    {
+        case 0x0:
+            if ((value & 1) && !(core->systCsr & 1))
+            {
+                simSysTickRestart(core);
+            }
+            core->systCsr = value & 0x7;
+            if ((core->systCsr & 0x3) == 0x3)
+            {
+                core->nvicEnabled |= 1ull << SIM_SYSTICK_IRQ;
+            }
+            else
+            {
+                core->nvicEnabled &= ~(1ull << SIM_SYSTICK_IRQ);
+            }
+            break;
+        case 0x4: core->systRvr = value & 0xffffff; break;
+        case 0x8: simSysTickRestart(core); break;               // any write clears the counter
+        default:  break;
+    }
+}
+
+/* Group priority: the bits above PRIGROUP, the rest is the subpriority */
+static int simGroupPriority(SimCore *core, int priority)
+{
+    return priority & (0xff << (core->prigroup + 1)) & 0xff;
+}
+
+/* Group priority of the running handler, boosted by BASEPRI (special[0]) */
+static int simExecPriority(SimCore *core)
+{
+    int priority = core->irqDepth ? simGroupPriority(core, core->nvicPriority[core->irqActive[core->irqDepth - 1]]) : 256;
+    int basepri = core->special[0] & 0xf0;
+    return (basepri && (simGroupPriority(core, basepri) < priority)) ? simGroupPriority(core, basepri) : priority;
+}
+
+/* Highest priority interrupt that can preempt the running code, -1 if none.
+   Preemption compares the group priorities, the choice between the pending
+   ones the whole priority then the IRQ number.
+   PRIMASK is checked by the caller (it does not prevent waking up from wfi). */
+static int simIrqNext(SimCore *core)
+{
+    int next = -1;
+    uint64_t active = 0;
+    for (int d = 0; d < core->irqDepth; d++)
+    {
+        active |= 1ull << core->irqActive[d];
+    }
+    // A level stays high while its handler runs: it is sampled again on return
+    core->nvicPending |= simIrqLines() & core->nvicEnabled & ~active;
+    simSysTickPoll(core);
+    for (int irq = 0; irq < SIM_NUM_LINES; irq++)
+    {
+        if ((((core->nvicPending & core->nvicEnabled) & ~active) >> irq) & 1)
+        {
+            if ((simGroupPriority(core, core->nvicPriority[irq]) < simExecPriority(core)) &&
+                ((next < 0) || (core->nvicPriority[irq] < core->nvicPriority[next])))
+            {
+                next = irq;
+            }
+        }
+    }
+    return (core->irqDepth < SIM_MAX_NESTING) ? next : -1;
+}
+
+/* Exception number of a line: IRQn is exception 16 + n, SysTick is 15 */
+static int simIrqVector(int irq)
+{
+    return (irq == SIM_SYSTICK_IRQ) ? 15 : 16 + irq;
+}
+
+/* Handler of an IRQ from the vector table pointed by VTOR (the linked vector
+   table until VTOR is written). The host table has pointer sized entries. */
+static void (*simIrqHandler(SimCore *core, int irq))(void)
+{
+    static void **vectorTable;
+    static size_t vectorCount;
+    if (vectorTable == NULL)
+    {
+        Dl_info info;
+        const ElfW(Sym) *symbol = NULL;
+        vectorTable = dlsym(RTLD_DEFAULT, "vectorTable");
+        if (vectorTable && dladdr1(vectorTable, &info, (void **)&symbol, RTLD_DL_SYMENT) && symbol)
+        {
+            vectorCount = symbol->st_size / sizeof(void *);
+        }
+    }
+    void **table = core->vtor ? (void **)(uintptr_t)core->vtor : vectorTable;
+    if ((table == NULL) || ((table == vectorTable) && ((size_t)simIrqVector(irq) >= vectorCount)))
+    {
+        return NULL;
+    }
+    return (void (*)(void))table[simIrqVector(irq)];
+}
+
+/* Takes the pending interrupts of the calling core, called without simLock.
+   An interrupt pending when a handler returns is tail-chained: the return
+   and the next entry cost SIM_TAILCHAIN_CYCLES instead of both stackings. */
+static void simTakeInterrupts(void)
+{
+    SimCore *core = simSelf();
+    int returning = 0;                  // a handler returned, its exception return is not counted yet
+    for (;;)
+    {
+        pthread_mutex_lock(&simLock);
+        int irq = core->primask ? -1 : simIrqNext(core);
+        void (*handler)(void) = (irq >= 0) ? simIrqHandler(core, irq) : NULL;
+        if ((irq >= 0) && (handler == NULL))
+        {
+            fprintf(stderr, "[sim] core%u: no handler for IRQ%d in the vector table, IRQ disabled\n", core->id, irq);
+            core->nvicEnabled &= ~(1ull << irq);
+        }
+        if (handler)
+        {
+            core->nvicPending &= ~(1ull << irq);
+            core->irqActive[core->irqDepth++] = irq;
+            core->irqCount[irq]++;
+        }
+        pthread_mutex_unlock(&simLock);
+        if (handler == NULL)
+        {
+            if (returning)
+            {
+                simConsume(SIM_IRQ_CYCLES);
+            }
+            return;
+        }
+        simConsume(returning ? SIM_TAILCHAIN_CYCLES : SIM_IRQ_CYCLES);
+        handler();
+        pthread_mutex_lock(&simLock);
+        core->irqDepth--;
+        pthread_mutex_unlock(&simLock);
+        returning = 1;
+    }
+}
+
+static uint32_t simNvicRead(uint32_t address)
+{
+    SimCore *core = simSelf();
+    uint32_t offset = address - SIM_NVIC;
+    uint32_t word = (offset & 0x7f) / 4;
+    if (address == SIM_VTOR)
+    {
+        // The bootrom points VTOR to the vector table of the image
+        return core->vtor ? core->vtor : (uint32_t)(uintptr_t)dlsym(RTLD_DEFAULT, "vectorTable");
+    }
+    if (address == SIM_AIRCR)
+    {
+        return 0xfa050000u | (core->prigroup << 8);             // VECTKEYSTAT
+    }
+    switch (offset & ~0x7fu)
+    {
+        case 0x000:                                             // ISER
+        case 0x080: return (uint32_t)(core->nvicEnabled >> (32 * word));   // ICER
+        case 0x100:                                             // ISPR
+        case 0x180: return (uint32_t)(core->nvicPending >> (32 * word));   // ICPR
+        case 0x200:                                             // IABR
+        {
+            uint64_t active = 0;
+            for (int d = 0; d < core->irqDepth; d++)
+            {
+                active |= (core->irqActive[d] < SIM_NUM_IRQS) ? (1ull << core->irqActive[d]) : 0;
+            }
+            return (uint32_t)(active >> (32 * word));
+        }
+        default:    break;
+    }
+    if ((offset >= 0x300) && (offset < 0x300 + SIM_NUM_IRQS))   // IPR
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            value |= (uint32_t)core->nvicPriority[(offset - 0x300) + i] << (8 * i);
+        }
+        return value;
+    }
+    return 0;
+}
+
+static void simNvicWrite(uint32_t address, uint32_t value)
+{
+    SimCore *core = simSelf();
+    uint32_t offset = address - SIM_NVIC;
+    uint64_t bits = (uint64_t)value << (32 * ((offset & 0x7f) / 4));
+    uint64_t valid = (1ull << SIM_NUM_IRQS) - 1;
+    if (address == SIM_VTOR)
+    {
+        core->vtor = value & ~0x7fu;
+        return;
+    }
+    if (address == SIM_AIRCR)
+    {
+        if ((value >> 16) == 0x05fa)                            // VECTKEY, SYSRESETREQ is not modelled
+        {
+            core->prigroup = (value >> 8) & 7;
+        }
+        return;
+    }
+    switch (offset & ~0x7fu)
+    {
+        case 0x000: core->nvicEnabled |= bits & valid; return;      // ISER
+        case 0x080: core->nvicEnabled &= ~(bits & valid); return;   // ICER
+        case 0x100: core->nvicPending |= bits & valid; return;      // ISPR
+        case 0x180: core->nvicPending &= ~(bits & valid); return;   // ICPR
+        default:    break;
+    }
+    if ((offset >= 0x300) && (offset < 0x300 + SIM_NUM_IRQS))   // IPR: 4 implemented bits
+    {
+        for (uint32_t i = 0; (i < 4) && ((offset - 0x300) + i < SIM_NUM_IRQS); i++)
+        {
+            core->nvicPriority[(offset - 0x300) + i] = (value >> (8 * i)) & 0xf0;
+        }
+    }
+}
+
+/* Next time a UART changes its state (end of the character being sent, next
+   received character or RX timeout), a timer of the core expires or a state
+   machine runs while the PIO or DMA interrupts wait for it. */
+static uint64_t simNextEventPs(SimCore *core)
+{
+    uint64_t next = simTimerNextPs(core);
+    uint64_t systick = simSysTickNextPs(core);
+    uint64_t pio = simPioNextPs();
+    next = (systick < next) ? systick : next;
+    next = (pio < next) ? pio : next;
+    for (int i = 0; i < 2; i++)
+    {
+        SimUart *uart = &simUart[i];
+        if ((simResets & uart->resetBit) || !(uart->cr & 1) || (simUartCharPs(uart) == UINT64_MAX))
+        {
+            continue;
+        }
+        if (uart->shiftBusy && (uart->shiftEndPs < next))
+        {
+            next = uart->shiftEndPs;
+        }
+        if (uart->rxInput && *uart->rxInput && (uart->rxNextPs < next))
+        {
+            next = uart->rxNextPs;
+        }
+        if (uart->rxTimeoutPs && (uart->rxTimeoutPs < next))
+        {
+            next = uart->rxTimeoutPs;
+        }
+    }
+    return next;
+}
+
+/* How far a sleeping core may skip ahead: not past the time of the other
+   core while it runs (it may still wake this one up), nor past the next event
+   of the other core while it sleeps (it runs first). */
+static uint64_t simSleepLimit(SimCore *core)
+{
+    SimCore *other = &simCores[core->id ^ 1];
+    if (!other->idle)
+    {
+        return other->timePs;
+    }
+    return other->nvicEnabled ? simNextEventPs(other) : UINT64_MAX;
+}
+
+/* wfi with interrupts enabled: skips the idle time until an interrupt can be
+   taken, or up to the limit set by the other core. idlePs is skipped when
+   nothing is scheduled. Returns 0 when no interrupt can be taken yet (the
+   caller waits in real time). */
+static int simSleep(SimCore *core, uint64_t idlePs)
+{
+    while (1)
+    {
+        if (core->nvicEnabled && (simIrqNext(core) >= 0))
+        {
+            return 1;
+        }
+        uint64_t next = core->nvicEnabled ? simNextEventPs(core) : UINT64_MAX;
+        if (next == UINT64_MAX)
+        {
+            next = idlePs ? (core->timePs + idlePs) : UINT64_MAX;
+            idlePs = 0;
+        }
+        uint64_t limit = simSleepLimit(core);
+        uint64_t target = (next < limit) ? next : limit;
+        if ((target == UINT64_MAX) || (target <= core->timePs))
+        {
+            return 0;
+        }
+        core->sleepPs += target - core->timePs;
+        core->timePs = target;
+        pthread_cond_broadcast(&simCond);                       // the other core may be waiting for this one
+        if ((core->id == 0) && (core->timePs >= simMaxPs))
+        {
+            simFinish();
+        }
+        if (target != next)
+        {
+            return 0;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   Register access entry points
+*/
+static uint32_t simCost(uint32_t address)
+{
+    switch (address >> 28)
+    {
+        case 0x4: return SIM_COST_APB;
+        case 0x5: return SIM_COST_AHB;
+        case 0xd: return SIM_COST_SIO;
+        case 0xe: return SIM_COST_PPB;
+        default:  return 1;
+    }
+}
+
+static SimFuncStats *simFuncStats(SimCore *core, void *fn)
+{
+    for (int i = ((uintptr_t)fn >> 4) % SIM_MAX_FUNCS, n = 0; n < SIM_MAX_FUNCS; i = (i + 1) % SIM_MAX_FUNCS, n++)
+    {
+        if ((core->funcs[i].fn == fn) || (core->funcs[i].fn == NULL))
+        {
+            core->funcs[i].fn = fn;
+            return &core->funcs[i];
+        }
+    }
+    return NULL;
+}
+
+static void simCountAccess(int write)
+{
+    SimCore *core = simSelf();
+    if (write)
+    {
+        core->writes++;
+    }
+    else
+    {
+        core->reads++;
+    }
+    if ((core->depth > 0) && (core->depth <= SIM_MAX_DEPTH))
+    {
+        SimFuncStats *stats = simFuncStats(core, core->stack[core->depth - 1].fn);
+        if (stats)
+        {
+            *(write ? &stats->writes : &stats->reads) += 1;
+        }
+    }
+}
+
+/* Bus accesses, shared by the cores and the DMA. Called with simLock held */
+static uint32_t simBusRead(uint32_t address)
+{
+    uint32_t value;
+    uint32_t base = address & ~0x3000u;
+    if ((address >> 28) == 0xd)
+    {
+        value = simSioRead(address - SIM_SIO);
+    }
+    else if ((base & 0xffffc000u) == SIM_CLOCKS)
+    {
+        value = simClocksRead(base - SIM_CLOCKS);
+    }
+    else if ((base & 0xffffc000u) == SIM_XOSC)
+    {
+        value = simXoscRead(base - SIM_XOSC);
+    }
+    else if ((base & 0xffffc000u) == SIM_RESETS)
+    {
+        value = simResetsRead(base - SIM_RESETS);
+    }
+    else if ((base & 0xffffc000u) == SIM_PSM)
+    {
+        value = simPsmRead(base - SIM_PSM);
+    }
+    else if ((base & 0xffffc000u) == SIM_PLL_SYS)
+    {
+        value = simPllRead(&simPll[0], base - SIM_PLL_SYS);
+    }
+    else if ((base & 0xffffc000u) == SIM_PLL_USB)
+    {
+        value = simPllRead(&simPll[1], base - SIM_PLL_USB);
+    }
+    else if ((base & 0xffffc000u) == SIM_UART0)
+    {
+        value = simUartRead(&simUart[0], base - SIM_UART0);
+    }
+    else if ((base & 0xffffc000u) == SIM_UART1)
+    {
+        value = simUartRead(&simUart[1], base - SIM_UART1);
+    }
+    else if ((base & 0xffffc000u) == SIM_DMA)
+    {
+        value = (simResets & SIM_RESET_DMA) ? 0 : simDmaRead(base - SIM_DMA);
+    }
+    else if ((address == SIM_DWT + 0x004) && (*simStoreSlot(SIM_DWT) & 1))
+    {
+        value = (uint32_t)simSelf()->cycles;                    // DWT_CYCCNT
+    }
+    else if (((address >= SIM_NVIC) && (address < SIM_NVIC + 0x400)) || (address == SIM_VTOR) || (address == SIM_AIRCR))
+    {
+        value = simNvicRead(address);
+    }
+    else if ((address >= SIM_SYSTICK) && (address < SIM_SYSTICK + 0x10))
+    {
+        value = simSysTickRead(address - SIM_SYSTICK);
+    }
+    else if (address == SIM_SHPR3)
+    {
+        value = (uint32_t)simSelf()->nvicPriority[SIM_SYSTICK_IRQ] << 24;   // PendSV is not modelled
+    }
+    else if ((base & 0xffffc000u) == SIM_TIMER0)
+    {
+        value = (simResets & SIM_RESET_TIMER0) ? 0 : simTimerRead(base - SIM_TIMER0);
+    }
+    else if ((base & 0xffffc000u) == SIM_TICKS)
+    {
+        value = simTicksRead(base - SIM_TICKS);
+    }
+    else if ((base & 0xffffc000u) == SIM_SHA256)
+    {
+        value = (simResets & SIM_RESET_SHA256) ? 0 : simShaRead(base - SIM_SHA256);
+    }
+    else if (((base & 0xfff00000u) >= SIM_PIO0) && ((base & 0xfff00000u) < SIM_PIO0 + 0x100000 * SIM_PIO_BLOCKS))
+    {
+        int p = (base - SIM_PIO0) >> 20;
+        value = (simResets & (SIM_RESET_PIO0 << p)) ? 0 : simPioRead(p, base & 0xfff);
+    }
+    else
+    {
+        value = *simStoreSlot(((address >> 28) < 0xd) ? base : address);
+    }
+    return value;
+}
+
+static void simBusWrite(uint32_t address, uint32_t value)
+{
+    uint32_t base = address & ~0x3000u;
+    uint32_t alias = (address >> 12) & 0x3;
+    if ((address >> 28) == 0xd)
+    {
+        simSioWrite(address - SIM_SIO, value);
+    }
+    else if (((address >= SIM_NVIC) && (address < SIM_NVIC + 0x400)) || (address == SIM_VTOR) || (address == SIM_AIRCR))
+    {
+        simNvicWrite(address, value);
+    }
+    else if ((address >= SIM_SYSTICK) && (address < SIM_SYSTICK + 0x10))
+    {
+        simSysTickWrite(address - SIM_SYSTICK, value);
+    }
+    else if (address == SIM_SHPR3)
+    {
+        simSelf()->nvicPriority[SIM_SYSTICK_IRQ] = (value >> 24) & 0xf0;
+    }
+    else if ((address >> 28) >= 0xe)
+    {
+        *simStoreSlot(address) = value;                         // PPB has no atomic aliases
+    }
+    else if ((base & 0xffffc000u) == SIM_CLOCKS)
+    {
+        simClocksWrite(base - SIM_CLOCKS, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_XOSC)
+    {
+        simXoscWrite(base - SIM_XOSC, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_RESETS)
+    {
+        simResetsWrite(base - SIM_RESETS, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_PSM)
+    {
+        simPsmWrite(base - SIM_PSM, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_PLL_SYS)
+    {
+        simPllWrite(&simPll[0], base - SIM_PLL_SYS, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_PLL_USB)
+    {
+        simPllWrite(&simPll[1], base - SIM_PLL_USB, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_UART0)
+    {
+        simUartWrite(&simUart[0], base - SIM_UART0, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_UART1)
+    {
+        simUartWrite(&simUart[1], base - SIM_UART1, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_DMA)
+    {
+        if (!(simResets & SIM_RESET_DMA))
+        {
+            simDmaWrite(base - SIM_DMA, value, alias);
+        }
+    }
+    else if ((base & 0xffffc000u) == SIM_TIMER0)
+    {
+        if (!(simResets & SIM_RESET_TIMER0))
+        {
+            simTimerWrite(base - SIM_TIMER0, value, alias);
+        }
+    }
+    else if ((base & 0xffffc000u) == SIM_TICKS)
+    {
+        simTicksWrite(base - SIM_TICKS, value, alias);
+    }
+    else if ((base & 0xffffc000u) == SIM_SHA256)
+    {
+        if (!(simResets & SIM_RESET_SHA256))
+        {
+            simShaWrite(base - SIM_SHA256, value, alias);
+        }
+    }
+    else if ((base & 0xffffc000u) == SIM_IO_BANK0)
+    {
+        simIoBank0Write(base - SIM_IO_BANK0, value, alias);
+    }
+    else if (((base & 0xfff00000u) >= SIM_PIO0) && ((base & 0xfff00000u) < SIM_PIO0 + 0x100000 * SIM_PIO_BLOCKS))
+    {
+        int p = (base - SIM_PIO0) >> 20;
+        if (!(simResets & (SIM_RESET_PIO0 << p)))
+        {
+            simPioWrite(p, base & 0xfff, value, alias);
+        }
+    }
+    else if ((address >> 26) == (SIM_XIP_MAINT >> 26))
+    {
+        // XIP cache maintenance: there is no cache, code fetches cost nothing
+    }
+    else
+    {
+        uint32_t *reg = simStoreSlot(base);
+        *reg = simAlias(*reg, value, alias);
+    }
+}
+
+uint32_t sim_read32(uint32_t address)
+{
+    pthread_mutex_lock(&simLock);
+    simCountAccess(0);
+    uint32_t value = simBusRead(address);
+    pthread_mutex_unlock(&simLock);
+    simConsume(simCost(address));
+    simTakeInterrupts();
+    return value;
+}
+
+void sim_write32(uint32_t address, uint32_t value)
+{
+    pthread_mutex_lock(&simLock);
+    simCountAccess(1);
+    simBusWrite(address, value);
+    pthread_mutex_unlock(&simLock);
+    simConsume(simCost(address));
+    simTakeInterrupts();
+}
+
+/* wfe waits for an event from the other core (sev or a FIFO write). Real time
+   is bounded, so code that polls a register inside the wfe loop keeps going,
+   and without an event it skips ahead to the next interrupt like wfi does.
+   wfi first skips ahead to the next interrupt (see simSleep). A sleeping core
+   never skips past the other core, so a core woken up by the other one is
+   never ahead of it. */
+void sim_asm(const char *instruction)
+{
+    SimCore *core = simSelf();
+    if (strcmp(instruction, "cpsid i") == 0)
+    {
+        core->primask = 1;
+    }
+    else if (strcmp(instruction, "cpsie i") == 0)
+    {
+        core->primask = 0;
+    }
+    else if (strcmp(instruction, "sev") == 0)
+    {
+        pthread_mutex_lock(&simLock);
+        simCores[0].event = simCores[1].event = 1;
+        pthread_cond_broadcast(&simCond);
+        pthread_mutex_unlock(&simLock);
+    }
+    else if ((strcmp(instruction, "wfe") == 0) || (strcmp(instruction, "wfi") == 0))
+    {
+        pthread_mutex_lock(&simLock);
+        core->idle = 1;
+        if (!core->event && !((instruction[2] == 'i') && simSleep(core, 0)))
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 200000;
+            if (deadline.tv_nsec >= 1000000000)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000;
+            }
+            if ((pthread_cond_timedwait(&simCond, &simLock, &deadline) != 0) && !core->event)
+            {
+                // wfi idles when nothing is scheduled, wfe only if the other core sleeps too
+                int idle = (instruction[2] == 'i') || simCores[core->id ^ 1].idle;
+                simSleep(core, idle ? SIM_IDLE_PS : 0);
+            }
+            if (core->event)
+            {
+                simSyncTime(core);
+            }
+        }
+        core->event = 0;
+        core->idle = 0;
+        pthread_mutex_unlock(&simLock);
+    }
+    simConsume(SIM_COST_ASM);
+    simTakeInterrupts();
+}
+
+/* Special registers (mrs/msr). IPSR reads the exception number of the running
+   handler, the others are plain per core storage. */
+static const char *simSpecialNames[] = { "basepri", "faultmask", "control", "msp", "psp", "msplim", "psplim", NULL };
+
+uint32_t sim_mrs(const char *reg)
+{
+    SimCore *core = simSelf();
+    uint32_t value = 0;
+    if (strcmp(reg, "primask") == 0)
+    {
+        value = core->primask;
+    }
+    else if (strcmp(reg, "ipsr") == 0)
+    {
+        value = core->irqDepth ? (uint32_t)simIrqVector(core->irqActive[core->irqDepth - 1]) : 0;
+    }
+    for (int i = 0; simSpecialNames[i]; i++)
+    {
+        if (strcmp(reg, simSpecialNames[i]) == 0)
+        {
+            value = core->special[i];
+        }
+    }
+    simConsume(SIM_COST_ASM);
+    return value;
+}
+
+void sim_msr(const char *reg, uint32_t value)
+{
+    SimCore *core = simSelf();
+    if (strcmp(reg, "primask") == 0)
+    {
+        core->primask = value & 1;
+    }
+    for (int i = 0; simSpecialNames[i]; i++)
+    {
+        if (strcmp(reg, simSpecialNames[i]) == 0)
+        {
+            core->special[i] = value;
+        }
+    }
+    simConsume(SIM_COST_ASM);
+    simTakeInterrupts();
+}
+
+/* ---------------------------------------------------------------------------
+   Core 1 bootrom: echoes the launch sequence received over the FIFO and jumps
+   to the entry point once the sequence 0, 0, 1, VTOR, SP, entry is complete.
+   See section 5.3 "Launching code on processor core 1" of RP2350 datasheet.
+*/
+static uint32_t simBootromPop(void)
+{
+    pthread_mutex_lock(&simLock);
+    while (simFifo[1].count == 0)
+    {
+        pthread_cond_wait(&simCond, &simLock);
+    }
+    simSyncTime(&simCores[1]);
+    uint32_t value = simFifoPop(&simFifo[1]);
+    pthread_mutex_unlock(&simLock);
+    return value;
+}
+
+static void simBootromPush(uint32_t value)
+{
+    pthread_mutex_lock(&simLock);
+    simFifoPush(&simFifo[0], value);
+    simCores[0].event = 1;
+    pthread_cond_broadcast(&simCond);
+    pthread_mutex_unlock(&simLock);
+}
+
+static void *simCore1Thread(void *arg)
+{
+    uint32_t cmd[6];
+    int seq = 0;
+    (void)arg;
+    simCore = &simCores[1];
+    while (seq < 6)
+    {
+        cmd[seq] = simBootromPop();
+        simBootromPush(cmd[seq]);
+        if (((seq < 2) && (cmd[seq] != 0)) || ((seq == 2) && (cmd[seq] != 1)))
+        {
+            seq = 0;
+            continue;
+        }
+        seq = (cmd[seq] == 0) ? ((seq < 2) ? seq + 1 : 0) : seq + 1;
+    }
+    simCores[1].vtor = cmd[3];                                  // not aligned on the host
+    simCores[1].idle = 0;
+    ((void (*)(void))(uintptr_t)cmd[5])();
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------------
+   Function instrumentation (-finstrument-functions)
+*/
+void __cyg_profile_func_enter(void *fn, void *site)
+{
+    SimCore *core = simSelf();
+    (void)site;
+    if (core->depth < SIM_MAX_DEPTH)
+    {
+        core->stack[core->depth].fn = fn;
+        core->stack[core->depth].startCycles = core->cycles;
+        simFuncStats(core, fn);
+    }
+    core->depth++;
+}
+
+void __cyg_profile_func_exit(void *fn, void *site)
+{
+    SimCore *core = simSelf();
+    (void)site;
+    core->depth--;
+    if ((core->depth >= 0) && (core->depth < SIM_MAX_DEPTH))
+    {
+        SimFuncStats *stats = simFuncStats(core, fn);
+        uint64_t cycles = core->cycles - core->stack[core->depth].startCycles;
+        if (stats)
+        {
+            stats->calls++;
+            stats->inclCycles += cycles;
+            stats->minCycles = (stats->calls == 1 || cycles < stats->minCycles) ? cycles : stats->minCycles;
+            stats->maxCycles = (cycles > stats->maxCycles) ? cycles : stats->maxCycles;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+   Report
+*/
+/* Static functions are not in the dynamic symbol table, so the names are
+   taken from the symbol table of the executable (nm), then from dladdr. */
+static const char *simFuncName(void *fn)
+{
+    static struct { uintptr_t addr; char name[64]; } symbols[4096];
+    static int count = -1;
+    Dl_info info;
+    if (count < 0)
+    {
+        char exe[512];
+        char cmd[600];
+        ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+        count = 0;
+        if (len > 0)
+        {
+            exe[len] = '\0';
+            snprintf(cmd, sizeof(cmd), "nm --defined-only '%s' 2>/dev/null", exe);
+            FILE *nm = popen(cmd, "r");
+            char line[256];
+            while (nm && (count < 4096) && fgets(line, sizeof(line), nm))
+            {
+                unsigned long addr;
+                char type;
+                if (sscanf(line, "%lx %c %63s", &addr, &type, symbols[count].name) == 3 && ((type == 't') || (type == 'T')))
+                {
+                    symbols[count++].addr = addr;
+                }
+            }
+            if (nm)
+            {
+                pclose(nm);
+            }
+        }
+    }
+    for (int i = 0; i < count; i++)
+    {
+        if (symbols[i].addr == (uintptr_t)fn)
+        {
+            return symbols[i].name;
+        }
+    }
+    if (dladdr(fn, &info) && info.dli_sname)
+    {
+        return info.dli_sname;
+    }
+    return "?";
+}
+
+static void simFinish(void)
+{
+    pthread_mutex_lock(&simLock);
+    if (simFinished)
+    {
+        pthread_mutex_unlock(&simLock);
+        return;
+    }
+    simFinished = 1;
+    for (int i = 0; i < 2; i++)
+    {
+        simUartAdvance(&simUart[i]);
+    }
+    simPioAdvance(simMaxPs);
+
+    const char *csvPath = getenv("SIM_REPORT");
+    FILE *csv = csvPath ? fopen(csvPath, "w") : NULL;
+    if (csv)
+    {
+        fprintf(csv, "function,core,calls,reads,writes,self_cycles,incl_cycles,min_cycles,max_cycles\n");
+    }
+    fprintf(stderr, "\n--- rp2350 sim: %.3f ms simulated, clk_ref %.3f MHz, clk_sys %.3f MHz, clk_peri %.3f MHz, clk_usb %.3f MHz ---\n",
+            simCores[0].timePs / 1e9, simClkRefHz() / 1e6, 1e6 / simPsPerCycle, simClkPeriHz() / 1e6, simClkUsbHz() / 1e6);
+    fprintf(stderr, "%-24s %4s %8s %10s %10s %12s %12s %12s\n",
+            "function", "core", "calls", "reads", "writes", "self cyc", "incl cyc", "cyc/call");
+    for (int c = 0; c < 2; c++)
+    {
+        SimCore *core = &simCores[c];
+        for (int i = 0; i < SIM_MAX_FUNCS; i++)
+        {
+            SimFuncStats *s = &core->funcs[i];
+            if (s->fn == NULL)
+            {
+                continue;
+            }
+            const char *name = simFuncName(s->fn);
+            fprintf(stderr, "%-24s %4d %8llu %10llu %10llu %12llu %12llu %12llu\n", name, c,
+                    (unsigned long long)s->calls, (unsigned long long)s->reads, (unsigned long long)s->writes,
+                    (unsigned long long)s->selfCycles, (unsigned long long)s->inclCycles,
+                    (unsigned long long)(s->calls ? s->inclCycles / s->calls : 0));
+            if (csv)
+            {
+                fprintf(csv, "%s,%d,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", name, c,
+                        (unsigned long long)s->calls, (unsigned long long)s->reads, (unsigned long long)s->writes,
+                        (unsigned long long)s->selfCycles, (unsigned long long)s->inclCycles,
+                        (unsigned long long)s->minCycles, (unsigned long long)s->maxCycles);
+            }
+        }
+        fprintf(stderr, "core%d: %llu cycles, %llu reads, %llu writes, %.3f ms sleeping\n", c, (unsigned long long)core->cycles,
+                (unsigned long long)core->reads, (unsigned long long)core->writes, core->sleepPs / 1e9);
+        for (int irq = 0; irq < SIM_NUM_IRQS; irq++)
+        {
+            if (core->irqCount[irq])
+            {
+                fprintf(stderr, "core%d: IRQ%d taken %llu times\n", c, irq, (unsigned long long)core->irqCount[irq]);
+            }
+        }
+        if (core->irqCount[SIM_SYSTICK_IRQ])
+        {
+            fprintf(stderr, "core%d: SysTick taken %llu times\n", c, (unsigned long long)core->irqCount[SIM_SYSTICK_IRQ]);
+        }
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        SimUart *uart = &simUart[i];
+        uint64_t divisor = ((uint64_t)uart->ibrd << 6) | uart->fbrd;
+        if (uart->txBytes || uart->rxBytes)
+        {
+            fprintf(stderr, "%s: %llu bytes sent, %llu received, %llu dropped, %llu overruns, %.0f baud (IBRD %u FBRD %u)\n",
+                    uart->name, (unsigned long long)uart->txBytes, (unsigned long long)uart->rxBytes,
+                    (unsigned long long)uart->txDropped, (unsigned long long)uart->rxOverruns,
+                    divisor ? (4.0 * simClkPeriHz()) / divisor : 0.0, uart->ibrd, uart->fbrd);
+        }
+    }
+    for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++)
+    {
+        if (simDma[ch].transfers)
+        {
+            fprintf(stderr, "DMA%d: %llu transfers\n", ch, (unsigned long long)simDma[ch].transfers);
+        }
+    }
+    if (simSha.blocks)
+    {
+        fprintf(stderr, "SHA256: %llu blocks\n", (unsigned long long)simSha.blocks);
+    }
+    for (int i = 0; i < 4 * SIM_PIO_BLOCKS; i++)
+    {
+        if (simPio[i / 4].sm[i % 4].instructions)
+        {
+            fprintf(stderr, "PIO%d SM%d: %llu instructions\n", i / 4, i % 4, (unsigned long long)simPio[i / 4].sm[i % 4].instructions);
+        }
+    }
+    for (int pin = 0; pin < 32; pin++)
+    {
+        if (simGpioEdges[pin])
+        {
+            fprintf(stderr, "GPIO%d: %llu changes\n", pin, (unsigned long long)simGpioEdges[pin]);
+        }
+    }
+    if (csv)
+    {
+        fclose(csv);
+    }
+    fflush(stdout);
+    fflush(stderr);
+    _exit(0);
+}
+
+__attribute__((constructor)) static void simInit(void)
+{
+    pthread_t thread;
+    const char *env;
+
+    simCores[0].id = 0;
+    simCores[1].id = 1;
+    simCores[1].idle = 1;                                       // waits in the bootrom
+    simCore = &simCores[0];
+    simMaxPs = (uint64_t)(((env = getenv("SIM_MAX_MS")) ? atof(env) : 2000.0) * 1e9);
+    simTraceGpio = getenv("SIM_TRACE_GPIO") != NULL;
+    *simStoreSlot(SIM_CLOCKS + 0xac) = 0xffffffff;              // WAKE_EN0/1 and SLEEP_EN0/1: every clock
+    *simStoreSlot(SIM_CLOCKS + 0xb0) = 0x7fffffff;
+    *simStoreSlot(SIM_CLOCKS + 0xb4) = 0xffffffff;
+    *simStoreSlot(SIM_CLOCKS + 0xb8) = 0x7fffffff;
+    for (int i = 0; i < 2; i++)
+    {
+        simUart[i].cr = 0x300;
+        simUart[i].ifls = 0x12;
+        simUart[i].out = stdout;
+    }
+    for (int p = 0; p < SIM_PIO_BLOCKS; p++)
+    {
+        simPioReset(p);
+    }
+    simUart[0].rxInput = getenv("SIM_UART0_RX");
+    simUart[0].rxNextPs = (uint64_t)(((env = getenv("SIM_UART0_RX_MS")) ? atof(env) : 10.0) * 1e9);
+    simUart[1].rxInput = getenv("SIM_UART1_RX");
+    simUart[1].rxNextPs = (uint64_t)(((env = getenv("SIM_UART1_RX_MS")) ? atof(env) : 10.0) * 1e9);
+    if ((env = getenv("SIM_UART1_OUT")) && ((simUart[1].out = fopen(env, "w")) == NULL))
+    {
+        simUart[1].out = stdout;
+    }
+    pthread_create(&thread, NULL, simCore1Thread, NULL);
+}
@@ -0,0 +1,29 @@
+/* Copyright (c) 2024 CarlosFTM
+   SPDX-License-Identifier: GPL-3.0-or-later
+   (see LICENSE.txt for details)
+*/
+
+/* RP2350 register simulator for host builds
+   When an example is compiled with -DHOST_SIM (see host.mk), the PUT32/GET32
+   macros are routed to the simulator instead of dereferencing the address, so
+   the same source runs on a Linux PC. The asm() statements used by the examples
+   ("nop", "wfe", "sev", ...) are routed to the simulator as well, so they can
+   consume simulated cycles and wake up the other core. sim_mrs()/sim_msr()
+   access the special registers (primask, ipsr, msplim...) for ../bsp/cpu.h.
+*/
+#ifndef RP2350_SIM_H
+#define RP2350_SIM_H
+
+#include <stdint.h>
+
+uint32_t sim_read32(uint32_t address);
+void sim_write32(uint32_t address, uint32_t value);
+void sim_asm(const char *instruction);
+uint32_t sim_mrs(const char *reg);
+void sim_msr(const char *reg, uint32_t value);
+
+#define PUT32(address, value) sim_write32((uint32_t)(address), (uint32_t)(value))
+#define GET32(address) sim_read32((uint32_t)(address))
+#define asm(instruction) sim_asm(instruction)
+
+#endif /* RP2350_SIM_H */
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+"""Puts the results of two runs of a benchmark side by side.
+
+Reads the UART0 output of the benchmarks ("name: value unit" lines) of two
+builds, typically the Arm and the RISC-V one of the same benchmark, and
+prints the cycle figures of both with their ratio and the faster one. The
+results without unit (check values) must be the same in both runs.
+
+  ../tools/benchcompare.py kernels_arm.log kernels_riscv.log
+  ../tools/benchcompare.py before.log after.log --labels before after
+"""
+
+import argparse
+import re
+import sys
+
+RESULT = re.compile(r"^(.+?): (\d+) ?(.*)$")
+
+
+def read_results(path):
+    """Results in the order of the file, by name and unit (a repeated one gets a #n suffix)"""
+    results = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = RESULT.match(line.strip("\r\n"))
+            if not m:
+                continue
+            name, value, unit = m.group(1), int(m.group(2)), m.group(3).strip()
+            name = ("%s (%s)" % (name, unit)) if unit else name
+            key = name
+            n = 2
+            while key in results:
+                key = "%s #%d" % (name, n)
+                n += 1
+            results[key] = (value, unit)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("first", help="output of the first run")
+    parser.add_argument("second", help="output of the second run")
+    parser.add_argument("--labels", nargs=2, default=("arm", "riscv"), help="names of the two runs")
+    args = parser.parse_args()
+
+    first = read_results(args.first)
+    second = read_results(args.second)
+    a, b = args.labels
+    print("%-36s %12s %12s %8s  %s" % ("result", a, b, b + "/" + a, "faster"))
+    mismatches = 0
+    for name, (value, unit) in first.items():
+        if name not in second:
+            continue
+        other, other_unit = second[name]
+        if not unit:
+            if other != value:
+                print("%-36s %12d %12d  MISMATCH" % (name, value, other))
+                mismatches += 1
+            continue
+        if "cycles" not in unit or unit != other_unit:
+            continue
+        ratio = ("%8.2f" % (other / value)) if value else "%8s" % "-"
+        faster = a if value < other else b if other < value else "="
+        print("%-36s %12d %12d %s  %s" % (name, value, other, ratio, faster))
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,315 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+"""Encodes and decodes the COBS + CRC-16 frames of bsp/frame.c.
+
+A frame is type (1) | seq (1) | payload | CRC-16/CCITT-FALSE (2, little
+endian), COBS encoded and ended by a 0x00. Anything that is not a valid frame
+is counted and skipped.
+
+  ../tools/framelink.py decode frames.bin --stats          # saved capture
+  ../tools/framelink.py decode /dev/ttyACM0 --baud 3000000 # board (raw tty)
+  ../tools/framelink.py decode --pty                       # creates a pty for the simulator
+  echo hello | ../tools/framelink.py encode --type 1 > frames.bin
+  ../tools/framelink.py loopback --frames 20000 --size 64 --corrupt 1e-4
+"""
+
+import argparse
+import binascii
+import os
+import random
+import struct
+import sys
+import threading
+import time
+
+MAX_PAYLOAD = 256                       # FRAME_MAX_PAYLOAD of bsp/frame.h
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, frameCrc16(0xffff, ...)"""
+    return binascii.crc_hqx(data, 0xffff)
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code = 0                            # position of the code byte of the current block
+    for byte in data:
+        if byte == 0:
+            out[code] = len(out) - code
+            code = len(out)
+            out.append(0)
+            continue
+        out.append(byte)
+        if len(out) - code == 0xff:
+            out[code] = 0xff
+            code = len(out)
+            out.append(0)
+    out[code] = len(out) - code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Returns None when a code byte points past the end"""
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code < 0xff and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(frame_type, seq, payload):
+    raw = bytes([frame_type & 0xff, seq & 0xff]) + payload
+    return cobs_encode(raw + struct.pack("<H", crc16(raw))) + b"\x00"
+
+
+class Encoder:
+    """Numbers the frames like frameTxInit/frameBegin"""
+
+    def __init__(self):
+        self.seq = 0
+
+    def frame(self, frame_type, payload):
+        if len(payload) > MAX_PAYLOAD:
+            raise ValueError("payload longer than %d bytes" % MAX_PAYLOAD)
+        data = encode_frame(frame_type, self.seq, payload)
+        self.seq = (self.seq + 1) & 0xff
+        return data
+
+
+class Decoder:
+    """Finds the frames in a byte stream, the same rules as frameRxByte"""
+
+    def __init__(self, on_frame):
+        self.buf = bytearray()
+        self.on_frame = on_frame
+        self.next_seq = None
+        self.frames = 0
+        self.crc_errors = 0
+        self.lost = 0
+        self.overflows = 0
+        self.limit = MAX_PAYLOAD + 4 + (MAX_PAYLOAD + 4) // 254 + 1
+
+    def feed(self, data):
+        start = 0
+        while True:
+            end = data.find(b"\x00", start)
+            if end < 0:
+                self.buf += data[start:]
+                return
+            self.buf += data[start:end]
+            start = end + 1
+            self.end_of_frame()
+
+    def end_of_frame(self):
+        encoded = bytes(self.buf)
+        self.buf.clear()
+        if not encoded:
+            return                          # delimiters in a row
+        if len(encoded) > self.limit:
+            self.overflows += 1
+            return
+        raw = cobs_decode(encoded)
+        if raw is None or len(raw) < 4 or crc16(raw[:-2]) != struct.unpack_from("<H", raw, len(raw) - 2)[0]:
+            self.crc_errors += 1
+            return
+        seq = raw[1]
+        if self.next_seq is not None:
+            self.lost += (seq - self.next_seq) & 0xff
+        self.next_seq = (seq + 1) & 0xff
+        self.frames += 1
+        self.on_frame(raw[0], seq, raw[2:-2])
+
+    def stats(self):
+        return "%d frames, %d lost, %d CRC errors, %d overflows" % (
+            self.frames, self.lost, self.crc_errors, self.overflows)
+
+
+def configure_tty(fd, baud):
+    """Raw 8N1 at the given baud rate, like stty raw"""
+    import termios
+    import tty
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    if baud:
+        speed = getattr(termios, "B%d" % baud)
+        attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+
+
+def open_input(name, baud, flags):
+    if name == "-":
+        return sys.stdin.fileno() if flags == os.O_RDONLY else sys.stdout.fileno()
+    fd = os.open(name, flags | getattr(os, "O_NOCTTY", 0))
+    if os.isatty(fd):
+        configure_tty(fd, baud)
+    return fd
+
+
+def open_pty():
+    """Master and slave of a new pseudo-terminal, both raw"""
+    master, slave = os.openpty()
+    configure_tty(master, 0)
+    configure_tty(slave, 0)
+    return master, slave
+
+
+def cmd_decode(args):
+    if args.pty:
+        fd, slave = open_pty()
+        sys.stderr.write("waiting for frames on %s (e.g. SIM_UART1_OUT=%s)\n" % (os.ttyname(slave), os.ttyname(slave)))
+    else:
+        fd = open_input(args.input, args.baud, os.O_RDONLY)
+
+    def on_frame(frame_type, seq, payload):
+        if args.quiet:
+            return
+        text = payload.hex() if args.hex else payload.decode("ascii", "replace")
+        sys.stdout.write("type %3d seq %3d len %3d: %s\n" % (frame_type, seq, len(payload), text))
+
+    decoder = Decoder(on_frame)
+    try:
+        while True:
+            try:
+                data = os.read(fd, 4096)
+            except OSError:
+                break                       # pty closed by the other side
+            if not data:
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+    if args.stats:
+        sys.stderr.write(decoder.stats() + "\n")
+    return 0 if decoder.frames else 1
+
+
+def cmd_encode(args):
+    """One frame per line of stdin (without the newline), or per --chunk bytes"""
+    fd = open_input(args.output, args.baud, os.O_WRONLY)
+    encoder = Encoder()
+    data = sys.stdin.buffer.read()
+    if args.chunk:
+        pieces = [data[i:i + args.chunk] for i in range(0, len(data), args.chunk)]
+    else:
+        pieces = data.splitlines()
+    for piece in pieces:
+        os.write(fd, encoder.frame(args.type, piece))
+    return 0
+
+
+def cmd_loopback(args):
+    """Frames written on the master of a pty and read back from its slave"""
+    master, slave = open_pty()
+    rng = random.Random(args.seed)
+    sent = {"frames": 0, "bytes": 0, "done": None}
+    received = []
+    wrong = [0]
+
+    def pattern(number):
+        body = bytes((number * 7 + i * 13) & 0xff for i in range(args.size - 4))
+        return struct.pack("<I", number) + body
+
+    def on_frame(frame_type, seq, payload):
+        number = struct.unpack_from("<I", payload, 0)[0] if len(payload) >= 4 else 0
+        if frame_type != args.type or payload != pattern(number):
+            wrong[0] += 1                   # valid CRC with a wrong payload: should never happen
+        received.append(seq)
+
+    decoder = Decoder(on_frame)
+
+    def writer():
+        encoder = Encoder()
+        for number in range(args.frames):
+            data = bytearray(encoder.frame(args.type, pattern(number)))
+            if args.drop and rng.random() < args.drop:
+                continue
+            if args.corrupt:
+                for i in range(len(data)):
+                    if rng.random() < args.corrupt:
+                        data[i] ^= 1 << rng.randrange(8)
+            os.write(master, bytes(data))
+            sent["frames"] += 1
+            sent["bytes"] += len(data)
+        sent["done"] = sent["bytes"] + 1    # set before the last write: the reader stops there
+        os.write(master, b"\x00")          # ends a frame whose delimiter was corrupted
+
+    start = time.perf_counter()
+    thread = threading.Thread(target=writer)
+    thread.start()
+    total = 0
+    while sent["done"] is None or total < sent["done"]:
+        data = os.read(slave, 65536)
+        total += len(data)
+        decoder.feed(data)
+    thread.join()
+    elapsed = time.perf_counter() - start
+    os.close(master)
+    os.close(slave)
+
+    print("pty loopback: %d frames of %d bytes sent (%d dropped before the pty), %d bytes on the wire"
+          % (sent["frames"], args.size, args.frames - sent["frames"], sent["bytes"]))
+    print("received: %s" % decoder.stats())
+    print("throughput: %.0f frames/s, %.1f KB/s payload in %.3f s"
+          % (decoder.frames / elapsed, decoder.frames * args.size / 1024.0 / elapsed, elapsed))
+    if args.baud:
+        wire = sent["bytes"] * 10.0 / args.baud
+        print("at %d baud 8N1: %.3f s on the wire, %.1f KB/s payload" % (args.baud, wire, decoder.frames * args.size / 1024.0 / wire))
+    missing = args.frames - decoder.frames
+    # Every frame that is not received is either seen as lost in the sequence
+    # numbers or missing at the end of the run
+    tail = (args.frames - 1 - received[-1]) & 0xff if received else 0
+    ok = (decoder.lost + tail == missing or missing >= 256) and not wrong[0]
+    print("detected: %d of %d missing frames, %d wrong payloads" % (decoder.lost + tail, missing, wrong[0]))
+    return 0 if ok else 1
+
+
+def main():
+    global MAX_PAYLOAD
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--max-payload", type=int, default=MAX_PAYLOAD, help="FRAME_MAX_PAYLOAD of the firmware")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("decode", help="prints the frames of a capture, tty or pty")
+    p.add_argument("input", nargs="?", default="-", help="capture file or tty (default: stdin)")
+    p.add_argument("--baud", type=int, default=115200, help="baud rate when input is a tty")
+    p.add_argument("--pty", action="store_true", help="create a pseudo-terminal and decode what is written to it")
+    p.add_argument("--hex", action="store_true", help="payload in hexadecimal")
+    p.add_argument("--quiet", action="store_true", help="do not print the frames")
+    p.add_argument("--stats", action="store_true", help="print the counters at the end (stderr)")
+    p.set_defaults(func=cmd_decode)
+
+    p = sub.add_parser("encode", help="sends stdin as frames")
+    p.add_argument("output", nargs="?", default="-", help="file or tty (default: stdout)")
+    p.add_argument("--baud", type=int, default=115200, help="baud rate when output is a tty")
+    p.add_argument("--type", type=int, default=0, help="message type")
+    p.add_argument("--chunk", type=int, default=0, help="bytes per frame (default: one frame per line)")
+    p.set_defaults(func=cmd_encode)
+
+    p = sub.add_parser("loopback", help="encoder and decoder through a pseudo-terminal")
+    p.add_argument("--frames", type=int, default=10000)
+    p.add_argument("--size", type=int, default=64, help="payload bytes per frame (4 at least)")
+    p.add_argument("--type", type=int, default=0x10)
+    p.add_argument("--drop", type=float, default=0.0, help="probability to drop a whole frame")
+    p.add_argument("--corrupt", type=float, default=0.0, help="probability to flip a bit of each byte")
+    p.add_argument("--baud", type=int, default=0, help="also print the time the bytes take on a UART")
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_loopback)
+
+    args = parser.parse_args()
+    MAX_PAYLOAD = args.max_payload
+    if args.command == "loopback" and not 4 <= args.size <= MAX_PAYLOAD:
+        parser.error("--size must be 4 to %d" % MAX_PAYLOAD)
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+"""Decodes the profiling reports of bsp/prof.c into a table.
+
+The reports are binary frames mixed with the text sent on UART0. Anything
+that is not a valid frame is skipped (or printed with --text).
+
+  ./03_MultiCore.host | ../tools/profdecode.py          # host simulator
+  ../tools/profdecode.py /dev/ttyACM0 --baud 115200     # board (raw tty)
+  ../tools/profdecode.py capture.bin --last             # saved capture
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b"PRF1"
+HEADER = struct.Struct("<IHHHHHBB")     # clk_sys, overhead[2], cost[2], probes, bins, 0
+
+
+def configure_tty(fd, baud):
+    """Raw 8N1 at the given baud rate, like stty raw"""
+    import termios
+    import tty
+    tty.setraw(fd)
+    attrs = termios.tcgetattr(fd)
+    speed = getattr(termios, "B%d" % baud)
+    attrs[4] = attrs[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+
+
+def parse_report(body):
+    """body: the bytes after the length field, checksum excluded"""
+    clk, ov0, ov1, cost0, cost1, count, bins, _ = HEADER.unpack_from(body, 0)
+    pos = HEADER.size
+    probes = []
+    for _ in range(count):
+        name_len = body[pos]
+        name = body[pos + 1:pos + 1 + name_len].decode("ascii", "replace")
+        pos += 1 + name_len
+        mask = body[pos]
+        pos += 1
+        cores = {}
+        for core in (0, 1):
+            if not mask & (1 << core):
+                continue
+            fields = struct.unpack_from("<%dI" % (5 + bins), body, pos)
+            pos += 4 * (5 + bins)
+            cores[core] = {
+                "count": fields[0],
+                "min": fields[1],
+                "max": fields[2],
+                "sum": fields[3] | (fields[4] << 32),
+                "hist": fields[5:],
+            }
+        probes.append((name, cores))
+    return {"clk": clk, "overhead": (ov0, ov1), "cost": (cost0, cost1), "probes": probes}
+
+
+def histogram(hist):
+    """Non empty bins as <upper bound>:<count>, e.g. <64:12"""
+    parts = []
+    for n, value in enumerate(hist):
+        if value == 0:
+            continue
+        if n == 0:
+            parts.append("0:%d" % value)
+        elif n == len(hist) - 1:
+            parts.append(">=%d:%d" % (1 << (n - 1), value))
+        else:
+            parts.append("<%d:%d" % (1 << n, value))
+    return " ".join(parts)
+
+
+def print_report(report, number, out):
+    clk = report["clk"]
+    out.write("report %d: clk_sys %.3f MHz, probe overhead %d/%d cycles (subtracted), "
+              "cost %d/%d cycles (core 0/1)\n"
+              % (number, clk / 1e6, report["overhead"][0], report["overhead"][1],
+                 report["cost"][0], report["cost"][1]))
+    out.write("%-24s %4s %9s %9s %11s %9s %10s  %s\n"
+              % ("probe", "core", "count", "min", "mean", "max", "mean us", "histogram (cycles:count)"))
+    for name, cores in report["probes"]:
+        for core, stats in sorted(cores.items()):
+            mean = stats["sum"] / stats["count"] if stats["count"] else 0.0
+            us = (mean * 1e6 / clk) if clk else 0.0
+            out.write("%-24s %4d %9d %9d %11.1f %9d %10.3f  %s\n"
+                      % (name, core, stats["count"], stats["min"], mean, stats["max"], us,
+                         histogram(stats["hist"])))
+    out.write("\n")
+    out.flush()
+
+
+class Decoder:
+    """Finds the frames in a byte stream"""
+
+    def __init__(self, on_report, on_text):
+        self.buf = bytearray()
+        self.on_report = on_report
+        self.on_text = on_text
+        self.errors = 0
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(MAGIC)
+            if start < 0:
+                keep = len(MAGIC) - 1           # the magic may be split between two reads
+                self.on_text(bytes(self.buf[:-keep] if len(self.buf) > keep else b""))
+                del self.buf[:max(0, len(self.buf) - keep)]
+                return
+            self.on_text(bytes(self.buf[:start]))
+            del self.buf[:start]
+            if len(self.buf) < 8:
+                return
+            length = struct.unpack_from("<I", self.buf, 4)[0]
+            if length < HEADER.size or length > (1 << 20):
+                self.errors += 1
+                del self.buf[:len(MAGIC)]
+                continue
+            if len(self.buf) < 8 + length + 4:
+                return
+            body = bytes(self.buf[8:8 + length])
+            checksum = struct.unpack_from("<I", self.buf, 8 + length)[0]
+            if (sum(body) & 0xffffffff) != checksum:
+                self.errors += 1
+                del self.buf[:len(MAGIC)]
+                continue
+            del self.buf[:8 + length + 4]
+            try:
+                report = parse_report(body)
+            except (struct.error, IndexError):
+                self.errors += 1
+                continue
+            self.on_report(report)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", nargs="?", default="-", help="capture file or tty (default: stdin)")
+    parser.add_argument("--baud", type=int, default=115200, help="baud rate when input is a tty")
+    parser.add_argument("--last", action="store_true", help="only print the last report")
+    parser.add_argument("--text", action="store_true", help="also print the text around the reports")
+    args = parser.parse_args()
+
+    if args.input == "-":
+        fd = sys.stdin.fileno()
+    else:
+        fd = os.open(args.input, os.O_RDONLY | getattr(os, "O_NOCTTY", 0))
+        if os.isatty(fd):
+            configure_tty(fd, args.baud)
+
+    reports = []
+
+    def on_report(report):
+        reports.append(report)
+        if not args.last:
+            print_report(report, len(reports), sys.stdout)
+
+    def on_text(text):
+        if args.text and text:
+            sys.stdout.write(text.decode("ascii", "replace"))
+
+    decoder = Decoder(on_report, on_text)
+    try:
+        while True:
+            data = os.read(fd, 4096)
+            if not data:
+                break
+            decoder.feed(data)
+    except KeyboardInterrupt:
+        pass
+    if args.last and reports:
+        print_report(reports[-1], len(reports), sys.stdout)
+    if decoder.errors:
+        sys.stderr.write("%d damaged reports skipped\n" % decoder.errors)
+    return 0 if reports else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,257 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+"""Size report of a firmware from the map file of the GNU linker.
+
+Prints the size of every output section and the use of every memory region
+(flash counts the initialized data too, copied to RAM by crt0), and the
+largest functions (one input section each with -ffunction-sections).
+With --baseline, the changes since the saved report of a previous build.
+
+  ../tools/size_report.py output.map --top 10
+  ../tools/size_report.py output.map --baseline 03_MultiCore.size.json --save 03_MultiCore.size.json
+  ../tools/size_report.py output.map --cycles report.csv    # SIM_REPORT of the host simulator
+"""
+
+import argparse
+import csv
+import json
+import os
+import re
+import sys
+
+NUM = r"0x[0-9a-fA-F]+"
+RE_REGION = re.compile(r"^(\S+)\s+(%s)\s+(%s)(?:\s+(\S+))?\s*$" % (NUM, NUM))
+RE_OUTPUT = re.compile(r"^(\.?[A-Za-z_][\w.]*)(?:\s+(%s)\s+(%s))?(?:\s+load address\s+(%s))?\s*$" % (NUM, NUM, NUM))
+RE_INPUT = re.compile(r"^ (\.?[\w.$]+)(?:\s+(%s)\s+(%s)\s+(.*))?$" % (NUM, NUM))
+RE_INPUT_CONT = re.compile(r"^\s+(%s)\s+(%s)\s+(.*)$" % (NUM, NUM))
+RE_SYMBOL = re.compile(r"^\s+(%s)\s+([A-Za-z_$][\w$.]*)\s*$" % NUM)
+RE_LOAD = re.compile(r"load address\s+(%s)" % NUM)
+
+# Output sections of the linker script that hold code
+CODE_SECTIONS = (".text", ".time_critical")
+
+# Input sections without contents in the image (zeroed or left as they are)
+NOBITS = (".bss", "COMMON", ".noinit")
+
+
+def parse_map(path):
+    regions = []
+    sections = []               # name, vma, size, lma
+    inputs = []                 # output section, input section, address, size, object
+    symbols = []                # address, name
+    state = "start"
+    pending_output = None
+    pending_input = None
+    current = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Memory Configuration"):
+                state = "memory"
+                continue
+            if line.startswith("Linker script and memory map"):
+                state = "map"
+                continue
+            if state == "memory":
+                m = RE_REGION.match(line)
+                if m and m.group(1) != "Name":
+                    regions.append({"name": m.group(1), "origin": int(m.group(2), 16),
+                                    "length": int(m.group(3), 16)})
+                continue
+            if state != "map":
+                continue
+
+            # Output section: name alone on its line when it is long
+            if pending_output is not None:
+                m = RE_INPUT_CONT.match(line) or re.match(r"^\s+(%s)\s+(%s)(.*)$" % (NUM, NUM), line)
+                if m:
+                    lma = RE_LOAD.search(line)
+                    current = {"name": pending_output, "vma": int(m.group(1), 16), "size": int(m.group(2), 16),
+                               "lma": int(lma.group(1), 16) if lma else None}
+                    sections.append(current)
+                pending_output = None
+                continue
+            if line and not line[0].isspace():
+                m = RE_OUTPUT.match(line)
+                if m:
+                    if m.group(2) is None:
+                        pending_output = m.group(1)
+                    else:
+                        current = {"name": m.group(1), "vma": int(m.group(2), 16), "size": int(m.group(3), 16),
+                                   "lma": int(m.group(4), 16) if m.group(4) else None}
+                        sections.append(current)
+                else:
+                    current = None
+                continue
+            if current is None:
+                continue
+
+            # Input section, on one or two lines
+            if pending_input is not None:
+                m = RE_INPUT_CONT.match(line)
+                if m:
+                    inputs.append((current["name"], pending_input, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+                pending_input = None
+                if m:
+                    continue
+            m = RE_INPUT.match(line)
+            if m and not line.startswith("  "):
+                if m.group(2) is None:
+                    pending_input = m.group(1)
+                else:
+                    inputs.append((current["name"], m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+                continue
+            m = RE_SYMBOL.match(line)
+            if m and not m.group(2).startswith("."):
+                symbols.append((int(m.group(1), 16), m.group(2)))
+    return regions, sections, inputs, symbols
+
+
+def short_object(obj):
+    """obj/release/libbsp.a(uart.o) -> libbsp.a(uart.o)"""
+    obj = obj.strip()
+    return os.path.basename(obj.split("(")[0]) + (("(" + obj.split("(", 1)[1]) if "(" in obj else "")
+
+
+def functions(inputs, symbols):
+    """Size of every function: its own input section, or the distance to the
+    next symbol when several functions share a section (no -ffunction-sections)"""
+    result = {}
+    symbols = sorted(symbols)
+    for output, name, addr, size, obj in inputs:
+        if output not in CODE_SECTIONS or size == 0:
+            continue
+        inside = [s for s in symbols if addr <= s[0] < addr + size]
+        base = name.split(".")
+        if len(base) > 2 and base[1] in ("text", "time_critical"):
+            fn = ".".join(base[2:])
+            result[fn] = {"size": size, "object": short_object(obj)}
+        elif inside:
+            for i, (saddr, sname) in enumerate(inside):
+                end = inside[i + 1][0] if i + 1 < len(inside) else addr + size
+                result[sname] = {"size": (end - saddr) & ~1, "object": short_object(obj)}
+    return result
+
+
+def region_of(regions, addr):
+    for region in regions:
+        if region["origin"] <= addr < region["origin"] + region["length"] and region["name"] != "*default*":
+            return region["name"]
+    return None
+
+
+def build_report(path):
+    regions, sections, inputs, symbols = parse_map(path)
+    used = {r["name"]: 0 for r in regions if r["name"] != "*default*"}
+    # The map does not tell NOLOAD sections apart: a section takes room at its
+    # load address only when one of its input sections has contents
+    loaded = {i[0] for i in inputs if i[3] and not i[1].startswith(NOBITS)}
+    out_sections = []
+    for s in sections:
+        if s["size"] == 0:
+            continue
+        vma_region = region_of(regions, s["vma"])
+        if vma_region is None:
+            continue                                    # debug sections
+        lma_region = None
+        if (s["lma"] is not None) and (s["name"] in loaded):
+            lma_region = region_of(regions, s["lma"])
+        used[vma_region] += s["size"]
+        if lma_region and lma_region != vma_region:
+            used[lma_region] += s["size"]
+        out_sections.append({"name": s["name"], "vma": s["vma"], "size": s["size"],
+                             "region": vma_region, "load": lma_region if lma_region != vma_region else None})
+    return {
+        "regions": [{"name": r["name"], "length": r["length"], "used": used[r["name"]]}
+                    for r in regions if r["name"] in used],
+        "sections": out_sections,
+        "functions": functions(inputs, symbols),
+    }
+
+
+def delta(value, old):
+    if old is None:
+        return "new"
+    return "%+d" % (value - old) if value != old else ""
+
+
+def load_cycles(path):
+    """function -> cycles per call, from the SIM_REPORT CSV of the simulator"""
+    cycles = {}
+    with open(path) as f:
+        for row in csv.DictReader(f):
+            calls = int(row["calls"])
+            entry = cycles.setdefault(row["function"], [0, 0])
+            entry[0] += int(row["incl_cycles"])
+            entry[1] += calls
+    return {fn: (total / calls if calls else 0.0) for fn, (total, calls) in cycles.items()}
+
+
+def print_report(report, base, top, cycles, out):
+    out.write("%-16s %10s %8s %7s  %s\n" % ("section", "address", "size", "change", "region"))
+    base_sections = {s["name"]: s["size"] for s in base["sections"]} if base else {}
+    for s in report["sections"]:
+        where = s["region"] + ((" (loaded from %s)" % s["load"]) if s["load"] else "")
+        change = delta(s["size"], base_sections.get(s["name"])) if base else ""
+        out.write("%-16s 0x%08x %8d %7s  %s\n" % (s["name"], s["vma"], s["size"], change, where))
+    out.write("\n%-16s %8s %8s %6s %7s\n" % ("region", "used", "size", "use", "change"))
+    base_regions = {r["name"]: r["used"] for r in base["regions"]} if base else {}
+    for r in report["regions"]:
+        change = delta(r["used"], base_regions.get(r["name"])) if base else ""
+        out.write("%-16s %8d %8d %5.1f%% %7s\n" % (r["name"], r["used"], r["length"],
+                                                    100.0 * r["used"] / r["length"] if r["length"] else 0.0, change))
+
+    fns = report["functions"]
+    base_fns = base["functions"] if base else {}
+    largest = sorted(fns.items(), key=lambda kv: (-kv[1]["size"], kv[0]))[:top]
+    out.write("\nlargest functions (%d in total, %d bytes)\n" % (len(fns), sum(f["size"] for f in fns.values())))
+    out.write("%8s %7s%s  %-28s %s\n" % ("size", "change", " %11s" % "cyc/call" if cycles else "", "function", "object"))
+    for name, f in largest:
+        change = delta(f["size"], base_fns[name]["size"] if name in base_fns else None) if base else ""
+        cyc = ""
+        if cycles:
+            cyc = (" %11.1f" % cycles[name]) if name in cycles else " %11s" % ""
+        out.write("%8d %7s%s  %-28s %s\n" % (f["size"], change, cyc, name, f["object"]))
+
+    if base:
+        changed = [(n, f["size"] - base_fns[n]["size"]) for n, f in fns.items()
+                   if n in base_fns and f["size"] != base_fns[n]["size"]]
+        added = [n for n in fns if n not in base_fns]
+        removed = [n for n in base_fns if n not in fns]
+        if changed or added or removed:
+            out.write("\nchanged since the last build:\n")
+            for name, d in sorted(changed, key=lambda c: -abs(c[1])):
+                out.write("  %-28s %+d bytes\n" % (name, d))
+            for name in sorted(added):
+                out.write("  %-28s new, %d bytes\n" % (name, fns[name]["size"]))
+            for name in sorted(removed):
+                out.write("  %-28s removed\n" % name)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map", help="map file of the linker (-Wl,-Map=output.map)")
+    parser.add_argument("--top", type=int, default=10, help="number of functions to list")
+    parser.add_argument("--baseline", help="report saved by a previous build (--save), missing is fine")
+    parser.add_argument("--save", help="save the report as JSON for the next build")
+    parser.add_argument("--cycles", help="SIM_REPORT CSV of the host simulator: adds the cycles per call")
+    args = parser.parse_args()
+
+    report = build_report(args.map)
+    base = None
+    if args.baseline and os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            base = json.load(f)
+    cycles = load_cycles(args.cycles) if args.cycles else None
+    print_report(report, base, args.top, cycles, sys.stdout)
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(report, f, indent=1, sort_keys=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+"""Stack report: the stack usage of every function, from GCC, next to the
+high-water marks measured on the cores.
+
+A build with make STACKUSAGE=1 writes, next to every object, the frame of
+each function (-fstack-usage, .su) and its calls (-fcallgraph-info=su, .ci).
+The report lists the largest frames and the deepest call paths (frame plus
+the worst case of the calls below it), then the worst case of each entry
+point with the interrupt handlers on top, and the watermarks printed by
+stackPrint() (bsp/stack.c) in a capture of the UART.
+
+  ../tools/stackreport.py obj/arm/debug --top 15
+  ../tools/stackreport.py obj/arm/debug --capture uart.log --root main --root schedCore1
+"""
+
+import argparse
+import glob
+import os
+import re
+import sys
+
+STACK_RESERVE = 256             # bsp/stack.h
+EXCEPTION_FRAME = 32            # stacked by the core for each interrupt level (no FPU context)
+
+RE_SU = re.compile(r"^(.*):(\d+):(\d+):(\S+)\t(\d+)\t(\S+)$")
+RE_NODE = re.compile(r'^node: \{ title: "([^"]+)" label: "([^"]*)"(.*)\}$')
+RE_EDGE = re.compile(r'^edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+RE_BYTES = re.compile(r"(\d+) bytes \(([^)]*)\)")
+RE_WATERMARK = re.compile(r"stack core (\d): used (\d+) of (\d+) bytes")
+RE_OVERFLOW = re.compile(r"stack overflow: core (\d), ([^,(]+)")
+
+INDIRECT = "__indirect_call"
+
+
+class Function:
+    def __init__(self, name, location, frame, kind):
+        self.name = name
+        self.location = location
+        self.frame = frame
+        self.kind = kind        # static, dynamic, dynamic,bounded
+        self.calls = []         # titles
+        self.indirect = False
+
+
+def load_su(paths):
+    functions = {}
+    for path in paths:
+        with open(path, errors="replace") as f:
+            for line in f:
+                m = RE_SU.match(line.rstrip("\n"))
+                if m:
+                    name = m.group(4)
+                    location = "%s:%s" % (os.path.basename(m.group(1)), m.group(2))
+                    functions[name] = Function(name, location, int(m.group(5)), m.group(6))
+    return functions
+
+
+def load_ci(paths):
+    """Nodes defined in a unit are keyed by their title ("name" or
+    "file:name" for static functions), the calls to other units are
+    resolved by name afterwards."""
+    functions = {}
+    external = {}
+    edges = []
+    for path in paths:
+        with open(path, errors="replace") as f:
+            for line in f:
+                line = line.rstrip("\n")
+                m = RE_NODE.match(line)
+                if m:
+                    title, label, rest = m.groups()
+                    parts = label.split("\\n")
+                    b = RE_BYTES.search(label)
+                    if "ellipse" in rest or not b:
+                        external[title] = parts[0]
+                        continue
+                    location = os.path.basename(parts[1]).rsplit(":", 1)[0] if len(parts) > 1 else ""
+                    functions[title] = Function(parts[0], location, int(b.group(1)), b.group(2))
+                    continue
+                m = RE_EDGE.match(line)
+                if m:
+                    edges.append(m.groups())
+    names = {}
+    for title, function in functions.items():
+        if ":" not in title:
+            names[function.name] = title
+    for source, target in edges:
+        caller = functions.get(source)
+        if caller is None:
+            continue
+        if target == INDIRECT:
+            caller.indirect = True
+        elif target in functions:
+            caller.calls.append(target)
+        elif external.get(target, target) in names:
+            caller.calls.append(names[external.get(target, target)])
+        # else: libgcc, or a function of a unit built without STACKUSAGE=1
+    return functions
+
+
+def worst_paths(functions):
+    """Worst case of each function: its frame plus the deepest call. A cycle
+    (recursion) has no bound, its functions are marked."""
+    worst = {}
+    path = {}
+    recursive = set()
+    active = set()
+
+    def visit(title):
+        if title in worst:
+            return worst[title]
+        if title in active:
+            recursive.add(title)
+            return 0
+        active.add(title)
+        function = functions[title]
+        deepest = 0
+        below = None
+        for callee in function.calls:
+            depth = visit(callee)
+            if callee in recursive:
+                recursive.add(title)
+            if depth > deepest:
+                deepest = depth
+                below = callee
+        active.discard(title)
+        worst[title] = function.frame + deepest
+        path[title] = below
+        return worst[title]
+
+    sys.setrecursionlimit(max(1000, 4 * len(functions)))
+    for title in functions:
+        visit(title)
+    return worst, path, recursive
+
+
+def load_capture(path):
+    """Last watermark of each core and the overflows reported in a capture
+    (text of the UART, binary frames mixed in are skipped)."""
+    watermarks = {}
+    overflows = []
+    with open(path, "rb") as f:
+        text = f.read().decode("ascii", errors="replace")
+    for m in RE_WATERMARK.finditer(text):
+        watermarks[int(m.group(1))] = (int(m.group(2)), int(m.group(3)))
+    for m in RE_OVERFLOW.finditer(text):
+        overflows.append((int(m.group(1)), m.group(2).strip()))
+    return watermarks, overflows
+
+
+def find(functions, name):
+    for title, function in functions.items():
+        if function.name == name:
+            return title
+    return None
+
+
+def chain(functions, path, title):
+    names = []
+    while title is not None and len(names) < 8:
+        names.append(functions[title].name)
+        title = path.get(title)
+    return " > ".join(names)
+
+
+def print_report(functions, graph, roots, capture, top, out):
+    ordered = sorted(functions.values(), key=lambda f: (-f.frame, f.name))
+    out.write("largest frames\n")
+    out.write("  %-32s %7s  %-16s %s\n" % ("function", "bytes", "kind", "location"))
+    for function in ordered[:top]:
+        out.write("  %-32s %7d  %-16s %s\n" % (function.name, function.frame, function.kind, function.location))
+    if any(f.kind != "static" for f in functions.values()):
+        dynamic = sorted(f.name for f in functions.values() if f.kind.startswith("dynamic") and "bounded" not in f.kind)
+        if dynamic:
+            out.write("  unbounded (alloca, VLA): %s\n" % ", ".join(dynamic))
+
+    estimate = None
+    if graph:
+        worst, path, recursive = worst_paths(functions)
+        out.write("\ndeepest call paths\n")
+        out.write("  %-32s %7s  %s\n" % ("function", "bytes", "path"))
+        for title in sorted(worst, key=lambda t: (-worst[t], functions[t].name))[:top]:
+            out.write("  %-32s %7d  %s\n" % (functions[title].name, worst[title], chain(functions, path, title)))
+        if recursive:
+            out.write("  recursive (no bound): %s\n" % ", ".join(sorted(functions[t].name for t in recursive)))
+        indirect = sorted(functions[t].name for t in functions if functions[t].indirect)
+        if indirect:
+            out.write("  indirect calls, not followed: %s\n" % ", ".join(indirect))
+
+        handlers = [t for t in functions if functions[t].name.endswith("_Handler") and functions[t].name != "Reset_Handler"]
+        handler = max(handlers, key=lambda t: worst[t]) if handlers else None
+        interrupt = (worst[handler] + EXCEPTION_FRAME) if handler else 0
+        out.write("\nentry points (+ worst interrupt: %s)\n" % (
+            "%s %d + frame %d bytes" % (functions[handler].name, worst[handler], EXCEPTION_FRAME) if handler else "none"))
+        for name in roots:
+            title = find(functions, name)
+            if title is None:
+                out.write("  %-32s not found\n" % name)
+                continue
+            total = worst[title] + interrupt
+            estimate = total if estimate is None else max(estimate, total)
+            out.write("  %-32s %7d  (%d + %d)\n" % (name, total, worst[title], interrupt))
+        out.write("  nested interrupts add one frame and one handler per priority level\n")
+
+    if capture:
+        watermarks, overflows = capture
+        out.write("\nmeasured (stackPrint)\n")
+        for core, what in overflows:
+            out.write("  stack overflow reported on core %d: %s\n" % (core, what))
+        for core in sorted(watermarks):
+            used, usable = watermarks[core]
+            size = usable + STACK_RESERVE
+            needed = max(used, estimate or 0)
+            out.write("  core %d: used %d of %d bytes (%d%%), %d bytes free" % (
+                core, used, usable, (100 * used) // usable if usable else 0, usable - used))
+            out.write(", bank %d bytes, %d needed with the reserve\n" % (size, needed + STACK_RESERVE))
+        if estimate is not None:
+            out.write("  the watermark is what ran, the worst case is what can run: size with the larger\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("objdir", nargs="+", help="directories with the .su/.ci files (make STACKUSAGE=1)")
+    parser.add_argument("--capture", help="text received from the UART with the stackPrint() lines")
+    parser.add_argument("--root", action="append", help="entry point of a core (default: main)")
+    parser.add_argument("--top", type=int, default=10, help="number of functions to list")
+    args = parser.parse_args()
+
+    su = [p for d in args.objdir for p in sorted(glob.glob(os.path.join(d, "*.su")))]
+    ci = [p for d in args.objdir for p in sorted(glob.glob(os.path.join(d, "*.ci")))]
+    if not su and not ci:
+        sys.stderr.write("no .su or .ci file in %s: build with make STACKUSAGE=1\n" % " ".join(args.objdir))
+        return 1
+    graph = len(ci) > 0
+    functions = load_ci(ci) if graph else load_su(su)
+    capture = load_capture(args.capture) if args.capture else None
+    print_report(functions, graph, args.root or ["main"], capture, args.top, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+# Copyright (c) 2024 CarlosFTM
+# SPDX-License-Identifier: GPL-3.0-or-later
+# (see LICENSE.txt for details)
+
+"""Prints the messages of the tokenized log of bsp/tlog.c.
+
+The firmware only sends the ID of the format string, a time stamp and the
+raw arguments, in frames of bsp/frame.c. The format strings are read from
+the tlog_fmt section of the ELF file of the same build.
+
+  ../tools/tlogdecode.py tlog.elf /dev/ttyACM0 --baud 3000000   # board (raw tty)
+  ../tools/tlogdecode.py tlog.host tlog.bin                     # simulator capture
+  ../tools/tlogdecode.py tlog.host --pty                        # pty for SIM_UART1_OUT
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import framelink                        # noqa: E402
+
+TLOG_FRAME = 0x20                       # frame type of core 0, core 1 is TLOG_FRAME + 1
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|j|z|t)?([diouxXcp%])")
+
+
+def read_formats(path):
+    """Contents of the tlog_fmt section: the ID of a string is its offset"""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        raise ValueError("%s is not an ELF file" % path)
+    is64 = elf[4] == 2
+    endian = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3a)
+        header = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2e)
+        header = endian + "IIIIIIIIII"
+    sections = [struct.unpack_from(header, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    for name, _, _, _, offset, size, _, _, _, _ in sections:
+        start = names[4] + name
+        if elf[start:elf.index(b"\x00", start)] == b"tlog_fmt":
+            return elf[offset:offset + size]
+    raise ValueError("%s has no tlog_fmt section (no TLOG in this build?)" % path)
+
+
+def varints(data):
+    pos = 0
+    while pos < len(data):
+        value = 0
+        shift = 0
+        while True:
+            if pos >= len(data):
+                raise ValueError("truncated message")
+            byte = data[pos]
+            pos += 1
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        yield value & 0xffffffff
+
+
+def render(fmt, args):
+    """printf with 32-bit integer arguments"""
+    args = list(args)
+
+    def convert(m):
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        if not args:
+            return "<missing>"
+        value = args.pop(0)
+        if conv in "di":
+            bits = {"hh": 8, "h": 16}.get(length, 32)
+            value &= (1 << bits) - 1
+            if value >= 1 << (bits - 1):
+                value -= 1 << bits
+        elif length in ("hh", "h"):
+            value &= 0xff if length == "hh" else 0xffff
+        if conv == "p":
+            return "0x%08x" % value
+        if conv == "c":
+            return chr(value & 0xff)
+        spec = "%" + flags + width + ("." + precision if precision else "") + {"u": "d", "i": "d"}.get(conv, conv)
+        return spec % value
+
+    return SPEC.sub(convert, fmt)
+
+
+class Log:
+    def __init__(self, formats, out):
+        self.formats = formats
+        self.out = out
+        self.messages = 0
+        self.unknown = 0
+        self.damaged = 0
+        self.other = 0
+        self.frames = framelink.Decoder(self.on_frame)
+
+    def string(self, offset):
+        if offset >= len(self.formats):
+            return None
+        end = self.formats.find(b"\x00", offset)
+        return self.formats[offset:end if end >= 0 else len(self.formats)].decode("ascii", "replace")
+
+    def on_frame(self, frame_type, seq, payload):
+        core = frame_type - TLOG_FRAME
+        if core not in (0, 1):
+            self.other += 1
+            return
+        words = varints(payload)
+        time = 0
+        try:
+            for header in words:
+                time = (time + next(words)) & 0xffffffff
+                args = [next(words) for _ in range(header & 7)]
+                fmt = self.string(header >> 3)
+                self.messages += 1
+                if fmt is None:
+                    self.unknown += 1
+                    text = "<unknown ID %d>" % (header >> 3)
+                else:
+                    text = render(fmt, args)
+                self.out.write("[%14.6f] core%d: %s\n" % (time / 1e6, core, text))
+        except (ValueError, StopIteration):
+            self.damaged += 1
+        self.out.flush()
+
+    def stats(self):
+        return ("%d messages, %d unknown IDs, %d damaged frames, %d other frames; frames: %s"
+                % (self.messages, self.unknown, self.damaged, self.other, self.frames.stats()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="ELF file of the firmware (.elf, or .host for the simulator)")
+    parser.add_argument("input", nargs="?", default="-", help="capture file or tty (default: stdin)")
+    parser.add_argument("--baud", type=int, default=115200, help="baud rate when input is a tty")
+    parser.add_argument("--pty", action="store_true", help="create a pseudo-terminal and decode what is written to it")
+    parser.add_argument("--stats", action="store_true", help="print the counters at the end (stderr)")
+    args = parser.parse_args()
+
+    log = Log(read_formats(args.elf), sys.stdout)
+    if args.pty:
+        fd, slave = framelink.open_pty()
+        sys.stderr.write("waiting for messages on %s\n" % os.ttyname(slave))
+    else:
+        fd = framelink.open_input(args.input, args.baud, os.O_RDONLY)
+    try:
+        while True:
+            try:
+                data = os.read(fd, 4096)
+            except OSError:
+                break
+            if not data:
+                break
+            log.frames.feed(data)
+    except KeyboardInterrupt:
+        pass
+    if args.stats:
+        sys.stderr.write(log.stats() + "\n")
+    return 0 if log.messages else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())